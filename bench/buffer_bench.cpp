@@ -0,0 +1,135 @@
+/*
+ * Buffer读写下标的微基准：单一所有者（size_t下标）与原子下标两种实例化的对比。
+ *
+ * 1. 按请求解析 + 响应生成的方式操作缓冲区（逐行FindCRLF/Retrieve、多次小段Append），
+ *    两种Buffer跑同一份模板代码；
+ * 2. 真实路径：HttpRequest::parse + HttpResponse::MakeResponse（只接受Buffer），给出绝对耗时。
+ *
+ * 在仓库根目录下运行：cd bench && make && ./buffer_bench [迭代次数]
+ */
+#include <chrono>
+#include <string>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "../code/buffer/buffer.h"
+#include "../code/http/httprequest.h"
+#include "../code/http/httpresponse.h"
+#include "../code/http/filecache.h"
+
+namespace {
+
+const char REQUEST[] =
+    "GET /index.html HTTP/1.1\r\n"
+    "Host: 127.0.0.1:1316\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko)\r\n"
+    "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8\r\n"
+    "Accept-Language: zh-CN,zh;q=0.9,en;q=0.8\r\n"
+    "Accept-Encoding: gzip, deflate\r\n"
+    "Connection: keep-alive\r\n"
+    "\r\n";
+
+const char *HEADERS[] = {
+    "HTTP/1.1 200 OK\r\n",
+    "Connection: keep-alive\r\n",
+    "keep-alive: max=100, timeout=60\r\n",
+    "Content-type: text/html\r\n",
+    "Content-length: 3067\r\n\r\n",
+};
+
+double NowNS()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// 与解析和响应生成相同的缓冲区访问模式
+template <typename BufferT>
+double BufferPath(long iterations, size_t *checksum)
+{
+    BufferT in, out;
+    size_t sum = 0;
+    double start = NowNS();
+    for (long i = 0; i < iterations; i++)
+    {
+        in.Append(REQUEST, sizeof(REQUEST) - 1);
+        // 逐行扫描请求头
+        while (in.ReadableBytes() > 0)
+        {
+            const char *end = in.Peek() + in.ReadableBytes();
+            const char *lineEnd = BufferT::FindCRLF(in.Peek(), end);
+            if (lineEnd == end)
+            {
+                break;
+            }
+            sum += lineEnd - in.Peek();
+            in.RetrieveUntil(lineEnd + 2);
+        }
+        // 逐段写响应头，再整体取走
+        for (const char *header : HEADERS)
+        {
+            out.Append(header, strlen(header));
+        }
+        sum += out.ReadableBytes();
+        out.Retrieve(out.ReadableBytes());
+    }
+    double elapsed = NowNS() - start;
+    *checksum += sum;
+    return elapsed / iterations;
+}
+
+double RealPath(long iterations, const std::string &srcDir, size_t *checksum)
+{
+    Buffer in, out;
+    HttpRequest request;
+    HttpResponse response;
+    size_t sum = 0;
+    double start = NowNS();
+    for (long i = 0; i < iterations; i++)
+    {
+        in.Append(REQUEST, sizeof(REQUEST) - 1);
+        request.Init();
+        if (!request.parse(in) || !request.IsFinished())
+        {
+            fprintf(stderr, "parse failed\n");
+            exit(1);
+        }
+        std::string path = request.path();
+        response.Init(srcDir, path, request.IsKeepAlive(), 200);
+        response.MakeResponse(out);
+        in.Retrieve(request.RequestLength());
+        sum += out.ReadableBytes() + response.FileLen();
+        out.Retrieve(out.ReadableBytes());
+        response.UnmapFile();
+    }
+    double elapsed = NowNS() - start;
+    *checksum += sum;
+    return elapsed / iterations;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    long iterations = argc > 1 ? atol(argv[1]) : 2000000;
+    char *cwd = getcwd(nullptr, 256);
+    std::string srcDir = std::string(cwd) + "/../resources/";
+    free(cwd);
+    FileCache::Instance()->Init(64 << 20, true);
+
+    size_t checksum = 0;
+    // 预热
+    BufferPath<Buffer>(iterations / 10, &checksum);
+    BufferPath<AtomicBuffer>(iterations / 10, &checksum);
+
+    double plain = BufferPath<Buffer>(iterations, &checksum);
+    double atomic = BufferPath<AtomicBuffer>(iterations, &checksum);
+    printf("buffer path   Buffer(size_t): %7.1f ns/op   AtomicBuffer: %7.1f ns/op   (%.2fx)\n",
+           plain, atomic, atomic / plain);
+
+    double real = RealPath(iterations / 4, srcDir, &checksum);
+    printf("parse + MakeResponse (Buffer): %7.1f ns/op\n", real);
+    printf("checksum %zu\n", checksum);
+    return 0;
+}
@@ -0,0 +1,452 @@
+/*
+ * 基于epoll的HTTP/1.1压测工具，代替fork-per-client、HTTP/1.0、不复用连接的webbench。
+ *
+ * 每个线程一个epoll实例，负责connections / threads个长连接；每个连接上保持pipeline个在途请求，
+ * 收到一个完整的响应（按Content-length跳过正文）就立即补发一个，服务端要求关闭时重新连接。
+ * 每个请求从发出到收到最后一个字节的耗时都记录下来，结束后合并排序，给出精确的分位数。
+ * 前warmup秒的请求和错误不计入结果。
+ *
+ * 结果以bench/results.h中的JSON行输出到stdout（req/s、p50/p99/p999/max耗时、错误数），
+ * 人可读的摘要输出到stderr。
+ *
+ * 用法：./loadgen [-a 地址] [-p 端口] [-c 连接数] [-t 线程数] [-d 秒数] [-w 预热秒数] [-P 流水线深度] [-u 路径]
+ * 例如：./loadgen -p 1316 -c 200 -t 4 -d 10 -P 4 -u /index.html > load.jsonl
+ */
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+
+#include "results.h"
+
+namespace {
+
+struct Options
+{
+    const char *addr = "127.0.0.1";
+    int port = 1316;
+    int connections = 100;
+    int threads = 1;
+    int duration = 10;
+    int warmup = 1;
+    int pipeline = 1;
+    const char *path = "/index.html";
+};
+
+Options opt;
+std::atomic<bool> running(true);
+std::atomic<bool> measuring(false);
+
+uint64_t NowNS()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/**
+ * 一个长连接：在途请求的发出时间按顺序排队，响应按同样的顺序到达
+ */
+struct Conn
+{
+    int fd = -1;
+    std::string in;          // 还没解析完的响应数据
+    size_t sendOffset = 0;   // out中已发出的字节数
+    std::string out;         // 待发出的请求
+    std::vector<uint64_t> sentAt;  // 在途请求的发出时间（环形）
+    size_t head = 0, inflight = 0;
+    size_t bodyLeft = 0;     // 当前响应还没收到的正文字节数
+    bool inBody = false;
+    bool closeAfter = false; // 当前响应带Connection: close
+};
+
+struct Stats
+{
+    std::vector<uint32_t> latencyUs;
+    uint64_t requests = 0;
+    uint64_t errors = 0;     // 连接失败、被对端关闭、非2xx/3xx响应
+    uint64_t reconnects = 0;
+    uint64_t bytes = 0;
+};
+
+class Worker
+{
+public:
+    Worker(int conns, const std::string &request) : request_(request)
+    {
+        epfd_ = epoll_create1(EPOLL_CLOEXEC);
+        conns_.resize(conns);
+    }
+
+    ~Worker()
+    {
+        for (Conn &c : conns_)
+        {
+            if (c.fd >= 0)
+            {
+                close(c.fd);
+            }
+        }
+        close(epfd_);
+    }
+
+    void Run()
+    {
+        for (size_t i = 0; i < conns_.size(); i++)
+        {
+            Connect_(i);
+        }
+        std::vector<struct epoll_event> events(256);
+        while (running.load(std::memory_order_relaxed))
+        {
+            int n = epoll_wait(epfd_, events.data(), events.size(), 100);
+            for (int i = 0; i < n; i++)
+            {
+                size_t idx = events[i].data.u64;
+                if (events[i].events & (EPOLLERR | EPOLLHUP))
+                {
+                    Fail_(idx);
+                    continue;
+                }
+                if (events[i].events & EPOLLOUT)
+                {
+                    Flush_(idx);
+                }
+                if (events[i].events & EPOLLIN)
+                {
+                    Read_(idx);
+                }
+            }
+        }
+    }
+
+    Stats stats;
+
+private:
+    void Connect_(size_t idx)
+    {
+        Conn &c = conns_[idx];
+        c = Conn();
+        c.sentAt.resize(opt.pipeline);
+        c.fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        int one = 1;
+        setsockopt(c.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        struct sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(opt.port);
+        inet_pton(AF_INET, opt.addr, &addr.sin_addr);
+        if (connect(c.fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 && errno != EINPROGRESS)
+        {
+            stats.errors++;
+            close(c.fd);
+            c.fd = -1;
+            return;
+        }
+        struct epoll_event ev = {};
+        ev.events = EPOLLIN | EPOLLOUT | EPOLLET;
+        ev.data.u64 = idx;
+        epoll_ctl(epfd_, EPOLL_CTL_ADD, c.fd, &ev);
+        // 连接建立前先排好请求，可写时一起发出
+        for (int i = 0; i < opt.pipeline; i++)
+        {
+            Queue_(c);
+        }
+    }
+
+    void Queue_(Conn &c)
+    {
+        c.out += request_;
+        c.sentAt[(c.head + c.inflight) % c.sentAt.size()] = NowNS();
+        c.inflight++;
+    }
+
+    void Fail_(size_t idx)
+    {
+        Conn &c = conns_[idx];
+        if (c.fd >= 0)
+        {
+            close(c.fd);
+        }
+        c.fd = -1;
+        if (running.load(std::memory_order_relaxed))
+        {
+            if (measuring.load(std::memory_order_relaxed))
+            {
+                stats.errors++;
+            }
+            stats.reconnects++;
+            Connect_(idx);
+        }
+    }
+
+    void Flush_(size_t idx)
+    {
+        Conn &c = conns_[idx];
+        while (c.sendOffset < c.out.size())
+        {
+            ssize_t n = send(c.fd, c.out.data() + c.sendOffset, c.out.size() - c.sendOffset, MSG_NOSIGNAL);
+            if (n < 0)
+            {
+                if (errno != EAGAIN)
+                {
+                    Fail_(idx);
+                }
+                return;
+            }
+            c.sendOffset += n;
+        }
+        c.out.clear();
+        c.sendOffset = 0;
+    }
+
+    void Read_(size_t idx)
+    {
+        Conn &c = conns_[idx];
+        char buf[65536];
+        while (true)
+        {
+            ssize_t n = recv(c.fd, buf, sizeof(buf), 0);
+            if (n == 0)
+            {
+                Fail_(idx);
+                return;
+            }
+            if (n < 0)
+            {
+                if (errno != EAGAIN)
+                {
+                    Fail_(idx);
+                }
+                return;
+            }
+            stats.bytes += n;
+            if (!Parse_(idx, buf, n))
+            {
+                return;
+            }
+        }
+    }
+
+    /**
+     * 解析收到的数据，每完成一个响应记录耗时并补发一个请求
+     * @return 连接被重建时返回false
+     */
+    bool Parse_(size_t idx, const char *data, size_t len)
+    {
+        Conn &c = conns_[idx];
+        while (len > 0)
+        {
+            if (c.inBody)
+            {
+                size_t n = std::min(len, c.bodyLeft);
+                c.bodyLeft -= n;
+                data += n;
+                len -= n;
+                if (c.bodyLeft == 0)
+                {
+                    c.inBody = false;
+                    if (!Complete_(idx))
+                    {
+                        return false;
+                    }
+                }
+                continue;
+            }
+            c.in.append(data, len);
+            len = 0;
+            size_t end = c.in.find("\r\n\r\n");
+            if (end == std::string::npos)
+            {
+                break;
+            }
+            // 响应头：状态码、Content-length、Connection
+            int status = atoi(c.in.c_str() + 9);
+            if ((status < 200 || status >= 400) && measuring.load(std::memory_order_relaxed))
+            {
+                stats.errors++;
+            }
+            c.bodyLeft = 0;
+            c.closeAfter = false;
+            for (size_t pos = c.in.find("\r\n"); pos < end; pos = c.in.find("\r\n", pos + 2))
+            {
+                const char *line = c.in.c_str() + pos + 2;
+                if (strncasecmp(line, "Content-length:", 15) == 0)
+                {
+                    c.bodyLeft = strtoul(line + 15, nullptr, 10);
+                }
+                else if (strncasecmp(line, "Connection: close", 17) == 0)
+                {
+                    c.closeAfter = true;
+                }
+            }
+            // 头部之后的数据重新作为正文处理
+            std::string rest = c.in.substr(end + 4);
+            c.in.clear();
+            c.inBody = true;
+            if (c.bodyLeft == 0)
+            {
+                c.inBody = false;
+                if (!Complete_(idx))
+                {
+                    return false;
+                }
+            }
+            if (!rest.empty())
+            {
+                return Parse_(idx, rest.data(), rest.size());
+            }
+        }
+        return true;
+    }
+
+    bool Complete_(size_t idx)
+    {
+        Conn &c = conns_[idx];
+        uint64_t now = NowNS();
+        if (c.inflight > 0)
+        {
+            uint64_t sent = c.sentAt[c.head];
+            c.head = (c.head + 1) % c.sentAt.size();
+            c.inflight--;
+            if (measuring.load(std::memory_order_relaxed))
+            {
+                stats.requests++;
+                stats.latencyUs.push_back(static_cast<uint32_t>(std::min<uint64_t>((now - sent) / 1000, UINT32_MAX)));
+            }
+        }
+        if (c.closeAfter)
+        {
+            // 服务端关闭连接（如达到keep-alive上限），剩下的在途请求作废，重新连接
+            close(c.fd);
+            c.fd = -1;
+            stats.reconnects++;
+            if (running.load(std::memory_order_relaxed))
+            {
+                Connect_(idx);
+            }
+            return false;
+        }
+        if (running.load(std::memory_order_relaxed))
+        {
+            Queue_(c);
+            Flush_(idx);
+        }
+        return true;
+    }
+
+    int epfd_;
+    std::string request_;
+    std::vector<Conn> conns_;
+};
+
+void Usage(const char *prog)
+{
+    fprintf(stderr, "usage: %s [-a addr] [-p port] [-c connections] [-t threads] [-d seconds] "
+                    "[-w warmup seconds] [-P pipeline] [-u path]\n", prog);
+    exit(1);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    int ch;
+    while ((ch = getopt(argc, argv, "a:p:c:t:d:w:P:u:h")) != -1)
+    {
+        switch (ch)
+        {
+        case 'a': opt.addr = optarg; break;
+        case 'p': opt.port = atoi(optarg); break;
+        case 'c': opt.connections = atoi(optarg); break;
+        case 't': opt.threads = atoi(optarg); break;
+        case 'd': opt.duration = atoi(optarg); break;
+        case 'w': opt.warmup = atoi(optarg); break;
+        case 'P': opt.pipeline = atoi(optarg); break;
+        case 'u': opt.path = optarg; break;
+        default: Usage(argv[0]);
+        }
+    }
+    if (opt.connections <= 0 || opt.threads <= 0 || opt.duration <= 0 || opt.warmup < 0 || opt.pipeline <= 0)
+    {
+        Usage(argv[0]);
+    }
+    opt.threads = std::min(opt.threads, opt.connections);
+    std::string request = std::string("GET ") + opt.path + " HTTP/1.1\r\n"
+                          "Host: " + opt.addr + ":" + std::to_string(opt.port) + "\r\n"
+                          "Connection: keep-alive\r\n\r\n";
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (int i = 0; i < opt.threads; i++)
+    {
+        int conns = opt.connections / opt.threads + (i < opt.connections % opt.threads ? 1 : 0);
+        workers.emplace_back(new Worker(conns, request));
+    }
+    std::vector<std::thread> threads;
+    for (auto &w : workers)
+    {
+        threads.emplace_back(&Worker::Run, w.get());
+    }
+    sleep(opt.warmup);
+    measuring = true;
+    uint64_t start = NowNS();
+    sleep(opt.duration);
+    measuring = false;
+    double seconds = (NowNS() - start) / 1e9;
+    running = false;
+    for (auto &t : threads)
+    {
+        t.join();
+    }
+
+    Stats total;
+    for (auto &w : workers)
+    {
+        total.requests += w->stats.requests;
+        total.errors += w->stats.errors;
+        total.reconnects += w->stats.reconnects;
+        total.bytes += w->stats.bytes;
+        total.latencyUs.insert(total.latencyUs.end(), w->stats.latencyUs.begin(), w->stats.latencyUs.end());
+    }
+    std::sort(total.latencyUs.begin(), total.latencyUs.end());
+    auto quantile = [&total](double q) -> double {
+        if (total.latencyUs.empty())
+        {
+            return 0;
+        }
+        size_t i = std::min(total.latencyUs.size() - 1, static_cast<size_t>(q * total.latencyUs.size()));
+        return total.latencyUs[i];
+    };
+    long n = static_cast<long>(total.requests);
+    double rps = total.requests / seconds;
+    BenchResult("loadgen_rps", rps, "req/s", n);
+    BenchResult("loadgen_p50", quantile(0.5), "us", n);
+    BenchResult("loadgen_p99", quantile(0.99), "us", n);
+    BenchResult("loadgen_p999", quantile(0.999), "us", n);
+    BenchResult("loadgen_max", total.latencyUs.empty() ? 0 : total.latencyUs.back(), "us", n);
+    BenchResult("loadgen_errors", static_cast<double>(total.errors), "count", n);
+    fprintf(stderr, "%s:%d%s  %d conns x %d pipeline, %d threads, %.1fs\n"
+                    "  %llu requests, %.0f req/s, %.1f MB/s, %llu errors, %llu reconnects\n"
+                    "  latency p50 %.0fus  p99 %.0fus  p999 %.0fus  max %.0fus\n",
+            opt.addr, opt.port, opt.path, opt.connections, opt.pipeline, opt.threads, seconds,
+            (unsigned long long)total.requests, rps, total.bytes / seconds / 1e6,
+            (unsigned long long)total.errors, (unsigned long long)total.reconnects,
+            quantile(0.5), quantile(0.99), quantile(0.999),
+            total.latencyUs.empty() ? 0.0 : (double)total.latencyUs.back());
+    return 0;
+}
@@ -0,0 +1,288 @@
+/*
+ * 热路径上各模块的微基准，用于在版本之间比较是否退化。
+ *
+ * 每个基准输出一行JSON（bench/results.h中的格式），可以重定向到文件后用tools/bench_compare.sh比较：
+ *   HttpRequest::parse、HttpResponse::MakeResponse、Buffer追加/取走、HeapTimer add/adjust/tick、
+ *   ThreadPool::AddTask（以及WorkStealingPool作对照）、Log::write（异步写入和被等级过滤两种情况）。
+ *
+ * 在仓库根目录下运行：cd bench && make && ./micro_bench [迭代次数] [名字过滤] > micro.jsonl
+ */
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../code/buffer/buffer.h"
+#include "../code/http/httprequest.h"
+#include "../code/http/httpresponse.h"
+#include "../code/http/filecache.h"
+#include "../code/timer/heaptimer.h"
+#include "../code/pool/threadpool.h"
+#include "../code/pool/stealpool.h"
+#include "../code/log/log.h"
+#include "results.h"
+
+namespace {
+
+const char REQUEST[] =
+    "GET /index.html HTTP/1.1\r\n"
+    "Host: 127.0.0.1:1316\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko)\r\n"
+    "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8\r\n"
+    "Accept-Language: zh-CN,zh;q=0.9,en;q=0.8\r\n"
+    "Accept-Encoding: gzip, deflate\r\n"
+    "Connection: keep-alive\r\n"
+    "\r\n";
+
+const char *HEADERS[] = {
+    "HTTP/1.1 200 OK\r\n",
+    "Connection: keep-alive\r\n",
+    "keep-alive: max=100, timeout=60\r\n",
+    "Content-type: text/html\r\n",
+    "Content-length: 3067\r\n\r\n",
+};
+
+const char *filter = nullptr;
+bool warmup = false;
+size_t checksum = 0;
+
+double NowNS()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool Selected(const char *name)
+{
+    return !filter || strstr(name, filter);
+}
+
+void Report(const char *name, long iterations, double elapsedNS)
+{
+    if (warmup)
+    {
+        return;
+    }
+    BenchResult(name, elapsedNS / iterations, "ns/op", iterations);
+}
+
+void BenchParse(long iterations)
+{
+    Buffer in;
+    HttpRequest request;
+    double start = NowNS();
+    for (long i = 0; i < iterations; i++)
+    {
+        in.Append(REQUEST, sizeof(REQUEST) - 1);
+        request.Init();
+        if (!request.parse(in) || !request.IsFinished())
+        {
+            fprintf(stderr, "parse failed\n");
+            exit(1);
+        }
+        checksum += request.RequestLength();
+        in.Retrieve(request.RequestLength());
+    }
+    Report("http_parse", iterations, NowNS() - start);
+}
+
+void BenchMakeResponse(long iterations, const std::string &srcDir)
+{
+    Buffer out;
+    HttpResponse response;
+    std::string path = "/index.html";
+    double start = NowNS();
+    for (long i = 0; i < iterations; i++)
+    {
+        response.Init(srcDir, path, true, 200);
+        response.SetKeepAlive(100, 60);
+        response.MakeResponse(out);
+        checksum += out.ReadableBytes() + response.FileLen();
+        out.Retrieve(out.ReadableBytes());
+        response.UnmapFile();
+    }
+    Report("http_make_response", iterations, NowNS() - start);
+}
+
+void BenchBuffer(long iterations)
+{
+    Buffer out;
+    double start = NowNS();
+    for (long i = 0; i < iterations; i++)
+    {
+        for (const char *header : HEADERS)
+        {
+            out.Append(header, strlen(header));
+        }
+        checksum += out.ReadableBytes();
+        out.Retrieve(out.ReadableBytes());
+    }
+    Report("buffer_append_retrieve", iterations, NowNS() - start);
+}
+
+void BenchHeapTimer(long iterations)
+{
+    // 定时器数量与连接数同量级，超出部分分轮进行
+    const int count = static_cast<int>(std::min(iterations, 100000L));
+    long rounds = std::max(1L, iterations / count);
+    TimeoutCallBack cb = [] { checksum++; };
+    double addNS = 0, adjustNS = 0, tickNS = 0;
+    unsigned seed = 1;
+    for (long r = 0; r < rounds; r++)
+    {
+        HeapTimer timer;
+        double start = NowNS();
+        for (int id = 0; id < count; id++)
+        {
+            timer.add(id, 60000 + (id * 7919) % 1000, cb);
+        }
+        addNS += NowNS() - start;
+
+        // 模拟读写事件续期：随机的连接延长到更晚的时间
+        start = NowNS();
+        for (int i = 0; i < count; i++)
+        {
+            seed = seed * 1103515245 + 12345;
+            timer.adjust((seed >> 8) % count, 61000 + i % 1000);
+        }
+        adjustNS += NowNS() - start;
+
+        // 全部改为已过期，tick逐个弹出并回调
+        for (int id = 0; id < count; id++)
+        {
+            timer.adjust(id, 0);
+        }
+        start = NowNS();
+        timer.tick();
+        tickNS += NowNS() - start;
+        if (timer.size() != 0)
+        {
+            fprintf(stderr, "tick left %zu timers\n", timer.size());
+            exit(1);
+        }
+    }
+    Report("heaptimer_add", rounds * count, addNS);
+    Report("heaptimer_adjust", rounds * count, adjustNS);
+    Report("heaptimer_tick_expire", rounds * count, tickNS);
+}
+
+void BenchThreadPool(long iterations)
+{
+    // ThreadPool的工作线程是分离的，引用着线程池本身，基准结束前不析构
+    static ThreadPool *pool = new ThreadPool(4);
+    std::atomic<long> done(0);
+    double start = NowNS();
+    for (long i = 0; i < iterations; i++)
+    {
+        pool->AddTask([&done] { done.fetch_add(1, std::memory_order_relaxed); });
+    }
+    double posted = NowNS();
+    while (done.load(std::memory_order_relaxed) < iterations)
+    {
+        std::this_thread::yield();
+    }
+    double finished = NowNS();
+    Report("threadpool_addtask", iterations, posted - start);
+    Report("threadpool_task_e2e", iterations, finished - start);
+}
+
+void BenchStealPool(long iterations)
+{
+    std::atomic<long> done(0);
+    double start, posted, finished;
+    {
+        WorkStealingPool<long> pool(4, [&done](long &) { done.fetch_add(1, std::memory_order_relaxed); });
+        start = NowNS();
+        for (long i = 0; i < iterations; i++)
+        {
+            pool.AddTask(i);
+        }
+        posted = NowNS();
+        while (done.load(std::memory_order_relaxed) < iterations)
+        {
+            std::this_thread::yield();
+        }
+        finished = NowNS();
+    }
+    Report("stealpool_addtask", iterations, posted - start);
+    Report("stealpool_task_e2e", iterations, finished - start);
+}
+
+void BenchLog(long iterations)
+{
+    // 异步模式：调用线程只格式化并放入无锁队列，写线程落盘
+    Log::Instance()->init(1, "./bench_log", ".log", 4096);
+    double start = NowNS();
+    for (long i = 0; i < iterations; i++)
+    {
+        LOG_INFO("Client[%d](%s:%d) in, userCount:%d", (int)(i & 1023), "127.0.0.1", 40000, (int)(i & 255));
+    }
+    double elapsed = NowNS() - start;
+    Log::Instance()->flush();
+    Report("log_write_async", iterations, elapsed);
+
+    // 等级过滤：只有一次relaxed原子读
+    start = NowNS();
+    for (long i = 0; i < iterations; i++)
+    {
+        LOG_DEBUG("filtered %ld", i);
+    }
+    Report("log_write_filtered", iterations, NowNS() - start);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    long iterations = argc > 1 ? atol(argv[1]) : 1000000;
+    filter = argc > 2 ? argv[2] : nullptr;
+    if (iterations <= 0)
+    {
+        fprintf(stderr, "usage: %s [iterations] [name filter]\n", argv[0]);
+        return 1;
+    }
+    char *cwd = getcwd(nullptr, 256);
+    std::string srcDir = std::string(cwd) + "/../resources/";
+    free(cwd);
+    FileCache::Instance()->Init(64 << 20, true);
+
+    if (Selected("http_parse"))
+    {
+        warmup = true;
+        BenchParse(iterations / 10);
+        warmup = false;
+        BenchParse(iterations);
+    }
+    if (Selected("http_make_response"))
+    {
+        BenchMakeResponse(iterations, srcDir);
+    }
+    if (Selected("buffer"))
+    {
+        BenchBuffer(iterations);
+    }
+    if (Selected("heaptimer"))
+    {
+        BenchHeapTimer(iterations);
+    }
+    if (Selected("threadpool"))
+    {
+        BenchThreadPool(iterations);
+    }
+    if (Selected("stealpool"))
+    {
+        BenchStealPool(iterations);
+    }
+    // 最后打开日志，前面的基准不受日志开销影响
+    if (Selected("log"))
+    {
+        BenchLog(iterations);
+    }
+    fprintf(stderr, "checksum %zu\n", checksum);
+    return 0;
+}
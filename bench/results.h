@@ -0,0 +1,24 @@
+/*
+ * 基准结果的输出格式：每个结果一行JSON，便于重定向到文件、在版本之间比较（tools/bench_compare.sh）。
+ *
+ *   {"name":"http_parse","value":123.4,"unit":"ns/op","iterations":1000000,"version":"9e92836"}
+ *
+ * unit为req/s或ops/s时数值越大越好，其余（ns/op、us）越小越好。version由Makefile用git describe填入。
+ */
+#ifndef BENCH_RESULTS_H
+#define BENCH_RESULTS_H
+
+#include <stdio.h>
+
+#ifndef BENCH_VERSION
+#define BENCH_VERSION "unknown"
+#endif
+
+inline void BenchResult(const char *name, double value, const char *unit, long iterations)
+{
+    printf("{\"name\":\"%s\",\"value\":%.3f,\"unit\":\"%s\",\"iterations\":%ld,\"version\":\"%s\"}\n",
+           name, value, unit, iterations, BENCH_VERSION);
+    fflush(stdout);
+}
+
+#endif // BENCH_RESULTS_H
@@ -1,53 +1,85 @@
 #include "buffer.h"
 
-// 读写下标初始化，vector<char>初始化
-Buffer::Buffer(int initBuffSize) : buffer_(initBuffSize), readPos_(0), writePos_(0) {}
+char BufferBase::emptyBlock_[1];
 
-/// Buffer 内存布局:
-/// +-------------------+------------------+------------------+
-/// | prependable bytes |  readable bytes  |  writable bytes  |
-/// |                   |     (CONTENT)    |                  |
-/// +-------------------+------------------+------------------+
-/// |                   |                  |                  |
-/// 0      <=      readerIndex   <=   writerIndex    <=     size
-
-
-// 可写的数量：buffer大小 - 写下标
-size_t Buffer::WritableBytes() const
+size_t BufferBase::FormatUInt(uint64_t value, char *out)
 {
-    return buffer_.size() - writePos_;
+    static const char DIGITS[] =
+        "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+        "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+    // 先从低位往高位写到临时数组的尾部，再整体拷贝
+    char tmp[MAX_UINT_DIGITS];
+    char *p = tmp + MAX_UINT_DIGITS;
+    while (value >= 100)
+    {
+        size_t i = (value % 100) * 2;
+        value /= 100;
+        *--p = DIGITS[i + 1];
+        *--p = DIGITS[i];
+    }
+    if (value >= 10)
+    {
+        size_t i = value * 2;
+        *--p = DIGITS[i + 1];
+        *--p = DIGITS[i];
+    }
+    else
+    {
+        *--p = static_cast<char>('0' + value);
+    }
+    size_t len = tmp + MAX_UINT_DIGITS - p;
+    memcpy(out, p, len);
+    return len;
 }
 
-// 可读的数量：写下标 - 读下标
-size_t Buffer::ReadableBytes() const
+// 读写下标初始化，从内存池取初始块
+template <typename Index>
+BasicBuffer<Index>::BasicBuffer(int initBuffSize) : data_(emptyBlock_), cap_(0), readPos_(0), writePos_(0)
 {
-    return writePos_ - readPos_;
+    assert(initBuffSize >= 0);
+    if (initBuffSize > 0)
+    {
+        data_ = BufferPool::Alloc(initBuffSize, &cap_);
+    }
 }
 
-// 可预留空间：已经读过的就没用了，等于读下标
-size_t Buffer::PrependableBytes() const
+// 内存块还给内存池
+template <typename Index>
+BasicBuffer<Index>::~BasicBuffer()
 {
-    return readPos_;
+    Reset_(emptyBlock_, 0);
 }
 
-/**
- * @brief 获取缓冲区中可读数据的起始指针
- * 
- * @return const char* 指向可读数据的起始位置的指针
- */
-const char *Buffer::Peek() const
+// 换成新的内存块，旧块还给内存池
+template <typename Index>
+void BasicBuffer<Index>::Reset_(char *block, size_t cap)
 {
-    // 返回缓冲区中读指针指向的位置，即可读数据的起始位置
-    return &buffer_[readPos_];
+    if (cap_ > 0)
+    {
+        BufferPool::Free(data_, cap_);
+    }
+    data_ = block;
+    cap_ = cap;
 }
 
+/// Buffer 内存布局:
+/// +-------------------+------------------+------------------+
+/// | prependable bytes |  readable bytes  |  writable bytes  |
+/// |                   |     (CONTENT)    |                  |
+/// +-------------------+------------------+------------------+
+/// |                   |                  |                  |
+/// 0      <=      readerIndex   <=   writerIndex    <=     size
+
+
 // 确保可写的长度
 /**
  * @brief 确保缓冲区有足够的可写空间
  * 
  * @param len 需要确保的可写空间大小
  */
-void Buffer::EnsureWriteable(size_t len)
+template <typename Index>
+void BasicBuffer<Index>::EnsureWriteable(size_t len)
 {
     // 如果需要的可写空间大于当前缓冲区的可写空间
     if (len > WritableBytes())
@@ -59,51 +91,31 @@ void Buffer::EnsureWriteable(size_t len)
     assert(len <= WritableBytes());
 }
 
-// 移动写下标，在Append中使用
-void Buffer::HasWritten(size_t len)
-{
-    writePos_ += len;
-}
-
-// 读取len长度，移动读下标
-void Buffer::Retrieve(size_t len)
-{
-    readPos_ += len;
-}
-
 // 读取到end位置
-void Buffer::RetrieveUntil(const char *end)
+template <typename Index>
+void BasicBuffer<Index>::RetrieveUntil(const char *end)
 {
     assert(Peek() <= end);
     Retrieve(end - Peek()); // end指针 - 读指针 长度
 }
 
 // 取出所有数据，buffer归零，读写下标归零,在别的函数中会用到
-void Buffer::RetrieveAll()
+template <typename Index>
+void BasicBuffer<Index>::RetrieveAll()
 {
-    memset(&buffer_[0], 0, buffer_.size()); // 覆盖原本数据
+    memset(data_, 0, cap_); // 覆盖原本数据
     readPos_ = writePos_ = 0;
 }
 
 // 取出剩余可读的str
-std::string Buffer::RetrieveAllToStr()
+template <typename Index>
+std::string BasicBuffer<Index>::RetrieveAllToStr()
 {
     std::string str(Peek(), ReadableBytes());
     RetrieveAll();
     return str;
 }
 
-// 写指针的位置
-const char *Buffer::BeginWriteConst() const
-{
-    return &buffer_[writePos_];
-}
-
-char *Buffer::BeginWrite()
-{
-    return &buffer_[writePos_];
-}
-
 // 添加str到缓冲区
 /**
  * @brief 将指定长度的字符数据追加到缓冲区
@@ -111,7 +123,8 @@ char *Buffer::BeginWrite()
  * @param str 要追加的字符数据的指针
  * @param len 要追加的字符数据的长度
  */
-void Buffer::Append(const char *str, size_t len)
+template <typename Index>
+void BasicBuffer<Index>::Append(const char *str, size_t len)
 {
     // 确保传入的字符指针不为空
     assert(str);
@@ -123,12 +136,25 @@ void Buffer::Append(const char *str, size_t len)
     HasWritten(len);
 }
 
+/**
+ * @brief 将无符号整数以十进制追加到缓冲区
+ *
+ * @param value 要追加的整数
+ */
+template <typename Index>
+void BasicBuffer<Index>::AppendUInt(uint64_t value)
+{
+    EnsureWriteable(MAX_UINT_DIGITS);
+    HasWritten(FormatUInt(value, BeginWrite()));
+}
+
 /**
  * @brief 将字符串追加到缓冲区
  * 
  * @param str 要追加的字符串
  */
-void Buffer::Append(const std::string &str)
+template <typename Index>
+void BasicBuffer<Index>::Append(const std::string &str)
 {
     // 调用另一个重载的 Append 函数，将字符串的内容追加到缓冲区
     Append(str.c_str(), str.size());
@@ -140,14 +166,16 @@ void Buffer::Append(const std::string &str)
  * @param data 要追加的二进制数据的指针
  * @param len 要追加的二进制数据的长度
  */
-void Buffer::Append(const void *data, size_t len)
+template <typename Index>
+void BasicBuffer<Index>::Append(const void *data, size_t len)
 {
     // 将传入的二进制数据指针转换为字符指针，并调用另一个重载的 Append 函数，将数据追加到缓冲区
     Append(static_cast<const char *>(data), len);
 }
 
 // 将buffer中的读下标的地方放到该buffer中的写下标位置
-void Buffer::Append(const Buffer &buff)
+template <typename Index>
+void BasicBuffer<Index>::Append(const BasicBuffer &buff)
 {
     Append(buff.Peek(), buff.ReadableBytes());
 }
@@ -160,16 +188,19 @@ void Buffer::Append(const Buffer &buff)
  * @param Errno 错误码指针
  * @return ssize_t 读取的字节数
  */
-ssize_t Buffer::ReadFd(int fd, int *Errno)
+template <typename Index>
+ssize_t BasicBuffer<Index>::ReadFd(int fd, int *Errno)
 {
-    char buff[65535]; // 栈区
+    // 第二段从内存池取（通常命中线程缓存），不再每次在栈上放64KB数组
+    size_t extraCap = 0;
+    char *extra = BufferPool::Alloc(EXTRA_READ_SIZE, &extraCap);
     struct iovec iov[2];
     size_t writeable = WritableBytes(); // 先记录能写多少
     // 分散读， 保证数据全部读完
     iov[0].iov_base = BeginWrite();
     iov[0].iov_len = writeable;
-    iov[1].iov_base = buff;
-    iov[1].iov_len = sizeof(buff);
+    iov[1].iov_base = extra;
+    iov[1].iov_len = extraCap;
 
     ssize_t len = readv(fd, iov, 2);
     if (len < 0)
@@ -180,16 +211,26 @@ ssize_t Buffer::ReadFd(int fd, int *Errno)
     {                     // 若len小于writable，说明写区可以容纳len
         writePos_ += len; // 直接移动写下标
     }
+    else if (writeable == 0 && ReadableBytes() == 0 && static_cast<size_t>(len) * 2 >= extraCap)
+    {
+        // 缓冲区为空且数据占了第二段的一半以上，直接接管第二段，省去一次拷贝
+        Reset_(extra, extraCap);
+        extra = nullptr;
+        readPos_ = 0;
+        writePos_ = len;
+    }
     else
     {
-        writePos_ = buffer_.size();                         // 写区写满了,下标移到最后
-        Append(buff, static_cast<size_t>(len - writeable)); // 剩余的长度
+        writePos_ = cap_;                                    // 写区写满了,下标移到最后
+        Append(extra, static_cast<size_t>(len - writeable)); // 剩余的长度
     }
+    BufferPool::Free(extra, extraCap);
     return len;
 }
 
 // 将buffer中可读的区域写入fd中
-ssize_t Buffer::WriteFd(int fd, int *Errno)
+template <typename Index>
+ssize_t BasicBuffer<Index>::WriteFd(int fd, int *Errno)
 {
     ssize_t len = write(fd, Peek(), ReadableBytes());
     if (len < 0)
@@ -201,29 +242,26 @@ ssize_t Buffer::WriteFd(int fd, int *Errno)
     return len;
 }
 
-char *Buffer::BeginPtr_()
-{
-    return &buffer_[0];
-}
-
-const char *Buffer::BeginPtr_() const
-{
-    return &buffer_[0];
-}
-
 // 扩展空间
 /**
  * @brief 调整缓冲区空间以确保有足够的可写空间
  * 
  * @param len 需要确保的可写空间大小
  */
-void Buffer::MakeSpace_(size_t len)
+template <typename Index>
+void BasicBuffer<Index>::MakeSpace_(size_t len)
 {
     // 如果当前可写空间加上预留空间（已读空间）仍小于所需空间
     if (WritableBytes() + PrependableBytes() < len)
     {
-        // 直接扩展缓冲区大小，确保有足够的空间
-        buffer_.resize(writePos_ + len + 1);
+        // 换成能容纳可读数据和len的更大等级的块，顺便丢掉已读的部分
+        size_t readable = ReadableBytes();
+        size_t cap = 0;
+        char *block = BufferPool::Alloc(readable + len, &cap);
+        std::copy(BeginPtr_() + readPos_, BeginPtr_() + writePos_, block);
+        Reset_(block, cap);
+        readPos_ = 0;
+        writePos_ = readable;
     }
     else
     {
@@ -239,3 +277,35 @@ void Buffer::MakeSpace_(size_t len)
         assert(readable == ReadableBytes());
     }
 }
+
+/**
+ * @brief 把空闲内存还给内存池
+ * 
+ * 连接空闲时调用，空闲连接不再占用缓冲区内存。
+ */
+template <typename Index>
+void BasicBuffer<Index>::Shrink()
+{
+    size_t readable = ReadableBytes();
+    if (readable == 0)
+    {
+        Reset_(emptyBlock_, 0);
+        readPos_ = writePos_ = 0;
+        return;
+    }
+    // 块比数据需要的大4倍以上时才搬，避免来回换块
+    if (BufferPool::BlockSize(readable) * 4 > cap_)
+    {
+        return;
+    }
+    size_t cap = 0;
+    char *block = BufferPool::Alloc(readable, &cap);
+    std::copy(BeginPtr_() + readPos_, BeginPtr_() + writePos_, block);
+    Reset_(block, cap);
+    readPos_ = 0;
+    writePos_ = readable;
+}
+
+// 显式实例化：单一所有者版本和原子下标版本
+template class BasicBuffer<size_t>;
+template class BasicBuffer<std::atomic<size_t>>;
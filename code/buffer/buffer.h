@@ -6,46 +6,100 @@
 #include <sys/uio.h> //readv
 #include <vector>    //readv
 #include <atomic>
+#include <stdint.h>
 #include <assert.h>
-class Buffer
+#include "bufferpool.h"
+
+/// 与读写下标类型无关的部分：分隔符扫描和公共常量。
+class BufferBase
 {
 public:
-    Buffer(int initBuffSize = 1024);
-    ~Buffer() = default;
+    // 分隔符扫描（bufferscan.cpp），运行时按CPU选择AVX2/SSE2/NEON/标量实现，找不到时返回end
+    static const char *FindCRLF(const char *begin, const char *end);
+    static const char *FindCRLFCRLF(const char *begin, const char *end);
+    // set为不超过MAX_SCAN_SET个字符的小字符集
+    static const char *FindAnyOf(const char *begin, const char *end, const char *set, size_t setLen);
+    static const size_t MAX_SCAN_SET = 8;
+
+    // ReadFd第二段iovec的大小，这段内存也来自内存池
+    static const size_t EXTRA_READ_SIZE = 65536;
+
+    // 把无符号整数写成十进制（每次两位查表），out至少MAX_UINT_DIGITS字节，返回位数，不写'\0'
+    static size_t FormatUInt(uint64_t value, char *out);
+    static const size_t MAX_UINT_DIGITS = 20;
 
-    size_t WritableBytes() const;
-    size_t ReadableBytes() const;
-    size_t PrependableBytes() const;
+protected:
+    static char emptyBlock_[1]; // 没有内存块时Peek/BeginWrite指向这里
+};
 
-    const char *Peek() const;
+/// 存储来自BufferPool的分级内存块：扩容时换成更大等级的块，Shrink()把空闲内存还给内存池。
+/// initBuffSize为0时构造不分配内存，第一次写入时才从内存池取块。
+///
+/// Index为读写下标的类型：
+///  - size_t：单一所有者（EPOLLONESHOT下的连接缓冲区、锁内使用的日志缓冲区），即Buffer；
+///  - std::atomic<size_t>：下标的每次读写都是顺序一致的原子操作，即AtomicBuffer。
+/// 两种实例化都在buffer.cpp里显式生成，高频的小函数定义在类内以便内联。
+template <typename Index>
+class BasicBuffer : public BufferBase
+{
+public:
+    BasicBuffer(int initBuffSize = 1024);
+    ~BasicBuffer();
+    BasicBuffer(const BasicBuffer &) = delete;
+    BasicBuffer &operator=(const BasicBuffer &) = delete;
+
+    size_t WritableBytes() const { return cap_ - writePos_; }          // 可写的数量：buffer大小 - 写下标
+    size_t ReadableBytes() const { return writePos_ - readPos_; }      // 可读的数量：写下标 - 读下标
+    size_t PrependableBytes() const { return readPos_; }               // 可预留空间：已经读过的就没用了，等于读下标
+
+    const char *Peek() const { return data_ + readPos_; }              // 可读数据的起始位置
+    char *BeginRead() { return data_ + readPos_; }                     // 可读数据的起始位置（可就地修改）
     void EnsureWriteable(size_t len);
-    void HasWritten(size_t len);
+    void HasWritten(size_t len) { writePos_ += len; }                  // 移动写下标，在Append中使用
 
-    void Retrieve(size_t len);
+    void Retrieve(size_t len) { readPos_ += len; }                     // 读取len长度，移动读下标
     void RetrieveUntil(const char *end);
 
     void RetrieveAll();
     std::string RetrieveAllToStr();
 
-    const char *BeginWriteConst() const;
-    char *BeginWrite();
+    const char *BeginWriteConst() const { return data_ + writePos_; }  // 写指针的位置
+    char *BeginWrite() { return data_ + writePos_; }
 
     void Append(const std::string &str);
     void Append(const char *str, size_t len);
     void Append(const void *data, size_t len);
-    void Append(const Buffer &buff);
+    void Append(const BasicBuffer &buff);
+    // 追加十进制整数（如Content-length），不经过to_string/snprintf
+    void AppendUInt(uint64_t value);
+    // 追加字符串字面量，长度在编译期确定
+    template <size_t N>
+    void AppendLiteral(const char (&str)[N]) { Append(str, N - 1); }
+
+    // 归还空闲内存：没有可读数据时整块还给内存池（容量变为0），
+    // 否则在块明显偏大时把数据搬到能容纳它的最小块
+    void Shrink();
+    size_t Capacity() const { return cap_; }
 
     ssize_t ReadFd(int fd, int *Errno);
     ssize_t WriteFd(int fd, int *Errno);
 
 private:
-    char *BeginPtr_(); // buffer开头
-    const char *BeginPtr_() const;
+    char *BeginPtr_() { return data_; } // buffer开头
+    const char *BeginPtr_() const { return data_; }
     void MakeSpace_(size_t len);
+    void Reset_(char *block, size_t cap);
 
-    std::vector<char> buffer_;
-    std::atomic<std::size_t> readPos_;  // 读的下标
-    std::atomic<std::size_t> writePos_; // 写的下标
+    char *data_;    // 来自BufferPool的内存块
+    size_t cap_;    // 内存块大小
+    Index readPos_;  // 读的下标
+    Index writePos_; // 写的下标
 };
 
-#endif // BUFFER_H
\ No newline at end of file
+typedef BasicBuffer<size_t> Buffer;
+typedef BasicBuffer<std::atomic<size_t>> AtomicBuffer;
+
+extern template class BasicBuffer<size_t>;
+extern template class BasicBuffer<std::atomic<size_t>>;
+
+#endif // BUFFER_H
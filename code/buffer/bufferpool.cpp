@@ -0,0 +1,121 @@
+#include "bufferpool.h"
+#include <new>
+#include <assert.h>
+
+std::atomic<size_t> BufferPool::cacheLimit_(4 << 20);
+
+namespace {
+
+struct FreeNode
+{
+    FreeNode *next;
+};
+
+// 线程缓存已析构（线程退出之后、静态对象析构时仍可能有Buffer被释放）
+thread_local bool cacheDestroyed = false;
+
+// 线程本地的分级空闲链表
+struct ThreadCache
+{
+    FreeNode *heads[BufferPool::CLASS_COUNT] = {};
+    size_t bytes = 0;
+
+    ~ThreadCache()
+    {
+        for (int i = 0; i < BufferPool::CLASS_COUNT; i++)
+        {
+            while (heads[i])
+            {
+                FreeNode *node = heads[i];
+                heads[i] = node->next;
+                ::operator delete(node);
+            }
+        }
+        bytes = 0;
+        cacheDestroyed = true;
+    }
+};
+
+ThreadCache *LocalCache()
+{
+    if (cacheDestroyed)
+    {
+        return nullptr;
+    }
+    static thread_local ThreadCache cache;
+    return &cache;
+}
+
+} // namespace
+
+int BufferPool::ClassOf_(size_t size)
+{
+    int cls = 0;
+    size_t blockSize = MIN_BLOCK;
+    while (blockSize < size && cls < CLASS_COUNT)
+    {
+        blockSize <<= 1;
+        cls++;
+    }
+    return cls; // 等于CLASS_COUNT表示超过最大等级
+}
+
+size_t BufferPool::BlockSize(size_t size)
+{
+    int cls = ClassOf_(size);
+    return cls < CLASS_COUNT ? MIN_BLOCK << cls : size;
+}
+
+char *BufferPool::Alloc(size_t size, size_t *cap)
+{
+    assert(size > 0 && cap);
+    int cls = ClassOf_(size);
+    if (cls >= CLASS_COUNT)
+    {
+        *cap = size;
+        return static_cast<char *>(::operator new(size));
+    }
+    *cap = MIN_BLOCK << cls;
+    ThreadCache *cache = LocalCache();
+    FreeNode *node = cache ? cache->heads[cls] : nullptr;
+    if (node)
+    {
+        // 命中线程缓存
+        cache->heads[cls] = node->next;
+        cache->bytes -= *cap;
+        return reinterpret_cast<char *>(node);
+    }
+    return static_cast<char *>(::operator new(*cap));
+}
+
+void BufferPool::Free(char *block, size_t cap)
+{
+    if (!block)
+    {
+        return;
+    }
+    int cls = ClassOf_(cap);
+    ThreadCache *cache = LocalCache();
+    // 超过最大等级、缓存已满或线程缓存已析构时直接释放
+    if (!cache || cls >= CLASS_COUNT || (MIN_BLOCK << cls) != cap ||
+        cache->bytes + cap > cacheLimit_.load(std::memory_order_relaxed))
+    {
+        ::operator delete(block);
+        return;
+    }
+    FreeNode *node = reinterpret_cast<FreeNode *>(block);
+    node->next = cache->heads[cls];
+    cache->heads[cls] = node;
+    cache->bytes += cap;
+}
+
+void BufferPool::SetThreadCacheLimit(size_t bytes)
+{
+    cacheLimit_.store(bytes, std::memory_order_relaxed);
+}
+
+size_t BufferPool::ThreadCachedBytes()
+{
+    ThreadCache *cache = LocalCache();
+    return cache ? cache->bytes : 0;
+}
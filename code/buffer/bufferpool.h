@@ -0,0 +1,57 @@
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+#include <cstddef>
+#include <atomic>
+
+/**
+ * @class BufferPool
+ * @brief Buffer使用的分级内存池。
+ *
+ * 内存块按2的幂分为CLASS_COUNT个等级（1KB ~ 1MB），每个线程为每个等级维护一个空闲链表（块本身存放
+ * 链表指针），分配和归还都只是链表头的弹出/压入，不加锁。块可以在一个线程分配、在另一个线程归还，
+ * 归还到当前线程的缓存中。每个线程缓存的总字节数不超过上限，超出部分直接释放给系统；线程退出时
+ * 释放它缓存的所有块。大于最大等级的请求不经过缓存。
+ */
+class BufferPool
+{
+public:
+    static const size_t MIN_BLOCK = 1024;    // 最小等级的块大小
+    static const int CLASS_COUNT = 11;       // 等级数量，最大等级为MIN_BLOCK << (CLASS_COUNT - 1)
+
+    /**
+     * @brief 分配至少size字节的内存块
+     * @param size 需要的字节数，大于0
+     * @param cap 输出实际分配的块大小（等级大小，或超过最大等级时就是size）
+     * @return 内存块
+     */
+    static char *Alloc(size_t size, size_t *cap);
+
+    /**
+     * @brief 归还Alloc分配的内存块
+     * @param block 内存块，为nullptr时忽略
+     * @param cap Alloc输出的块大小
+     */
+    static void Free(char *block, size_t cap);
+
+    /**
+     * @brief size向上取整后的块大小
+     */
+    static size_t BlockSize(size_t size);
+
+    /**
+     * @brief 设置每个线程缓存的字节数上限，为0时不缓存
+     */
+    static void SetThreadCacheLimit(size_t bytes);
+
+    /**
+     * @brief 当前线程缓存中的字节数
+     */
+    static size_t ThreadCachedBytes();
+
+private:
+    static int ClassOf_(size_t size);
+
+    static std::atomic<size_t> cacheLimit_;  // 每个线程缓存的字节数上限
+};
+
+#endif // BUFFER_POOL_H
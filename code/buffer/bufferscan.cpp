@@ -0,0 +1,344 @@
+#include "buffer.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BUFFER_SCAN_X86
+#elif defined(__ARM_NEON) || defined(__aarch64__)
+#include <arm_neon.h>
+#define BUFFER_SCAN_NEON
+#endif
+
+/// 分隔符扫描的几种实现：
+/// 向量版本每次比较16/32个字节，CRLF用错开一个字节的两次加载直接比出"\r\n"，
+/// 不足一个向量宽度的尾部交给标量版本处理。
+
+namespace {
+
+typedef const char *(*ScanFn)(const char *, const char *);
+typedef const char *(*AnyOfFn)(const char *, const char *, const char *, size_t);
+
+// ---------------- 标量版本 ----------------
+
+const char *FindCRLFScalar(const char *begin, const char *end)
+{
+    while (begin < end)
+    {
+        const char *cr = static_cast<const char *>(memchr(begin, '\r', end - begin));
+        if (!cr || cr + 1 >= end)
+        {
+            return end;
+        }
+        if (cr[1] == '\n')
+        {
+            return cr;
+        }
+        begin = cr + 1;
+    }
+    return end;
+}
+
+const char *FindCRLFCRLFScalar(const char *begin, const char *end)
+{
+    while (end - begin >= 4)
+    {
+        const char *cr = static_cast<const char *>(memchr(begin, '\r', end - begin - 3));
+        if (!cr)
+        {
+            return end;
+        }
+        if (cr[1] == '\n' && cr[2] == '\r' && cr[3] == '\n')
+        {
+            return cr;
+        }
+        begin = cr + 1;
+    }
+    return end;
+}
+
+const char *FindAnyOfScalar(const char *begin, const char *end, const char *set, size_t setLen)
+{
+    for (; begin < end; begin++)
+    {
+        for (size_t i = 0; i < setLen; i++)
+        {
+            if (*begin == set[i])
+            {
+                return begin;
+            }
+        }
+    }
+    return end;
+}
+
+#ifdef BUFFER_SCAN_X86
+
+// ---------------- SSE2 版本（x86-64 基线指令集） ----------------
+
+__attribute__((target("sse2")))
+const char *FindCRLFSSE2(const char *p, const char *end)
+{
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i lf = _mm_set1_epi8('\n');
+    while (end - p >= 17)
+    {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 1));
+        int mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, cr), _mm_cmpeq_epi8(b, lf)));
+        if (mask)
+        {
+            return p + __builtin_ctz(mask);
+        }
+        p += 16;
+    }
+    return FindCRLFScalar(p, end);
+}
+
+__attribute__((target("sse2")))
+const char *FindCRLFCRLFSSE2(const char *p, const char *end)
+{
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i lf = _mm_set1_epi8('\n');
+    while (end - p >= 19)
+    {
+        __m128i m = _mm_and_si128(
+            _mm_and_si128(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)), cr),
+                          _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 1)), lf)),
+            _mm_and_si128(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 2)), cr),
+                          _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 3)), lf)));
+        int mask = _mm_movemask_epi8(m);
+        if (mask)
+        {
+            return p + __builtin_ctz(mask);
+        }
+        p += 16;
+    }
+    return FindCRLFCRLFScalar(p, end);
+}
+
+__attribute__((target("sse2")))
+const char *FindAnyOfSSE2(const char *p, const char *end, const char *set, size_t setLen)
+{
+    __m128i sv[BufferBase::MAX_SCAN_SET];
+    for (size_t i = 0; i < setLen; i++)
+    {
+        sv[i] = _mm_set1_epi8(set[i]);
+    }
+    while (end - p >= 16)
+    {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        __m128i m = _mm_setzero_si128();
+        for (size_t i = 0; i < setLen; i++)
+        {
+            m = _mm_or_si128(m, _mm_cmpeq_epi8(a, sv[i]));
+        }
+        int mask = _mm_movemask_epi8(m);
+        if (mask)
+        {
+            return p + __builtin_ctz(mask);
+        }
+        p += 16;
+    }
+    return FindAnyOfScalar(p, end, set, setLen);
+}
+
+// ---------------- AVX2 版本（运行时检测到才使用） ----------------
+
+__attribute__((target("avx2")))
+const char *FindCRLFAVX2(const char *p, const char *end)
+{
+    const __m256i cr = _mm256_set1_epi8('\r');
+    const __m256i lf = _mm256_set1_epi8('\n');
+    while (end - p >= 33)
+    {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 1));
+        unsigned mask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(a, cr), _mm256_cmpeq_epi8(b, lf)));
+        if (mask)
+        {
+            return p + __builtin_ctz(mask);
+        }
+        p += 32;
+    }
+    return FindCRLFSSE2(p, end);
+}
+
+__attribute__((target("avx2")))
+const char *FindCRLFCRLFAVX2(const char *p, const char *end)
+{
+    const __m256i cr = _mm256_set1_epi8('\r');
+    const __m256i lf = _mm256_set1_epi8('\n');
+    while (end - p >= 35)
+    {
+        __m256i m = _mm256_and_si256(
+            _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)), cr),
+                             _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 1)), lf)),
+            _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 2)), cr),
+                             _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 3)), lf)));
+        unsigned mask = _mm256_movemask_epi8(m);
+        if (mask)
+        {
+            return p + __builtin_ctz(mask);
+        }
+        p += 32;
+    }
+    return FindCRLFCRLFSSE2(p, end);
+}
+
+__attribute__((target("avx2")))
+const char *FindAnyOfAVX2(const char *p, const char *end, const char *set, size_t setLen)
+{
+    __m256i sv[BufferBase::MAX_SCAN_SET];
+    for (size_t i = 0; i < setLen; i++)
+    {
+        sv[i] = _mm256_set1_epi8(set[i]);
+    }
+    while (end - p >= 32)
+    {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        __m256i m = _mm256_setzero_si256();
+        for (size_t i = 0; i < setLen; i++)
+        {
+            m = _mm256_or_si256(m, _mm256_cmpeq_epi8(a, sv[i]));
+        }
+        unsigned mask = _mm256_movemask_epi8(m);
+        if (mask)
+        {
+            return p + __builtin_ctz(mask);
+        }
+        p += 32;
+    }
+    return FindAnyOfSSE2(p, end, set, setLen);
+}
+
+#endif // BUFFER_SCAN_X86
+
+#ifdef BUFFER_SCAN_NEON
+
+// ---------------- NEON 版本 ----------------
+
+// NEON没有movemask，把比较结果每个字节压缩成4位，得到64位掩码
+inline uint64_t NeonMask(uint8x16_t cmp)
+{
+    uint8x8_t res = vshrn_n_u16(vreinterpretq_u16_u8(cmp), 4);
+    return vget_lane_u64(vreinterpret_u64_u8(res), 0);
+}
+
+inline uint8x16_t NeonLoad(const char *p)
+{
+    return vld1q_u8(reinterpret_cast<const uint8_t *>(p));
+}
+
+const char *FindCRLFNEON(const char *p, const char *end)
+{
+    const uint8x16_t cr = vdupq_n_u8('\r');
+    const uint8x16_t lf = vdupq_n_u8('\n');
+    while (end - p >= 17)
+    {
+        uint64_t mask = NeonMask(vandq_u8(vceqq_u8(NeonLoad(p), cr), vceqq_u8(NeonLoad(p + 1), lf)));
+        if (mask)
+        {
+            return p + (__builtin_ctzll(mask) >> 2);
+        }
+        p += 16;
+    }
+    return FindCRLFScalar(p, end);
+}
+
+const char *FindCRLFCRLFNEON(const char *p, const char *end)
+{
+    const uint8x16_t cr = vdupq_n_u8('\r');
+    const uint8x16_t lf = vdupq_n_u8('\n');
+    while (end - p >= 19)
+    {
+        uint8x16_t m = vandq_u8(vandq_u8(vceqq_u8(NeonLoad(p), cr), vceqq_u8(NeonLoad(p + 1), lf)),
+                                vandq_u8(vceqq_u8(NeonLoad(p + 2), cr), vceqq_u8(NeonLoad(p + 3), lf)));
+        uint64_t mask = NeonMask(m);
+        if (mask)
+        {
+            return p + (__builtin_ctzll(mask) >> 2);
+        }
+        p += 16;
+    }
+    return FindCRLFCRLFScalar(p, end);
+}
+
+const char *FindAnyOfNEON(const char *p, const char *end, const char *set, size_t setLen)
+{
+    uint8x16_t sv[BufferBase::MAX_SCAN_SET];
+    for (size_t i = 0; i < setLen; i++)
+    {
+        sv[i] = vdupq_n_u8(static_cast<uint8_t>(set[i]));
+    }
+    while (end - p >= 16)
+    {
+        uint8x16_t a = NeonLoad(p);
+        uint8x16_t m = vdupq_n_u8(0);
+        for (size_t i = 0; i < setLen; i++)
+        {
+            m = vorrq_u8(m, vceqq_u8(a, sv[i]));
+        }
+        uint64_t mask = NeonMask(m);
+        if (mask)
+        {
+            return p + (__builtin_ctzll(mask) >> 2);
+        }
+        p += 16;
+    }
+    return FindAnyOfScalar(p, end, set, setLen);
+}
+
+#endif // BUFFER_SCAN_NEON
+
+// ---------------- 运行时选择 ----------------
+
+struct ScanImpl
+{
+    ScanFn crlf;
+    ScanFn crlfcrlf;
+    AnyOfFn anyOf;
+};
+
+ScanImpl SelectImpl()
+{
+#if defined(BUFFER_SCAN_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return {FindCRLFAVX2, FindCRLFCRLFAVX2, FindAnyOfAVX2};
+    }
+    if (__builtin_cpu_supports("sse2"))
+    {
+        return {FindCRLFSSE2, FindCRLFCRLFSSE2, FindAnyOfSSE2};
+    }
+#elif defined(BUFFER_SCAN_NEON)
+    return {FindCRLFNEON, FindCRLFCRLFNEON, FindAnyOfNEON};
+#endif
+    return {FindCRLFScalar, FindCRLFCRLFScalar, FindAnyOfScalar};
+}
+
+// 第一次使用时检测一次CPU特性，之后只是一次函数指针调用
+const ScanImpl &Impl()
+{
+    static const ScanImpl impl = SelectImpl();
+    return impl;
+}
+
+} // namespace
+
+const char *BufferBase::FindCRLF(const char *begin, const char *end)
+{
+    assert(begin <= end);
+    return Impl().crlf(begin, end);
+}
+
+const char *BufferBase::FindCRLFCRLF(const char *begin, const char *end)
+{
+    assert(begin <= end);
+    return Impl().crlfcrlf(begin, end);
+}
+
+const char *BufferBase::FindAnyOf(const char *begin, const char *end, const char *set, size_t setLen)
+{
+    assert(begin <= end && set && setLen > 0 && setLen <= MAX_SCAN_SET);
+    return Impl().anyOf(begin, end, set, setLen);
+}
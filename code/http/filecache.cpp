@@ -0,0 +1,240 @@
+#include "filecache.h"
+#include "httpresponse.h"
+
+using namespace std;
+
+FileEntry::FileEntry() : fd(-1), data(nullptr), checkedAt(0), totalBytes(0) {
+    st = { 0 };
+}
+
+FileEntry::~FileEntry() {
+    // 最后一个引用释放时才解除映射、关闭文件
+    if(data) { munmap(data, st.st_size); }
+    if(fd >= 0) { close(fd); }
+}
+
+FileCache::FileCache() : budget_(0), used_(0), mapFiles_(true), hits_(0), misses_(0) {}
+
+FileCache* FileCache::Instance() {
+    static FileCache cache;
+    return &cache;
+}
+
+void FileCache::Init(size_t budgetBytes, bool mapFiles) {
+    lock_guard<mutex> locker(mtx_);
+    budget_ = budgetBytes;
+    mapFiles_ = mapFiles;
+    lru_.clear();
+    map_.clear();
+    used_ = 0;
+}
+
+void FileCache::SetBudget(size_t budgetBytes) {
+    lock_guard<mutex> locker(mtx_);
+    budget_ = budgetBytes;
+    Evict_();
+}
+
+int64_t FileCache::NowMs_() {
+    return chrono::duration_cast<chrono::milliseconds>(
+                chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+FileEntryPtr FileCache::Get(const string& path, int* err) {
+    assert(err);
+    FileEntryPtr entry;
+    if(budget_ > 0) {
+        // 命中时只在锁内做一次哈希查找和链表移动
+        lock_guard<mutex> locker(mtx_);
+        auto it = map_.find(path);
+        if(it != map_.end()) {
+            entry = *it->second;
+            lru_.splice(lru_.begin(), lru_, it->second);
+        }
+    }
+    if(entry) {
+        if(IsFresh_(*entry, NowMs_())) {
+            hits_++;
+            return entry;
+        }
+        // 文件已被修改，移除旧条目（借出的旧条目在引用释放后才关闭）
+        LOG_DEBUG("FileCache: %s changed, reload", path.c_str());
+        lock_guard<mutex> locker(mtx_);
+        auto it = map_.find(path);
+        if(it != map_.end() && *it->second == entry) {
+            used_ -= entry->totalBytes;
+            lru_.erase(it->second);
+            map_.erase(it);
+        }
+    }
+
+    misses_++;
+    // 打开文件和建立映射放在锁外进行
+    entry = Load_(path, err);
+    if(!entry || budget_ == 0 || entry->totalBytes > budget_) {
+        return entry;
+    }
+
+    lock_guard<mutex> locker(mtx_);
+    if(map_.count(path) == 0) {
+        lru_.push_front(entry);
+        map_[path] = lru_.begin();
+        used_ += entry->totalBytes;
+        Evict_();
+    }
+    return entry;
+}
+
+shared_ptr<FileEntry> FileCache::Open_(const string& path, int* err) {
+    shared_ptr<FileEntry> entry = make_shared<FileEntry>();
+    entry->path = path;
+    entry->fd = open(path.data(), O_RDONLY | O_CLOEXEC);
+    if(entry->fd < 0) {
+        *err = errno;
+        return nullptr;
+    }
+    if(fstat(entry->fd, &entry->st) < 0) {
+        *err = errno;
+        return nullptr;
+    }
+    // 目录视为不存在，其他用户不可读视为禁止访问
+    if(S_ISDIR(entry->st.st_mode)) {
+        *err = EISDIR;
+        return nullptr;
+    }
+    if(!(entry->st.st_mode & S_IROTH)) {
+        *err = EACCES;
+        return nullptr;
+    }
+    if(mapFiles_ && entry->st.st_size > 0) {
+        // MAP_PRIVATE 建立一个写入时拷贝的私有映射
+        void* mmRet = mmap(0, entry->st.st_size, PROT_READ, MAP_PRIVATE, entry->fd, 0);
+        if(mmRet == MAP_FAILED) {
+            *err = errno;
+            return nullptr;
+        }
+        entry->data = static_cast<char*>(mmRet);
+    }
+    entry->totalBytes = entry->st.st_size;
+    entry->checkedAt = NowMs_();
+    return entry;
+}
+
+// 生成 Content-length 及结尾空行
+static void AppendContentLength(string* header, off_t size) {
+    char length[Buffer::MAX_UINT_DIGITS];
+    *header += "Content-length: ";
+    header->append(length, Buffer::FormatUInt(size, length));
+    *header += "\r\n\r\n";
+}
+
+// 由stat结果生成ETag和Last-Modified，再拼出各种响应共用的头部片段
+static void BuildHeaders(FileEntry* entry, const string& contentType, const char* encoding,
+                         bool vary, bool ranges) {
+    // 修改时间精确到纳秒，同一秒内改写的文件也能区分
+    char buf[64];
+    int n = snprintf(buf, sizeof(buf), "\"%lx.%lx-%lx\"", (unsigned long)entry->st.st_mtim.tv_sec,
+                     (unsigned long)entry->st.st_mtim.tv_nsec, (unsigned long)entry->st.st_size);
+    entry->etag.assign(buf, n);
+    struct tm t;
+    gmtime_r(&entry->st.st_mtim.tv_sec, &t);
+    entry->lastModified.assign(buf, strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", &t));
+
+    entry->validators = "ETag: " + entry->etag + "\r\nLast-Modified: " + entry->lastModified + "\r\n";
+    // 有压缩版本时，未压缩的响应也要告诉缓存按Accept-Encoding区分
+    if(vary) {
+        entry->validators += "Vary: Accept-Encoding\r\n";
+    }
+    entry->prefix = contentType;
+    if(encoding) {
+        entry->prefix += "Content-Encoding: ";
+        entry->prefix += encoding;
+        entry->prefix += "\r\n";
+    }
+    entry->prefix += entry->validators;
+    if(ranges) {
+        entry->prefix += "Accept-Ranges: bytes\r\n";
+    }
+    entry->header = entry->prefix;
+    AppendContentLength(&entry->header, entry->st.st_size);
+}
+
+FileEntryPtr FileCache::Load_(const string& path, int* err) {
+    shared_ptr<FileEntry> entry = Open_(path, err);
+    if(!entry) {
+        return nullptr;
+    }
+    entry->mime = HttpResponse::MimeType(path);
+    entry->br = LoadVariant_(*entry, ".br", "br");
+    entry->gzip = LoadVariant_(*entry, ".gz", "gzip");
+    BuildHeaders(entry.get(), HttpResponse::ContentTypeHeader(path), nullptr,
+                 entry->br || entry->gzip, true);
+    if(entry->br) { entry->totalBytes += entry->br->totalBytes; }
+    if(entry->gzip) { entry->totalBytes += entry->gzip->totalBytes; }
+    return entry;
+}
+
+shared_ptr<const FileEntry> FileCache::LoadVariant_(const FileEntry& origin, const char* suffix,
+                                                    const char* encoding) {
+    int err = 0;
+    shared_ptr<FileEntry> variant = Open_(origin.path + suffix, &err);
+    if(!variant) {
+        return nullptr;
+    }
+    // 比原文件旧的压缩文件可能已经过期，宁可发送未压缩的原文件；压缩后没有变小的也不用
+    if(variant->st.st_mtime < origin.st.st_mtime || variant->st.st_size >= origin.st.st_size) {
+        LOG_WARN("FileCache: ignore %s (stale or not smaller)", variant->path.c_str());
+        return nullptr;
+    }
+    // 类型沿用原文件，另加编码头；ETag取自压缩文件本身，与原文件不同。Range请求总是发送原文件，压缩版本不通告Accept-Ranges
+    variant->mime = origin.mime;
+    BuildHeaders(variant.get(), HttpResponse::ContentTypeHeader(origin.path), encoding, true, false);
+    return variant;
+}
+
+bool FileCache::IsFresh_(const FileEntry& entry, int64_t nowMs) {
+    int64_t checked = entry.checkedAt.load(memory_order_relaxed);
+    if(nowMs - checked < REVALIDATE_MS) {
+        return true;
+    }
+    // 同一时间只让一个线程去stat
+    if(!entry.checkedAt.compare_exchange_strong(checked, nowMs)) {
+        return true;
+    }
+    struct stat st;
+    // 压缩版本与原文件一起校验，任何一个变化都整体重新加载
+    const FileEntry* files[] = { &entry, entry.br.get(), entry.gzip.get() };
+    for(const FileEntry* file : files) {
+        if(!file) { continue; }
+        if(stat(file->path.data(), &st) < 0) {
+            return false;
+        }
+        if(st.st_ino != file->st.st_ino || st.st_size != file->st.st_size ||
+           st.st_mtim.tv_sec != file->st.st_mtim.tv_sec ||
+           st.st_mtim.tv_nsec != file->st.st_mtim.tv_nsec) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void FileCache::Evict_() {
+    while(used_ > budget_ && !lru_.empty()) {
+        FileEntryPtr victim = lru_.back();
+        used_ -= victim->totalBytes;
+        map_.erase(victim->path);
+        lru_.pop_back();
+    }
+}
+
+void FileCache::Clear() {
+    lock_guard<mutex> locker(mtx_);
+    lru_.clear();
+    map_.clear();
+    used_ = 0;
+}
+
+size_t FileCache::UsedBytes() {
+    lock_guard<mutex> locker(mtx_);
+    return used_;
+}
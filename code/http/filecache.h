@@ -0,0 +1,139 @@
+#ifndef FILE_CACHE_H
+#define FILE_CACHE_H
+
+#include <string>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <unordered_map>
+#include <fcntl.h>       // open
+#include <unistd.h>      // close
+#include <errno.h>
+#include <sys/stat.h>    // stat
+#include <sys/mman.h>    // mmap, munmap
+#include <time.h>        // gmtime_r, strftime
+
+#include "../log/log.h"
+
+/**
+ * @brief 文件缓存中的一个条目，创建后只读，可在多个线程间共享。
+ */
+struct FileEntry {
+    std::string path;           // 文件的完整路径
+    struct stat st;             // 文件状态
+    int fd;                     // 打开的文件描述符（sendfile直接使用，带显式偏移，可多线程共享）
+    char* data;                 // 文件的只读内存映射，未映射时为nullptr
+    std::string mime;           // MIME类型
+    std::string etag;           // 由mtime和大小生成的强校验值（带引号），如 "\"65f0c1a2.1b3c-2a00\""
+    std::string lastModified;   // RFC 1123格式的修改时间，如 "Tue, 12 Mar 2024 08:00:00 GMT"
+    std::string validators;     // 预先生成的 "ETag: ...\r\nLast-Modified: ...\r\n[Vary]"，304响应只发送这些头
+    std::string prefix;         // 除Content-length外的全部实体头（Content-type、编码、validators、Accept-Ranges）
+    std::string header;         // prefix + "Content-length: ...\r\n\r\n"，完整的200响应头
+    mutable std::atomic<int64_t> checkedAt;    // 上次校验mtime的时间（毫秒）
+    // 预压缩的兄弟文件（path.gz / path.br），和本条目一起加载，不单独进入缓存；没有时为nullptr
+    std::shared_ptr<const FileEntry> gzip;
+    std::shared_ptr<const FileEntry> br;
+    size_t totalBytes;          // 本条目及压缩版本的总字节数，计入缓存预算
+
+    FileEntry();
+    ~FileEntry();
+};
+
+typedef std::shared_ptr<const FileEntry> FileEntryPtr;
+
+/**
+ * @brief 进程级静态文件缓存。
+ *
+ * 以完整路径为key缓存打开的文件描述符、内存映射、stat结果、MIME类型和预先生成的响应头，
+ * 条目通过shared_ptr引用计数，HttpResponse只借用条目，不再自己open/mmap/munmap。
+ * 条目最多每隔REVALIDATE_MS重新stat一次，发现mtime/大小/inode变化就重新加载；
+ * 缓存总字节数受预算限制，超出时按LRU淘汰，单个超过预算的文件不进入缓存（用完即释放）。
+ * 加载文件时顺带查找预先压缩好的 path.br / path.gz（不比原文件旧才使用），挂在条目上供HttpResponse按
+ * Accept-Encoding选择；请求路径上从不压缩，兄弟文件的增删在原文件变化重新加载时才生效。
+ * ETag/Last-Modified也在加载时由stat结果生成，条件请求和Range请求不需要再访问文件系统。
+ */
+class FileCache {
+public:
+    static FileCache* Instance();
+
+    /**
+     * @brief 初始化缓存
+     * @param budgetBytes 缓存文件的总字节数上限，为0时不缓存（每次都重新打开）
+     * @param mapFiles 是否为文件建立内存映射（mmap + writev 发送时需要，sendfile 发送时不需要）
+     */
+    void Init(size_t budgetBytes, bool mapFiles);
+
+    /**
+     * @brief 调整字节预算（配置重载），超出新预算的条目按LRU立即淘汰
+     */
+    void SetBudget(size_t budgetBytes);
+
+    /**
+     * @brief 获取文件条目，未命中时加载
+     * @param path 文件的完整路径
+     * @param err 失败时保存errno（ENOENT/EISDIR/EACCES等）
+     * @return 文件条目，失败时为nullptr
+     */
+    FileEntryPtr Get(const std::string& path, int* err);
+
+    /**
+     * @brief 清空缓存（已借出的条目在最后一个引用释放时才真正关闭）
+     */
+    void Clear();
+
+    size_t UsedBytes();
+    size_t Hits() const { return hits_; }
+    size_t Misses() const { return misses_; }
+
+private:
+    FileCache();
+    ~FileCache() = default;
+
+    /**
+     * @brief 打开文件并创建条目
+     */
+    FileEntryPtr Load_(const std::string& path, int* err);
+
+    /**
+     * @brief 加载原文件的预压缩版本，不存在或比原文件旧时返回nullptr
+     * @param origin 原文件条目
+     * @param suffix 兄弟文件后缀（".gz" / ".br"）
+     * @param encoding Content-Encoding的值
+     */
+    std::shared_ptr<const FileEntry> LoadVariant_(const FileEntry& origin, const char* suffix,
+                                                  const char* encoding);
+
+    /**
+     * @brief 打开文件、fstat并按需建立内存映射，不生成响应头
+     */
+    std::shared_ptr<FileEntry> Open_(const std::string& path, int* err);
+
+    /**
+     * @brief 条目是否与磁盘上的文件一致（按时间间隔节流）
+     */
+    bool IsFresh_(const FileEntry& entry, int64_t nowMs);
+
+    /**
+     * @brief 按LRU淘汰，直到总字节数不超过预算，调用者需持有锁
+     */
+    void Evict_();
+
+    static int64_t NowMs_();
+
+    static const int REVALIDATE_MS = 1000;  // mtime校验间隔
+
+    typedef std::list<FileEntryPtr> LruList;
+
+    std::atomic<size_t> budget_; // 字节预算，Get在锁外读取
+    size_t used_;           // 已缓存的字节数
+    bool mapFiles_;         // 是否建立内存映射
+    LruList lru_;           // 表头为最近使用
+    std::unordered_map<std::string, LruList::iterator> map_;
+    std::mutex mtx_;
+    std::atomic<size_t> hits_;
+    std::atomic<size_t> misses_;
+};
+
+#endif //FILE_CACHE_H
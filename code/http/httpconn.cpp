@@ -7,11 +7,19 @@ const char *HttpConn::srcDir;
 std::atomic<int> HttpConn::userCount;
 // 静态成员变量，指示是否使用ET模式
 bool HttpConn::isET;
+// 静态成员变量，指示是否用sendfile发送文件
+bool HttpConn::useSendfile = false;
+// 静态成员变量，每个长连接最多处理的请求数
+std::atomic<int> HttpConn::keepAliveMax(0);
+// 静态成员变量，长连接空闲超时（毫秒）
+std::atomic<int> HttpConn::keepAliveTimeoutMS(0);
+// 静态成员变量，服务器是否正在排空
+std::atomic<bool> HttpConn::draining(false);
 
 /**
  * @brief 默认构造函数，初始化成员变量
  */
-HttpConn::HttpConn()
+HttpConn::HttpConn() : readBuff_(0), writeBuff_(0)
 {
     // 初始化文件描述符为-1，表示未连接
     fd_ = -1;
@@ -19,6 +27,19 @@ HttpConn::HttpConn()
     addr_ = {0};
     // 初始化连接状态为关闭
     isClose_ = true;
+    gen_ = 0;
+    keepAlive_ = false;
+    requestCount_ = 0;
+    owner_ = nullptr;
+    verifyPending_ = false;
+    // 初始化待发送的数据为空
+    chunkHead_ = 0;
+    toWrite_ = 0;
+    sentBytes_ = 0;
+    reqStartUs_ = 0;
+    readUs_ = 0;
+    memset(&trace_, 0, sizeof(trace_));
+    accessHead_ = 0;
 };
 
 /**
@@ -34,8 +55,9 @@ HttpConn::~HttpConn()
  * @brief 初始化连接
  * @param fd 文件描述符
  * @param addr 地址结构体
+ * @param owner 连接的所属者
  */
-void HttpConn::init(int fd, const sockaddr_in &addr)
+void HttpConn::init(int fd, const sockaddr_in &addr, ConnOwner *owner)
 {
     // 确保文件描述符有效
     assert(fd > 0);
@@ -49,8 +71,25 @@ void HttpConn::init(int fd, const sockaddr_in &addr)
     writeBuff_.RetrieveAll();
     // 清空读缓冲区
     readBuff_.RetrieveAll();
-    // 设置连接状态为打开
+    // 清空上一个连接残留的待发送数据和解析状态
+    chunks_.clear();
+    chunkHead_ = 0;
+    toWrite_ = 0;
+    sentBytes_ = 0;
+    accessPending_.clear();
+    accessHead_ = 0;
+    request_.Init();
+    keepAlive_ = false;
+    requestCount_ = 0;
+    owner_ = owner;
+    verifyPending_ = false;
+    reqStartUs_ = 0;
+    readUs_ = 0;
+    memset(&trace_, 0, sizeof(trace_));
+    // 设置连接状态为打开，代数加一，之前投递的定时器和任务都失效
     isClose_ = false;
+    gen_.fetch_add(1, std::memory_order_release);
+    Metrics::Add(METRIC_ACCEPTS);
     // 记录日志
     LOG_INFO("Client[%d](%s:%d) in, userCount:%d", fd_, GetIP(), GetPort(), (int)userCount);
 }
@@ -60,13 +99,26 @@ void HttpConn::init(int fd, const sockaddr_in &addr)
  */
 void HttpConn::Close()
 {
-    // 取消文件映射
+    // 取消文件映射，释放写队列中借用的文件
     response_.UnmapFile();
+    chunks_.clear();
+    chunkHead_ = 0;
+    toWrite_ = 0;
+    // 没发送完的响应不记访问日志
+    accessPending_.clear();
+    accessHead_ = 0;
+    // 缓冲区内存还给内存池，关闭后的连接对象不占用缓冲区
+    readBuff_.RetrieveAll();
+    readBuff_.Shrink();
+    writeBuff_.RetrieveAll();
+    writeBuff_.Shrink();
     // 如果连接未关闭
     if (isClose_ == false)
     {
-        // 设置连接状态为关闭
+        // 设置连接状态为关闭，代数加一
         isClose_ = true;
+        gen_.fetch_add(1, std::memory_order_release);
+        owner_.store(nullptr, std::memory_order_relaxed);
         // 减少用户计数
         userCount--;
         // 关闭文件描述符
@@ -119,6 +171,11 @@ int HttpConn::GetPort() const
  */
 ssize_t HttpConn::read(int *saveErrno)
 {
+    // 读之前缓冲区是空的，这次读到的是一个新请求的开头，耗时从这里算起
+    if (readBuff_.ReadableBytes() == 0 && Metrics::Instance()->IsEnabled())
+    {
+        readUs_ = Metrics::NowUs();
+    }
     ssize_t len = -1;
     do
     {
@@ -133,86 +190,473 @@ ssize_t HttpConn::read(int *saveErrno)
 }
 
 /**
- * @brief 将数据从写缓冲区写入文件描述符
+ * @brief 发送写队列中的数据
+ *
+ * 队列头部连续的缓冲区/内存段用一次sendmsg聚合发送；后面紧跟sendfile文件段时带上MSG_MORE，
+ * 提示内核与随后的文件数据合并成满MSS的报文；队列头部是文件段时用sendfile发送。
+ *
  * @param saveErrno 保存错误码的指针
- * @return 写入的字节数
+ * @return 最后一次发送的字节数
  */
 ssize_t HttpConn::write(int *saveErrno)
 {
+    if (toWrite_ == 0)
+    {
+        return 0;
+    }
     ssize_t len = -1;
     do
     {
-        // 将iov的内容写到fd中
-        len = writev(fd_, iov_, iovCnt_);
+        WriteChunk &front = chunks_[chunkHead_];
+        // 返回0时errno不会被设置，先清掉，避免把之前读循环留下的EAGAIN当成本次的错误
+        errno = 0;
+        if (front.type == WriteChunk::FILE)
+        {
+            // sendfile会推进front.offset
+            len = sendfile(fd_, front.file->fd, &front.offset, front.len);
+        }
+        else
+        {
+            struct iovec iov[MAX_IOV];
+            bool more = false;
+            int cnt = GatherIov(iov, MAX_IOV, &more);
+            struct msghdr msg = {};
+            msg.msg_iov = iov;
+            msg.msg_iovlen = cnt;
+            len = sendmsg(fd_, &msg, MSG_NOSIGNAL | (more ? MSG_MORE : 0));
+        }
+        if (len == 0 && front.type == WriteChunk::FILE)
+        {
+            // 缓存的文件在加载后被截短，已经发不完响应头声明的长度，当作错误让调用者关闭连接
+            *saveErrno = EIO;
+            break;
+        }
         if (len <= 0)
         {
             *saveErrno = errno;
             break;
         }
-        if (iov_[0].iov_len + iov_[1].iov_len == 0)
+        Consume(len);
+        if (toWrite_ == 0)
         {
             break;
         } /* 传输结束 */
-        else if (static_cast<size_t>(len) > iov_[0].iov_len)
+    } while (isET || toWrite_ > 10240);
+    return len;
+}
+
+/**
+ * @brief 把写队列头部连续的缓冲区/内存段填入iovec
+ * @param iov 输出的iovec数组
+ * @param maxIov iov的容量
+ * @param more 这些数据段后面还有文件段时置为true
+ * @return 填入的iovec个数
+ */
+int HttpConn::GatherIov(struct iovec *iov, int maxIov, bool *more) const
+{
+    int cnt = 0;
+    *more = false;
+    const char *buff = writeBuff_.Peek();
+    for (size_t i = chunkHead_; i < chunks_.size() && cnt < maxIov; i++)
+    {
+        const WriteChunk &chunk = chunks_[i];
+        if (chunk.type == WriteChunk::FILE)
+        {
+            *more = true;
+            break;
+        }
+        if (chunk.type == WriteChunk::BUFFER)
         {
-            iov_[1].iov_base = (uint8_t *)iov_[1].iov_base + (len - iov_[0].iov_len);
-            iov_[1].iov_len -= (len - iov_[0].iov_len);
-            if (iov_[0].iov_len)
+            iov[cnt].iov_base = const_cast<char *>(buff);
+            buff += chunk.len;
+        }
+        else
+        {
+            iov[cnt].iov_base = const_cast<char *>(chunk.data);
+        }
+        iov[cnt].iov_len = chunk.len;
+        cnt++;
+    }
+    return cnt;
+}
+
+/**
+ * @brief 把收到的数据追加到读缓冲区
+ * @param data 数据
+ * @param len 字节数
+ */
+void HttpConn::AppendInput(const char *data, size_t len)
+{
+    if (readBuff_.ReadableBytes() == 0 && Metrics::Instance()->IsEnabled())
+    {
+        readUs_ = Metrics::NowUs();
+    }
+    readBuff_.Append(data, len);
+}
+
+/**
+ * @brief 记录一次读事件的派发和开始处理的时间
+ * @param dispatchTs 事件被派发的时间，0表示派发即开始处理
+ */
+void HttpConn::TraceEvent(uint64_t dispatchTs)
+{
+    if (!Trace::Instance()->IsEnabled() || (readBuff_.ReadableBytes() > 0 && trace_.ts[TRACE_TASK_START]))
+    {
+        return;
+    }
+    uint64_t now = Trace::Now();
+    trace_.ts[TRACE_DISPATCH] = dispatchTs ? dispatchTs : now;
+    trace_.ts[TRACE_TASK_START] = now;
+}
+
+/**
+ * @brief 从写队列头部移除已发送的数据
+ * @param len 已发送的字节数
+ */
+void HttpConn::Consume(size_t len)
+{
+    assert(len <= toWrite_);
+    toWrite_ -= len;
+    sentBytes_ += len;
+    Metrics::Add(METRIC_SENT_BYTES, len);
+    TRACE_PROBE2(write, fd_, len);
+    bool trace = Trace::Instance()->IsEnabled();
+    uint64_t nowTs = trace ? Trace::Now() : 0;
+    if (trace)
+    {
+        // 这次发出了第一个字节的响应（起点在已发送总量之前）记下首次发送的时间
+        for (size_t i = accessHead_; i < accessPending_.size() &&
+                                     accessPending_[i].end - accessPending_[i].record.bytes < sentBytes_; i++)
+        {
+            uint64_t &first = accessPending_[i].trace.ts[TRACE_FIRST_WRITE];
+            if (!first)
             {
-                writeBuff_.RetrieveAll();
-                iov_[0].iov_len = 0;
+                first = nowTs;
             }
         }
+    }
+    // 提交已完整发送的响应的访问日志，记录耗时
+    if (accessHead_ < accessPending_.size() && accessPending_[accessHead_].end <= sentBytes_)
+    {
+        bool accessLog = AccessLog::Instance()->IsOpen();
+        uint64_t now = accessLog ? AccessLog::NowUs() : 0;
+        uint64_t nowMono = Metrics::Instance()->IsEnabled() ? Metrics::NowUs() : 0;
+        while (accessHead_ < accessPending_.size() && accessPending_[accessHead_].end <= sentBytes_)
+        {
+            PendingAccess &pending = accessPending_[accessHead_];
+            if (pending.readUs)
+            {
+                Metrics::ObserveLatency(nowMono > pending.readUs ? nowMono - pending.readUs : 0);
+            }
+            if (trace)
+            {
+                pending.trace.ts[TRACE_LAST_WRITE] = nowTs;
+                Trace::Instance()->Finish(fd_, pending.trace, pending.record);
+            }
+            if (accessLog)
+            {
+                AccessRecord &record = pending.record;
+                record.latencyUs = now > record.timeUs ? static_cast<uint32_t>(now - record.timeUs) : 0;
+                AccessLog::Instance()->Append(record);
+            }
+            accessHead_++;
+        }
+        if (accessHead_ == accessPending_.size())
+        {
+            accessPending_.clear();
+            accessHead_ = 0;
+        }
+    }
+    while (len > 0)
+    {
+        WriteChunk &chunk = chunks_[chunkHead_];
+        size_t n = std::min(len, chunk.len);
+        if (chunk.type == WriteChunk::BUFFER)
+        {
+            writeBuff_.Retrieve(n);
+        }
+        else if (chunk.type == WriteChunk::MEMORY)
+        {
+            chunk.data += n;
+        }
+        chunk.len -= n;
+        len -= n;
+        if (chunk.len == 0)
+        {
+            chunk.file.reset();
+            chunkHead_++;
+        }
+    }
+    if (chunkHead_ == chunks_.size())
+    {
+        // 全部发送完，复用队列，写缓冲区的内存还给内存池
+        chunks_.clear();
+        chunkHead_ = 0;
+        writeBuff_.RetrieveAll();
+        writeBuff_.Shrink();
+    }
+}
+
+/**
+ * @brief 把刚生成的响应追加到写队列
+ * @param bytes 本次MakeResponse追加到写缓冲区的字节数
+ */
+void HttpConn::QueueResponse_(size_t bytes)
+{
+    if (bytes > 0)
+    {
+        // 与前一个响应的写缓冲区数据相邻时合并成一段
+        if (chunks_.size() > chunkHead_ && chunks_.back().type == WriteChunk::BUFFER)
+        {
+            chunks_.back().len += bytes;
+        }
         else
         {
-            iov_[0].iov_base = (uint8_t *)iov_[0].iov_base + len;
-            iov_[0].iov_len -= len;
-            writeBuff_.Retrieve(len);
+            chunks_.push_back({WriteChunk::BUFFER, bytes, nullptr, 0, nullptr});
         }
-    } while (isET || ToWriteBytes() > 10240);
-    return len;
+        toWrite_ += bytes;
+    }
+    size_t fileLen = response_.FileLen();
+    if (fileLen == 0)
+    {
+        return;
+    }
+    if (response_.FileFd() >= 0)
+    {
+        // sendfile模式，文件在write()中发送
+        chunks_.push_back({WriteChunk::FILE, fileLen, nullptr, response_.FileOffset(), response_.Entry()});
+    }
+    else if (response_.File())
+    {
+        chunks_.push_back({WriteChunk::MEMORY, fileLen, response_.File(), 0, response_.Entry()});
+    }
+    else
+    {
+        return;
+    }
+    toWrite_ += fileLen;
 }
 
 /**
- * @brief 处理HTTP请求
- * @return 处理结果
+ * @brief 为刚解析完的请求生成响应
+ * @param ok 请求格式是否正确
  */
-bool HttpConn::process()
+void HttpConn::Respond_(bool ok)
 {
-    // 初始化请求对象
-    request_.Init();
-    if (readBuff_.ReadableBytes() <= 0)
+    size_t before = writeBuff_.ReadableBytes();
+    size_t queued = toWrite_;
+    // 400时请求会被重置，先记下方法和路径
+    bool accessLog = AccessLog::Instance()->IsOpen();
+    bool metrics = Metrics::Instance()->IsEnabled();
+    bool trace = Trace::Instance()->IsEnabled();
+    if (accessLog || metrics || trace)
     {
-        return false;
+        BeginAccess_();
+        accessPending_.back().readUs = metrics ? (readUs_ ? readUs_ : Metrics::NowUs()) : 0;
     }
-    else if (request_.parse(readBuff_))
-    { // 解析成功
+    if (ok && metrics && request_.path() == Metrics::PATH)
+    {
+        // 指标不来自文件，当场生成
+        requestCount_++;
+        int maxRequests = keepAliveMax.load(std::memory_order_relaxed);
+        keepAlive_ = request_.IsKeepAlive() && !draining.load(std::memory_order_relaxed) &&
+                     (maxRequests <= 0 || requestCount_ < maxRequests);
+        response_.Init(srcDir, request_.path(), keepAlive_, 200, useSendfile);
+        response_.SetKeepAlive(maxRequests > 0 ? maxRequests - requestCount_ : 0,
+                               keepAliveTimeoutMS.load(std::memory_order_relaxed) / 1000);
+        response_.MakeContent(writeBuff_, Metrics::CONTENT_TYPE, Metrics::Instance()->Render());
+        readBuff_.Retrieve(request_.RequestLength());
+    }
+    else if (ok)
+    {
         // 记录日志
         LOG_DEBUG("%s", request_.path().c_str());
+        // 达到单连接请求数上限或服务器正在排空时，本次响应带上Connection: close
+        requestCount_++;
+        int maxRequests = keepAliveMax.load(std::memory_order_relaxed);
+        keepAlive_ = request_.IsKeepAlive() && !draining.load(std::memory_order_relaxed) &&
+                     (maxRequests <= 0 || requestCount_ < maxRequests);
         // 初始化响应对象
-        response_.Init(srcDir, request_.path(), request_.IsKeepAlive(), 200);
+        response_.Init(srcDir, request_.path(), keepAlive_, 200, useSendfile);
+        response_.SetKeepAlive(maxRequests > 0 ? maxRequests - requestCount_ : 0,
+                               keepAliveTimeoutMS.load(std::memory_order_relaxed) / 1000);
+        // 请求头切片在Retrieve之前有效
+        response_.SetAcceptEncoding(request_.AcceptEncoding());
+        response_.SetConditional(request_);
+        response_.MakeResponse(writeBuff_);
+        // 响应生成后请求头切片不再使用，丢弃该请求占用的数据
+        readBuff_.Retrieve(request_.RequestLength());
     }
     else
     {
-        // 初始化响应对象，状态码为400
-        response_.Init(srcDir, request_.path(), false, 400);
+        Metrics::Add(METRIC_PARSE_ERRORS);
+        // 初始化响应对象，状态码为400（请求体过大时为413）
+        keepAlive_ = false;
+        response_.Init(srcDir, request_.path(), false, request_.ErrorCode(), useSendfile);
+        response_.MakeResponse(writeBuff_);
+        // 格式错误时无法确定请求边界，丢弃全部数据，连接在响应后关闭
+        readBuff_.RetrieveAll();
+        request_.Init();
+    }
+    QueueResponse_(writeBuff_.ReadableBytes() - before);
+    Metrics::CountStatus(response_.Code());
+    TRACE_PROBE2(response__built, fd_, response_.Code());
+    if (accessLog || metrics || trace)
+    {
+        // 响应最后一个字节在本连接发送总量中的位置
+        PendingAccess &pending = accessPending_.back();
+        pending.end = sentBytes_ + toWrite_;
+        pending.record.bytes = static_cast<uint32_t>(toWrite_ - queued);
+        pending.record.status = static_cast<uint16_t>(response_.Code());
+        if (trace)
+        {
+            // 派发和开始处理的时间留给同一读事件中的下一个流水线请求
+            pending.trace = trace_;
+            pending.trace.ts[TRACE_RESPONSE_BUILT] = Trace::Now();
+            trace_.ts[TRACE_PARSE_DONE] = 0;
+            trace_.ts[TRACE_VERIFY_DONE] = 0;
+        }
+    }
+    // 文件已由写队列持有
+    response_.UnmapFile();
+}
+
+/**
+ * @brief 为当前请求新建一条待提交的访问日志
+ */
+void HttpConn::BeginAccess_()
+{
+    accessPending_.emplace_back();
+    AccessRecord &record = accessPending_.back().record;
+    memset(&record, 0, sizeof(record));
+    record.timeUs = reqStartUs_ ? reqStartUs_ : AccessLog::NowUs();
+    record.clientIp = addr_.sin_addr.s_addr;
+    record.clientPort = addr_.sin_port;
+    const std::string &method = request_.method();
+    const std::string &path = request_.path();
+    memcpy(record.method, method.data(), std::min(method.size(), sizeof(record.method)));
+    record.pathLen = static_cast<uint8_t>(std::min(path.size(), sizeof(record.path)));
+    memcpy(record.path, path.data(), record.pathLen);
+    reqStartUs_ = 0;
+}
+
+/**
+ * @brief 把当前请求的验证交给SqlExecutor
+ * @return 投递成功返回true
+ */
+bool HttpConn::SubmitVerify_()
+{
+    if (!owner_)
+    {
+        return false;
+    }
+    // 回调在数据库线程执行，只捕获值，不访问连接本身
+    ConnOwner *owner = owner_;
+    HttpConn *conn = this;
+    uint32_t gen = Generation();
+    std::string name = request_.GetPost("username");
+    std::string pwd = request_.GetPost("password");
+    bool isLogin = request_.IsLoginRequest();
+    verifyPending_ = true;
+    bool added = SqlExecutor::Instance()->AddTask([owner, conn, gen, name, pwd, isLogin](MYSQL *sql) {
+        owner->ResumeConn(conn, gen, HttpRequest::UserVerify(sql, name, pwd, isLogin));
+    });
+    if (!added)
+    {
+        verifyPending_ = false;
     }
+    return added;
+}
 
-    // 生成响应报文放入写缓冲区
-    response_.MakeResponse(writeBuff_);
-    // 响应头
-    iov_[0].iov_base = const_cast<char *>(writeBuff_.Peek());
-    iov_[0].iov_len = writeBuff_.ReadableBytes();
-    iovCnt_ = 1;
+/**
+ * @brief 异步验证完成，生成该请求的响应
+ * @param ok 验证结果
+ */
+void HttpConn::OnVerifyDone(bool ok)
+{
+    assert(verifyPending_ && request_.NeedsUserVerify());
+    verifyPending_ = false;
+    TraceMark_(TRACE_VERIFY_DONE);
+    TRACE_PROBE2(verify__done, fd_, ok);
+    // 等待期间读缓冲区可能扩容搬移过，重新定位请求（已完成的请求不会重新解析）
+    request_.parse(readBuff_);
+    request_.SetVerifyResult(ok);
+    Respond_(true);
+}
 
-    // 文件
-    if (response_.FileLen() > 0 && response_.File())
+/**
+ * @brief 处理读缓冲区中所有完整的HTTP请求
+ * @return 是否有待发送的响应
+ */
+bool HttpConn::process()
+{
+    // 等待验证结果期间不处理后面的请求，保证响应顺序
+    if (verifyPending_)
+    {
+        return false;
+    }
+    int handled = 0;
+    // 连接将要关闭时不再处理后面的请求
+    while (readBuff_.ReadableBytes() > 0 && handled < MAX_PIPELINE && (handled == 0 || keepAlive_))
+    {
+        // 上一个请求已处理完，开始解析新的请求（等待验证的请求保留）
+        if (request_.IsFinished() && !request_.NeedsUserVerify())
+        {
+            request_.Init();
+        }
+        if (!request_.parse(readBuff_))
+        {
+            Respond_(false);
+            handled++;
+            continue;
+        }
+        if (!request_.IsFinished())
+        { // 请求还不完整，留在读缓冲区继续等待数据
+            // 大请求体按Content-Length一次预留，后续数据直接读进缓冲区，不再逐级扩容搬移
+            if (request_.BodyPending() > 0)
+            {
+                readBuff_.EnsureWriteable(request_.BodyPending());
+            }
+            break;
+        }
+        // 访问日志的耗时从请求解析完成算起（等待验证后重新进入时保留第一次的时间）
+        if (reqStartUs_ == 0 && AccessLog::Instance()->IsOpen())
+        {
+            reqStartUs_ = AccessLog::NowUs();
+        }
+        if (!trace_.ts[TRACE_PARSE_DONE])
+        {
+            TraceMark_(TRACE_PARSE_DONE);
+            TRACE_PROBE2(parse__done, fd_, request_.path().c_str());
+        }
+        if (request_.NeedsUserVerify())
+        {
+            // 缓存命中时直接在当前线程得出结果，不经过数据库线程
+            if (!request_.VerifyFromCache())
+            {
+                // 前面的响应还没发完时先发送，写完后再投递，保证同一时刻只有一个线程在处理本连接
+                if (owner_ && toWrite_ > 0)
+                {
+                    break;
+                }
+                if (SubmitVerify_())
+                {
+                    break;
+                }
+                request_.VerifyUser();
+            }
+            TraceMark_(TRACE_VERIFY_DONE);
+        }
+        Respond_(true);
+        handled++;
+    }
+    // 读缓冲区处理完（或只剩一小段不完整的请求）时归还多余的内存，空闲连接几乎不占内存；
+    // 正在接收的请求体保留预留的空间
+    if (request_.BodyPending() == 0)
     {
-        iov_[1].iov_base = response_.File();
-        iov_[1].iov_len = response_.FileLen();
-        iovCnt_ = 2;
+        readBuff_.Shrink();
     }
     // 记录日志
-    LOG_DEBUG("filesize:%d, %d  to %d", response_.FileLen(), iovCnt_, ToWriteBytes());
-    return true;
+    LOG_DEBUG("pipelined %d, %d chunks to %d", handled, (int)(chunks_.size() - chunkHead_), (int)toWrite_);
+    return toWrite_ > 0;
 }
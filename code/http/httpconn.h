@@ -3,14 +3,44 @@
 
 #include <sys/types.h>
 #include <sys/uio.h>   // readv/writev
+#include <sys/sendfile.h> // sendfile
+#include <sys/socket.h> // send
 #include <arpa/inet.h> // sockaddr_in
 #include <stdlib.h>    // atoi()
 #include <errno.h>
+#include <vector>
+#include <algorithm>  // min
 
 #include "../log/log.h"
+#include "../log/accesslog.h"
+#include "../log/metrics.h"
+#include "../log/trace.h"
 #include "../buffer/buffer.h"
+#include "../pool/sqlexecutor.h"
 #include "httprequest.h"
 #include "httpresponse.h"
+
+class HttpConn;
+
+/**
+ * @brief 连接的所属者（主Reactor或从Reactor）
+ *
+ * 连接上的异步操作（数据库查询）在其他线程完成后，通过所属者把连接交回原来的线程继续处理。
+ */
+class ConnOwner
+{
+public:
+    virtual ~ConnOwner() = default;
+
+    /**
+     * @brief 异步验证完成，可在任意线程调用；所属者应在自己的线程里调用conn->OnVerifyDone(ok)
+     * @param conn 连接
+     * @param gen 投递时连接的代数，不一致时丢弃
+     * @param ok 验证结果
+     */
+    virtual void ResumeConn(HttpConn *conn, uint32_t gen, bool ok) = 0;
+};
+
 /*
 进行读写数据并调用httprequest 来解析数据以及httpresponse来生成响应
 */
@@ -31,8 +61,9 @@ public:
      * @brief 初始化连接
      * @param sockFd 文件描述符
      * @param addr 地址结构体
+     * @param owner 连接的所属者，为nullptr时登录/注册在当前线程同步访问数据库
      */
-    void init(int sockFd, const sockaddr_in &addr);
+    void init(int sockFd, const sockaddr_in &addr, ConnOwner *owner = nullptr);
 
     /**
      * @brief 从文件描述符读取数据到读缓冲区
@@ -48,6 +79,42 @@ public:
      */
     ssize_t write(int *saveErrno);
 
+    /**
+     * @brief 把写队列头部连续的缓冲区/内存段填入iovec，供调用者自己发送（如io_uring的SENDMSG）
+     *
+     * iovec指向写缓冲区和文件映射，在Consume()或process()之前有效；process()可能让写缓冲区扩容搬移，
+     * 因此发送完成之前不能调用process()。
+     *
+     * @param iov 输出的iovec数组
+     * @param maxIov iov的容量
+     * @param more 这些数据段后面还有文件段（sendfile模式）时置为true
+     * @return 填入的iovec个数，0表示队列头部是文件段或没有待发送的数据
+     */
+    int GatherIov(struct iovec *iov, int maxIov, bool *more) const;
+
+    /**
+     * @brief 从写队列头部移除已发送的len字节，提交发送完的响应的访问日志
+     * @param len 已发送的字节数
+     */
+    void Consume(size_t len);
+
+    /**
+     * @brief 把其他途径收到的数据（如io_uring provided buffer）追加到读缓冲区，之后调用process()
+     * @param data 数据
+     * @param len 字节数
+     */
+    void AppendInput(const char *data, size_t len);
+
+    /**
+     * @brief 记录一次读事件的派发和开始处理的时间（只在开启阶段计时时记录），在read()/AppendInput()之前调用
+     *
+     * 读缓冲区为空时这次读到的是新请求的开头，之后解析出的请求都以这两个时间为起点；
+     * 缓冲区里还有没处理完的请求时保留原来的时间。
+     *
+     * @param dispatchTs 事件被派发（投递到线程池）的时间，0表示派发即开始处理
+     */
+    void TraceEvent(uint64_t dispatchTs = 0);
+
     /**
      * @brief 关闭连接
      */
@@ -78,18 +145,51 @@ public:
     sockaddr_in GetAddr() const;
 
     /**
-     * @brief 处理HTTP请求
-     * @return 处理结果
+     * @brief 处理读缓冲区中所有完整的HTTP请求（支持流水线）
+     *
+     * 依次解析每个完整的请求并把响应按顺序追加到写队列，不完整的请求留在读缓冲区等待后续数据。
+     * 一次最多处理MAX_PIPELINE个请求，写完后再次调用以处理剩余的请求。
+     * 遇到登录/注册请求时把验证交给SqlExecutor并停在这个请求上（IsVerifyPending()），
+     * 此时调用者不应重新注册读写事件，等所属者调用OnVerifyDone()后再继续。
+     *
+     * @return 有待发送的响应时返回true
      */
     bool process();
 
+    /**
+     * @brief 是否在等待异步验证结果
+     */
+    bool IsVerifyPending() const
+    {
+        return verifyPending_;
+    }
+
+    /**
+     * @brief 异步验证完成，在连接所属的线程中调用，生成该请求的响应；之后调用者再调用process()
+     * @param ok 验证结果
+     */
+    void OnVerifyDone(bool ok);
+
     /**
      * @brief 计算待写入的总字节数
      * @return 待写入的总字节数
      */
-    int ToWriteBytes()
+    size_t ToWriteBytes() const
     {
-        return iov_[0].iov_len + iov_[1].iov_len;
+        return toWrite_;
+    }
+
+    /**
+     * @brief 获取连接的代数，每次init和Close都会加一
+     *
+     * 连接对象按fd复用，定时器回调和线程池任务记录投递时的代数，执行时代数不同说明连接已关闭
+     * 或fd已被新连接复用，应直接丢弃。
+     *
+     * @return 当前代数
+     */
+    uint32_t Generation() const
+    {
+        return gen_.load(std::memory_order_acquire);
     }
 
     /**
@@ -98,17 +198,111 @@ public:
      */
     bool IsKeepAlive() const
     {
-        return request_.IsKeepAlive();
+        return keepAlive_;
+    }
+
+    /**
+     * @brief 长连接是否空闲：读缓冲区中没有未处理的数据（包括不完整的请求）、没有待发送的响应、不在等待验证。
+     *        只在连接所属的线程中调用，排空时空闲的连接可以直接关闭。
+     */
+    bool IsIdle() const
+    {
+        return !verifyPending_ && toWrite_ == 0 && readBuff_.ReadableBytes() == 0;
+    }
+
+    /**
+     * @brief 连接的所属者，可在任意线程读取；连接关闭后为nullptr
+     *
+     * 所属的Reactor遍历连接表时据此找出自己的连接：它在本线程关闭连接时清空这个值，
+     * 读到自己说明连接仍由本线程处理。
+     */
+    ConnOwner *Owner() const
+    {
+        return owner_.load(std::memory_order_relaxed);
     }
 
     // 静态成员变量，指示是否使用ET模式
     static bool isET;
     // 静态成员变量，存储源目录
     static const char *srcDir;
+    // 静态成员变量，指示是否用sendfile发送文件（否则mmap + writev）
+    static bool useSendfile;
+    // 静态成员变量，每个长连接最多处理的请求数，小于等于0表示不限制（配置重载时修改）
+    static std::atomic<int> keepAliveMax;
+    // 静态成员变量，长连接空闲超时（毫秒），用于响应头中的通告，0表示不通告（配置重载时修改）
+    static std::atomic<int> keepAliveTimeoutMS;
     // 原子变量，记录当前连接的用户数量
     static std::atomic<int> userCount; // 原子，支持锁
+    // 静态成员变量，服务器正在排空（准备退出）时为true，之后的响应都带Connection: close
+    static std::atomic<bool> draining;
+    // 一次sendmsg最多聚合的数据段
+    static const int MAX_IOV = 64;
 
 private:
+    /**
+     * @brief 写队列中的一段待发送数据
+     */
+    struct WriteChunk
+    {
+        enum Type
+        {
+            BUFFER, // 写缓冲区中的数据（响应头、错误信息），按顺序从writeBuff_头部取
+            MEMORY, // 内存映射的文件内容
+            FILE,   // 用sendfile发送的文件内容
+        };
+        int type;
+        size_t len;          // 剩余未发送的字节数
+        const char *data;    // MEMORY: 下一个待发送的字节
+        off_t offset;        // FILE: 下一个待发送的文件偏移
+        FileEntryPtr file;   // MEMORY/FILE: 持有文件缓存条目，发送完才释放
+    };
+
+    /**
+     * @brief 一条还没发送完的响应，发送到end字节时提交访问日志、记录耗时
+     */
+    struct PendingAccess
+    {
+        uint64_t end;        // 响应最后一个字节在本连接发送总量中的位置
+        uint64_t readUs;     // 读到该请求第一个字节的时间（Metrics::NowUs），只在开启指标时记录
+        AccessRecord record;
+        TraceSpan trace;     // 各阶段的时间戳，只在开启阶段计时时记录
+    };
+
+    static const int MAX_PIPELINE = 32;   // 一次process最多处理的流水线请求数
+
+    /**
+     * @brief 把刚生成的响应（写缓冲区中新增的bytes字节 + 文件）追加到写队列
+     */
+    void QueueResponse_(size_t bytes);
+
+    /**
+     * @brief 为刚解析完的请求生成响应并追加到写队列
+     * @param ok 请求格式是否正确，否则回复400并丢弃读缓冲区
+     */
+    void Respond_(bool ok);
+
+    /**
+     * @brief 为当前请求新建一条访问日志（方法、路径、客户端），Respond_补上状态码和字节数，发送完再提交
+     */
+    void BeginAccess_();
+
+    /**
+     * @brief 开启阶段计时时记录当前请求到达某个阶段的时间
+     */
+    void TraceMark_(TracePhase phase)
+    {
+        if (Trace::Instance()->IsEnabled())
+        {
+            trace_.ts[phase] = Trace::Now();
+        }
+    }
+
+    /**
+     * @brief 把当前请求的验证交给SqlExecutor
+     * @return 投递成功返回true，否则调用者同步验证
+     */
+    bool SubmitVerify_();
+
     // 文件描述符
     int fd_;
     // 地址结构体
@@ -116,15 +310,38 @@ private:
 
     // 连接状态
     bool isClose_;
+    // 连接代数
+    std::atomic<uint32_t> gen_;
+    // 最后一个响应之后是否保持连接
+    bool keepAlive_;
+    // 本连接已处理的请求数
+    int requestCount_;
+    // 连接的所属者（关闭时清空，Reactor遍历连接表时在其他线程读取）
+    std::atomic<ConnOwner *> owner_;
+    // 是否在等待异步验证结果
+    bool verifyPending_;
+
+    // 写队列，按请求顺序排列，chunkHead_之前的已发送完
+    std::vector<WriteChunk> chunks_;
+    size_t chunkHead_;
+    // 写队列中剩余的总字节数
+    size_t toWrite_;
+    // 本连接已发送的总字节数
+    uint64_t sentBytes_;
 
-    // iovec结构体数量
-    int iovCnt_;
-    // iovec结构体数组
-    struct iovec iov_[2];
+    // 当前请求解析完成的时间（只在开启访问日志时记录）
+    uint64_t reqStartUs_;
+    // 读缓冲区中第一个字节到达的时间（只在开启指标时记录）
+    uint64_t readUs_;
+    // 当前请求（及所在读事件）各阶段的时间戳，响应生成后转入PendingAccess
+    TraceSpan trace_;
+    // 等待发送完成的访问日志，accessHead_之前的已提交
+    std::vector<PendingAccess> accessPending_;
+    size_t accessHead_;
 
-    // 读缓冲区
+    // 读缓冲区（内存来自BufferPool，连接空闲时归还）
     Buffer readBuff_;
-    // 写缓冲区
+    // 写缓冲区（内存来自BufferPool，响应发送完时归还）
     Buffer writeBuff_;
 
     // HTTP请求对象
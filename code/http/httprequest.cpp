@@ -15,73 +15,164 @@ const unordered_set<string> HttpRequest::DEFAULT_HTML{
 const unordered_map<string, int> HttpRequest::DEFAULT_HTML_TAG{
     {"/login.html", 1}, {"/register.html", 0}};
 
+std::atomic<size_t> HttpRequest::maxBodySize(0);
+
 // 初始化操作，一些清零操作
 void HttpRequest::Init()
 {
     state_ = REQUEST_LINE; // 初始状态
-    method_ = path_ = version_ = body_ = "";
-    header_.clear();
+    // clear()保留容量，长连接上的后续请求不再分配内存
+    method_.clear();
+    path_.clear();
+    version_.clear();
+    base_ = nullptr;
+    pos_ = 0;
+    scanPos_ = 0;
+    headComplete_ = false;
+    headers_.clear();
+    host_ = connection_ = contentType_ = acceptEncoding_ = {0, 0};
+    ifNoneMatch_ = ifModifiedSince_ = range_ = ifRange_ = {0, 0};
+    contentLength_ = 0;
+    hasContentLength_ = false;
+    chunked_ = false;
+    chunkState_ = CHUNK_SIZE;
+    chunkLeft_ = 0;
+    bodyOff_ = 0;
+    bodyLen_ = 0;
+    bodyPending_ = 0;
+    errorCode_ = 400;
+    keepAlive_ = false;
     post_.clear();
+    verifyTag_ = -1;
+    cacheMissed_ = false;
 }
 
-// 解析处理
+// 解析处理，状态机按行推进，数据不完整时停在当前状态等待下次调用
 bool HttpRequest::parse(Buffer &buff)
 {
-    const char END[] = "\r\n";
-    if (buff.ReadableBytes() == 0) // 没有可读的字节
-        return false;
-    // 读取数据开始
-    while (buff.ReadableBytes() && state_ != FINISH)
+    // 缓冲区可能因扩容搬移过，每次都重新取起始位置，已解析的内容按偏移保存
+    base_ = buff.BeginRead();
+    const char *end = buff.BeginWriteConst();
+    if (!headComplete_)
+    {
+        // 先确认请求头已完整（出现空行）再逐行解析，分多次到达的请求头不会被反复扫描
+        const char *headEnd = Buffer::FindCRLFCRLF(base_ + scanPos_, end);
+        if (headEnd == end)
+        {
+            size_t total = end - base_;
+            if (total > MAX_HEADER_SIZE)
+            {
+                LOG_ERROR("Request header too large");
+                return false;
+            }
+            // 下次从可能构成"\r\n\r\n"的最后3个字节处继续查找
+            scanPos_ = total > 3 ? total - 3 : 0;
+            return true;
+        }
+        headComplete_ = true;
+    }
+    while (state_ != FINISH)
     {
-        // 从buff中的读指针开始到读指针结束，这块区域是未读取得数据并去处"\r\n"，返回有效数据得行末指针
-        const char *lineend = search(buff.Peek(), buff.BeginWriteConst(), END, END + 2);
-        string line(buff.Peek(), lineend);
+        const char *begin = base_ + pos_;
+        if (state_ == BODY)
+        {
+            if (chunked_)
+            {
+                if (!ParseChunked_(end))
+                {
+                    return false;
+                }
+                if (state_ != FINISH)
+                { // 还有分块没收全
+                    return true;
+                }
+            }
+            else
+            {
+                size_t received = end - begin;
+                if (received < contentLength_)
+                { // 请求体还没收全；限制了请求体大小时才让调用者按剩余长度预留空间
+                    bodyPending_ = maxBodySize.load(std::memory_order_relaxed) ? contentLength_ - received : 0;
+                    return true;
+                }
+                bodyPending_ = 0;
+                bodyLen_ = contentLength_;
+                pos_ += contentLength_;
+                state_ = FINISH;
+            }
+            ParseBody_();
+            break;
+        }
+        const char *lineend = Buffer::FindCRLF(begin, end);
+        if (lineend == end)
+        { // 一行还没收全
+            if (static_cast<size_t>(end - begin) > MAX_LINE)
+            {
+                LOG_ERROR("Request line too long");
+                return false;
+            }
+            return true;
+        }
+        if (static_cast<size_t>(lineend - begin) > MAX_LINE)
+        {
+            LOG_ERROR("Request line too long");
+            return false;
+        }
         switch (state_)
         {
         case REQUEST_LINE:
-            // 解析错误
-            if (!ParseRequestLine_(line))
+            // 忽略请求行之前的空行
+            if (lineend != begin)
             {
-                return false;
+                if (!ParseRequestLine_(begin, lineend))
+                {
+                    return false;
+                }
+                ParsePath_(); // 解析路径
             }
-            ParsePath_(); // 解析路径
             break;
         case HEADERS:
-            ParseHeader_(line);
-            if (buff.ReadableBytes() <= 2)
-            {                    // 说明是get请求，后面为\r\n
-                state_ = FINISH; // 提前结束
+            if (lineend == begin)
+            { // 空行，请求头结束
+                if (!HeadersDone_())
+                {
+                    return false;
+                }
+            }
+            else if (!ParseHeader_(begin, lineend))
+            {
+                return false;
             }
-            break;
-        case BODY:
-            ParseBody_(line);
             break;
         default:
             break;
         }
-        if (lineend == buff.BeginWrite())
-        { // 读完了
-            buff.RetrieveAll();
-            break;
+        pos_ = lineend + 2 - base_; // 跳过回车换行
+        if (state_ == BODY)
+        {
+            bodyOff_ = pos_;
         }
-        buff.RetrieveUntil(lineend + 2); // 跳过回车换行
     }
     LOG_DEBUG("[%s], [%s], [%s]", method_.c_str(), path_.c_str(), version_.c_str());
     return true;
 }
 
-bool HttpRequest::ParseRequestLine_(const string &line)
+bool HttpRequest::ParseRequestLine_(const char *begin, const char *end)
 {
-    regex patten("^([^ ]*) ([^ ]*) HTTP/([^ ]*)$");
-    smatch Match; // 用来匹配patten得到结果
-    // 在匹配规则中，以括号()的方式来划分组别 一共三个括号 [0]表示整体
-    if (regex_match(line, Match, patten))
-    { // 匹配指定字符串整体是否符合
-        method_ = Match[1];
-        path_ = Match[2];
-        version_ = Match[3];
-        state_ = HEADERS;
-        return true;
+    // METHOD SP PATH SP HTTP/VERSION，各部分都不能为空且不含空格
+    const char *sp1 = static_cast<const char *>(memchr(begin, ' ', end - begin));
+    if (sp1 && sp1 > begin)
+    {
+        const char *sp2 = static_cast<const char *>(memchr(sp1 + 1, ' ', end - sp1 - 1));
+        if (sp2 && sp2 > sp1 + 1 && end - sp2 > 6 && memcmp(sp2 + 1, "HTTP/", 5) == 0 &&
+            !memchr(sp2 + 1, ' ', end - sp2 - 1))
+        {
+            method_.assign(begin, sp1);
+            path_.assign(sp1 + 1, sp2);
+            version_.assign(sp2 + 6, end);
+            state_ = HEADERS;
+            return true;
+        }
     }
     LOG_ERROR("RequestLine Error");
     return false;
@@ -103,189 +194,542 @@ void HttpRequest::ParsePath_()
     }
 }
 
-void HttpRequest::ParseHeader_(const string &line)
+bool HttpRequest::ParseHeader_(const char *begin, const char *end)
+{
+    const char *colon = static_cast<const char *>(memchr(begin, ':', end - begin));
+    if (!colon || colon == begin || headers_.size() >= MAX_HEADERS)
+    {
+        LOG_ERROR("Header Error");
+        return false;
+    }
+    // 去掉值两端的空白
+    const char *vbegin = colon + 1;
+    const char *vend = end;
+    while (vbegin < vend && (*vbegin == ' ' || *vbegin == '\t'))
+        vbegin++;
+    while (vend > vbegin && (vend[-1] == ' ' || vend[-1] == '\t'))
+        vend--;
+
+    HeaderField field;
+    field.name = {static_cast<uint32_t>(begin - base_), static_cast<uint32_t>(colon - begin)};
+    field.value = {static_cast<uint32_t>(vbegin - base_), static_cast<uint32_t>(vend - vbegin)};
+    headers_.push_back(field);
+
+    // 常用请求头按长度分派，避免逐个字符串比较
+    StrSlice name(begin, colon - begin);
+    switch (name.len)
+    {
+    case 4:
+        if (name.EqualsNoCase("Host"))
+            host_ = field.value;
+        break;
+    case 5:
+        if (name.EqualsNoCase("Range"))
+            range_ = field.value;
+        break;
+    case 8:
+        if (name.EqualsNoCase("If-Range"))
+            ifRange_ = field.value;
+        break;
+    case 10:
+        if (name.EqualsNoCase("Connection"))
+            connection_ = field.value;
+        break;
+    case 12:
+        if (name.EqualsNoCase("Content-Type"))
+            contentType_ = field.value;
+        break;
+    case 13:
+        if (name.EqualsNoCase("If-None-Match"))
+            ifNoneMatch_ = field.value;
+        break;
+    case 15:
+        if (name.EqualsNoCase("Accept-Encoding"))
+            acceptEncoding_ = field.value;
+        break;
+    case 17:
+        if (name.EqualsNoCase("If-Modified-Since"))
+            ifModifiedSince_ = field.value;
+        else if (name.EqualsNoCase("Transfer-Encoding"))
+        {
+            // 只支持chunked，其他编码无法确定请求体的边界
+            if (!StrSlice(vbegin, vend - vbegin).EqualsNoCase("chunked"))
+            {
+                LOG_ERROR("Unsupported Transfer-Encoding");
+                return false;
+            }
+            chunked_ = true;
+        }
+        break;
+    case 14:
+        if (name.EqualsNoCase("Content-Length"))
+        {
+            if (vbegin == vend || vend - vbegin > 18)
+            {
+                LOG_ERROR("Content-Length Error");
+                return false;
+            }
+            size_t len = 0;
+            for (const char *p = vbegin; p < vend; p++)
+            {
+                if (*p < '0' || *p > '9')
+                {
+                    LOG_ERROR("Content-Length Error");
+                    return false;
+                }
+                len = len * 10 + (*p - '0');
+            }
+            // 重复且不一致的Content-Length无法确定请求体的边界（请求走私）
+            if (hasContentLength_ && len != contentLength_)
+            {
+                LOG_ERROR("Conflicting Content-Length");
+                return false;
+            }
+            contentLength_ = len;
+            hasContentLength_ = true;
+        }
+        break;
+    default:
+        break;
+    }
+    return true;
+}
+
+bool HttpRequest::HeadersDone_()
 {
-    regex patten("^([^:]*): ?(.*)$");
-    smatch Match;
-    if (regex_match(line, Match, patten))
+    // HTTP/1.1默认长连接，HTTP/1.0需要显式的keep-alive
+    StrSlice conn = Slice_(connection_);
+    if (version_ == "1.1")
     {
-        header_[Match[1]] = Match[2];
+        keepAlive_ = !conn.EqualsNoCase("close");
     }
     else
-    { // 匹配失败说明首部行匹配完了，状态变化
+    {
+        keepAlive_ = conn.EqualsNoCase("keep-alive");
+    }
+    // 同时出现时以Transfer-Encoding为准，响应后关闭连接（RFC 7230 3.3.3），
+    // 避免与前面代理对请求边界的理解不一致时后面的数据被当成下一个请求
+    if (chunked_)
+    {
+        if (hasContentLength_)
+        {
+            keepAlive_ = false;
+        }
+        contentLength_ = 0;
         state_ = BODY;
+        return true;
+    }
+    size_t limit = maxBodySize.load(std::memory_order_relaxed);
+    if (limit > 0 && contentLength_ > limit)
+    { // 不等请求体到达，直接拒绝
+        LOG_WARN("Request body too large: %zu > %zu", contentLength_, limit);
+        errorCode_ = 413;
+        return false;
+    }
+    state_ = contentLength_ > 0 ? BODY : FINISH;
+    return true;
+}
+
+bool HttpRequest::ParseChunked_(const char *end)
+{
+    size_t limit = maxBodySize.load(std::memory_order_relaxed);
+    while (state_ == BODY)
+    {
+        char *p = base_ + pos_;
+        // 分块格式本身的开销（大小行、trailer）不能远超请求体，否则大量极小的分块会撑大缓冲区
+        if (pos_ - bodyOff_ - bodyLen_ > bodyLen_ + MAX_HEADER_SIZE)
+        {
+            LOG_ERROR("Chunked overhead too large");
+            return false;
+        }
+        if (chunkState_ == CHUNK_DATA)
+        {
+            size_t n = std::min(chunkLeft_, static_cast<size_t>(end - p));
+            // 紧接在已解码部分之后，去掉夹在中间的分块格式
+            char *dst = base_ + bodyOff_ + bodyLen_;
+            if (dst != p)
+            {
+                memmove(dst, p, n);
+            }
+            bodyLen_ += n;
+            pos_ += n;
+            chunkLeft_ -= n;
+            if (chunkLeft_ > 0)
+            {
+                return true;
+            }
+            chunkState_ = CHUNK_DATA_END;
+            continue;
+        }
+        if (chunkState_ == CHUNK_DATA_END)
+        {
+            if (end - p < 2)
+            {
+                return true;
+            }
+            if (p[0] != '\r' || p[1] != '\n')
+            {
+                LOG_ERROR("Chunk data Error");
+                return false;
+            }
+            pos_ += 2;
+            chunkState_ = CHUNK_SIZE;
+            continue;
+        }
+        const char *lineend = Buffer::FindCRLF(p, end);
+        if (lineend == end)
+        {
+            if (static_cast<size_t>(end - p) > MAX_LINE)
+            {
+                LOG_ERROR("Chunk line too long");
+                return false;
+            }
+            return true;
+        }
+        if (static_cast<size_t>(lineend - p) > MAX_LINE)
+        {
+            LOG_ERROR("Chunk line too long");
+            return false;
+        }
+        pos_ = lineend + 2 - base_;
+        if (chunkState_ == CHUNK_TRAILER)
+        {
+            // trailer中的字段不使用，空行表示请求结束
+            if (lineend == p)
+            {
+                contentLength_ = bodyLen_;
+                state_ = FINISH;
+            }
+            continue;
+        }
+        // 分块大小为16进制，';'之后是忽略的扩展
+        size_t size = 0;
+        const char *q = p;
+        for (; q < lineend; q++)
+        {
+            int digit = ConverHex(*q);
+            if (digit < 0)
+            {
+                break;
+            }
+            if (size >> (sizeof(size_t) * 8 - 4))
+            {
+                LOG_ERROR("Chunk size Error");
+                return false;
+            }
+            size = size * 16 + digit;
+        }
+        if (q == p || (q < lineend && *q != ';' && *q != ' ' && *q != '\t'))
+        {
+            LOG_ERROR("Chunk size Error");
+            return false;
+        }
+        if (limit > 0 && size > limit - bodyLen_)
+        {
+            LOG_WARN("Request body too large: more than %zu", limit);
+            errorCode_ = 413;
+            return false;
+        }
+        chunkLeft_ = size;
+        chunkState_ = size > 0 ? CHUNK_DATA : CHUNK_TRAILER;
     }
+    return true;
 }
 
-void HttpRequest::ParseBody_(const string &line)
+void HttpRequest::ParseBody_()
 {
-    body_ = line;
+    LOG_DEBUG("Body len:%zu", bodyLen_);
     ParsePost_();
-    state_ = FINISH; // 状态转换为下一个状态
-    LOG_DEBUG("Body:%s, len:%d", line.c_str(), line.size());
+}
+
+int HttpRequest::AcceptEncoding() const
+{
+    // 形如 "gzip, deflate;q=0.5, br"，逐个取出逗号分隔的编码名和参数
+    StrSlice value = Slice_(acceptEncoding_);
+    int result = 0, refusedMask = 0, star = -1;
+    const char *p = value.data;
+    const char *end = value.data + value.len;
+    while (p < end)
+    {
+        const char *comma = static_cast<const char *>(memchr(p, ',', end - p));
+        const char *itemEnd = comma ? comma : end;
+        while (p < itemEnd && (*p == ' ' || *p == '\t'))
+            p++;
+        const char *semi = p;
+        while (semi < itemEnd && *semi != ';')
+            semi++;
+        const char *nameEnd = semi;
+        if (semi == itemEnd)
+            semi = nullptr;
+        while (nameEnd > p && (nameEnd[-1] == ' ' || nameEnd[-1] == '\t'))
+            nameEnd--;
+        // q=0（含0.0、0.00等）表示明确拒绝
+        bool refused = false;
+        if (semi)
+        {
+            const char *q = semi + 1;
+            while (q < itemEnd && (*q == ' ' || *q == '\t'))
+                q++;
+            if (itemEnd - q >= 3 && (q[0] == 'q' || q[0] == 'Q') && q[1] == '=' && q[2] == '0')
+            {
+                refused = true;
+                for (const char *d = q + 3; d < itemEnd; d++)
+                {
+                    if (*d != '.' && *d != '0' && *d != ' ')
+                    {
+                        refused = false;
+                        break;
+                    }
+                }
+            }
+        }
+        StrSlice name(p, nameEnd - p);
+        int encoding = 0;
+        if (name.EqualsNoCase("gzip") || name.EqualsNoCase("x-gzip"))
+            encoding = ENCODING_GZIP;
+        else if (name.EqualsNoCase("br"))
+            encoding = ENCODING_BR;
+        else if (name.EqualsNoCase("*"))
+            star = refused ? 0 : 1;
+        (refused ? refusedMask : result) |= encoding;
+        p = itemEnd + 1;
+    }
+    // "*"只对没有单独列出的格式生效
+    if (star > 0)
+        result |= (ENCODING_GZIP | ENCODING_BR) & ~refusedMask;
+    return result & ~refusedMask;
+}
+
+StrSlice HttpRequest::GetHeader(const char *key) const
+{
+    assert(key != nullptr);
+    for (const HeaderField &field : headers_)
+    {
+        if (Slice_(field.name).EqualsNoCase(key))
+        {
+            return Slice_(field.value);
+        }
+    }
+    return StrSlice();
 }
 
 // 16进制转化为10进制
 int HttpRequest::ConverHex(char ch)
 {
+    if (ch >= '0' && ch <= '9')
+        return ch - '0';
     if (ch >= 'A' && ch <= 'F')
         return ch - 'A' + 10;
     if (ch >= 'a' && ch <= 'f')
         return ch - 'a' + 10;
-    return ch;
+    return -1;
 }
 
 // 处理post请求
 void HttpRequest::ParsePost_()
 {
-    if (method_ == "POST" && header_["Content-Type"] == "application/x-www-form-urlencoded")
+    if (method_ == "POST" && ContentType().StartsWithNoCase("application/x-www-form-urlencoded"))
     {
-        ParseFromUrlencoded_(); // POST请求体示例
+        ParseFromUrlencoded_(base_ + bodyOff_, bodyLen_); // POST请求体示例
         if (DEFAULT_HTML_TAG.count(path_))
         { // 如果是登录/注册的path
             int tag = DEFAULT_HTML_TAG.find(path_)->second;
             LOG_DEBUG("Tag:%d", tag);
             if (tag == 0 || tag == 1)
             {
-                bool isLogin = (tag == 1); // 为1则是登录
-                if (UserVerify(post_["username"], post_["password"], isLogin))
-                {
-                    path_ = "/welcome.html";
-                }
-                else
-                {
-                    path_ = "/error.html";
-                }
+                // 为1则是登录，验证交给调用者（同步或异步）
+                verifyTag_ = tag;
             }
         }
     }
 }
 
-// 从url中解析编码
-void HttpRequest::ParseFromUrlencoded_()
+// 从url中解析编码，键和值都在读缓冲区上就地解码
+void HttpRequest::ParseFromUrlencoded_(char *begin, size_t len)
 {
-    if (body_.size() == 0)
+    char *end = begin + len;
+    char *p = begin;
+    while (p < end)
     {
-        return;
+        char *amp = static_cast<char *>(memchr(p, '&', end - p));
+        if (!amp)
+        {
+            amp = end;
+        }
+        char *eq = static_cast<char *>(memchr(p, '=', amp - p));
+        if (eq && eq > p)
+        {
+            size_t keyLen = DecodeUrl_(p, eq);
+            size_t valueLen = DecodeUrl_(eq + 1, amp);
+            string &value = post_[string(p, keyLen)];
+            value.assign(eq + 1, valueLen);
+            LOG_DEBUG("%.*s = %s", (int)keyLen, p, value.c_str());
+        }
+        p = amp + 1;
     }
+}
 
-    string key, value;
-    int num = 0;
-    int n = body_.size();
-    int i = 0, j = 0;
-
-    for (; i < n; i++)
+size_t HttpRequest::DecodeUrl_(char *begin, char *end)
+{
+    char *out = begin;
+    char *p = begin;
+    while (p < end)
     {
-        char ch = body_[i];
-        switch (ch)
+        // 直接跳到下一个需要处理的特殊字符，中间的普通字符整段前移
+        char *special = const_cast<char *>(Buffer::FindAnyOf(p, end, "+%", 2));
+        if (out != p)
+        {
+            memmove(out, p, special - p);
+        }
+        out += special - p;
+        p = special;
+        if (p == end)
         {
-        case '=':
-            key = body_.substr(j, i - j);
-            j = i + 1;
-            break;
-        case '+':
-            body_[i] = ' ';
-            break;
-        case '%':
-            num = ConverHex(body_[i + 1]) * 16 + ConverHex(body_[i + 2]);
-            body_[i + 2] = num % 10 + '0';
-            body_[i + 1] = num / 10 + '0';
-            i += 2;
-            break;
-        case '&':
-            value = body_.substr(j, i - j);
-            j = i + 1;
-            post_[key] = value;
-            LOG_DEBUG("%s = %s", key.c_str(), value.c_str());
-            break;
-        default:
             break;
         }
+        int hi, lo;
+        if (*p == '+')
+        {
+            *out++ = ' ';
+            p++;
+        }
+        else if (end - p >= 3 && (hi = ConverHex(p[1])) >= 0 && (lo = ConverHex(p[2])) >= 0)
+        {
+            *out++ = static_cast<char>(hi * 16 + lo);
+            p += 3;
+        }
+        else
+        {
+            *out++ = *p++;
+        }
     }
-    assert(j <= i);
-    if (post_.count(key) == 0 && j < i)
-    {
-        value = body_.substr(j, i - j);
-        post_[key] = value;
-    }
+    return out - begin;
 }
 
-bool HttpRequest::UserVerify(const string &name, const string &pwd, bool isLogin)
+void HttpRequest::SetVerifyResult(bool ok)
 {
+    assert(NeedsUserVerify());
+    path_ = ok ? "/welcome.html" : "/error.html";
+    verifyTag_ = -1;
+}
+
+bool HttpRequest::VerifyFromCache()
+{
+    assert(NeedsUserVerify());
+    std::string name = GetPost("username");
+    std::string pwd = GetPost("password");
+    std::string password;
     if (name == "" || pwd == "")
     {
+        SetVerifyResult(false);
+        return true;
+    }
+    // 未命中只统计一次，重新进入时不再加锁查找
+    if (cacheMissed_ || !UserCache::Instance()->Get(name, &password))
+    {
+        cacheMissed_ = true;
         return false;
     }
-    LOG_INFO("Verify name:%s pwd:%s", name.c_str(), pwd.c_str());
-    MYSQL *sql;
-    SqlConnRAII(&sql, SqlConnPool::Instance());
-    assert(sql);
-
-    bool flag = false;
-    unsigned int j = 0;
-    char order[256] = {0};
-    MYSQL_FIELD *fields = nullptr;
-    MYSQL_RES *res = nullptr;
+    // 登录比较密码；注册时用户已存在
+    SetVerifyResult(IsLoginRequest() && password == pwd);
+    return true;
+}
 
-    if (!isLogin)
+void HttpRequest::VerifyUser()
+{
+    if (VerifyFromCache())
     {
-        flag = true;
+        return;
     }
-    /* 查询用户及密码 */
-    snprintf(order, 256, "SELECT username, password FROM user WHERE username='%s' LIMIT 1", name.c_str());
-    LOG_DEBUG("%s", order);
+    MYSQL *sql = nullptr;
+    SqlConnRAII conn(&sql, SqlConnPool::Instance());
+    SetVerifyResult(UserVerify(sql, GetPost("username"), GetPost("password"), IsLoginRequest()));
+}
 
-    if (mysql_query(sql, order))
+// 绑定一个字符串参数/结果
+static void BindString(MYSQL_BIND &bind, const char *data, unsigned long size, unsigned long *length)
+{
+    memset(&bind, 0, sizeof(bind));
+    bind.buffer_type = MYSQL_TYPE_STRING;
+    bind.buffer = const_cast<char *>(data);
+    bind.buffer_length = size;
+    bind.length = length;
+}
+
+bool HttpRequest::UserVerify(MYSQL *sql, const string &name, const string &pwd, bool isLogin)
+{
+    if (name == "" || pwd == "" || !sql)
     {
-        mysql_free_result(res);
         return false;
     }
-    res = mysql_store_result(sql);
-    j = mysql_num_fields(res);
-    fields = mysql_fetch_fields(res);
+    LOG_INFO("Verify name:%s pwd:%s", name.c_str(), pwd.c_str());
+    SqlConnPool *pool = SqlConnPool::Instance();
 
-    while (MYSQL_ROW row = mysql_fetch_row(res))
+    /* 查询用户及密码，参数由预编译语句绑定，不再拼接SQL */
+    MYSQL_STMT *stmt = pool->GetStmt(sql, SqlConnPool::STMT_SELECT_USER);
+    if (!stmt)
     {
-        LOG_DEBUG("MYSQL ROW: %s %s", row[0], row[1]);
-        string password(row[1]);
-        /* 注册行为 且 用户名未被使用*/
-        if (isLogin)
-        {
-            if (pwd == password)
-            {
-                flag = true;
-            }
-            else
-            {
-                flag = false;
-                LOG_INFO("pwd error!");
-            }
-        }
-        else
-        {
-            flag = false;
-            LOG_INFO("user used!");
-        }
+        return false;
+    }
+    unsigned long nameLen = name.size();
+    MYSQL_BIND param[1];
+    BindString(param[0], name.data(), nameLen, &nameLen);
+    char password[256];
+    unsigned long passwordLen = 0;
+    MYSQL_BIND result[1];
+    BindString(result[0], password, sizeof(password), &passwordLen);
+    Metrics::Add(METRIC_DB_CALLS);
+    if (mysql_stmt_bind_param(stmt, param) || mysql_stmt_execute(stmt) ||
+        mysql_stmt_bind_result(stmt, result) || mysql_stmt_store_result(stmt))
+    {
+        LOG_ERROR("Select user error: %s", mysql_stmt_error(stmt));
+        pool->ResetStmt(sql, SqlConnPool::STMT_SELECT_USER);
+        return false;
+    }
+    int ret = mysql_stmt_fetch(stmt);
+    bool found = (ret == 0 || ret == MYSQL_DATA_TRUNCATED);
+    bool match = (ret == 0 && passwordLen == pwd.size() && memcmp(password, pwd.data(), passwordLen) == 0);
+    mysql_stmt_free_result(stmt);
+    if (ret == 0)
+    {
+        UserCache::Instance()->Put(name, std::string(password, passwordLen));
     }
-    mysql_free_result(res);
 
-    /* 注册行为 且 用户名未被使用*/
-    if (!isLogin && flag == true)
+    if (isLogin)
     {
-        LOG_DEBUG("regirster!");
-        bzero(order, 256);
-        snprintf(order, 256, "INSERT INTO user(username, password) VALUES('%s','%s')", name.c_str(), pwd.c_str());
-        LOG_DEBUG("%s", order);
-        if (mysql_query(sql, order))
+        if (!match)
         {
-            LOG_DEBUG("Insert error!");
-            flag = false;
+            LOG_INFO("pwd error!");
         }
-        flag = true;
+        return match;
     }
-    // SqlConnPool::Instance()->FreeConn(sql);
+    /* 注册行为 且 用户名已被使用*/
+    if (found)
+    {
+        LOG_INFO("user used!");
+        return false;
+    }
+    LOG_DEBUG("regirster!");
+    stmt = pool->GetStmt(sql, SqlConnPool::STMT_INSERT_USER);
+    if (!stmt)
+    {
+        return false;
+    }
+    unsigned long pwdLen = pwd.size();
+    MYSQL_BIND insert[2];
+    BindString(insert[0], name.data(), nameLen, &nameLen);
+    BindString(insert[1], pwd.data(), pwdLen, &pwdLen);
+    Metrics::Add(METRIC_DB_CALLS);
+    if (mysql_stmt_bind_param(stmt, insert) || mysql_stmt_execute(stmt))
+    {
+        LOG_DEBUG("Insert error: %s", mysql_stmt_error(stmt));
+        pool->ResetStmt(sql, SqlConnPool::STMT_INSERT_USER);
+        return false;
+    }
+    // 写穿：新用户马上可以从缓存登录
+    UserCache::Instance()->Put(name, pwd);
     LOG_DEBUG("UserVerify success!!");
-    return flag;
+    return true;
 }
 
 std::string HttpRequest::path() const
@@ -329,9 +773,5 @@ std::string HttpRequest::GetPost(const char *key) const
 
 bool HttpRequest::IsKeepAlive() const
 {
-    if (header_.count("Connection") == 1)
-    {
-        return header_.find("Connection")->second == "keep-alive" && version_ == "1.1";
-    }
-    return false;
+    return keepAlive_;
 }
\ No newline at end of file
@@ -4,13 +4,49 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <string>
-#include <regex>    // 正则表达式
+#include <vector>
+#include <atomic>
 #include <errno.h>     
+#include <string.h>    // memchr, strncasecmp
 #include <mysql/mysql.h>  //mysql
 
 #include "../buffer/buffer.h"
 #include "../log/log.h"
+#include "../log/metrics.h"
 #include "../pool/sqlconnpool.h"
+#include "../pool/usercache.h"
+
+/**
+ * @brief 指向读缓冲区中一段数据的只读切片（C++14没有string_view）
+ *
+ * 切片不拥有数据，只在对应的请求被Retrieve之前有效。
+ */
+struct StrSlice {
+    const char* data;
+    size_t len;
+
+    StrSlice() : data(nullptr), len(0) {}
+    StrSlice(const char* d, size_t n) : data(d), len(n) {}
+
+    bool empty() const { return len == 0; }
+    std::string ToString() const { return data ? std::string(data, len) : std::string(); }
+
+    /**
+     * @brief 忽略大小写比较
+     */
+    bool EqualsNoCase(const char* str) const {
+        size_t n = strlen(str);
+        return n == len && (n == 0 || strncasecmp(data, str, n) == 0);
+    }
+
+    /**
+     * @brief 忽略大小写判断是否以str开头
+     */
+    bool StartsWithNoCase(const char* str) const {
+        size_t n = strlen(str);
+        return n <= len && (n == 0 || strncasecmp(data, str, n) == 0);
+    }
+};
 
 class HttpRequest {
 public:
@@ -40,12 +76,84 @@ public:
     void Init();
 
     /**
-     * @brief 解析HTTP请求
-     * @param buff 缓冲区对象
-     * @return 解析成功与否
+     * @brief 增量解析HTTP请求
+     *
+     * 直接在buff.Peek()上扫描，不消费缓冲区中的数据，请求不完整时记住解析进度，
+     * 下次收到更多数据后从断点继续。请求完整后由调用者Retrieve(RequestLength())。
+     * 两次调用之间缓冲区只允许在尾部追加数据。
+     *
+     * 请求体按Content-Length或chunked传输编码增量接收，数据留在读缓冲区中，不拷贝到单独的字符串；
+     * chunked请求体在到达时就地去掉分块格式，拼接到请求头之后。
+     * 请求体超过maxBodySize时不等数据收完，立即返回false，ErrorCode()为413。
+     *
+     * @param buff 读缓冲区
+     * @return 请求格式错误或请求体过大时返回false，否则返回true（是否完整用IsFinished()判断）
      */
     bool parse(Buffer& buff);   
 
+    /**
+     * @brief parse返回false时应回复的状态码：格式错误为400，请求体过大为413
+     */
+    int ErrorCode() const { return errorCode_; }
+
+    /**
+     * @brief 按Content-Length接收请求体时还差的字节数，调用者据此一次预留读缓冲区，
+     *        其余情况（请求头、chunked、未限制请求体大小）为0
+     */
+    size_t BodyPending() const { return bodyPending_; }
+
+    /**
+     * @brief 是否已解析出一个完整的请求
+     */
+    bool IsFinished() const { return state_ == FINISH; }
+
+    /**
+     * @brief 完整请求（请求行+请求头+请求体）在读缓冲区中占用的字节数
+     */
+    size_t RequestLength() const { return pos_; }
+
+    /**
+     * @brief 按名称查找请求头（忽略大小写），只在请求被Retrieve之前有效
+     * @param key 请求头名称
+     * @return 请求头的值，不存在时为空切片
+     */
+    StrSlice GetHeader(const char* key) const;
+
+    /**
+     * @brief 常用请求头的快速访问，只在请求被Retrieve之前有效
+     */
+    StrSlice Host() const { return Slice_(host_); }
+    StrSlice ContentType() const { return Slice_(contentType_); }
+    size_t ContentLength() const { return contentLength_; }
+
+    /**
+     * @brief 请求体（chunked请求体为解码后的内容），只在请求完整之后、被Retrieve之前有效；
+     *        表单请求体在解析时已被就地URL解码
+     */
+    StrSlice Body() const { return bodyLen_ ? StrSlice(base_ + bodyOff_, bodyLen_) : StrSlice(); }
+
+    /**
+     * @brief 条件请求和Range请求使用的请求头，只在请求被Retrieve之前有效
+     */
+    StrSlice IfNoneMatch() const { return Slice_(ifNoneMatch_); }
+    StrSlice IfModifiedSince() const { return Slice_(ifModifiedSince_); }
+    StrSlice Range() const { return Slice_(range_); }
+    StrSlice IfRange() const { return Slice_(ifRange_); }
+
+    /**
+     * @brief Accept-Encoding中客户端接受的压缩格式
+     */
+    enum ContentEncoding {
+        ENCODING_GZIP = 1 << 0,
+        ENCODING_BR = 1 << 1,
+    };
+
+    /**
+     * @brief 解析Accept-Encoding（忽略q=0的格式），只在请求被Retrieve之前有效
+     * @return ContentEncoding的按位或，没有该请求头时为0
+     */
+    int AcceptEncoding() const;
+
     /**
      * @brief 获取请求路径
      * @return 请求路径字符串
@@ -90,25 +198,117 @@ public:
      */
     bool IsKeepAlive() const;
 
+    /**
+     * @brief 是否是等待验证的登录/注册请求
+     *
+     * 解析只记录需要验证，不访问数据库；由调用者同步调用VerifyUser()，
+     * 或者把UserVerify()交给SqlExecutor异步执行后调用SetVerifyResult()。
+     */
+    bool NeedsUserVerify() const { return verifyTag_ >= 0; }
+
+    /**
+     * @brief 是否是登录请求（否则为注册），只在NeedsUserVerify()时有意义
+     */
+    bool IsLoginRequest() const { return verifyTag_ == 1; }
+
+    /**
+     * @brief 设置验证结果，请求路径改为欢迎页或错误页
+     */
+    void SetVerifyResult(bool ok);
+
+    /**
+     * @brief 尝试只用UserCache验证：登录时缓存中有该用户则直接比较密码，注册时有该用户则直接失败
+     * @return 缓存命中、已设置验证结果时返回true；未命中时需要访问数据库。
+     *         同一个请求只查一次缓存，未命中后再调用（如等待前面的响应发完后重新进入）直接返回false
+     */
+    bool VerifyFromCache();
+
+    /**
+     * @brief 在当前线程同步验证（先查UserCache，未命中再从连接池取连接）
+     */
+    void VerifyUser();
+
+    /**
+     * @brief 用预编译语句验证用户，可在任意线程调用；查到的用户和注册成功的用户写入UserCache
+     * @param sql 数据库连接，为nullptr时验证失败
+     * @param name 用户名
+     * @param pwd 密码
+     * @param isLogin 是否登录（否则为注册）
+     * @return 验证成功与否
+     */
+    static bool UserVerify(MYSQL* sql, const std::string& name, const std::string& pwd, bool isLogin);
+
+    // 请求体的最大字节数，0表示不限制（配置重载时修改）
+    static std::atomic<size_t> maxBodySize;
+
 private:
     /**
-     * @brief 解析请求行
-     * @param line 请求行字符串
+     * @brief 相对于请求起始位置的偏移和长度，缓冲区扩容搬移数据后仍然有效
+     */
+    struct Span {
+        uint32_t off;
+        uint32_t len;
+    };
+
+    /**
+     * @brief chunked请求体的解析状态
+     */
+    enum CHUNK_STATE {
+        CHUNK_SIZE,      // 分块大小行
+        CHUNK_DATA,      // 分块数据
+        CHUNK_DATA_END,  // 分块数据后的\r\n
+        CHUNK_TRAILER,   // 最后一个分块之后的trailer，以空行结束
+    };
+
+    /**
+     * @brief 一个请求头
+     */
+    struct HeaderField {
+        Span name;
+        Span value;
+    };
+
+    static const size_t MAX_LINE = 8192;        // 请求行/单个请求头的最大长度
+    static const size_t MAX_HEADERS = 100;      // 请求头的最大个数
+    static const size_t MAX_HEADER_SIZE = 65536;    // 请求行+请求头的最大长度
+
+    StrSlice Slice_(const Span& span) const {
+        return span.len ? StrSlice(base_ + span.off, span.len) : StrSlice();
+    }
+
+    /**
+     * @brief 解析请求行 "METHOD SP PATH SP HTTP/x.y"
+     * @param begin 行首
+     * @param end 行尾（不含\r\n）
+     * @return 解析成功与否
+     */
+    bool ParseRequestLine_(const char* begin, const char* end);    // 处理请求行
+
+    /**
+     * @brief 解析一个请求头 "name: value"，并识别常用请求头
+     * @param begin 行首
+     * @param end 行尾（不含\r\n）
      * @return 解析成功与否
      */
-    bool ParseRequestLine_(const std::string& line);    // 处理请求行
+    bool ParseHeader_(const char* begin, const char* end);         // 处理请求头
 
     /**
-     * @brief 解析请求头
-     * @param line 请求头字符串
+     * @brief 请求头结束，确定是否长连接及是否有请求体
+     * @return Content-Length超过maxBodySize时返回false
      */
-    void ParseHeader_(const std::string& line);         // 处理请求头
+    bool HeadersDone_();
 
     /**
-     * @brief 解析请求体
-     * @param line 请求体字符串
+     * @brief 解析已到达的chunked数据，分块内容就地前移到已解码部分之后，全部到达时状态变为FINISH
+     * @param end 已接收数据的末尾
+     * @return 格式错误或请求体过大时返回false
      */
-    void ParseBody_(const std::string& line);           // 处理请求体
+    bool ParseChunked_(const char* end);
+
+    /**
+     * @brief 请求体完整后解析请求体
+     */
+    void ParseBody_();           // 处理请求体
 
     /**
      * @brief 解析请求路径
@@ -121,27 +321,44 @@ private:
     void ParsePost_();                                  // 处理Post事件
 
     /**
-     * @brief 从URL编码中解析数据
+     * @brief 在读缓冲区上就地解码URL编码的表单，只有键值对本身被拷贝到post_
+     * @param begin 表单起始
+     * @param len 表单长度
      */
-    void ParseFromUrlencoded_();                        // 从url种解析编码
+    void ParseFromUrlencoded_(char* begin, size_t len);     // 从url种解析编码
 
     /**
-     * @brief 用户验证
-     * @param name 用户名
-     * @param pwd 密码
-     * @param isLogin 是否登录
-     * @return 验证成功与否
+     * @brief 就地解码一段URL编码（'+'为空格，%XX为一个字节），格式不对的%原样保留
+     * @return 解码后的长度
      */
-    static bool UserVerify(const std::string& name, const std::string& pwd, bool isLogin);  // 用户验证
+    static size_t DecodeUrl_(char* begin, char* end);
 
     PARSE_STATE state_;  // 当前解析状态
-    std::string method_, path_, version_, body_;  // 请求方法、路径、版本、请求体
-    std::unordered_map<std::string, std::string> header_;  // 请求头
+    std::string method_, path_, version_;  // 请求方法、路径、版本
+    char* base_;         // 请求在读缓冲区中的起始位置（每次parse时更新）
+    size_t pos_;         // 下一个待解析字节相对请求起始的偏移
+    size_t scanPos_;     // 下次查找请求头结束空行的起始偏移
+    bool headComplete_;  // 请求头是否已完整到达
+    std::vector<HeaderField> headers_;  // 请求头，clear()后复用容量
+    Span host_, connection_, contentType_, acceptEncoding_;  // 常用请求头
+    Span ifNoneMatch_, ifModifiedSince_, range_, ifRange_;  // 条件请求和Range请求的请求头
+    size_t contentLength_;  // 请求体长度
+    bool hasContentLength_; // 是否出现过Content-Length
+    bool chunked_;       // 请求体是否使用chunked传输编码
+    CHUNK_STATE chunkState_;  // chunked请求体的解析状态
+    size_t chunkLeft_;   // 当前分块还未到达的字节数
+    size_t bodyOff_;     // 请求体相对请求起始的偏移
+    size_t bodyLen_;     // 已接收的请求体长度（chunked时为解码后的长度）
+    size_t bodyPending_; // 按Content-Length还差的字节数
+    int errorCode_;      // parse失败时的状态码
+    bool keepAlive_;     // 是否保持连接
     std::unordered_map<std::string, std::string> post_;  // POST请求参数
+    int verifyTag_;      // 等待验证的请求类型：-1无，0注册，1登录
+    bool cacheMissed_;   // 已经查过UserCache且未命中
 
     static const std::unordered_set<std::string> DEFAULT_HTML;  // 默认HTML页面
     static const std::unordered_map<std::string, int> DEFAULT_HTML_TAG;  // 默认HTML标签
-    static int ConverHex(char ch);  // 16进制转换为10进制
+    static int ConverHex(char ch);  // 16进制转换为10进制，不是16进制数字时返回-1
 };
 
 #endif
\ No newline at end of file
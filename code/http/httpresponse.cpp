@@ -1,4 +1,5 @@
 #include "httpresponse.h"
+#include "httprequest.h"
 
 using namespace std;
 
@@ -25,21 +26,36 @@ const unordered_map<string, string> HttpResponse::SUFFIX_TYPE = {
     { ".js",    "text/javascript "},
 };
 
-// 定义一个常量 unordered_map，用于存储 HTTP 状态码与对应的状态描述
-const unordered_map<int, string> HttpResponse::CODE_STATUS = {
-    { 200, "OK" },
-    { 400, "Bad Request" },
-    { 403, "Forbidden" },
-    { 404, "Not Found" },
-};
+// 状态行在编译期拼接成字面量，生成响应时只需一次拷贝
+#define HTTP_STATUS(code, text, page) \
+    { code, text, "HTTP/1.1 " #code " " text "\r\n", sizeof("HTTP/1.1 " #code " " text "\r\n") - 1, page }
 
-// 定义一个常量 unordered_map，用于存储 HTTP 状态码与对应的错误页面路径
-const unordered_map<int, string> HttpResponse::CODE_PATH = {
-    { 400, "/400.html" },
-    { 403, "/403.html" },
-    { 404, "/404.html" },
+// 定义 HTTP 状态码与对应的状态描述、状态行和错误页面路径
+const HttpResponse::Status HttpResponse::STATUS_TABLE[] = {
+    HTTP_STATUS(200, "OK", nullptr),
+    HTTP_STATUS(206, "Partial Content", nullptr),
+    HTTP_STATUS(304, "Not Modified", nullptr),
+    HTTP_STATUS(400, "Bad Request", "/400.html"),
+    HTTP_STATUS(403, "Forbidden", "/403.html"),
+    HTTP_STATUS(404, "Not Found", "/404.html"),
+    HTTP_STATUS(413, "Payload Too Large", "/413.html"),
+    HTTP_STATUS(416, "Range Not Satisfiable", nullptr),
 };
 
+#undef HTTP_STATUS
+
+const size_t HttpResponse::STATUS_COUNT = sizeof(STATUS_TABLE) / sizeof(STATUS_TABLE[0]);
+
+const HttpResponse::Status* HttpResponse::FindStatus_(int code) {
+    // 表很小，顺序查找比哈希更快
+    for(size_t i = 0; i < STATUS_COUNT; i++) {
+        if(STATUS_TABLE[i].code == code) {
+            return &STATUS_TABLE[i];
+        }
+    }
+    return nullptr;
+}
+
 /**
  * @brief 默认构造函数，初始化成员变量
  */
@@ -50,10 +66,14 @@ HttpResponse::HttpResponse() {
     path_ = srcDir_ = "";
     // 初始化是否保持连接为 false
     isKeepAlive_ = false;
-    // 初始化内存映射文件指针为 nullptr
-    mmFile_ = nullptr; 
+    keepAliveMax_ = keepAliveTimeout_ = 0;
+    acceptEncoding_ = 0;
+    bodyOffset_ = 0;
+    bodyLen_ = 0;
     // 初始化文件状态结构体为全零
     mmFileStat_ = { 0 };
+    // 默认使用 mmap 发送文件
+    useSendfile_ = false;
 };
 
 /**
@@ -70,24 +90,68 @@ HttpResponse::~HttpResponse() {
  * @param path 请求路径
  * @param isKeepAlive 是否保持连接
  * @param code HTTP 状态码
+ * @param useSendfile 是否使用 sendfile 发送文件
  */
-void HttpResponse::Init(const string& srcDir, string& path, bool isKeepAlive, int code){
+void HttpResponse::Init(const string& srcDir, string& path, bool isKeepAlive, int code,
+                        bool useSendfile){
     // 确保源目录不为空
     assert(srcDir != "");
-    // 如果内存映射文件已存在，则释放
-    if(mmFile_) { UnmapFile(); }
+    // 如果还借用着上一个文件缓存条目，则释放
+    if(file_) { UnmapFile(); }
+    // 设置文件发送方式
+    useSendfile_ = useSendfile;
     // 设置状态码
     code_ = code;
     // 设置是否保持连接
     isKeepAlive_ = isKeepAlive;
+    keepAliveMax_ = keepAliveTimeout_ = 0;
+    acceptEncoding_ = 0;
+    // clear 保留容量，长连接上的后续请求不再分配
+    ifNoneMatch_.clear();
+    ifModifiedSince_.clear();
+    range_.clear();
+    ifRange_.clear();
     // 设置请求路径
     path_ = path;
     // 设置源目录
     srcDir_ = srcDir;
-    // 重置内存映射文件指针为 nullptr
-    mmFile_ = nullptr; 
     // 重置文件状态结构体为全零
     mmFileStat_ = { 0 };
+    bodyOffset_ = 0;
+    bodyLen_ = 0;
+}
+
+/**
+ * @brief 设置通告的长连接限制
+ * @param remaining 剩余请求数
+ * @param timeoutSec 空闲超时（秒）
+ */
+void HttpResponse::SetKeepAlive(int remaining, int timeoutSec) {
+    keepAliveMax_ = remaining;
+    keepAliveTimeout_ = timeoutSec;
+}
+
+/**
+ * @brief 设置客户端接受的压缩格式
+ * @param encodings HttpRequest::ContentEncoding 的按位或
+ */
+void HttpResponse::SetAcceptEncoding(int encodings) {
+    acceptEncoding_ = encodings;
+}
+
+/**
+ * @brief 保存条件请求头和 Range 请求头
+ * @param request 已解析完整的请求
+ */
+void HttpResponse::SetConditional(const HttpRequest& request) {
+    StrSlice value = request.IfNoneMatch();
+    ifNoneMatch_.assign(value.data ? value.data : "", value.len);
+    value = request.IfModifiedSince();
+    ifModifiedSince_.assign(value.data ? value.data : "", value.len);
+    value = request.Range();
+    range_.assign(value.data ? value.data : "", value.len);
+    value = request.IfRange();
+    ifRange_.assign(value.data ? value.data : "", value.len);
 }
 
 /**
@@ -96,17 +160,45 @@ void HttpResponse::Init(const string& srcDir, string& path, bool isKeepAlive, in
  */
 void HttpResponse::MakeResponse(Buffer& buff) {
     /* 判断请求的资源文件 */
-    // 使用 stat 函数获取文件状态，如果文件不存在或为目录，则设置状态码为 404
-    if(stat((srcDir_ + path_).data(), &mmFileStat_) < 0 || S_ISDIR(mmFileStat_.st_mode)) {
-        code_ = 404;
+    // 从文件缓存借用文件条目，命中时不需要任何 stat/open/mmap 系统调用
+    int err = 0;
+    // 请求本身出错时（如400）直接返回错误页面，不再查找请求的文件
+    if(code_ < 400) {
+        fullPath_.assign(srcDir_).append(path_);
+        file_ = FileCache::Instance()->Get(fullPath_, &err);
+    } else {
+        file_ = nullptr;
     }
-    // 如果文件不可读，则设置状态码为 403
-    else if(!(mmFileStat_.st_mode & S_IROTH)) {
-        code_ = 403;
+    if(code_ < 400) {
+        // 如果文件不可读，则设置状态码为 403
+        if(!file_ && err == EACCES) {
+            code_ = 403;
+        }
+        // 如果文件不存在或为目录，则设置状态码为 404
+        else if(!file_) {
+            code_ = 404;
+        }
+        // 如果状态码未设置，则设置为 200
+        else if(code_ == -1) { 
+            code_ = 200; 
+        }
+        // 客户端接受时改为发送预压缩版本（br优先），压缩版本的条目自带 Content-Encoding 头；
+        // Range 请求的区间按原文件计算，不发送压缩版本
+        if(file_ && code_ == 200 && range_.empty()) {
+            if(file_->br && (acceptEncoding_ & HttpRequest::ENCODING_BR)) {
+                file_ = file_->br;
+            } else if(file_->gzip && (acceptEncoding_ & HttpRequest::ENCODING_GZIP)) {
+                file_ = file_->gzip;
+            }
+        }
     }
-    // 如果状态码未设置，则设置为 200
-    else if(code_ == -1) { 
-        code_ = 200; 
+    // 记录文件状态，默认发送整个文件
+    mmFileStat_ = file_ ? file_->st : (struct stat){ 0 };
+    bodyOffset_ = 0;
+    bodyLen_ = mmFileStat_.st_size;
+    // 处理条件请求和 Range 请求
+    if(file_ && code_ == 200) {
+        CheckConditional_();
     }
     // 处理错误页面
     ErrorHtml_();
@@ -118,20 +210,185 @@ void HttpResponse::MakeResponse(Buffer& buff) {
     AddContent_(buff);
 }
 
+/**
+ * @brief 生成正文不来自文件的 200 响应
+ * @param buff 缓冲区对象
+ * @param contentType Content-type 的值
+ * @param body 响应正文
+ */
+void HttpResponse::MakeContent(Buffer& buff, const char* contentType, const string& body) {
+    file_ = nullptr;
+    code_ = 200;
+    bodyOffset_ = 0;
+    bodyLen_ = 0;
+    AddStateLine_(buff);
+    AddHeader_(buff);
+    buff.AppendLiteral("Content-type: ");
+    buff.Append(contentType, strlen(contentType));
+    buff.AppendLiteral("\r\nContent-length: ");
+    buff.AppendUInt(body.size());
+    buff.AppendLiteral("\r\n\r\n");
+    buff.Append(body);
+}
+
 /**
  * @brief 获取内存映射文件指针
  * @return 内存映射文件指针
  */
 char* HttpResponse::File() {
-    return mmFile_;
+    return (file_ && !useSendfile_ && file_->data) ? file_->data + bodyOffset_ : nullptr;
+}
+
+/**
+ * @brief 获取 sendfile 模式下使用的文件描述符
+ * @return 文件描述符，未打开或非 sendfile 模式时为 -1
+ */
+int HttpResponse::FileFd() const {
+    return (file_ && useSendfile_) ? file_->fd : -1;
 }
 
 /**
- * @brief 获取内存映射文件大小
- * @return 内存映射文件大小
+ * @brief 获取要发送的文件内容长度
+ * @return 文件内容长度
  */
 size_t HttpResponse::FileLen() const {
-    return mmFileStat_.st_size;
+    return bodyLen_;
+}
+
+// 比较 ETag 的引号内部分，忽略 W/ 前缀（弱比较）
+static bool EtagEquals(const char* begin, const char* end, const string& etag) {
+    if(end - begin >= 2 && begin[0] == 'W' && begin[1] == '/') {
+        begin += 2;
+    }
+    return static_cast<size_t>(end - begin) == etag.size() && memcmp(begin, etag.data(), etag.size()) == 0;
+}
+
+// 解析不超过18位的十进制数，p 移到数字之后
+static bool ParseOffset(const char*& p, const char* end, off_t* value) {
+    const char* begin = p;
+    off_t v = 0;
+    while(p < end && *p >= '0' && *p <= '9' && p - begin < 18) {
+        v = v * 10 + (*p - '0');
+        p++;
+    }
+    *value = v;
+    return p > begin && (p == end || *p < '0' || *p > '9');
+}
+
+/**
+ * @brief If-None-Match（优先）或 If-Modified-Since 是否表明客户端的缓存仍然有效
+ * @return 可以返回304时为 true
+ */
+bool HttpResponse::NotModified_() const {
+    if(!ifNoneMatch_.empty()) {
+        // 形如 "\"a\", W/\"b\"" 或 "*"，任意一个匹配即可
+        const char* p = ifNoneMatch_.data();
+        const char* end = p + ifNoneMatch_.size();
+        while(p < end) {
+            const char* comma = static_cast<const char*>(memchr(p, ',', end - p));
+            const char* itemEnd = comma ? comma : end;
+            while(p < itemEnd && (*p == ' ' || *p == '\t')) { p++; }
+            const char* last = itemEnd;
+            while(last > p && (last[-1] == ' ' || last[-1] == '\t')) { last--; }
+            if((last - p == 1 && *p == '*') || EtagEquals(p, last, file_->etag)) {
+                return true;
+            }
+            p = itemEnd + 1;
+        }
+        // 有 If-None-Match 时忽略 If-Modified-Since
+        return false;
+    }
+    if(!ifModifiedSince_.empty()) {
+        // 浏览器通常原样带回 Last-Modified，先按字符串比较，避免解析日期
+        if(ifModifiedSince_ == file_->lastModified) {
+            return true;
+        }
+        struct tm t = { 0 };
+        const char* rest = strptime(ifModifiedSince_.c_str(), "%a, %d %b %Y %H:%M:%S GMT", &t);
+        if(rest && *rest == '\0') {
+            time_t since = timegm(&t);
+            // 晚于当前时间的日期无效
+            return since <= time(nullptr) && file_->st.st_mtim.tv_sec <= since;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 解析单个区间的 Range 请求头
+ * @return 206、416或0（忽略 Range）
+ */
+int HttpResponse::ParseRange_(off_t size, off_t* first, off_t* last) const {
+    const char* p = range_.data();
+    const char* end = p + range_.size();
+    if(range_.size() < 6 || strncasecmp(p, "bytes=", 6) != 0) {
+        return 0;
+    }
+    p += 6;
+    // 多个区间需要 multipart/byteranges，直接发送整个文件
+    if(memchr(p, ',', end - p)) {
+        return 0;
+    }
+    while(p < end && *p == ' ') { p++; }
+    while(end > p && end[-1] == ' ') { end--; }
+    if(p < end && *p == '-') {
+        // "-n"：最后n个字节
+        off_t suffix = 0;
+        p++;
+        if(!ParseOffset(p, end, &suffix) || p != end) {
+            return 0;
+        }
+        if(suffix == 0 || size == 0) {
+            return 416;
+        }
+        *first = suffix >= size ? 0 : size - suffix;
+        *last = size - 1;
+        return 206;
+    }
+    // "a-b" 或 "a-"
+    if(!ParseOffset(p, end, first) || p == end || *p != '-') {
+        return 0;
+    }
+    p++;
+    if(p == end) {
+        *last = size - 1;
+    } else if(!ParseOffset(p, end, last) || p != end || *last < *first) {
+        return 0;
+    } else if(*last >= size) {
+        *last = size - 1;
+    }
+    return *first < size ? 206 : 416;
+}
+
+/**
+ * @brief 把200响应改为304、206或416
+ */
+void HttpResponse::CheckConditional_() {
+    if(NotModified_()) {
+        code_ = 304;
+        bodyLen_ = 0;
+        return;
+    }
+    if(range_.empty()) {
+        return;
+    }
+    // If-Range 不匹配（文件已变化）时忽略 Range，发送整个文件；弱 ETag 永远不匹配
+    if(!ifRange_.empty()) {
+        bool match = ifRange_[0] == '"' ? ifRange_ == file_->etag : ifRange_ == file_->lastModified;
+        if(!match) {
+            return;
+        }
+    }
+    off_t first = 0, last = 0;
+    int code = ParseRange_(mmFileStat_.st_size, &first, &last);
+    if(code == 206) {
+        code_ = 206;
+        bodyOffset_ = first;
+        bodyLen_ = static_cast<size_t>(last - first + 1);
+    } else if(code == 416) {
+        code_ = 416;
+        bodyLen_ = 0;
+    }
 }
 
 /**
@@ -139,9 +396,15 @@ size_t HttpResponse::FileLen() const {
  */
 void HttpResponse::ErrorHtml_() {
     // 如果状态码对应的错误页面路径存在，则设置请求路径为错误页面路径，并获取文件状态
-    if(CODE_PATH.count(code_) == 1) {
-        path_ = CODE_PATH.find(code_)->second;
-        stat((srcDir_ + path_).data(), &mmFileStat_);
+    const Status* status = FindStatus_(code_);
+    if(status && status->errorPage) {
+        path_ = status->errorPage;
+        int err = 0;
+        fullPath_.assign(srcDir_).append(path_);
+        file_ = FileCache::Instance()->Get(fullPath_, &err);
+        mmFileStat_ = file_ ? file_->st : (struct stat){ 0 };
+        bodyOffset_ = 0;
+        bodyLen_ = mmFileStat_.st_size;
     }
 }
 
@@ -150,18 +413,14 @@ void HttpResponse::ErrorHtml_() {
  * @param buff 缓冲区对象
  */
 void HttpResponse::AddStateLine_(Buffer& buff) {
-    string status;
-    // 如果状态码对应的状态描述存在，则获取状态描述
-    if(CODE_STATUS.count(code_) == 1) {
-        status = CODE_STATUS.find(code_)->second;
-    }
-    // 如果状态码不存在，则设置状态码为 400，并获取对应的状态描述
-    else {
+    const Status* status = FindStatus_(code_);
+    // 如果状态码不存在，则设置状态码为 400
+    if(!status) {
         code_ = 400;
-        status = CODE_STATUS.find(400)->second;
+        status = FindStatus_(400);
     }
-    // 将状态行添加到缓冲区
-    buff.Append("HTTP/1.1 " + to_string(code_) + " " + status + "\r\n");
+    // 将预先生成的状态行添加到缓冲区
+    buff.Append(status->line, status->lineLen);
 }
 
 /**
@@ -169,18 +428,29 @@ void HttpResponse::AddStateLine_(Buffer& buff) {
  * @param buff 缓冲区对象
  */
 void HttpResponse::AddHeader_(Buffer& buff) {
-    // 添加 Connection 头
-    buff.Append("Connection: ");
     // 如果保持连接，则添加 keep-alive 相关头
     if(isKeepAlive_) {
-        buff.Append("keep-alive\r\n");
-        buff.Append("keep-alive: max=6, timeout=120\r\n");
+        buff.AppendLiteral("Connection: keep-alive\r\n");
+        // 通告实际生效的限制
+        if(keepAliveMax_ > 0 && keepAliveTimeout_ > 0) {
+            buff.AppendLiteral("keep-alive: max=");
+            buff.AppendUInt(keepAliveMax_);
+            buff.AppendLiteral(", timeout=");
+            buff.AppendUInt(keepAliveTimeout_);
+            buff.AppendLiteral("\r\n");
+        } else if(keepAliveMax_ > 0) {
+            buff.AppendLiteral("keep-alive: max=");
+            buff.AppendUInt(keepAliveMax_);
+            buff.AppendLiteral("\r\n");
+        } else if(keepAliveTimeout_ > 0) {
+            buff.AppendLiteral("keep-alive: timeout=");
+            buff.AppendUInt(keepAliveTimeout_);
+            buff.AppendLiteral("\r\n");
+        }
     } else{
         // 如果不保持连接，则添加 close 头
-        buff.Append("close\r\n");
+        buff.AppendLiteral("Connection: close\r\n");
     }
-    // 添加 Content-type 头
-    buff.Append("Content-type: " + GetFileType_() + "\r\n");
 }
 
 /**
@@ -188,53 +458,81 @@ void HttpResponse::AddHeader_(Buffer& buff) {
  * @param buff 缓冲区对象
  */
 void HttpResponse::AddContent_(Buffer& buff) {
-    // 打开文件
-    int srcFd = open((srcDir_ + path_).data(), O_RDONLY);
     // 如果文件打开失败，则添加错误内容到缓冲区并返回
-    if(srcFd < 0) { 
+    if(!file_) { 
+        buff.Append(ContentTypeHeader(path_));
         ErrorContent(buff, "File NotFound!");
         return; 
     }
-
-    //将文件映射到内存提高文件的访问速度  MAP_PRIVATE 建立一个写入时拷贝的私有映射
-    LOG_DEBUG("file path %s", (srcDir_ + path_).data());
-    int* mmRet = (int*)mmap(0, mmFileStat_.st_size, PROT_READ, MAP_PRIVATE, srcFd, 0);
-    // 如果内存映射失败，则添加错误内容到缓冲区并返回
-    if(*mmRet == -1) {
-        ErrorContent(buff, "File NotFound!");
-        return; 
+    LOG_DEBUG("file path %s", file_->path.data());
+    switch(code_) {
+    case 304:
+        // 304 只带校验头，没有响应体
+        buff.Append(file_->validators);
+        buff.AppendLiteral("\r\n");
+        break;
+    case 206:
+        buff.Append(file_->prefix);
+        buff.AppendLiteral("Content-Range: bytes ");
+        buff.AppendUInt(bodyOffset_);
+        buff.AppendLiteral("-");
+        buff.AppendUInt(bodyOffset_ + bodyLen_ - 1);
+        buff.AppendLiteral("/");
+        buff.AppendUInt(mmFileStat_.st_size);
+        buff.AppendLiteral("\r\nContent-length: ");
+        buff.AppendUInt(bodyLen_);
+        buff.AppendLiteral("\r\n\r\n");
+        break;
+    case 416:
+        buff.AppendLiteral("Content-Range: bytes */");
+        buff.AppendUInt(mmFileStat_.st_size);
+        buff.AppendLiteral("\r\nContent-length: 0\r\n\r\n");
+        break;
+    default:
+        // 文件缓存条目中已预先生成 Content-type 和 Content-length 头
+        buff.Append(file_->header);
+        break;
     }
-    // 设置内存映射文件指针
-    mmFile_ = (char*)mmRet;
-    // 关闭文件描述符
-    close(srcFd);
-    // 添加 Content-length 头和响应内容到缓冲区
-    buff.Append("Content-length: " + to_string(mmFileStat_.st_size) + "\r\n\r\n");
 }
 
 /**
- * @brief 释放内存映射文件
+ * @brief 释放借用的文件缓存条目
  */
 void HttpResponse::UnmapFile() {
-    // 检查内存映射文件指针是否为空
-    if(mmFile_) {
-        // 使用 munmap 函数释放内存映射文件
-        munmap(mmFile_, mmFileStat_.st_size);
-        // 将内存映射文件指针设置为 nullptr
-        mmFile_ = nullptr;
+    // 只释放引用，条目被淘汰且没有其他引用时才真正 munmap/close
+    file_.reset();
+}
+
+// 根据文件后缀名获取预先生成的 Content-type 头
+const string& HttpResponse::ContentTypeHeader(const string& path) {
+    // 第一次调用时由 SUFFIX_TYPE 生成全部头部片段（局部静态变量的初始化是线程安全的）
+    static const unordered_map<string, string> HEADERS = [] {
+        unordered_map<string, string> headers;
+        for(const auto& type : SUFFIX_TYPE) {
+            headers.emplace(type.first, "Content-type: " + type.second + "\r\n");
+        }
+        return headers;
+    }();
+    static const string DEFAULT_HEADER = "Content-type: text/plain\r\n";
+    string::size_type idx = path.find_last_of('.');
+    if(idx == string::npos) {
+        return DEFAULT_HEADER;
     }
+    // 后缀名都很短，substr 不会分配堆内存
+    auto it = HEADERS.find(path.substr(idx));
+    return it != HEADERS.end() ? it->second : DEFAULT_HEADER;
 }
 
-// 判断文件类型 
-string HttpResponse::GetFileType_() {
+// 根据文件后缀名判断 MIME 类型
+string HttpResponse::MimeType(const string& path) {
     // 查找路径中最后一个点的位置，即文件后缀名的起始位置
-    string::size_type idx = path_.find_last_of('.');
+    string::size_type idx = path.find_last_of('.');
     // 如果没有找到点，说明没有后缀名，返回默认的MIME类型 "text/plain"
     if(idx == string::npos) {   // 最大值 find函数在找不到指定值得情况下会返回string::npos
         return "text/plain";
     }
     // 获取文件后缀名
-    string suffix = path_.substr(idx);
+    string suffix = path.substr(idx);
     // 如果后缀名在 SUFFIX_TYPE 映射中存在，返回对应的MIME类型
     if(SUFFIX_TYPE.count(suffix) == 1) {
         return SUFFIX_TYPE.find(suffix)->second;
@@ -250,9 +548,10 @@ void HttpResponse::ErrorContent(Buffer& buff, string message)
     // 构建错误页面的HTML内容
     body += "<html><title>Error</title>";
     body += "<body bgcolor=\"ffffff\">";
-    // 如果状态码在 CODE_STATUS 映射中存在，获取对应的状态描述
-    if(CODE_STATUS.count(code_) == 1) {
-        status = CODE_STATUS.find(code_)->second;
+    // 如果状态码在状态码表中存在，获取对应的状态描述
+    const Status* known = FindStatus_(code_);
+    if(known) {
+        status = known->text;
     } else {
         // 如果状态码不在映射中，设置状态描述为 "Bad Request"
         status = "Bad Request";
@@ -264,7 +563,9 @@ void HttpResponse::ErrorContent(Buffer& buff, string message)
     body += "<hr><em>TinyWebServer</em></body></html>";
 
     // 将错误页面的HTML内容长度添加到缓冲区
-    buff.Append("Content-length: " + to_string(body.size()) + "\r\n\r\n");
+    buff.AppendLiteral("Content-length: ");
+    buff.AppendUInt(body.size());
+    buff.AppendLiteral("\r\n\r\n");
     // 将错误页面的HTML内容添加到缓冲区
     buff.Append(body);
 }
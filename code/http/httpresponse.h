@@ -9,6 +9,9 @@
 
 #include "../buffer/buffer.h"
 #include "../log/log.h"
+#include "filecache.h"
+
+class HttpRequest;
 
 class HttpResponse {
 public:
@@ -28,8 +31,29 @@ public:
      * @param path 请求路径
      * @param isKeepAlive 是否保持连接，默认为 false
      * @param code HTTP 状态码，默认为 -1
+     * @param useSendfile 为 true 时由调用者用 sendfile 发送文件描述符，否则用 writev 发送内存映射
+     */
+    void Init(const std::string& srcDir, std::string& path, bool isKeepAlive = false, int code = -1,
+              bool useSendfile = false);
+
+    /**
+     * @brief 设置响应头中通告的长连接限制，需在 Init 之后、MakeResponse 之前调用
+     * @param remaining 本连接还能处理的请求数，小于等于0时不通告
+     * @param timeoutSec 空闲超时（秒），小于等于0时不通告
+     */
+    void SetKeepAlive(int remaining, int timeoutSec);
+
+    /**
+     * @brief 设置客户端接受的压缩格式，需在 Init 之后、MakeResponse 之前调用
+     * @param encodings HttpRequest::AcceptEncoding() 的返回值，文件有对应的预压缩版本时发送压缩版本
+     */
+    void SetAcceptEncoding(int encodings);
+
+    /**
+     * @brief 保存请求中的条件请求头（If-None-Match/If-Modified-Since）和 Range/If-Range，需在 Init 之后、MakeResponse 之前调用
+     * @param request 已解析完整的请求，请求头切片在此处拷贝，之后请求可以被 Retrieve
      */
-    void Init(const std::string& srcDir, std::string& path, bool isKeepAlive = false, int code = -1);
+    void SetConditional(const HttpRequest& request);
 
     /**
      * @brief 生成 HTTP 响应
@@ -38,19 +62,45 @@ public:
     void MakeResponse(Buffer& buff);
 
     /**
-     * @brief 释放内存映射文件
+     * @brief 生成正文不来自文件的 200 响应（如 /metrics），需在 Init 之后调用
+     * @param buff 缓冲区对象
+     * @param contentType Content-type 的值
+     * @param body 响应正文，直接追加到缓冲区
+     */
+    void MakeContent(Buffer& buff, const char* contentType, const std::string& body);
+
+    /**
+     * @brief 释放借用的文件缓存条目
      */
     void UnmapFile();
 
     /**
-     * @brief 获取内存映射文件指针
+     * @brief 获取 sendfile 模式下使用的文件描述符
+     * @return 文件描述符，未打开或非 sendfile 模式时为 -1
+     */
+    int FileFd() const;
+
+    /**
+     * @brief 获取要发送的文件内容在内存映射中的起始位置（206响应时指向请求的区间）
      * @return 内存映射文件指针
      */
     char* File();
 
     /**
-     * @brief 获取内存映射文件大小
-     * @return 内存映射文件大小
+     * @brief 获取要发送的文件内容在文件中的偏移，sendfile 模式从该偏移开始发送
+     * @return 文件偏移，非206响应时为0
+     */
+    off_t FileOffset() const { return bodyOffset_; }
+
+    /**
+     * @brief 获取借用的文件缓存条目，调用者持有引用即可在响应对象复用后继续发送该文件
+     * @return 文件缓存条目，没有文件时为nullptr
+     */
+    const FileEntryPtr& Entry() const { return file_; }
+
+    /**
+     * @brief 获取要发送的文件内容长度
+     * @return 206响应时为区间长度，304/416响应时为0，否则为文件大小
      */
     size_t FileLen() const;
 
@@ -67,7 +117,57 @@ public:
      */
     int Code() const { return code_; }
 
+    /**
+     * @brief 根据文件后缀名获取 MIME 类型
+     * @param path 文件路径
+     * @return MIME 类型字符串
+     */
+    static std::string MimeType(const std::string& path);
+
+    /**
+     * @brief 根据文件后缀名获取预先生成的 "Content-type: ...\r\n" 头
+     * @param path 文件路径
+     * @return 头部片段，程序启动后第一次调用时生成
+     */
+    static const std::string& ContentTypeHeader(const std::string& path);
+
 private:
+    /**
+     * @brief 状态码对应的状态描述、编译期拼好的状态行和错误页面
+     */
+    struct Status {
+        int code;
+        const char* text;       // 状态描述，如 "OK"
+        const char* line;       // 完整状态行，如 "HTTP/1.1 200 OK\r\n"
+        size_t lineLen;
+        const char* errorPage;  // 错误页面路径，没有时为 nullptr
+    };
+
+    /**
+     * @brief 查找状态码
+     * @return 不认识的状态码返回 nullptr
+     */
+    static const Status* FindStatus_(int code);
+
+    /**
+     * @brief 根据 If-None-Match/If-Modified-Since 和 Range/If-Range 把200响应改为304、206或416
+     */
+    void CheckConditional_();
+
+    /**
+     * @brief If-None-Match（优先）或 If-Modified-Since 是否表明客户端的缓存仍然有效
+     */
+    bool NotModified_() const;
+
+    /**
+     * @brief 解析单个区间的 Range 请求头
+     * @param size 文件大小
+     * @param first 区间第一个字节的偏移
+     * @param last 区间最后一个字节的偏移
+     * @return 206表示区间有效，416表示区间无法满足，0表示忽略 Range（语法错误、多个区间）
+     */
+    int ParseRange_(off_t size, off_t* first, off_t* last) const;
+
     /**
      * @brief 添加状态行到缓冲区
      * @param buff 缓冲区对象
@@ -91,31 +191,41 @@ private:
      */
     void ErrorHtml_();
 
-    /**
-     * @brief 获取文件类型
-     * @return 文件类型字符串
-     */
-    std::string GetFileType_();
-
     // HTTP 状态码
     int code_;
     // 是否保持连接
     bool isKeepAlive_;
+    // 通告的剩余请求数和空闲超时（秒）
+    int keepAliveMax_;
+    int keepAliveTimeout_;
+    // 客户端接受的压缩格式（HttpRequest::ContentEncoding）
+    int acceptEncoding_;
+    // 条件请求和 Range 请求头的拷贝，复用容量
+    std::string ifNoneMatch_;
+    std::string ifModifiedSince_;
+    std::string range_;
+    std::string ifRange_;
+    // 要发送的文件内容的偏移和长度
+    off_t bodyOffset_;
+    size_t bodyLen_;
     // 请求路径
     std::string path_;
     // 源目录
     std::string srcDir_;
-    // 内存映射文件指针
-    char* mmFile_; 
+    // 源目录 + 请求路径，复用容量，查找文件缓存时不再拼接临时字符串
+    std::string fullPath_;
+    // 借用的文件缓存条目（持有文件描述符和内存映射）
+    FileEntryPtr file_;
     // 内存映射文件状态
     struct stat mmFileStat_;
+    // 是否使用 sendfile 发送文件
+    bool useSendfile_;
 
     // 后缀类型集
-    static const std::unordered_map<std::string, std::string> SUFFIX_TYPE;  
-    // 编码状态集
-    static const std::unordered_map<int, std::string> CODE_STATUS;          
-    // 编码路径集
-    static const std::unordered_map<int, std::string> CODE_PATH;            
+    static const std::unordered_map<std::string, std::string> SUFFIX_TYPE;
+    // 状态码表（状态描述、状态行、错误页面）
+    static const Status STATUS_TABLE[];
+    static const size_t STATUS_COUNT;
 };
 
 
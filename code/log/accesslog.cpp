@@ -0,0 +1,240 @@
+#include "accesslog.h"
+
+#include <sched.h>
+#include <pthread.h>
+#include <string.h>
+#include <assert.h>
+#include <sys/time.h>
+#include <sys/stat.h>
+#include <arpa/inet.h>
+
+using namespace std;
+
+AccessLog* AccessLog::Instance() {
+    static AccessLog log;
+    return &log;
+}
+
+uint64_t AccessLog::NowUs() {
+    struct timeval now = {0, 0};
+    gettimeofday(&now, nullptr);
+    return (uint64_t)now.tv_sec * 1000000 + now.tv_usec;
+}
+
+void AccessLog::Init(const char* path, const char* suffix, size_t maxFileBytes, size_t capacity, int cpu) {
+    assert(path && suffix && maxFileBytes > FILE_HEADER_SIZE && capacity > 0);
+    {
+        lock_guard<mutex> locker(mtx_);
+        path_ = path;
+        suffix_ = suffix;
+        maxFileBytes_ = maxFileBytes;
+        if(fp_) {
+            fflush(fp_);
+            fclose(fp_);
+            fp_ = nullptr;
+        }
+        OpenLocked_(time(nullptr), true);
+    }
+    if(!writeThread_) {
+        if(!ring_) { ring_.reset(new Ring(capacity)); }
+        running_ = true;
+        cpu_ = cpu;
+        writeThread_.reset(new thread(&AccessLog::Run_, this));
+    }
+    isOpen_ = true;
+}
+
+void AccessLog::Close() {
+    if(!writeThread_) { return; }
+    isOpen_ = false;
+    running_ = false;
+    {
+        lock_guard<mutex> locker(waitMtx_);
+        cond_.notify_one();
+    }
+    writeThread_->join();
+    writeThread_.reset();
+    // 队列保留：关闭前已通过IsOpen检查的线程仍可能调用Append
+    lock_guard<mutex> locker(mtx_);
+    if(fp_) {
+        fflush(fp_);
+        fclose(fp_);
+        fp_ = nullptr;
+    }
+}
+
+bool AccessLog::Append(const AccessRecord& record) {
+    if(!ring_->TryPush(reinterpret_cast<const char*>(&record), sizeof(record))) {
+        dropped_.fetch_add(1, memory_order_relaxed);
+        return false;
+    }
+    // 与写线程中的fence配对，写线程在等待时才需要唤醒
+    atomic_thread_fence(memory_order_seq_cst);
+    if(writerWaiting_.load(memory_order_relaxed)) {
+        lock_guard<mutex> locker(waitMtx_);
+        cond_.notify_one();
+    }
+    return true;
+}
+
+// 写线程：把记录攒成一批原样写入文件，队列空时冲洗文件并等待
+void AccessLog::Run_() {
+    // 绑核由调用者决定CPU，这里不依赖CpuAffinity，离线解码工具只需要链接本文件
+    if(cpu_ >= 0 && cpu_ < CPU_SETSIZE) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu_, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+    unique_ptr<char[]> batch(new char[BATCH_RECORDS * sizeof(AccessRecord)]);
+    while(true) {
+        size_t used = 0;
+        size_t n = ring_->Consume([&](const char* data, size_t len) {
+            assert(len == sizeof(AccessRecord));
+            memcpy(batch.get() + used, data, len);
+            used += len;
+        }, BATCH_RECORDS);
+        if(n > 0) {
+            lock_guard<mutex> locker(mtx_);
+            WriteLocked_(batch.get(), used);
+            written_.fetch_add(n, memory_order_relaxed);
+            continue;
+        }
+        {
+            lock_guard<mutex> locker(mtx_);
+            if(fp_) { fflush(fp_); }
+        }
+        if(!running_) { break; }
+        unique_lock<mutex> locker(waitMtx_);
+        writerWaiting_.store(true, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+        if(ring_->Empty() && running_) {
+            cond_.wait_for(locker, chrono::milliseconds(100));
+        }
+        writerWaiting_.store(false, memory_order_relaxed);
+    }
+}
+
+// 按日期和文件大小切换文件后写入一批记录（记录不跨文件）
+void AccessLog::WriteLocked_(const char* data, size_t len) {
+    time_t sec = time(nullptr);
+    if(sec != checkSec_) {
+        checkSec_ = sec;
+        struct tm t;
+        localtime_r(&sec, &t);
+        if(t.tm_mday != toDay_) {
+            OpenLocked_(sec, true);
+        }
+    }
+    while(len > 0 && fp_) {
+        if(fileBytes_ + sizeof(AccessRecord) > maxFileBytes_) {
+            OpenLocked_(sec, false);
+            if(!fp_) { break; }
+        }
+        size_t room = (maxFileBytes_ - fileBytes_) / sizeof(AccessRecord) * sizeof(AccessRecord);
+        size_t n = len < room ? len : room;
+        fwrite(data, 1, n, fp_);
+        fileBytes_ += n;
+        data += n;
+        len -= n;
+    }
+}
+
+void AccessLog::OpenLocked_(time_t sec, bool newDay) {
+    struct tm t;
+    localtime_r(&sec, &t);
+    if(newDay) {
+        toDay_ = t.tm_mday;
+        fileIndex_ = 0;
+    } else {
+        fileIndex_++;
+    }
+    checkSec_ = sec;
+    if(fp_) {
+        fflush(fp_);
+        fclose(fp_);
+    }
+
+    char fileName[LOG_NAME_LEN] = {0};
+    if(fileIndex_ == 0) {
+        snprintf(fileName, LOG_NAME_LEN - 1, "%s/%04d_%02d_%02d%s",
+                 path_, t.tm_year + 1900, t.tm_mon + 1, t.tm_mday, suffix_);
+    } else {
+        snprintf(fileName, LOG_NAME_LEN - 1, "%s/%04d_%02d_%02d-%d%s",
+                 path_, t.tm_year + 1900, t.tm_mon + 1, t.tm_mday, fileIndex_, suffix_);
+    }
+    fp_ = fopen(fileName, "a");
+    if(fp_ == nullptr) {
+        mkdir(path_, 0777);
+        fp_ = fopen(fileName, "a");
+    }
+    if(fp_ == nullptr) {
+        fileBytes_ = 0;
+        return;     // 打不开时丢弃记录，不影响服务
+    }
+    // 追加到已有文件时沿用原来的文件头
+    fseek(fp_, 0, SEEK_END);
+    long size = ftell(fp_);
+    fileBytes_ = size > 0 ? (size_t)size : 0;
+    if(fileBytes_ == 0) {
+        uint32_t header[4] = {FILE_MAGIC, FILE_VERSION, (uint32_t)sizeof(AccessRecord), 0};
+        static_assert(sizeof(header) == FILE_HEADER_SIZE, "access log header size mismatch");
+        fwrite(header, 1, sizeof(header), fp_);
+        fileBytes_ = sizeof(header);
+    }
+}
+
+// 转义成JSON字符串的内容：引号和反斜杠加反斜杠，控制字符写成\u00XX，out至少要有len * 6 + 1字节
+static void EscapeJson(const char* s, int len, char* out) {
+    static const char HEX[] = "0123456789abcdef";
+    int m = 0;
+    for(int i = 0; i < len; i++) {
+        unsigned char c = static_cast<unsigned char>(s[i]);
+        if(c == '"' || c == '\\') {
+            out[m++] = '\\';
+            out[m++] = c;
+        } else if(c < 0x20) {
+            memcpy(out + m, "\\u00", 4);
+            out[m + 4] = HEX[c >> 4];
+            out[m + 5] = HEX[c & 0xf];
+            m += 6;
+        } else {
+            out[m++] = c;
+        }
+    }
+    out[m] = '\0';
+}
+
+int AccessLog::Format(const AccessRecord& r, char* buf, size_t len, bool json) {
+    time_t sec = (time_t)(r.timeUs / 1000000);
+    struct tm t;
+    localtime_r(&sec, &t);
+    char ip[INET_ADDRSTRLEN] = {0};
+    struct in_addr addr;
+    addr.s_addr = r.clientIp;
+    inet_ntop(AF_INET, &addr, ip, sizeof(ip));
+    char method[sizeof(r.method) + 1] = {0};
+    memcpy(method, r.method, sizeof(r.method));
+    int pathLen = r.pathLen < sizeof(r.path) ? r.pathLen : (int)sizeof(r.path);
+
+    int n;
+    if(json) {
+        // 请求行里的方法和路径除空格外可以是任意字节，控制字符也要转义
+        char path[sizeof(r.path) * 6 + 1];
+        EscapeJson(r.path, pathLen, path);
+        char jsonMethod[sizeof(r.method) * 6 + 1];
+        EscapeJson(method, strlen(method), jsonMethod);
+        n = snprintf(buf, len, "{\"time\":\"%d-%02d-%02dT%02d:%02d:%02d.%06u\",\"client\":\"%s:%u\","
+                     "\"method\":\"%s\",\"path\":\"%s\",\"status\":%u,\"bytes\":%u,\"latency_us\":%u}",
+                     t.tm_year + 1900, t.tm_mon + 1, t.tm_mday, t.tm_hour, t.tm_min, t.tm_sec,
+                     (unsigned)(r.timeUs % 1000000), ip, (unsigned)ntohs(r.clientPort), jsonMethod, path,
+                     (unsigned)r.status, (unsigned)r.bytes, (unsigned)r.latencyUs);
+    } else {
+        n = snprintf(buf, len, "%d-%02d-%02d %02d:%02d:%02d.%06u %s:%u \"%s %.*s\" %u %u %uus",
+                     t.tm_year + 1900, t.tm_mon + 1, t.tm_mday, t.tm_hour, t.tm_min, t.tm_sec,
+                     (unsigned)(r.timeUs % 1000000), ip, (unsigned)ntohs(r.clientPort), method,
+                     pathLen, r.path, (unsigned)r.status, (unsigned)r.bytes, (unsigned)r.latencyUs);
+    }
+    if(n < 0) { return 0; }
+    return (size_t)n < len ? n : (int)len - 1;
+}
@@ -0,0 +1,129 @@
+/**
+ * @file accesslog.h
+ * @brief 定义了二进制访问日志 AccessLog。
+ */
+
+#ifndef ACCESSLOG_H
+#define ACCESSLOG_H
+
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <condition_variable>
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include "logring.h"
+
+/**
+ * @brief 一条访问日志记录，定长128字节，按原样写入文件。
+ */
+struct AccessRecord {
+    uint64_t timeUs;        // 请求解析完成的时间（Unix时间，微秒）
+    uint32_t latencyUs;     // 从请求解析完成到响应最后一个字节发出的耗时（微秒）
+    uint32_t bytes;         // 响应的总字节数（响应头 + 文件）
+    uint32_t clientIp;      // 客户端IPv4地址（网络字节序）
+    uint16_t clientPort;    // 客户端端口（网络字节序）
+    uint16_t status;        // 响应状态码
+    char method[8];         // 请求方法，不足8字节时以'\0'结尾
+    uint8_t pathLen;        // path的有效长度，超出部分截断
+    char path[95];          // 请求路径，不以'\0'结尾
+};
+static_assert(sizeof(AccessRecord) == 128, "AccessRecord must be 128 bytes");
+
+/**
+ * @brief 每个请求一条的访问日志，热路径上不做任何格式化。
+ *
+ * 请求线程只填好一条定长的AccessRecord，放进无锁环形队列就返回；独立的写线程把记录攒成一批原样fwrite到
+ * 二进制文件。文件以FILE_MAGIC开头的16字节文件头标明版本和记录长度，之后是连续的记录，
+ * 用tools/accesslog_dump（或Format）转成文本或JSON。文件按日期切换，超过maxFileBytes时切换到带序号的新文件，
+ * 与Log按MAX_LINES切换的规则一致。队列满时丢弃记录并计数，不阻塞请求线程。
+ */
+class AccessLog {
+public:
+    static const uint32_t FILE_MAGIC = 0x4c415357;  // "WSAL"
+    static const uint32_t FILE_VERSION = 1;
+    static const size_t FILE_HEADER_SIZE = 16;      // magic、版本、记录长度、保留字段各4字节
+    static const size_t MAX_LINE = 1024;            // Format输出一行的最大长度（JSON中控制字符转义后）
+
+    static AccessLog* Instance();
+
+    /**
+     * @brief 打开访问日志并启动写线程，重复调用时只切换文件
+     * @param path 日志目录
+     * @param suffix 文件后缀
+     * @param maxFileBytes 单个文件的最大字节数
+     * @param capacity 队列容量（记录条数）
+     * @param cpu 写线程绑定的CPU，小于0时不绑定（只在第一次启动写线程时生效）
+     */
+    void Init(const char* path = "./log", const char* suffix = ".access",
+              size_t maxFileBytes = 64 * 1024 * 1024, size_t capacity = 8192, int cpu = -1);
+
+    /**
+     * @brief 停止写线程，写完队列中剩下的记录后关闭文件
+     */
+    void Close();
+
+    // 每个请求都会调用，只做一次relaxed原子读
+    bool IsOpen() const { return isOpen_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief 提交一条记录，可在任意线程调用
+     * @return 队列已满（记录被丢弃）时返回false
+     */
+    bool Append(const AccessRecord& record);
+
+    /**
+     * @brief 把一条记录格式化成一行文本（或JSON），不含换行
+     * @param len buf的大小，不小于MAX_LINE时不会截断
+     * @return 写入buf的字节数
+     */
+    static int Format(const AccessRecord& record, char* buf, size_t len, bool json);
+
+    /**
+     * @brief 当前的Unix时间（微秒），用于填写timeUs
+     */
+    static uint64_t NowUs();
+
+    uint64_t Written() const { return written_.load(std::memory_order_relaxed); }
+    uint64_t Dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    typedef BasicLogRing<(sizeof(AccessRecord) + sizeof(size_t) + sizeof(uint32_t) + 7) / 8 * 8> Ring;
+    static const size_t BATCH_RECORDS = 512;    // 写线程每次fwrite的最大记录数
+    static const int LOG_NAME_LEN = 256;
+
+    AccessLog() = default;
+    ~AccessLog() { Close(); }
+
+    void Run_();
+    void WriteLocked_(const char* data, size_t len);
+    void OpenLocked_(time_t sec, bool newDay);  // 在mtx_内打开今天的（下一个）文件
+
+    const char* path_ = nullptr;
+    const char* suffix_ = nullptr;
+    size_t maxFileBytes_ = 0;
+    int cpu_ = -1;              // 写线程绑定的CPU
+
+    // 以下在mtx_内访问
+    FILE* fp_ = nullptr;
+    size_t fileBytes_ = 0;      // 当前文件已写入的字节数
+    int fileIndex_ = 0;         // 当天的第几个文件
+    int toDay_ = 0;
+    time_t checkSec_ = -1;      // 上次检查日期的秒数
+    std::mutex mtx_;
+
+    std::unique_ptr<Ring> ring_;
+    std::unique_ptr<std::thread> writeThread_;
+    std::atomic<bool> isOpen_{false};
+    std::atomic<bool> running_{false};
+    std::atomic<bool> writerWaiting_{false};
+    std::mutex waitMtx_;
+    std::condition_variable cond_;
+
+    std::atomic<uint64_t> written_{0};
+    std::atomic<uint64_t> dropped_{0};
+};
+
+#endif // ACCESSLOG_H
@@ -1,34 +1,75 @@
 #include "log.h"
+#include "../pool/cpuaffinity.h"
+
+using namespace std;
+
+namespace {
+
+// 每个线程自己的格式化缓冲区和按秒缓存的时间前缀，write不再共享缓冲区
+struct LogThreadBuf {
+    time_t sec = -1;            // prefix对应的秒数
+    char prefix[24];            // "YYYY-MM-DD HH:MM:SS"
+    int prefixLen = 0;
+    char line[1024];
+};
+
+thread_local LogThreadBuf tlsBuf;
+
+const char* const LEVEL_TITLE[] = {
+    "[debug]: ", "[info] : ", "[warn] : ", "[error]: "
+};
+
+}
 
 // 构造函数
 Log::Log() {
     fp_ = nullptr;
-    deque_ = nullptr;
+    ring_ = nullptr;
     writeThread_ = nullptr;
     lineCount_ = 0;
     toDay_ = 0;
+    fileIndex_ = 0;
+    rotateSec_ = -1;
+    isOpen_ = false;
+    level_ = 1;
     isAsync_ = false;
+    running_ = false;
+    writerWaiting_ = false;
 }
 
 Log::~Log() {
-    while(!deque_->empty()) {
-        deque_->flush();    // 唤醒消费者，处理掉剩下的任务
+    Close();
+}
+
+// 调用时其他线程不应再写日志：先关闭开关，写线程写完队列中剩下的日志后退出，再冲洗并关闭文件
+void Log::Close() {
+    isOpen_ = false;
+    // 只有异步日志才有队列和写线程（没有调用Init时两者都为空）
+    if(ring_ && writeThread_) {
+        running_ = false;   // 写线程写完队列中剩下的日志后退出
+        {
+            lock_guard<mutex> locker(waitMtx_);
+            cond_.notify_one();
+        }
+        writeThread_->join();
+        writeThread_.reset();
     }
-    deque_->Close();    // 关闭队列
-    writeThread_->join();   // 等待当前线程完成手中的任务
+    lock_guard<mutex> locker(mtx_);
     if(fp_) {       // 冲洗文件缓冲区，关闭文件描述符
-        lock_guard<mutex> locker(mtx_);
-        flush();        // 清空缓冲区中的数据
-        fclose(fp_);    // 关闭日志文件
+        fflush(fp_);
+        fclose(fp_);
+        fp_ = nullptr;
     }
 }
 
-// 唤醒阻塞队列消费者，开始写日志
+// 异步模式唤醒写线程（它写完队列后会冲洗文件），同步模式直接冲洗文件缓冲区
 void Log::flush() {
-    if(isAsync_) {  // 只有异步日志才会用到deque
-        deque_->flush();
+    if(isAsync_) {
+        WakeWriter_();
+        return;
     }
-    fflush(fp_);    // 清空输入缓冲区
+    lock_guard<mutex> locker(mtx_);
+    if(fp_) { fflush(fp_); }
 }
 
 // 懒汉模式 局部静态变量法（这种方法不需要加锁和解锁操作）
@@ -39,177 +80,207 @@ Log* Log::Instance() {
 
 // 异步日志的写线程函数
 void Log::FlushLogThread() {
+    // 落盘不在工作线程的核上进行
+    CpuAffinity::Instance()->PinHousekeeping();
     Log::Instance()->AsyncWrite_();
 }
 
-// 写线程真正的执行函数
+void Log::WakeWriter_() {
+    // 与写线程中的fence配对：要么写线程能看到刚发布的日志，要么这里能看到它在等待
+    atomic_thread_fence(memory_order_seq_cst);
+    if(writerWaiting_.load(memory_order_relaxed)) {
+        lock_guard<mutex> locker(waitMtx_);
+        cond_.notify_one();
+    }
+}
+
+// 写线程真正的执行函数：把队列中的日志攒成一批，一次fwrite写入文件
 void Log::AsyncWrite_() {
-    string str = "";
-    while(deque_->pop(str)) {
-        lock_guard<mutex> locker(mtx_);
-        fputs(str.c_str(), fp_);
+    unique_ptr<char[]> batch(new char[BATCH_SIZE]);
+    size_t used = 0, lines = 0;
+    while(true) {
+        size_t n = ring_->Consume([&](const char* data, size_t len) {
+            if(used + len > BATCH_SIZE) {
+                lock_guard<mutex> locker(mtx_);
+                WriteLocked_(batch.get(), used, lines, time(nullptr));
+                used = lines = 0;
+            }
+            memcpy(batch.get() + used, data, len);
+            used += len;
+            lines++;
+        }, BATCH_SIZE / 64);
+        if(n > 0) { continue; }
+
+        // 队列已空：写出这一批并冲洗文件，然后等待新的日志
+        if(used > 0) {
+            lock_guard<mutex> locker(mtx_);
+            WriteLocked_(batch.get(), used, lines, time(nullptr));
+            fflush(fp_);
+            used = lines = 0;
+        }
+        if(!running_) { break; }
+        unique_lock<mutex> locker(waitMtx_);
+        writerWaiting_.store(true, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+        if(ring_->Empty() && running_) {
+            // 超时只是兜底，正常情况下由生产者唤醒
+            cond_.wait_for(locker, chrono::milliseconds(100));
+        }
+        writerWaiting_.store(false, memory_order_relaxed);
     }
 }
 
 // 初始化日志实例
 void Log::init(int level, const char* path, const char* suffix, int maxQueCapacity) {
-    // 设置日志系统为开启状态
-    isOpen_ = true;
     // 设置日志级别
     level_ = level;
-    // 设置日志文件路径
-    path_ = path;
-    // 设置日志文件后缀
-    suffix_ = suffix;
     // 如果最大队列容量大于0，则启用异步日志
-    if(maxQueCapacity) {    
+    if(maxQueCapacity) {
         isAsync_ = true;
-        // 如果队列未初始化，则创建一个新的队列
-        if(!deque_) {   
-            // 使用unique_ptr创建一个新的BlockQueue<std::string>对象
-            unique_ptr<BlockQueue<std::string>> newQue(new BlockQueue<std::string>);
-            // 将新创建的队列的所有权转移给deque_
-            deque_ = move(newQue);  
-            // 使用unique_ptr创建一个新的线程，该线程将执行FlushLogThread函数
-            unique_ptr<thread> newThread(new thread(FlushLogThread));
-            // 将新创建的线程的所有权转移给writeThread_
-            writeThread_ = move(newThread);
+        // 如果队列未初始化，则一次性分配所有槽位；写线程在Close()后重新创建
+        if(!ring_) {
+            ring_.reset(new LogRing(maxQueCapacity));
+        }
+        if(!writeThread_) {
+            running_ = true;
+            writeThread_.reset(new thread(FlushLogThread));
         }
     } else {
         // 如果最大队列容量为0，则禁用异步日志
         isAsync_ = false;
     }
 
-    // 初始化日志行数为0
-    lineCount_ = 0;
-    
     // 获取当前时间
     time_t timer = time(nullptr);
     // 将时间转换为本地时间
-    struct tm *sysTime = localtime(&timer);
-    struct tm t = *sysTime;
+    struct tm t;
+    localtime_r(&timer, &t);
     // 设置日志文件路径
     path_ = path;
     // 设置日志文件后缀
     suffix_ = suffix;
     // 生成日志文件名
     char fileName[LOG_NAME_LEN] = {0};
-    snprintf(fileName, LOG_NAME_LEN - 1, "%s/%04d_%02d_%02d%s", 
+    snprintf(fileName, LOG_NAME_LEN - 1, "%s/%04d_%02d_%02d%s",
             path_, t.tm_year + 1900, t.tm_mon + 1, t.tm_mday, suffix_);
-    // 设置当前日期
-    toDay_ = t.tm_mday;
 
     {
-        // 加锁，确保线程安全
+        // 加锁，确保线程安全（写线程写文件时也持有mtx_）
         lock_guard<mutex> locker(mtx_);
-        // 清空缓冲区
-        buff_.RetrieveAll();
+        // 初始化日志行数为0，设置当前日期
+        lineCount_ = 0;
+        fileIndex_ = 0;
+        toDay_ = t.tm_mday;
+        rotateSec_ = timer;
         // 如果文件指针不为空，则刷新缓冲区并关闭文件
-        if(fp_) {   
-            flush();
+        if(fp_) {
+            fflush(fp_);
             fclose(fp_);
         }
         // 打开日志文件，如果文件不存在则创建
-        fp_ = fopen(fileName, "a"); 
+        fp_ = fopen(fileName, "a");
         // 如果文件打开失败，则创建目录并重新打开文件
         if(fp_ == nullptr) {
             mkdir(path_, 0777);
-            fp_ = fopen(fileName, "a"); 
+            fp_ = fopen(fileName, "a");
         }
         // 确保文件指针不为空
         assert(fp_ != nullptr);
     }
+    // 文件打开后再设置日志系统为开启状态，LOG_*宏不加锁读这个标志
+    isOpen_ = true;
 }
 
-void Log::write(int level, const char *format, ...) {
-    struct timeval now = {0, 0};
-    gettimeofday(&now, nullptr);
-    time_t tSec = now.tv_sec;
-    struct tm *sysTime = localtime(&tSec);
-    struct tm t = *sysTime;
-    va_list vaList;
+// 日志日期 日志行数  如果不是今天或行数超了，则切换到新的日志文件
+void Log::CheckRotate_(time_t sec) {
+    if(sec == rotateSec_ && lineCount_ < (fileIndex_ + 1) * MAX_LINES) {
+        return;     // 同一秒内日期不会变，省掉localtime_r
+    }
+    rotateSec_ = sec;
+    struct tm t;
+    localtime_r(&sec, &t);
+    bool newDay = toDay_ != t.tm_mday;
+    if(!newDay && lineCount_ < (fileIndex_ + 1) * MAX_LINES) {
+        return;
+    }
+
+    char newFile[LOG_NAME_LEN];
+    char tail[36] = {0};
+    snprintf(tail, 36, "%04d_%02d_%02d", t.tm_year + 1900, t.tm_mon + 1, t.tm_mday);
 
-    // 日志日期 日志行数  如果不是今天或行数超了
-    if (toDay_ != t.tm_mday || (lineCount_ && (lineCount_  %  MAX_LINES == 0)))
+    if (newDay)    // 时间不匹配，则替换为最新的日志文件名
     {
-        unique_lock<mutex> locker(mtx_);
-        locker.unlock();
-        
-        char newFile[LOG_NAME_LEN];
-        char tail[36] = {0};
-        snprintf(tail, 36, "%04d_%02d_%02d", t.tm_year + 1900, t.tm_mon + 1, t.tm_mday);
-
-        if (toDay_ != t.tm_mday)    // 时间不匹配，则替换为最新的日志文件名
-        {
-            snprintf(newFile, LOG_NAME_LEN - 72, "%s/%s%s", path_, tail, suffix_);
-            toDay_ = t.tm_mday;
-            lineCount_ = 0;
-        }
-        else {
-            snprintf(newFile, LOG_NAME_LEN - 72, "%s/%s-%d%s", path_, tail, (lineCount_  / MAX_LINES), suffix_);
-        }
-        
-        locker.lock();
-        flush();
-        fclose(fp_);
-        fp_ = fopen(newFile, "a");
-        assert(fp_ != nullptr);
+        snprintf(newFile, LOG_NAME_LEN - 72, "%s/%s%s", path_, tail, suffix_);
+        toDay_ = t.tm_mday;
+        lineCount_ = 0;
+        fileIndex_ = 0;
+    }
+    else {
+        // 写线程按批计数，行数可能一次越过多个MAX_LINES
+        fileIndex_ = lineCount_ / MAX_LINES;
+        snprintf(newFile, LOG_NAME_LEN - 72, "%s/%s-%d%s", path_, tail, fileIndex_, suffix_);
     }
 
-    // 在buffer内生成一条对应的日志信息
-    {
-        unique_lock<mutex> locker(mtx_);
-        lineCount_++;
-        int n = snprintf(buff_.BeginWrite(), 128, "%d-%02d-%02d %02d:%02d:%02d.%06ld ",
+    fflush(fp_);
+    fclose(fp_);
+    fp_ = fopen(newFile, "a");
+    assert(fp_ != nullptr);
+}
+
+void Log::WriteLocked_(const char* data, size_t len, size_t lines, time_t sec) {
+    CheckRotate_(sec);
+    fwrite(data, 1, len, fp_);
+    lineCount_ += static_cast<int>(lines);
+}
+
+void Log::write(int level, const char *format, ...) {
+    struct timeval now = {0, 0};
+    gettimeofday(&now, nullptr);
+    LogThreadBuf& tb = tlsBuf;
+    static_assert(sizeof(tb.line) == LINE_SIZE, "log line buffer size mismatch");
+
+    // 时间前缀每秒只用localtime_r生成一次
+    if(now.tv_sec != tb.sec) {
+        struct tm t;
+        localtime_r(&now.tv_sec, &t);
+        tb.prefixLen = snprintf(tb.prefix, sizeof(tb.prefix), "%d-%02d-%02d %02d:%02d:%02d",
                     t.tm_year + 1900, t.tm_mon + 1, t.tm_mday,
-                    t.tm_hour, t.tm_min, t.tm_sec, now.tv_usec);
-                    
-        buff_.HasWritten(n);
-        AppendLogLevelTitle_(level);    
-
-        va_start(vaList, format);
-        int m = vsnprintf(buff_.BeginWrite(), buff_.WritableBytes(), format, vaList);
-        va_end(vaList);
-
-        buff_.HasWritten(m);
-        buff_.Append("\n\0", 2);
-
-        if(isAsync_ && deque_ && !deque_->full()) { // 异步方式（加入阻塞队列中，等待写线程读取日志信息）
-            deque_->push_back(buff_.RetrieveAllToStr());
-        } else {    // 同步方式（直接向文件中写入日志信息）
-            fputs(buff_.Peek(), fp_);   // 同步就直接写入文件
-        }
-        buff_.RetrieveAll();    // 清空buff
+                    t.tm_hour, t.tm_min, t.tm_sec);
+        tb.sec = now.tv_sec;
     }
-}
 
-// 添加日志等级
-void Log::AppendLogLevelTitle_(int level) {
-    switch(level) {
-    case 0:
-        buff_.Append("[debug]: ", 9);
-        break;
-    case 1:
-        buff_.Append("[info] : ", 9);
-        break;
-    case 2:
-        buff_.Append("[warn] : ", 9);
-        break;
-    case 3:
-        buff_.Append("[error]: ", 9);
-        break;
-    default:
-        buff_.Append("[info] : ", 9);
-        break;
+    // 在线程自己的缓冲区内生成一条对应的日志信息：时间.微秒 等级 内容\n
+    char* p = tb.line;
+    memcpy(p, tb.prefix, tb.prefixLen);
+    p += tb.prefixLen;
+    *p++ = '.';
+    long usec = now.tv_usec;
+    for(int i = 5; i >= 0; i--) {
+        p[i] = static_cast<char>('0' + usec % 10);
+        usec /= 10;
     }
-}
+    p += 6;
+    *p++ = ' ';
+    memcpy(p, LEVEL_TITLE[(level >= 0 && level <= 3) ? level : 1], 9);
+    p += 9;
 
-int Log::GetLevel() {
-    lock_guard<mutex> locker(mtx_);
-    return level_;
-}
+    size_t used = p - tb.line;
+    size_t left = LINE_SIZE - used - 1;     // 留一个字节给换行
+    va_list vaList;
+    va_start(vaList, format);
+    int m = vsnprintf(p, left + 1, format, vaList);
+    va_end(vaList);
+    if(m < 0) { m = 0; }
+    used += (static_cast<size_t>(m) < left) ? m : left;
+    tb.line[used++] = '\n';
 
-void Log::SetLevel(int level) {
+    // 异步方式：放进无锁队列，由写线程批量写入
+    if(isAsync_ && ring_ && ring_->TryPush(tb.line, used)) {
+        WakeWriter_();
+        return;
+    }
+    // 同步方式（或队列已满、单行过长）：直接写入文件
     lock_guard<mutex> locker(mtx_);
-    level_ = level;
-}
\ No newline at end of file
+    WriteLocked_(tb.line, used, 1, now.tv_sec);
+    if(!isAsync_) { fflush(fp_); }
+}
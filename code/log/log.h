@@ -9,12 +9,13 @@
 #include <stdarg.h>           // vastart va_end
 #include <assert.h>
 #include <sys/stat.h>         // mkdir
-#include "blockqueue.h"
-#include "../buffer/buffer.h"
+#include <atomic>
+#include <condition_variable>
+#include "logring.h"
 
 class Log {
 public:
-    // 初始化日志实例（阻塞队列最大容量、日志保存路径、日志文件后缀）
+    // 初始化日志实例（日志级别、日志保存路径、日志文件后缀、队列最大容量）
     void init(int level, const char* path = "./log", 
                 const char* suffix =".log",
                 int maxQueueCapacity = 1024);
@@ -23,22 +24,28 @@ public:
     static void FlushLogThread();   // 异步写日志公有方法，调用私有方法asyncWrite
     
     void write(int level, const char *format,...);  // 将输出内容按照标准格式整理
-    void flush();
+    void flush();   // 异步模式下唤醒写线程，同步模式下冲洗文件缓冲区
+    void Close();   // 写完队列中剩下的日志，停止写线程并关闭文件（退出前调用，之后可以再次init）
 
-    int GetLevel();
-    void SetLevel(int level);
-    bool IsOpen() { return isOpen_; }
+    // 每条LOG_*都会调用，只做一次relaxed原子读，不加锁
+    int GetLevel() const { return level_.load(std::memory_order_relaxed); }
+    void SetLevel(int level) { level_.store(level, std::memory_order_relaxed); }
+    bool IsOpen() const { return isOpen_.load(std::memory_order_relaxed); }
     
 private:
     Log();
-    void AppendLogLevelTitle_(int level);
     virtual ~Log();
     void AsyncWrite_(); // 异步写日志方法
+    void WakeWriter_(); // 写线程在等待时唤醒它
+    void WriteLocked_(const char* data, size_t len, size_t lines, time_t sec); // 在mtx_内写文件
+    void CheckRotate_(time_t sec);  // 在mtx_内按日期和行数切换日志文件
 
 private:
     static const int LOG_PATH_LEN = 256;    // 日志文件最长文件名
     static const int LOG_NAME_LEN = 256;    // 日志最长名字
     static const int MAX_LINES = 50000;     // 日志文件内的最长日志条数
+    static const int LINE_SIZE = 1024;      // 单行日志的最大长度（超出部分截断）
+    static const size_t BATCH_SIZE = 64 * 1024;    // 写线程每次fwrite的最大字节数
 
     const char* path_;          //路径名
     const char* suffix_;        //后缀名
@@ -47,25 +54,39 @@ private:
 
     int lineCount_;             //日志行数记录
     int toDay_;                 //按当天日期区分文件
+    int fileIndex_;             //当天的第几个日志文件
+    time_t rotateSec_;          //CheckRotate_上次检查的秒数
 
-    bool isOpen_;               
+    std::atomic<bool> isOpen_;
  
-    Buffer buff_;       // 输出的内容，缓冲区
-    int level_;         // 日志等级
+    std::atomic<int> level_;    // 日志等级
     bool isAsync_;      // 是否开启异步日志
 
     FILE* fp_;                                          //打开log的文件指针
-    std::unique_ptr<BlockQueue<std::string>> deque_;    //阻塞队列
+    std::unique_ptr<LogRing> ring_;                     //预分配槽位的无锁环形队列
     std::unique_ptr<std::thread> writeThread_;          //写线程的指针
-    std::mutex mtx_;                                    //同步日志必需的互斥量
+    std::mutex mtx_;                                    //保护文件指针、行数和日期
+
+    std::atomic<bool> running_;         // 写线程是否继续运行
+    std::atomic<bool> writerWaiting_;   // 写线程是否在cond_上等待
+    std::mutex waitMtx_;
+    std::condition_variable cond_;
 };
 
+// 编译期最低日志等级，低于它的LOG_*调用在编译时整个去掉（例如 make LOG_MIN_LEVEL=1 去掉所有LOG_DEBUG）
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL 0
+#endif
+
+// level是常量时，(level) >= LOG_MIN_LEVEL在编译期求值，不满足的分支连同参数求值一起被删除；
+// 满足时运行期只做两次原子读
 #define LOG_BASE(level, format, ...) \
     do {\
-        Log* log = Log::Instance();\
-        if (log->IsOpen() && log->GetLevel() <= level) {\
-            log->write(level, format, ##__VA_ARGS__); \
-            log->flush();\
+        if ((level) >= LOG_MIN_LEVEL) {\
+            Log* log = Log::Instance();\
+            if (log->IsOpen() && log->GetLevel() <= (level)) {\
+                log->write(level, format, ##__VA_ARGS__); \
+            }\
         }\
     } while(0);
 
@@ -0,0 +1,134 @@
+/**
+ * @file logring.h
+ * @brief 定义了异步日志使用的多生产者单消费者无锁环形队列 LogRing。
+ */
+
+#ifndef LOGRING_H
+#define LOGRING_H
+
+#include <atomic>
+#include <memory>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+
+/**
+ * @brief 多生产者、单消费者的定长槽位无锁环形队列。
+ *
+ * @tparam SlotSize 每个槽位占用的字节数，普通日志用LogRing（512字节一行），访问日志用更小的槽位存放定长记录。
+ *
+ * 所有槽位在构造时一次性分配，每个槽位保存一行格式化好的日志。每个槽位带一个序号：
+ * 序号等于写位置时槽位空闲，生产者用CAS抢到写位置后拷贝数据，再把序号加一发布给消费者；
+ * 消费者读完后把序号推进一圈，槽位重新变为空闲。生产者之间只竞争一个原子变量，不加锁、不分配内存。
+ * 只能有一个线程调用Consume（日志写线程）。
+ */
+template<size_t SlotSize>
+class BasicLogRing {
+public:
+    static const size_t SLOT_SIZE = SlotSize;   // 每个槽位占用的字节数
+    static const size_t SLOT_DATA_SIZE = SLOT_SIZE - sizeof(size_t) - sizeof(uint32_t);  // 每条数据的最大长度
+
+    /**
+     * @brief 构造函数，分配所有槽位。
+     *
+     * @param capacity 槽位个数，向上取整为2的幂。
+     */
+    explicit BasicLogRing(size_t capacity) {
+        size_t count = 2;
+        while(count < capacity) { count <<= 1; }
+        mask_ = count - 1;
+        slots_.reset(new Slot[count]);
+        for(size_t i = 0; i < count; i++) {
+            slots_[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    BasicLogRing(const BasicLogRing&) = delete;
+    BasicLogRing& operator=(const BasicLogRing&) = delete;
+
+    /**
+     * @brief 写入一行日志，可在任意线程调用。
+     *
+     * @return 队列已满或这一行超过SLOT_DATA_SIZE时返回false，由调用者改为同步写入。
+     */
+    bool TryPush(const char* data, size_t len) {
+        if(len > SLOT_DATA_SIZE) { return false; }
+        size_t pos = tail_.load(std::memory_order_relaxed);
+        Slot* slot;
+        while(true) {
+            slot = &slots_[pos & mask_];
+            size_t seq = slot->seq.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if(diff == 0) {
+                if(tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if(diff < 0) {
+                return false;   // 消费者还没读走上一圈的数据，队列已满
+            } else {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+        memcpy(slot->data, data, len);
+        slot->len = static_cast<uint32_t>(len);
+        slot->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief 按写入顺序依次取出已发布的日志，只能在消费者线程调用。
+     *
+     * @param func 对每一行调用func(data, len)，data只在调用期间有效。
+     * @param maxCount 本次最多取出的行数。
+     * @return 取出的行数。
+     */
+    template<typename F>
+    size_t Consume(F&& func, size_t maxCount) {
+        size_t count = 0;
+        while(count < maxCount) {
+            Slot* slot = &slots_[head_ & mask_];
+            if(slot->seq.load(std::memory_order_acquire) != head_ + 1) {
+                break;  // 还没有发布（或正在拷贝）
+            }
+            func(slot->data, slot->len);
+            slot->seq.store(head_ + mask_ + 1, std::memory_order_release);
+            head_++;
+            count++;
+        }
+        return count;
+    }
+
+    /**
+     * @brief 是否没有待消费的日志，只能在消费者线程调用。
+     */
+    bool Empty() const {
+        return slots_[head_ & mask_].seq.load(std::memory_order_acquire) != head_ + 1;
+    }
+
+    size_t Capacity() const { return mask_ + 1; }
+
+private:
+    struct Slot {
+        std::atomic<size_t> seq;
+        uint32_t len;
+        char data[SLOT_DATA_SIZE];
+    };
+    static_assert(sizeof(Slot) == SLOT_SIZE, "LogRing slot size mismatch");
+
+    // 读写位置用填充隔开，避免生产者和消费者争用同一缓存行（C++14下new不保证alignas(64)）
+    std::unique_ptr<Slot[]> slots_;
+    size_t mask_;
+    char pad0_[64];
+    std::atomic<size_t> tail_{0};   // 生产者竞争的写位置
+    char pad1_[64];
+    size_t head_ = 0;               // 消费者独占的读位置
+};
+
+template<size_t SlotSize>
+const size_t BasicLogRing<SlotSize>::SLOT_SIZE;
+template<size_t SlotSize>
+const size_t BasicLogRing<SlotSize>::SLOT_DATA_SIZE;
+
+typedef BasicLogRing<512> LogRing;
+
+#endif // LOGRING_H
@@ -0,0 +1,225 @@
+#include "metrics.h"
+
+#include <new>
+#include <algorithm>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <assert.h>
+
+using namespace std;
+
+const char* Metrics::PATH = "/metrics";
+const char* Metrics::CONTENT_TYPE = "text/plain; version=0.0.4";
+const int Metrics::STATUS_CODES[] = { 200, 206, 304, 400, 403, 404, 416, 503 };
+const int Metrics::STATUS_NUM = sizeof(STATUS_CODES) / sizeof(STATUS_CODES[0]);
+
+// 直方图导出的2的幂边界：16us ~ 32s
+static const int EXPORT_MIN_BITS = 4;
+static const int EXPORT_MAX_BITS = 25;
+
+static const char* COUNTER_NAMES[][2] = {
+    { "webserver_accepts_total", "Accepted client connections." },
+    { "webserver_sent_bytes_total", "Response bytes written to clients." },
+    { "webserver_parse_errors_total", "Malformed requests answered with 400." },
+    { "webserver_db_calls_total", "SQL statements executed." },
+    { "webserver_timer_expirations_total", "Connections closed by the idle timer." },
+};
+static_assert(sizeof(COUNTER_NAMES) / sizeof(COUNTER_NAMES[0]) == METRIC_COUNTER_NUM,
+              "every counter needs a name");
+
+Metrics* Metrics::Instance() {
+    static Metrics metrics;
+    return &metrics;
+}
+
+Metrics::ThreadBlock::ThreadBlock() : latencySumUs(0) {
+    for(auto& c : counters) { c.store(0, memory_order_relaxed); }
+    for(auto& c : status) { c.store(0, memory_order_relaxed); }
+    for(auto& c : latency) { c.store(0, memory_order_relaxed); }
+}
+
+Metrics::ThreadBlock* Metrics::Register_() {
+    void* mem = nullptr;
+    if(posix_memalign(&mem, alignof(ThreadBlock), sizeof(ThreadBlock)) != 0) {
+        throw bad_alloc();
+    }
+    ThreadBlock* block = new(mem) ThreadBlock();
+    lock_guard<mutex> locker(mtx_);
+    blocks_.push_back(block);
+    return block;
+}
+
+uint64_t Metrics::NowUs() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+int Metrics::StatusIndex_(int status) {
+    for(int i = 0; i < STATUS_NUM; i++) {
+        if(STATUS_CODES[i] == status) { return i; }
+    }
+    return STATUS_NUM;
+}
+
+int Metrics::BucketIndex(uint64_t us) {
+    if(us < (uint64_t)SUB_BUCKETS) { return static_cast<int>(us); }
+    int msb = 63 - __builtin_clzll(us);
+    if(msb >= MAX_BITS) { return BUCKETS - 1; }
+    // 每个2的幂区间[2^msb, 2^(msb+1))均分为SUB_BUCKETS个子桶
+    return (msb - SUB_BITS + 1) * SUB_BUCKETS + static_cast<int>((us >> (msb - SUB_BITS)) & (SUB_BUCKETS - 1));
+}
+
+uint64_t Metrics::BucketUpperUs(int index) {
+    assert(index >= 0 && index < BUCKETS);
+    if(index < SUB_BUCKETS) { return index + 1; }
+    int msb = index / SUB_BUCKETS + SUB_BITS - 1;
+    uint64_t width = 1ULL << (msb - SUB_BITS);
+    return (1ULL << msb) + (index % SUB_BUCKETS + 1) * width;
+}
+
+void Metrics::AddGauge(const string& name, const string& help, function<double()> read, bool counter) {
+    assert(read);
+    lock_guard<mutex> locker(mtx_);
+    gauges_.push_back(Gauge{name, help, move(read), counter});
+}
+
+void Metrics::ClearGauges() {
+    lock_guard<mutex> locker(mtx_);
+    gauges_.clear();
+}
+
+uint64_t Metrics::Total(MetricCounter counter) {
+    uint64_t total = 0;
+    lock_guard<mutex> locker(mtx_);
+    for(ThreadBlock* block : blocks_) {
+        total += block->counters[counter].load(memory_order_relaxed);
+    }
+    return total;
+}
+
+/**
+ * @brief 合并后的直方图中第一个累计数达到q * count的子桶
+ */
+static uint64_t Quantile(const vector<uint64_t>& buckets, uint64_t count, double q) {
+    if(count == 0) { return 0; }
+    uint64_t rank = static_cast<uint64_t>(q * count + 0.5);
+    if(rank == 0) { rank = 1; }
+    uint64_t seen = 0;
+    for(size_t i = 0; i < buckets.size(); i++) {
+        seen += buckets[i];
+        if(seen >= rank) { return Metrics::BucketUpperUs(static_cast<int>(i)); }
+    }
+    return Metrics::BucketUpperUs(static_cast<int>(buckets.size()) - 1);
+}
+
+uint64_t Metrics::LatencyQuantileUs(double q) {
+    assert(q > 0 && q <= 1);
+    vector<uint64_t> buckets(BUCKETS, 0);
+    uint64_t count = 0;
+    {
+        lock_guard<mutex> locker(mtx_);
+        for(ThreadBlock* block : blocks_) {
+            for(int i = 0; i < BUCKETS; i++) {
+                uint64_t n = block->latency[i].load(memory_order_relaxed);
+                buckets[i] += n;
+                count += n;
+            }
+        }
+    }
+    return Quantile(buckets, count, q);
+}
+
+static void AppendHeader(string& out, const char* name, const char* help, const char* type) {
+    out.append("# HELP ").append(name).append(" ").append(help).append("\n");
+    out.append("# TYPE ").append(name).append(" ").append(type).append("\n");
+}
+
+static void AppendValue(string& out, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+
+static void AppendValue(string& out, const char* fmt, ...) {
+    char line[256];
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(line, sizeof(line), fmt, args);
+    va_end(args);
+    if(n > 0) { out.append(line, min(n, (int)sizeof(line) - 1)); }
+}
+
+string Metrics::Render() {
+    uint64_t counters[METRIC_COUNTER_NUM] = {0};
+    uint64_t status[STATUS_SLOTS] = {0};
+    vector<uint64_t> buckets(BUCKETS, 0);
+    uint64_t count = 0, sumUs = 0;
+    vector<pair<Gauge, double>> gauges;
+    {
+        // 只在锁内读计数，格式化和调用回调之外的工作放到锁外
+        lock_guard<mutex> locker(mtx_);
+        for(ThreadBlock* block : blocks_) {
+            for(int i = 0; i < METRIC_COUNTER_NUM; i++) {
+                counters[i] += block->counters[i].load(memory_order_relaxed);
+            }
+            for(int i = 0; i <= STATUS_NUM; i++) {
+                status[i] += block->status[i].load(memory_order_relaxed);
+            }
+            for(int i = 0; i < BUCKETS; i++) {
+                uint64_t n = block->latency[i].load(memory_order_relaxed);
+                buckets[i] += n;
+                count += n;
+            }
+            sumUs += block->latencySumUs.load(memory_order_relaxed);
+        }
+        for(const Gauge& gauge : gauges_) {
+            gauges.emplace_back(gauge, 0.0);
+        }
+    }
+    for(auto& gauge : gauges) {
+        gauge.second = gauge.first.read();
+    }
+
+    string out;
+    out.reserve(4096);
+    for(int i = 0; i < METRIC_COUNTER_NUM; i++) {
+        AppendHeader(out, COUNTER_NAMES[i][0], COUNTER_NAMES[i][1], "counter");
+        AppendValue(out, "%s %llu\n", COUNTER_NAMES[i][0], (unsigned long long)counters[i]);
+    }
+
+    AppendHeader(out, "webserver_responses_total", "Responses by status code.", "counter");
+    for(int i = 0; i < STATUS_NUM; i++) {
+        AppendValue(out, "webserver_responses_total{code=\"%d\"} %llu\n",
+                    STATUS_CODES[i], (unsigned long long)status[i]);
+    }
+    AppendValue(out, "webserver_responses_total{code=\"other\"} %llu\n", (unsigned long long)status[STATUS_NUM]);
+
+    for(auto& gauge : gauges) {
+        AppendHeader(out, gauge.first.name.c_str(), gauge.first.help.c_str(),
+                     gauge.first.counter ? "counter" : "gauge");
+        AppendValue(out, "%s %.17g\n", gauge.first.name.c_str(), gauge.second);
+    }
+
+    // 子桶的上界都是2的幂的整数倍，按2的幂边界累加不会把一个子桶拆开
+    const char* hist = "webserver_request_duration_seconds";
+    AppendHeader(out, hist, "Time from reading a request to writing its last byte.", "histogram");
+    uint64_t cumulative = 0;
+    int index = 0;
+    for(int bits = EXPORT_MIN_BITS; bits <= EXPORT_MAX_BITS; bits++) {
+        uint64_t bound = 1ULL << bits;
+        while(index < BUCKETS && BucketUpperUs(index) <= bound) {
+            cumulative += buckets[index++];
+        }
+        AppendValue(out, "%s_bucket{le=\"%.6f\"} %llu\n", hist, bound / 1e6, (unsigned long long)cumulative);
+    }
+    AppendValue(out, "%s_bucket{le=\"+Inf\"} %llu\n", hist, (unsigned long long)count);
+    AppendValue(out, "%s_sum %.6f\n", hist, sumUs / 1e6);
+    AppendValue(out, "%s_count %llu\n", hist, (unsigned long long)count);
+
+    const char* quantile = "webserver_request_duration_quantile_seconds";
+    AppendHeader(out, quantile, "Request duration quantiles from the HDR histogram (bucket upper bound).", "gauge");
+    const double qs[] = { 0.5, 0.9, 0.99, 0.999 };
+    for(double q : qs) {
+        AppendValue(out, "%s{quantile=\"%g\"} %.6f\n", quantile, q, Quantile(buckets, count, q) / 1e6);
+    }
+    return out;
+}
@@ -0,0 +1,180 @@
+/**
+ * @file metrics.h
+ * @brief 定义了按线程计数的指标 Metrics，以 Prometheus 文本格式导出。
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <functional>
+#include <stdint.h>
+
+/**
+ * @brief 计数器编号
+ */
+enum MetricCounter {
+    METRIC_ACCEPTS = 0,         // 建立的连接数
+    METRIC_SENT_BYTES,          // 发送的字节数（响应头 + 文件）
+    METRIC_PARSE_ERRORS,        // 格式错误的请求数（回复400）
+    METRIC_DB_CALLS,            // 执行的SQL语句数
+    METRIC_TIMER_EXPIRED,       // 超时关闭的连接数
+    METRIC_COUNTER_NUM
+};
+
+/**
+ * @class Metrics
+ * @brief 进程内指标：计数器、按状态码的请求数和请求耗时直方图。
+ *
+ * 每个线程第一次记录时分配一块自己的、按缓存行对齐的计数块，之后只写自己的块：
+ * 计数器由唯一的写者用relaxed的load + store累加，不需要带锁前缀的原子加，也不会和其他线程写同一缓存行。
+ * 导出时在锁内遍历所有线程的块求和，读到的是各计数器某一时刻的值，不保证彼此一致。
+ * 线程退出后它的块保留下来（累计值不丢失），服务器的线程是常驻的，块的数量有上界。
+ *
+ * 耗时直方图是HDR风格的对数-线性分桶：每个2的幂区间再均分为SUB_BUCKETS个子桶，相对误差不超过1/SUB_BUCKETS，
+ * 覆盖1us到2^32us（约71分钟）。导出时按2的幂合并成Prometheus直方图，并单独给出p50/p90/p99/p999。
+ * 线程池队列深度、空闲数据库连接数这类瞬时值不计数，由AddGauge注册的回调在导出时读取。
+ */
+class Metrics {
+public:
+    static Metrics* Instance();
+
+    /**
+     * @brief 开启后HttpConn才为每个请求记录耗时，并响应PATH的请求
+     */
+    void SetEnabled(bool enabled) { enabled_ = enabled; }
+    bool IsEnabled() const { return enabled_; }
+
+    /**
+     * @brief 计数器加n
+     */
+    static void Add(MetricCounter counter, uint64_t n = 1) {
+        Bump_(Local_()->counters[counter], n);
+    }
+
+    /**
+     * @brief 按状态码记录一个响应
+     * @param status 状态码
+     */
+    static void CountStatus(int status) {
+        Bump_(Local_()->status[StatusIndex_(status)], 1);
+    }
+
+    /**
+     * @brief 记录一个请求从读到数据到最后一个字节发出的耗时
+     * @param us 耗时（微秒）
+     */
+    static void ObserveLatency(uint64_t us) {
+        ThreadBlock* block = Local_();
+        Bump_(block->latency[BucketIndex(us)], 1);
+        Bump_(block->latencySumUs, us);
+    }
+
+    /**
+     * @brief 注册一个在导出时读取的瞬时值
+     * @param name 指标名
+     * @param help 说明
+     * @param read 读取函数，在导出的线程中调用
+     * @param counter 为true时按counter类型导出（值只增不减，但由其他模块自己计数）
+     */
+    void AddGauge(const std::string& name, const std::string& help, std::function<double()> read,
+                  bool counter = false);
+
+    /**
+     * @brief 删除所有注册的瞬时值（注册者析构前调用）
+     */
+    void ClearGauges();
+
+    /**
+     * @brief 生成Prometheus文本格式（text/plain; version=0.0.4）
+     */
+    std::string Render();
+
+    /**
+     * @brief 所有线程的计数器之和
+     */
+    uint64_t Total(MetricCounter counter);
+
+    /**
+     * @brief 所有线程的耗时直方图合并后的分位数（微秒，取所在子桶的上界）
+     * @param q 分位，0 < q <= 1
+     * @return 没有记录时返回0
+     */
+    uint64_t LatencyQuantileUs(double q);
+
+    /**
+     * @brief 单调时钟（微秒）
+     */
+    static uint64_t NowUs();
+
+    /**
+     * @brief 耗时对应的子桶下标
+     */
+    static int BucketIndex(uint64_t us);
+
+    /**
+     * @brief 子桶的上界（不含，微秒）
+     */
+    static uint64_t BucketUpperUs(int index);
+
+    static const char* PATH;                // "/metrics"
+    static const char* CONTENT_TYPE;        // 导出格式的Content-type
+    static const int SUB_BITS = 3;
+    static const int SUB_BUCKETS = 1 << SUB_BITS;
+    static const int MAX_BITS = 32;
+    static const int BUCKETS = (MAX_BITS - SUB_BITS + 1) * SUB_BUCKETS;
+
+    /**
+     * @brief 单独计数的状态码，其余的计入"other"
+     */
+    static const int STATUS_CODES[];
+    static const int STATUS_NUM;
+
+private:
+    static const int STATUS_SLOTS = 16;
+
+    /**
+     * @brief 一个线程的计数块，只由该线程写；按缓存行对齐分配（C++14的new不保证超过16字节的对齐）
+     */
+    struct alignas(64) ThreadBlock {
+        std::atomic<uint64_t> counters[METRIC_COUNTER_NUM];
+        std::atomic<uint64_t> status[STATUS_SLOTS];
+        std::atomic<uint64_t> latencySumUs;
+        std::atomic<uint64_t> latency[BUCKETS];
+        ThreadBlock();
+    };
+
+    struct Gauge {
+        std::string name;
+        std::string help;
+        std::function<double()> read;
+        bool counter;
+    };
+
+    Metrics() : enabled_(false) {}
+
+    static void Bump_(std::atomic<uint64_t>& value, uint64_t n) {
+        value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    static ThreadBlock* Local_() {
+        static thread_local ThreadBlock* block = nullptr;
+        if(!block) { block = Instance()->Register_(); }
+        return block;
+    }
+
+    static int StatusIndex_(int status);
+
+    ThreadBlock* Register_();
+
+    bool enabled_;
+    std::mutex mtx_;                                    // 保护blocks_和gauges_
+    std::vector<ThreadBlock*> blocks_;                  // 每个线程一块，不释放
+    std::vector<Gauge> gauges_;
+};
+
+#endif // METRICS_H
@@ -0,0 +1,88 @@
+#include "trace.h"
+
+#include <unistd.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+#include "log.h"
+
+using namespace std;
+
+bool Trace::useTsc_ = false;
+
+Trace* Trace::Instance() {
+    static Trace trace;
+    return &trace;
+}
+
+bool Trace::InvariantTsc_() {
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned int eax, ebx, ecx, edx;
+    // CPUID 0x80000007 EDX bit 8: Invariant TSC
+    if(__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)) {
+        return edx & (1u << 8);
+    }
+#endif
+    return false;
+}
+
+void Trace::Init(int slowRequestMS) {
+    enabled_ = slowRequestMS > 0;
+    slowNs_ = enabled_ ? static_cast<uint64_t>(slowRequestMS) * 1000000 : 0;
+    if(!enabled_ || useTsc_ || !InvariantTsc_()) { return; }
+#if defined(__x86_64__) || defined(__i386__)
+    // 对照单调时钟测10ms内的TSC计数，误差在千分之一以内
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    uint64_t c0 = __rdtsc();
+    usleep(10000);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    uint64_t c1 = __rdtsc();
+    double ns = (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec);
+    if(c1 > c0 && ns > 0) {
+        nsPerTick_ = ns / (c1 - c0);
+        useTsc_ = true;
+    }
+#endif
+}
+
+void Trace::Finish(int fd, const TraceSpan& span, const AccessRecord& record) {
+    const uint64_t* ts = span.ts;
+    uint64_t begin = ts[TRACE_DISPATCH] ? ts[TRACE_DISPATCH] : ts[TRACE_PARSE_DONE];
+    uint64_t total = ElapsedNs(begin, ts[TRACE_LAST_WRITE]);
+    TRACE_PROBE3(request__done, fd, record.status, total);
+    if(total < slowNs_) { return; }
+    slow_.fetch_add(1, memory_order_relaxed);
+
+    // 限速：每秒最多SLOW_LOG_PER_SEC条，窗口切换时只有一个线程能清零计数
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+    int64_t second = now.tv_sec;
+    int64_t last = logSecond_.load(memory_order_relaxed);
+    if(last != second && logSecond_.compare_exchange_strong(last, second, memory_order_relaxed)) {
+        loggedInSecond_.store(0, memory_order_relaxed);
+    }
+    if(loggedInSecond_.fetch_add(1, memory_order_relaxed) >= SLOW_LOG_PER_SEC) {
+        suppressed_.fetch_add(1, memory_order_relaxed);
+        return;
+    }
+    char extra[48] = "";
+    uint64_t suppressed = suppressed_.exchange(0, memory_order_relaxed);
+    if(suppressed) {
+        snprintf(extra, sizeof(extra), " (%llu not logged)", (unsigned long long)suppressed);
+    }
+
+    // 各阶段的耗时；验证只在登录/注册时发生，生成响应从验证完成（或解析完成）算起
+    uint64_t verified = ts[TRACE_VERIFY_DONE] ? ts[TRACE_VERIFY_DONE] : ts[TRACE_PARSE_DONE];
+    LOG_WARN("Slow request client[%d] %.8s %.*s %d %uB: %.3fms = queue %.3f + parse %.3f + verify %.3f"
+             " + build %.3f + send-wait %.3f + send %.3f%s",
+             fd, record.method, (int)record.pathLen, record.path, (int)record.status, record.bytes,
+             total / 1e6,
+             ElapsedNs(ts[TRACE_DISPATCH], ts[TRACE_TASK_START]) / 1e6,
+             ElapsedNs(ts[TRACE_TASK_START], ts[TRACE_PARSE_DONE]) / 1e6,
+             ElapsedNs(ts[TRACE_PARSE_DONE], ts[TRACE_VERIFY_DONE]) / 1e6,
+             ElapsedNs(verified, ts[TRACE_RESPONSE_BUILT]) / 1e6,
+             ElapsedNs(ts[TRACE_RESPONSE_BUILT], ts[TRACE_FIRST_WRITE]) / 1e6,
+             ElapsedNs(ts[TRACE_FIRST_WRITE], ts[TRACE_LAST_WRITE]) / 1e6,
+             extra);
+}
@@ -0,0 +1,139 @@
+/**
+ * @file trace.h
+ * @brief 定义了请求各阶段的时间戳 TraceSpan、慢请求采样 Trace 和可在编译期去掉的静态探针。
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <stdint.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>  // __rdtsc
+#endif
+
+#include "accesslog.h"
+
+/*
+ * 静态探针：编译时定义WEBSERVER_USDT（make USDT=1）展开为systemtap的USDT探针，
+ * 可用bpftrace/perf/systemtap按名字挂载，例如 bpftrace -e 'usdt:./bin/server:webserver:request__done { ... }'；
+ * 不挂载时只是一条nop。没有定义时展开为空，不留下任何代码。
+ */
+#ifdef WEBSERVER_USDT
+#include <sys/sdt.h>
+#define TRACE_PROBE1(name, a) DTRACE_PROBE1(webserver, name, a)
+#define TRACE_PROBE2(name, a, b) DTRACE_PROBE2(webserver, name, a, b)
+#define TRACE_PROBE3(name, a, b, c) DTRACE_PROBE3(webserver, name, a, b, c)
+#else
+#define TRACE_PROBE1(name, a) ((void)0)
+#define TRACE_PROBE2(name, a, b) ((void)0)
+#define TRACE_PROBE3(name, a, b, c) ((void)0)
+#endif
+
+/**
+ * @brief 一个请求经过的阶段
+ */
+enum TracePhase {
+    TRACE_DISPATCH = 0,     // 读事件被派发（主Reactor投递到线程池；多Reactor模式下与开始处理相同）
+    TRACE_TASK_START,       // 工作线程开始处理读事件
+    TRACE_PARSE_DONE,       // 请求解析完成
+    TRACE_VERIFY_DONE,      // 登录/注册的验证完成（缓存、同步或异步），其他请求为0
+    TRACE_RESPONSE_BUILT,   // 响应生成并加入写队列
+    TRACE_FIRST_WRITE,      // 响应的第一个字节发出
+    TRACE_LAST_WRITE,       // 响应的最后一个字节发出
+    TRACE_PHASE_NUM
+};
+
+/**
+ * @brief 一个请求各阶段的时间戳（Trace::Now()的计数），没有经过的阶段为0
+ */
+struct TraceSpan {
+    uint64_t ts[TRACE_PHASE_NUM];
+};
+
+/**
+ * @class Trace
+ * @brief 请求阶段计时和慢请求采样。
+ *
+ * 开启后HttpConn在每个阶段记一个时间戳，响应发送完时由Finish()计算总耗时（派发到最后一个字节发出），
+ * 超过阈值的请求把各阶段的耗时写进日志，能看出慢在线程池排队、解析、验证、生成响应还是等待套接字可写。
+ * 慢请求日志每秒最多SLOW_LOG_PER_SEC条，超出的只计数，过载时不会因为日志雪上加霜。
+ *
+ * 时间戳在支持不变TSC的x86上直接读rdtsc（约十几个周期，跨核一致），Init时对照CLOCK_MONOTONIC校准频率；
+ * 其他平台用CLOCK_MONOTONIC（vDSO）。CLOCK_MONOTONIC_COARSE的精度是一个时钟节拍（1~4ms），
+ * 大多数阶段比它短，不使用。
+ */
+class Trace {
+public:
+    static Trace* Instance();
+
+    /**
+     * @brief 初始化，在工作线程启动之前调用
+     * @param slowRequestMS 慢请求阈值（毫秒），大于0时开启阶段计时
+     */
+    void Init(int slowRequestMS);
+
+    // 每个请求都会调用，只读一个普通成员
+    bool IsEnabled() const { return enabled_; }
+
+    /**
+     * @brief 当前时间戳（rdtsc计数或纳秒）
+     */
+    static uint64_t Now() {
+#if defined(__x86_64__) || defined(__i386__)
+        if(useTsc_) { return __rdtsc(); }
+#endif
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+    }
+
+    /**
+     * @brief 两个时间戳之差换算成纳秒，from为0或晚于to时返回0
+     */
+    uint64_t ElapsedNs(uint64_t from, uint64_t to) const {
+        return (from && to > from) ? static_cast<uint64_t>((to - from) * nsPerTick_) : 0;
+    }
+
+    /**
+     * @brief 一个请求的响应发送完毕，超过阈值时写慢请求日志
+     * @param fd 客户端套接字
+     * @param span 各阶段的时间戳
+     * @param record 请求的方法、路径、状态码和字节数
+     */
+    void Finish(int fd, const TraceSpan& span, const AccessRecord& record);
+
+    /**
+     * @brief 超过阈值的请求数（包括因限速没有写日志的）
+     */
+    uint64_t SlowCount() const { return slow_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief 时间戳是否来自rdtsc
+     */
+    static bool UsesTsc() { return useTsc_; }
+
+    static const int SLOW_LOG_PER_SEC = 100;
+
+private:
+    Trace() : enabled_(false), slowNs_(0), nsPerTick_(1.0),
+              slow_(0), logSecond_(0), loggedInSecond_(0), suppressed_(0) {}
+
+    /**
+     * @brief CPU是否有不变TSC（频率恒定、各核同步）
+     */
+    static bool InvariantTsc_();
+
+    static bool useTsc_;
+    bool enabled_;
+    uint64_t slowNs_;
+    double nsPerTick_;
+
+    std::atomic<uint64_t> slow_;
+    std::atomic<int64_t> logSecond_;        // 限速窗口所在的秒
+    std::atomic<int> loggedInSecond_;       // 本秒已写的慢请求日志数
+    std::atomic<uint64_t> suppressed_;      // 因限速没有写日志的慢请求数，下一条日志中报告
+};
+
+#endif // TRACE_H
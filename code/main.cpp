@@ -1,12 +1,24 @@
 #include <unistd.h>
+#include <iostream>
 #include "server/webserver.h"
 
-int main() {
+int main(int argc, char* argv[]) {
+    // 配置文件路径：第一个参数，默认为工作目录下的server.conf；文件不存在时使用默认配置
+    std::string configFile = argc > 1 ? argv[1] : "./server.conf";
+    ServerConfig config;
+    if(access(configFile.c_str(), F_OK) == 0) {
+        std::string err;
+        if(!config.Load(configFile, &err)) {
+            std::cerr << "config error: " << err << std::endl;
+            return 1;
+        }
+    } else if(argc > 1) {
+        std::cerr << "config file not found: " << configFile << std::endl;
+        return 1;
+    } else {
+        configFile.clear();
+    }
     // 守护进程 后台运行 
-    WebServer server(
-        1316, 3, 60000,              // 端口 ET模式 timeoutMs 
-        3306, "root", "123456", "webserver", /* Mysql配置 */
-        12, 8, true, 0, 1024);             /* 连接池数量 线程池数量 日志开关 日志等级 日志异步队列容量 */
-    
+    WebServer server(config, configFile);
     server.Start();
-} 
+}
@@ -0,0 +1,155 @@
+#include "cpuaffinity.h"
+
+#include <sched.h>
+#include <pthread.h>
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+
+using namespace std;
+
+namespace {
+
+/**
+ * @brief 解析sysfs的CPU列表，如"0-3,8-11"
+ */
+vector<int> ParseCpuList(const char* list) {
+    vector<int> cpus;
+    const char* p = list;
+    while(*p) {
+        char* end = nullptr;
+        long first = strtol(p, &end, 10);
+        if(end == p) { break; }
+        long last = first;
+        p = end;
+        if(*p == '-') {
+            last = strtol(p + 1, &end, 10);
+            p = end;
+        }
+        for(long cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++) {
+            cpus.push_back(static_cast<int>(cpu));
+        }
+        if(*p != ',') { break; }
+        p++;
+    }
+    return cpus;
+}
+
+} // namespace
+
+CpuAffinity* CpuAffinity::Instance() {
+    static CpuAffinity affinity;
+    return &affinity;
+}
+
+CpuAffinity::CpuAffinity() : enabled_(false), nodeCount_(1), housekeeping_(-1), next_(0) {
+    CPU_ZERO(&allowed_);
+}
+
+void CpuAffinity::Init(bool enabled, int housekeepingCpu) {
+    enabled_.store(false, memory_order_release);
+    workers_.clear();
+    nodeOf_.assign(CPU_SETSIZE, 0);
+    nodeCount_ = 1;
+    housekeeping_ = -1;
+    next_ = 0;
+
+    // 每个节点目录下的cpulist列出该节点的CPU，没有该目录（非NUMA内核）时视为一个节点
+    DIR* dir = opendir("/sys/devices/system/node");
+    if(dir) {
+        int maxNode = -1;
+        struct dirent* entry;
+        while((entry = readdir(dir)) != nullptr) {
+            int node = 0;
+            if(sscanf(entry->d_name, "node%d", &node) != 1) { continue; }
+            char path[128], list[1024];
+            snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+            FILE* fp = fopen(path, "r");
+            if(!fp) { continue; }
+            if(fgets(list, sizeof(list), fp)) {
+                for(int cpu : ParseCpuList(list)) { nodeOf_[cpu] = node; }
+                if(node > maxNode) { maxNode = node; }
+            }
+            fclose(fp);
+        }
+        closedir(dir);
+        nodeCount_ = maxNode + 1 > 1 ? maxNode + 1 : 1;
+    }
+    if(!enabled) { return; }
+
+    cpu_set_t& set = allowed_;
+    CPU_ZERO(&set);
+    if(sched_getaffinity(0, sizeof(set), &set) != 0) { return; }
+    vector<int> allowed;
+    for(int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if(CPU_ISSET(cpu, &set)) { allowed.push_back(cpu); }
+    }
+    if(allowed.empty()) { return; }
+    housekeeping_ = (housekeepingCpu >= 0 && housekeepingCpu < CPU_SETSIZE && CPU_ISSET(housekeepingCpu, &set)) ?
+                    housekeepingCpu : allowed.back();
+
+    // 按节点分组后轮流从各节点取一个，相邻编号的工作线程落在不同节点上
+    vector<vector<int>> byNode(nodeCount_);
+    for(int cpu : allowed) {
+        if(cpu != housekeeping_ || allowed.size() == 1) { byNode[nodeOf_[cpu]].push_back(cpu); }
+    }
+    for(size_t i = 0; workers_.size() < allowed.size(); i++) {
+        bool any = false;
+        for(auto& cpus : byNode) {
+            if(i < cpus.size()) {
+                workers_.push_back(cpus[i]);
+                any = true;
+            }
+        }
+        if(!any) { break; }
+    }
+    enabled_.store(true, memory_order_release);
+}
+
+int CpuAffinity::ClaimWorkerCpu() {
+    if(!IsEnabled()) { return -1; }
+    return workers_[next_.fetch_add(1, memory_order_relaxed) % workers_.size()];
+}
+
+int CpuAffinity::NodeOf(int cpu) const {
+    return cpu >= 0 && cpu < static_cast<int>(nodeOf_.size()) ? nodeOf_[cpu] : 0;
+}
+
+bool CpuAffinity::Pin(int cpu) {
+    if(cpu < 0 || cpu >= CPU_SETSIZE) { return false; }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+void CpuAffinity::Unpin() const {
+    if(IsEnabled()) { sched_setaffinity(0, sizeof(allowed_), &allowed_); }
+}
+
+void CpuAffinity::SetIncomingCpu(int fd, int cpu) {
+#ifdef SO_INCOMING_CPU
+    if(cpu >= 0) { setsockopt(fd, SOL_SOCKET, SO_INCOMING_CPU, &cpu, sizeof(cpu)); }
+#endif
+}
+
+int CpuAffinity::IncomingCpu(int fd) {
+#ifdef SO_INCOMING_CPU
+    int cpu = -1;
+    socklen_t len = sizeof(cpu);
+    if(getsockopt(fd, SOL_SOCKET, SO_INCOMING_CPU, &cpu, &len) == 0) { return cpu; }
+#endif
+    return -1;
+}
+
+string CpuAffinity::Describe() const {
+    if(!IsEnabled()) { return "off"; }
+    string desc = "workers ";
+    for(size_t i = 0; i < workers_.size(); i++) {
+        desc += (i ? "," : "") + to_string(workers_[i]);
+    }
+    desc += ", housekeeping " + to_string(housekeeping_) + ", NUMA nodes " + to_string(nodeCount_);
+    return desc;
+}
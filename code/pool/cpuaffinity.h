@@ -0,0 +1,108 @@
+#ifndef CPU_AFFINITY_H
+#define CPU_AFFINITY_H
+
+#include <vector>
+#include <string>
+#include <atomic>
+#include <sched.h>
+
+/**
+ * @class CpuAffinity
+ * @brief 线程绑核：工作线程（从Reactor、线程池线程、单Reactor模式的主Reactor）各占一个核，
+ *        日志等后台线程放在housekeeping核上。
+ *
+ * NUMA拓扑从/sys/devices/system/node读取（不依赖libnuma），可用的CPU取进程启动时的亲和性
+ * （taskset、cgroup cpuset的限制都会体现在里面）。工作核按NUMA节点交错排列，前几个工作线程
+ * 均匀分布到各个节点上；housekeeping核不分给工作线程（只有一个可用CPU时除外）。
+ * 缓冲区内存来自BufferPool的线程缓存，由绑定后的线程第一次写入，按内核的first-touch策略落在
+ * 该线程所在的节点上。没有Init或未启用时所有操作都不做任何事。
+ */
+class CpuAffinity {
+public:
+    static CpuAffinity* Instance();
+
+    /**
+     * @brief 读取拓扑并决定各线程使用的CPU，需在创建要绑核的线程之前调用
+     * @param enabled 是否绑核
+     * @param housekeepingCpu 后台线程使用的CPU，小于0或不可用时取最后一个可用的CPU
+     */
+    void Init(bool enabled, int housekeepingCpu);
+
+    bool IsEnabled() const { return enabled_.load(std::memory_order_acquire); }
+
+    /**
+     * @brief 按顺序领取下一个工作核（超过工作核数量后从头循环），可在任意线程调用
+     * @return CPU编号，未启用时返回-1
+     */
+    int ClaimWorkerCpu();
+
+    /**
+     * @brief 后台线程使用的CPU，未启用时返回-1
+     */
+    int HousekeepingCpu() const { return IsEnabled() ? housekeeping_ : -1; }
+
+    /**
+     * @brief CPU所在的NUMA节点，拓扑未知时为0
+     */
+    int NodeOf(int cpu) const;
+
+    /**
+     * @brief NUMA节点数
+     */
+    int NodeCount() const { return nodeCount_; }
+
+    /**
+     * @brief 领取一个工作核并把当前线程绑定上去
+     * @return 绑定的CPU，未启用或失败时返回-1
+     */
+    int PinWorker() {
+        int cpu = ClaimWorkerCpu();
+        return Pin(cpu) ? cpu : -1;
+    }
+
+    /**
+     * @brief 把当前线程绑定到housekeeping核，未启用时什么都不做
+     */
+    void PinHousekeeping() { Pin(HousekeepingCpu()); }
+
+    /**
+     * @brief 把当前线程绑定到cpu
+     * @return cpu小于0或绑定失败时返回false
+     */
+    static bool Pin(int cpu);
+
+    /**
+     * @brief 把当前线程恢复成Init时进程的亲和性（如平滑升级fork出的子进程exec之前），未启用时什么都不做
+     */
+    void Unpin() const;
+
+    /**
+     * @brief 给SO_REUSEPORT监听套接字设置SO_INCOMING_CPU，内核优先把在该CPU上收到的连接交给它
+     *        （需要内核支持，否则只是不生效）
+     */
+    static void SetIncomingCpu(int fd, int cpu);
+
+    /**
+     * @brief 连接的数据包在哪个CPU上被内核处理（网卡队列中断所在的核）
+     * @return CPU编号，未知时返回-1
+     */
+    static int IncomingCpu(int fd);
+
+    /**
+     * @brief 工作核和housekeeping核的描述，用于启动日志
+     */
+    std::string Describe() const;
+
+private:
+    CpuAffinity();
+
+    std::atomic<bool> enabled_;
+    std::vector<int> workers_;      // 工作核，按NUMA节点交错排列
+    std::vector<int> nodeOf_;       // CPU -> NUMA节点
+    int nodeCount_;
+    int housekeeping_;
+    cpu_set_t allowed_;             // Init时进程可用的CPU
+    std::atomic<unsigned> next_;    // 下一个领取的工作核下标
+};
+
+#endif // CPU_AFFINITY_H
@@ -1,5 +1,7 @@
 #include "sqlconnpool.h"
 
+using namespace std;
+
 SqlConnPool* SqlConnPool::Instance() {
     static SqlConnPool pool;
     return &pool;
@@ -10,23 +12,88 @@ void SqlConnPool::Init(const char* host, uint16_t port,
               const char* user,const char* pwd, 
               const char* dbName, int connSize = 10) {
     assert(connSize > 0);
+    host_ = host;
+    port_ = port;
+    user_ = user;
+    pwd_ = pwd;
+    dbName_ = dbName;
     for(int i = 0; i < connSize; i++) {
-        MYSQL* conn = nullptr;
-        conn = mysql_init(conn);
-        if(!conn) {
-            LOG_ERROR("MySql init error!");
-            assert(conn);
-        }
-        conn = mysql_real_connect(conn, host, user, pwd, dbName, port, nullptr, 0);
-        if (!conn) {
-            LOG_ERROR("MySql Connect error!");
-        }
+        MYSQL* conn = Connect_();
         connQue_.emplace(conn);
+        stmts_[conn].fill(nullptr);
     }
     MAX_CONN_ = connSize;
     sem_init(&semId_, 0, MAX_CONN_);
 }
 
+MYSQL* SqlConnPool::Connect_() {
+    MYSQL* conn = nullptr;
+    conn = mysql_init(conn);
+    if(!conn) {
+        LOG_ERROR("MySql init error!");
+        assert(conn);
+    }
+    conn = mysql_real_connect(conn, host_.c_str(), user_.c_str(), pwd_.c_str(), dbName_.c_str(), port_, nullptr, 0);
+    if (!conn) {
+        LOG_ERROR("MySql Connect error!");
+    }
+    return conn;
+}
+
+void SqlConnPool::Close_(MYSQL* conn) {
+    auto it = stmts_.find(conn);
+    if(it != stmts_.end()) {
+        for(MYSQL_STMT* stmt : it->second) {
+            if(stmt) { mysql_stmt_close(stmt); }
+        }
+        stmts_.erase(it);
+    }
+    if(conn) { mysql_close(conn); }
+}
+
+void SqlConnPool::Resize(int connSize) {
+    assert(connSize > 0);
+    // 建立连接较慢，放在锁外
+    vector<MYSQL*> added;
+    {
+        lock_guard<mutex> locker(mtx_);
+        int current = MAX_CONN_ - retire_;
+        if(connSize == current) { return; }
+        if(connSize < current) {
+            retire_ += current - connSize;
+            // 空闲的连接立即关闭，信号量同步减少
+            while(retire_ > 0 && sem_trywait(&semId_) == 0) {
+                MYSQL* conn = connQue_.front();
+                connQue_.pop();
+                Close_(conn);
+                retire_--;
+                MAX_CONN_--;
+            }
+            LOG_INFO("SqlConnPool resize to %d, %d to close on release", connSize, retire_);
+            return;
+        }
+        int keep = min(connSize - current, retire_);
+        retire_ -= keep;
+        added.resize(connSize - current - keep);
+    }
+    for(MYSQL*& conn : added) {
+        conn = Connect_();
+    }
+    lock_guard<mutex> locker(mtx_);
+    for(MYSQL* conn : added) {
+        connQue_.push(conn);
+        stmts_[conn].fill(nullptr);
+        MAX_CONN_++;
+        sem_post(&semId_);
+    }
+    LOG_INFO("SqlConnPool resize to %d", connSize);
+}
+
+int SqlConnPool::Size() {
+    lock_guard<mutex> locker(mtx_);
+    return MAX_CONN_ - retire_;
+}
+
 MYSQL* SqlConnPool::GetConn() {
     MYSQL* conn = nullptr;
     if(connQue_.empty()) {
@@ -44,12 +111,68 @@ MYSQL* SqlConnPool::GetConn() {
 void SqlConnPool::FreeConn(MYSQL* conn) {
     assert(conn);
     lock_guard<mutex> locker(mtx_);
+    // 连接池缩小后多出的连接在归还时关闭
+    if(retire_ > 0) {
+        Close_(conn);
+        retire_--;
+        MAX_CONN_--;
+        return;
+    }
     connQue_.push(conn);
     sem_post(&semId_);  // +1
 }
 
+// 各预编译语句的SQL，下标与StmtId对应
+static const char* STMT_SQL[SqlConnPool::STMT_COUNT] = {
+    "SELECT password FROM user WHERE username = ? LIMIT 1",
+    "INSERT INTO user(username, password) VALUES(?, ?)",
+};
+
+MYSQL_STMT* SqlConnPool::GetStmt(MYSQL* conn, StmtId id) {
+    assert(id >= 0 && id < STMT_COUNT);
+    if(!conn) { return nullptr; }
+    std::array<MYSQL_STMT*, STMT_COUNT>* connStmts;
+    {
+        // 调整连接池大小时会增删stmts_的条目，查找在锁内进行；
+        // 条目的地址不随rehash变化，连接由调用者独占，锁外读写自己的条目是安全的
+        lock_guard<mutex> locker(mtx_);
+        auto it = stmts_.find(conn);
+        if(it == stmts_.end()) { return nullptr; }
+        connStmts = &it->second;
+    }
+    MYSQL_STMT*& stmt = (*connStmts)[id];
+    if(stmt) { return stmt; }
+    stmt = mysql_stmt_init(conn);
+    if(!stmt) {
+        LOG_ERROR("MySql stmt init error: %s", mysql_error(conn));
+        return nullptr;
+    }
+    if(mysql_stmt_prepare(stmt, STMT_SQL[id], strlen(STMT_SQL[id]))) {
+        LOG_ERROR("MySql prepare error: %s", mysql_stmt_error(stmt));
+        mysql_stmt_close(stmt);
+        stmt = nullptr;
+    }
+    return stmt;
+}
+
+void SqlConnPool::ResetStmt(MYSQL* conn, StmtId id) {
+    assert(id >= 0 && id < STMT_COUNT);
+    lock_guard<mutex> locker(mtx_);
+    auto it = stmts_.find(conn);
+    if(it == stmts_.end() || !it->second[id]) { return; }
+    mysql_stmt_close(it->second[id]);
+    it->second[id] = nullptr;
+}
+
 void SqlConnPool::ClosePool() {
     lock_guard<mutex> locker(mtx_);
+    // 先关闭预编译语句再关闭连接
+    for(auto& item : stmts_) {
+        for(MYSQL_STMT*& stmt : item.second) {
+            if(stmt) { mysql_stmt_close(stmt); }
+            stmt = nullptr;
+        }
+    }
     while(!connQue_.empty()) {
         auto conn = connQue_.front();
         connQue_.pop();
@@ -4,31 +4,74 @@
 #include <mysql/mysql.h>
 #include <string>
 #include <queue>
+#include <array>
+#include <unordered_map>
 #include <mutex>
 #include <semaphore.h>
 #include <thread>
+#include <vector>
+#include <algorithm>
 #include "../log/log.h"
 
 class SqlConnPool {
 public:
+    // 预编译语句，每个连接各自缓存一份
+    enum StmtId {
+        STMT_SELECT_USER,   // 按用户名查询密码
+        STMT_INSERT_USER,   // 插入新用户
+        STMT_COUNT,
+    };
+
     static SqlConnPool *Instance();
 
     MYSQL *GetConn();
     void FreeConn(MYSQL * conn);
     int GetFreeConnCount();
 
+    // 取连接conn上已预编译的语句，第一次使用时才预编译；失败返回nullptr。
+    // 只能由当前持有conn的线程调用
+    MYSQL_STMT *GetStmt(MYSQL *conn, StmtId id);
+    // 语句执行出错（例如连接断开重连）后丢弃缓存，下次重新预编译
+    void ResetStmt(MYSQL *conn, StmtId id);
+
     void Init(const char* host, uint16_t port,
               const char* user,const char* pwd, 
               const char* dbName, int connSize);
     void ClosePool();
 
+    /**
+     * @brief 调整连接数（配置重载），可在任意线程调用
+     *
+     * 增加时立即建立新连接；减少时先关闭空闲的连接，不够的部分在使用中的连接归还时关闭。
+     *
+     * @param connSize 新的连接数
+     */
+    void Resize(int connSize);
+    int Size();
+
 private:
     SqlConnPool() = default;
     ~SqlConnPool() { ClosePool(); }
 
+    /**
+     * @brief 用Init时的参数建立一个连接，失败时返回nullptr
+     */
+    MYSQL* Connect_();
+
+    /**
+     * @brief 关闭连接及其预编译语句，调用者需持有锁
+     */
+    void Close_(MYSQL* conn);
+
     int MAX_CONN_;
+    int retire_ = 0;        // 缩小连接池时还需要在归还时关闭的连接数
+
+    std::string host_, user_, pwd_, dbName_;
+    uint16_t port_ = 0;
 
     std::queue<MYSQL *> connQue_;
+    // 每个连接的预编译语句，Init/Resize/Close_在锁内增删键，数组元素由持有连接的线程修改
+    std::unordered_map<MYSQL *, std::array<MYSQL_STMT *, STMT_COUNT>> stmts_;
     std::mutex mtx_;
     sem_t semId_;
 };
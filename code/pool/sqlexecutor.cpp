@@ -0,0 +1,131 @@
+#include "sqlexecutor.h"
+#include "cpuaffinity.h"
+
+#include <algorithm>
+
+using namespace std;
+
+SqlExecutor* SqlExecutor::Instance() {
+    static SqlExecutor executor;
+    return &executor;
+}
+
+void SqlExecutor::Init(SqlConnPool* pool, int threadNum) {
+    assert(pool && threadNum > 0);
+    lock_guard<mutex> locker(mtx_);
+    assert(!isRunning_);
+    pool_ = pool;
+    isRunning_ = true;
+    limit_ = threadNum;
+    running_ = 0;
+    retire_ = 0;
+    exited_.clear();
+    for(int i = 0; i < threadNum; i++) {
+        threads_.emplace_back(&SqlExecutor::Run_, this);
+    }
+}
+
+bool SqlExecutor::AddTask(SqlTask task) {
+    {
+        lock_guard<mutex> locker(mtx_);
+        if(!isRunning_) { return false; }
+        tasks_.emplace_back(std::move(task));
+    }
+    cond_.notify_one();
+    return true;
+}
+
+bool SqlExecutor::IsRunning() {
+    lock_guard<mutex> locker(mtx_);
+    return isRunning_;
+}
+
+void SqlExecutor::Resize(int threadNum) {
+    assert(threadNum > 0);
+    vector<thread> exited;
+    {
+        lock_guard<mutex> locker(mtx_);
+        if(!isRunning_) { return; }
+        // 回收之前调小时已经退出的线程，在锁外join
+        for(const thread::id& id : exited_) {
+            auto it = find_if(threads_.begin(), threads_.end(),
+                              [&id](const thread& t) { return t.get_id() == id; });
+            if(it == threads_.end()) { continue; }
+            exited.push_back(std::move(*it));
+            threads_.erase(it);
+        }
+        exited_.clear();
+        if(threadNum > limit_) {
+            // 还没退出的线程先留下，不够再创建
+            int add = threadNum - limit_;
+            int keep = min(add, retire_);
+            retire_ -= keep;
+            for(int i = 0; i < add - keep; i++) {
+                threads_.emplace_back(&SqlExecutor::Run_, this);
+            }
+        } else {
+            retire_ += limit_ - threadNum;
+        }
+        limit_ = threadNum;
+    }
+    cond_.notify_all();
+    for(auto& t : exited) {
+        t.join();
+    }
+}
+
+int SqlExecutor::ThreadCount() {
+    lock_guard<mutex> locker(mtx_);
+    return limit_;
+}
+
+void SqlExecutor::Stop() {
+    vector<thread> threads;
+    {
+        lock_guard<mutex> locker(mtx_);
+        if(!isRunning_) { return; }
+        isRunning_ = false;
+        if(!tasks_.empty()) {
+            LOG_WARN("SqlExecutor stop, %d tasks dropped", (int)tasks_.size());
+        }
+        tasks_.clear();
+        exited_.clear();
+        threads.swap(threads_);
+    }
+    cond_.notify_all();
+    for(auto& t : threads) {
+        t.join();
+    }
+}
+
+void SqlExecutor::Run_() {
+    // 数据库线程大部分时间在等待网络，放在housekeeping核上，不占用工作核
+    CpuAffinity::Instance()->PinHousekeeping();
+    unique_lock<mutex> locker(mtx_);
+    while(true) {
+        if(retire_ > 0) {
+            // 线程数调小，先退出的线程把剩下的任务留给其他线程
+            retire_--;
+            exited_.push_back(this_thread::get_id());
+            if(!tasks_.empty()) { cond_.notify_one(); }
+            break;
+        } else if(!tasks_.empty() && running_ < limit_) {
+            SqlTask task = std::move(tasks_.front());
+            tasks_.pop_front();
+            running_++;
+            locker.unlock();
+            {
+                // 只在执行任务期间占用连接
+                MYSQL* sql = nullptr;
+                SqlConnRAII conn(&sql, pool_);
+                task(sql);
+            }
+            locker.lock();
+            running_--;
+        } else if(!isRunning_) {
+            break;
+        } else {
+            cond_.wait(locker);
+        }
+    }
+}
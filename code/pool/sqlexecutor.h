@@ -0,0 +1,84 @@
+#ifndef SQL_EXECUTOR_H
+#define SQL_EXECUTOR_H
+
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <thread>
+#include <assert.h>
+
+#include "sqlconnpool.h"
+
+/**
+ * @class SqlExecutor
+ * @brief 专门执行数据库任务的线程组。
+ *
+ * 登录/注册这类数据库操作不再在HTTP工作线程上同步执行：HttpConn把任务交给SqlExecutor后立即返回，
+ * 工作线程（或从Reactor）继续处理其他连接上的静态文件请求。每个任务执行时从SqlConnPool取一个连接，
+ * 线程数不超过连接数时取连接不会阻塞。任务的回调在数据库线程中执行，负责把结果交回连接所属的线程。
+ */
+class SqlExecutor {
+public:
+    typedef std::function<void(MYSQL*)> SqlTask;   // 参数为本次使用的连接，连接池为空时为nullptr
+
+    static SqlExecutor* Instance();
+
+    /**
+     * @brief 启动数据库线程
+     * @param pool 连接池
+     * @param threadNum 线程数，一般等于连接池的连接数
+     */
+    void Init(SqlConnPool* pool, int threadNum);
+
+    /**
+     * @brief 投递一个数据库任务，可在任意线程调用
+     * @return 没有启动（或已停止）时返回false，调用者应改为同步执行
+     */
+    bool AddTask(SqlTask task);
+
+    /**
+     * @brief 是否已启动
+     */
+    bool IsRunning();
+
+    /**
+     * @brief 调整线程数，随连接池一起调整（配置重载）
+     *
+     * 新的上限立即生效：正在执行的任务数达到上限时其他线程不再取任务，保证同时占用的连接数不超过
+     * 新的连接数。增加时立即创建新线程；减少时多出的线程执行完手上的任务后退出。
+     *
+     * @param threadNum 新的线程数
+     */
+    void Resize(int threadNum);
+
+    /**
+     * @brief 调整后的线程数（多出的线程可能还没有退出）
+     */
+    int ThreadCount();
+
+    /**
+     * @brief 停止：丢弃还没开始的任务，等待正在执行的任务完成后回收线程
+     */
+    void Stop();
+
+private:
+    SqlExecutor() = default;
+    ~SqlExecutor() { Stop(); }
+
+    void Run_();
+
+    SqlConnPool* pool_ = nullptr;
+    bool isRunning_ = false;
+    std::mutex mtx_;
+    std::condition_variable cond_;
+    std::deque<SqlTask> tasks_;
+    std::vector<std::thread> threads_;
+    int limit_ = 0;                         // 同时执行的任务数上限，即调整后的线程数
+    int running_ = 0;                       // 正在执行的任务数
+    int retire_ = 0;                        // 等待退出的线程数
+    std::vector<std::thread::id> exited_;   // 调小后已退出、还没有join的线程
+};
+
+#endif // SQL_EXECUTOR_H
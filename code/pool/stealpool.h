@@ -0,0 +1,259 @@
+#ifndef STEALPOOL_H
+#define STEALPOOL_H
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <thread>
+#include <atomic>
+#include <assert.h>
+
+#include "cpuaffinity.h"
+
+/**
+ * @brief 有界无锁MPMC环形队列（Vyukov算法）。
+ *
+ * 每个槽位带一个序号，生产者和消费者只通过CAS推进各自的下标，
+ * 任意线程都可以入队和出队，因此同一个队列既能被所属工作线程消费，也能被其他线程窃取。
+ *
+ * @tparam T 元素类型，应为小的、可平凡拷贝的任务句柄。
+ */
+template<typename T>
+class BoundedQueue {
+public:
+    /**
+     * @brief 构造函数
+     * @param size 队列容量，必须是2的幂
+     */
+    explicit BoundedQueue(size_t size) : cells_(new Cell[size]), mask_(size - 1) {
+        assert(size >= 2 && (size & (size - 1)) == 0);
+        for(size_t i = 0; i < size; i++) {
+            cells_[i].seq.store(i, std::memory_order_relaxed);
+        }
+        enqueuePos_.store(0, std::memory_order_relaxed);
+        dequeuePos_.store(0, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 入队
+     * @return 队列已满时返回false
+     */
+    bool Push(const T& item) {
+        Cell* cell;
+        size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+        while(true) {
+            cell = &cells_[pos & mask_];
+            size_t seq = cell->seq.load(std::memory_order_acquire);
+            intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+            if(dif == 0) {
+                if(enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if(dif < 0) {
+                return false;   // 满了
+            } else {
+                pos = enqueuePos_.load(std::memory_order_relaxed);
+            }
+        }
+        cell->data = item;
+        cell->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief 出队
+     * @return 队列为空时返回false
+     */
+    bool Pop(T& item) {
+        Cell* cell;
+        size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+        while(true) {
+            cell = &cells_[pos & mask_];
+            size_t seq = cell->seq.load(std::memory_order_acquire);
+            intptr_t dif = (intptr_t)seq - (intptr_t)(pos + 1);
+            if(dif == 0) {
+                if(dequeuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if(dif < 0) {
+                return false;   // 空了
+            } else {
+                pos = dequeuePos_.load(std::memory_order_relaxed);
+            }
+        }
+        item = cell->data;
+        cell->seq.store(pos + mask_ + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief 队列中元素数量的近似值
+     */
+    size_t Size() const {
+        size_t enq = enqueuePos_.load(std::memory_order_relaxed);
+        size_t deq = dequeuePos_.load(std::memory_order_relaxed);
+        return enq > deq ? enq - deq : 0;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> seq;
+        T data;
+    };
+
+    // 生产者下标和消费者下标放在不同的缓存行，避免伪共享
+    char pad0_[64];
+    std::unique_ptr<Cell[]> cells_;
+    const size_t mask_;
+    char pad1_[64];
+    std::atomic<size_t> enqueuePos_;
+    char pad2_[64 - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> dequeuePos_;
+    char pad3_[64 - sizeof(std::atomic<size_t>)];
+};
+
+/**
+ * @brief 带工作窃取的线程池，可替代ThreadPool。
+ *
+ * 与ThreadPool的区别：
+ *  - 每个工作线程有自己的有界无锁队列，AddTask轮询投递，不经过全局互斥锁；
+ *  - 自己的队列空了就去其他线程的队列里窃取任务；
+ *  - 任务是固定大小的句柄（例如连接指针 + 操作码），处理函数在构造时给定一次，
+ *    每个事件不再分配std::function；
+ *  - 只有存在休眠的工作线程时才会加锁唤醒，满载时完全无锁。
+ * 所有队列都满时由调用者线程直接执行该任务，作为背压。
+ *
+ * @tparam Task 任务句柄类型
+ */
+template<typename Task>
+class WorkStealingPool {
+public:
+    typedef std::function<void(Task&)> Handler;
+
+    /**
+     * @brief 构造函数，创建工作线程
+     * @param threadCount 工作线程数量
+     * @param handler 任务处理函数，在工作线程中调用
+     * @param queueSize 每个工作线程队列的容量，必须是2的幂
+     */
+    WorkStealingPool(int threadCount, Handler handler, size_t queueSize = 4096)
+        : handler_(std::move(handler)), isClosed_(false), idle_(0), next_(0) {
+        assert(threadCount > 0 && handler_);
+        for(int i = 0; i < threadCount; i++) {
+            queues_.emplace_back(new BoundedQueue<Task>(queueSize));
+        }
+        for(int i = 0; i < threadCount; i++) {
+            threads_.emplace_back(&WorkStealingPool::Worker_, this, i);
+        }
+    }
+
+    /**
+     * @brief 析构函数，处理完剩余任务后等待所有工作线程退出
+     */
+    ~WorkStealingPool() {
+        {
+            std::lock_guard<std::mutex> locker(mtx_);
+            isClosed_ = true;
+        }
+        cond_.notify_all();
+        for(auto& t : threads_) {
+            if(t.joinable()) { t.join(); }
+        }
+    }
+
+    /**
+     * @brief 添加一个任务
+     * @param task 任务句柄
+     */
+    void AddTask(const Task& task) {
+        size_t n = queues_.size();
+        size_t start = next_++;
+        size_t i = 0;
+        for(; i < n; i++) {
+            if(queues_[(start + i) % n]->Push(task)) { break; }
+        }
+        if(i == n) {
+            // 所有队列都满了，在调用者线程中直接执行
+            Task t = task;
+            handler_(t);
+            return;
+        }
+        // 与工作线程的idle_++配对，保证不会丢失唤醒
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(idle_.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard<std::mutex> locker(mtx_);
+            cond_.notify_one();
+        }
+    }
+
+    /**
+     * @brief 所有队列中等待执行的任务数量（近似值）
+     */
+    size_t QueueSize() const {
+        size_t total = 0;
+        for(auto& q : queues_) { total += q->Size(); }
+        return total;
+    }
+
+private:
+    /**
+     * @brief 先取自己的队列，再从其他线程的队列窃取
+     */
+    bool Take_(size_t self, Task& task) {
+        if(queues_[self]->Pop(task)) { return true; }
+        size_t n = queues_.size();
+        for(size_t i = 1; i < n; i++) {
+            if(queues_[(self + i) % n]->Pop(task)) { return true; }
+        }
+        return false;
+    }
+
+    /**
+     * @brief 工作线程主循环
+     */
+    void Worker_(size_t self) {
+        static const int SPIN_COUNT = 16;
+        Task task;
+        int spins = 0;
+        // 开启绑核时每个工作线程占一个核
+        CpuAffinity::Instance()->PinWorker();
+        while(true) {
+            if(Take_(self, task)) {
+                handler_(task);
+                spins = 0;
+                continue;
+            }
+            if(isClosed_.load(std::memory_order_acquire)) {
+                break;
+            }
+            // 短暂自旋，负载较高时避免频繁休眠/唤醒
+            if(++spins < SPIN_COUNT) {
+                std::this_thread::yield();
+                continue;
+            }
+            idle_.fetch_add(1, std::memory_order_seq_cst);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            {
+                std::unique_lock<std::mutex> locker(mtx_);
+                while(!isClosed_.load(std::memory_order_relaxed) && QueueSize() == 0) {
+                    cond_.wait(locker);
+                }
+            }
+            idle_.fetch_sub(1, std::memory_order_relaxed);
+            spins = 0;
+        }
+    }
+
+    Handler handler_;                                       // 任务处理函数
+    std::vector<std::unique_ptr<BoundedQueue<Task>>> queues_;   // 每个工作线程一个队列
+    std::vector<std::thread> threads_;                      // 工作线程
+    std::atomic<bool> isClosed_;                            // 关闭标志
+    std::atomic<int> idle_;                                 // 休眠中的工作线程数
+    std::atomic<size_t> next_;                              // 下一个投递的队列（轮询）
+    std::mutex mtx_;                                        // 仅用于休眠/唤醒
+    std::condition_variable cond_;
+};
+
+#endif
@@ -6,8 +6,12 @@
 #include <condition_variable>
 #include <functional>
 #include <thread>
+#include <atomic>
+#include <algorithm>
+#include <vector>
 #include <assert.h>
 
+#include "cpuaffinity.h"
 
 class ThreadPool {
 public:
@@ -16,37 +20,30 @@ public:
     // 尽量用make_shared代替new，如果通过new再传递给shared_ptr，内存是不连续的，会造成内存碎片化
     explicit ThreadPool(int threadCount = 8) : pool_(std::make_shared<Pool>()) { // make_shared:传递右值，功能是在动态内存中分配一个对象并初始化它，返回指向此对象的shared_ptr
         assert(threadCount > 0);
-        for(int i = 0; i < threadCount; i++) {
-            std::thread([this]() {
-                std::unique_lock<std::mutex> locker(pool_->mtx_);
-                while(true) {
-                    if(!pool_->tasks.empty()) {
-                        auto task = std::move(pool_->tasks.front());    // 左值变右值,资产转移
-                        pool_->tasks.pop();
-                        locker.unlock();    // 因为已经把任务取出来了，所以可以提前解锁了
-                        task();
-                        locker.lock();      // 马上又要取任务了，上锁
-                    } else if(pool_->isClosed) {
-                        break;
-                    } else {
-                        pool_->cond_.wait(locker);    // 等待,如果任务来了就notify的
-                    }
-                    
-                }
-            }).detach();
-        }
+        pool_->threads = threadCount;
+        Spawn_(threadCount);
     }
 
+    /**
+     * @brief 关闭线程池：工作线程执行完队列中剩下的任务后退出，析构函数等待它们全部退出
+     *
+     * 返回后不会再有线程访问任务引用的对象，所属者可以安全地释放它们。不能在工作线程中析构。
+     */
     ~ThreadPool() {
         // 检查 pool_ 是否有效（即是否指向一个有效的 Pool 对象）
         if(pool_) {
-            // 加锁以确保线程安全，防止在修改 isClosed 标志时发生数据竞争
-            std::unique_lock<std::mutex> locker(pool_->mtx_);
-            // 将 isClosed 标志设置为 true，表示线程池已关闭
-            pool_->isClosed = true;
+            {
+                // 加锁以确保线程安全，防止在修改 isClosed 标志时发生数据竞争
+                std::unique_lock<std::mutex> locker(pool_->mtx_);
+                // 将 isClosed 标志设置为 true，表示线程池已关闭
+                pool_->isClosed = true;
+            }
+            // 唤醒所有正在等待的线程，让它们检查 isClosed 标志并退出循环
+            pool_->cond_.notify_all();
+        }
+        for(auto& worker : workers_) {
+            if(worker.joinable()) { worker.join(); }
         }
-        // 唤醒所有正在等待的线程，让它们检查 isClosed 标志并退出循环
-        pool_->cond_.notify_all();
     }
 
     template<typename T>
@@ -61,19 +58,119 @@ public:
         std::unique_lock<std::mutex> locker(pool_->mtx_);
         // 使用 std::forward 完美转发任务到任务队列中
         pool_->tasks.emplace(std::forward<T>(task));
+        pool_->size.store(pool_->tasks.size(), std::memory_order_relaxed);
         // 唤醒一个正在等待的线程来处理新添加的任务
         pool_->cond_.notify_one();
     }
 
+    /**
+     * @brief 任务队列中等待执行的任务数量（近似值），不加锁，供准入控制在投递前检查
+     */
+    size_t QueueSize() const {
+        return pool_->size.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 调整工作线程数，可在任意线程调用（配置重载）
+     *
+     * 增加时立即创建新线程；减少时让多出的线程在空闲时（任务队列为空）退出，正在执行的任务不受影响。
+     *
+     * @param threadCount 新的线程数
+     */
+    void Resize(int threadCount) {
+        assert(threadCount > 0);
+        // 回收之前调小时已经退出的线程
+        Reap_();
+        std::unique_lock<std::mutex> locker(pool_->mtx_);
+        int current = pool_->threads - pool_->retire;
+        if(threadCount > current) {
+            // 还没退出的线程先留下，不够再创建
+            int add = threadCount - current;
+            int keep = std::min(add, pool_->retire);
+            pool_->retire -= keep;
+            pool_->threads += add - keep;
+            locker.unlock();
+            Spawn_(add - keep);
+        } else if(threadCount < current) {
+            pool_->retire += current - threadCount;
+            pool_->cond_.notify_all();
+        }
+    }
+
+    /**
+     * @brief 调整后的工作线程数（多出的线程可能还没有退出）
+     */
+    int ThreadCount() {
+        std::lock_guard<std::mutex> locker(pool_->mtx_);
+        return pool_->threads - pool_->retire;
+    }
+
 private:
+    /**
+     * @brief 创建n个工作线程，由析构函数（或调小后的Resize）join
+     */
+    void Spawn_(int n) {
+        for(int i = 0; i < n; i++) {
+            workers_.emplace_back([pool = pool_]() {
+                // 开启绑核时每个工作线程占一个核
+                CpuAffinity::Instance()->PinWorker();
+                std::unique_lock<std::mutex> locker(pool->mtx_);
+                while(true) {
+                    if(!pool->tasks.empty()) {
+                        auto task = std::move(pool->tasks.front());    // 左值变右值,资产转移
+                        pool->tasks.pop();
+                        pool->size.store(pool->tasks.size(), std::memory_order_relaxed);
+                        locker.unlock();    // 因为已经把任务取出来了，所以可以提前解锁了
+                        task();
+                        locker.lock();      // 马上又要取任务了，上锁
+                    } else if(pool->isClosed) {
+                        break;
+                    } else if(pool->retire > 0) {
+                        // 线程数调小，空闲的线程退出
+                        pool->retire--;
+                        pool->threads--;
+                        pool->exited.push_back(std::this_thread::get_id());
+                        break;
+                    } else {
+                        pool->cond_.wait(locker);    // 等待,如果任务来了就notify的
+                    }
+                    
+                }
+            });
+        }
+    }
+
+    /**
+     * @brief join调小线程数后已经退出的线程
+     */
+    void Reap_() {
+        std::vector<std::thread::id> exited;
+        {
+            std::lock_guard<std::mutex> locker(pool_->mtx_);
+            exited.swap(pool_->exited);
+        }
+        for(const std::thread::id& id : exited) {
+            auto it = std::find_if(workers_.begin(), workers_.end(),
+                                   [&id](const std::thread& t) { return t.get_id() == id; });
+            if(it == workers_.end()) { continue; }
+            it->join();
+            workers_.erase(it);
+        }
+    }
+
     // 用一个结构体封装起来，方便调用
     struct Pool {
         std::mutex mtx_;
         std::condition_variable cond_;
         bool isClosed;
         std::queue<std::function<void()>> tasks; // 任务队列，函数类型为void()
+        std::atomic<size_t> size{0};             // tasks.size()的副本，在锁内更新
+        int threads = 0;                         // 工作线程数
+        int retire = 0;                          // 等待退出的线程数
+        std::vector<std::thread::id> exited;     // 调小后已退出、还没有join的线程
     };
     std::shared_ptr<Pool> pool_;
+    std::vector<std::thread> workers_;           // 工作线程，只在所属者的线程（构造、Resize、析构）中修改
 };
 
 #endif
\ No newline at end of file
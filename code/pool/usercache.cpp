@@ -0,0 +1,104 @@
+#include "usercache.h"
+
+using namespace std;
+
+UserCache* UserCache::Instance() {
+    static UserCache cache;
+    return &cache;
+}
+
+void UserCache::Init(size_t capacity, int ttlMS, size_t shardCount) {
+    assert(shards_.empty() && ttlMS > 0 && shardCount > 0);
+    if(capacity == 0) { return; }
+    size_t count = 1;
+    while(count < shardCount) { count <<= 1; }
+    // 容量太小时减少分片，保证每个分片至少能放一条
+    while(count > 1 && capacity / count == 0) { count >>= 1; }
+    shards_.reserve(count);
+    for(size_t i = 0; i < count; i++) {
+        shards_.emplace_back(new Shard());
+    }
+    shardMask_ = count - 1;
+    shardCapacity_ = capacity / count;
+    ttl_ = chrono::milliseconds(ttlMS);
+}
+
+UserCache::Shard& UserCache::ShardOf_(const string& name) {
+    return *shards_[hash<string>()(name) & shardMask_];
+}
+
+bool UserCache::Get(const string& name, string* pwd) {
+    assert(pwd);
+    if(shards_.empty()) { return false; }
+    Shard& shard = ShardOf_(name);
+    {
+        lock_guard<mutex> locker(shard.mtx);
+        auto it = shard.index.find(name);
+        if(it != shard.index.end()) {
+            auto entry = it->second;
+            if(entry->expires > Clock::now()) {
+                // 移到表头
+                shard.lru.splice(shard.lru.begin(), shard.lru, entry);
+                *pwd = entry->pwd;
+                hits_.fetch_add(1, memory_order_relaxed);
+                return true;
+            }
+            // 已过期
+            shard.lru.erase(entry);
+            shard.index.erase(it);
+        }
+    }
+    misses_.fetch_add(1, memory_order_relaxed);
+    return false;
+}
+
+void UserCache::Put(const string& name, const string& pwd) {
+    if(shards_.empty()) { return; }
+    Shard& shard = ShardOf_(name);
+    Clock::time_point expires = Clock::now() + ttl_;
+    lock_guard<mutex> locker(shard.mtx);
+    auto it = shard.index.find(name);
+    if(it != shard.index.end()) {
+        it->second->pwd = pwd;
+        it->second->expires = expires;
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+        return;
+    }
+    // 分片已满，淘汰表尾最久未使用的记录
+    if(shard.index.size() >= shardCapacity_) {
+        shard.index.erase(shard.lru.back().name);
+        shard.lru.pop_back();
+    }
+    shard.lru.push_front(Entry{name, pwd, expires});
+    shard.index.emplace(name, shard.lru.begin());
+}
+
+void UserCache::Erase(const string& name) {
+    if(shards_.empty()) { return; }
+    Shard& shard = ShardOf_(name);
+    lock_guard<mutex> locker(shard.mtx);
+    auto it = shard.index.find(name);
+    if(it != shard.index.end()) {
+        shard.lru.erase(it->second);
+        shard.index.erase(it);
+    }
+}
+
+void UserCache::Clear() {
+    for(auto& shard : shards_) {
+        lock_guard<mutex> locker(shard->mtx);
+        shard->lru.clear();
+        shard->index.clear();
+    }
+    hits_ = 0;
+    misses_ = 0;
+}
+
+size_t UserCache::Size() {
+    size_t size = 0;
+    for(auto& shard : shards_) {
+        lock_guard<mutex> locker(shard->mtx);
+        size += shard->index.size();
+    }
+    return size;
+}
@@ -0,0 +1,89 @@
+#ifndef USER_CACHE_H
+#define USER_CACHE_H
+
+#include <string>
+#include <list>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <assert.h>
+
+/**
+ * @class UserCache
+ * @brief 用户名 -> 密码的内存缓存，挡在SqlConnPool前面。
+ *
+ * 按用户名哈希分成若干分片，每个分片一把锁、一条LRU链表和一个哈希表，不同用户的查询不会互相等待。
+ * 总容量平均分到各分片，分片满时淘汰最久未使用的记录；每条记录写入后ttl毫秒过期，过期记录在查询时删除。
+ * 只缓存数据库中确实存在的用户（查询命中或注册成功时写入），不缓存"用户不存在"。
+ * 没有Init（或容量为0）时不缓存，Get总是未命中。
+ */
+class UserCache {
+public:
+    static UserCache* Instance();
+
+    /**
+     * @brief 初始化
+     * @param capacity 最多缓存的用户数，为0时不缓存
+     * @param ttlMS 记录的有效期（毫秒）
+     * @param shardCount 分片数，向上取整为2的幂
+     */
+    void Init(size_t capacity, int ttlMS, size_t shardCount = 16);
+
+    /**
+     * @brief 查询用户的密码
+     * @param name 用户名
+     * @param pwd 命中时输出密码
+     * @return 是否命中
+     */
+    bool Get(const std::string& name, std::string* pwd);
+
+    /**
+     * @brief 写入（或刷新）一条记录
+     */
+    void Put(const std::string& name, const std::string& pwd);
+
+    /**
+     * @brief 删除一条记录
+     */
+    void Erase(const std::string& name);
+
+    /**
+     * @brief 清空所有记录和计数
+     */
+    void Clear();
+
+    size_t Size();
+    uint64_t Hits() const { return hits_.load(std::memory_order_relaxed); }
+    uint64_t Misses() const { return misses_.load(std::memory_order_relaxed); }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Entry {
+        std::string name;
+        std::string pwd;
+        Clock::time_point expires;
+    };
+
+    struct Shard {
+        std::mutex mtx;
+        std::list<Entry> lru;   // 表头是最近使用的记录
+        std::unordered_map<std::string, std::list<Entry>::iterator> index;
+    };
+
+    UserCache() = default;
+
+    Shard& ShardOf_(const std::string& name);
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+    size_t shardMask_ = 0;
+    size_t shardCapacity_ = 0;  // 每个分片的容量
+    std::chrono::milliseconds ttl_{0};
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+};
+
+#endif // USER_CACHE_H
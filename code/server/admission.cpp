@@ -0,0 +1,48 @@
+#include "admission.h"
+
+#include <sys/socket.h>
+
+using namespace std;
+
+Admission* Admission::Instance() {
+    static Admission admission;
+    return &admission;
+}
+
+Admission::Admission(): maxQueue_(0), maxInFlight_(0), highWater_(0), lowWater_(0),
+                        inFlight_(0), shed_(0) {
+    Init(0, 0, 0, 0, 1);
+}
+
+void Admission::Init(size_t maxQueue, int maxInFlight, int highWater, int lowWater, int retryAfterSec) {
+    maxQueue_ = maxQueue;
+    maxInFlight_ = maxInFlight > 0 ? maxInFlight : 0;
+    highWater_ = highWater > 0 ? highWater : 0;
+    lowWater_ = (lowWater > 0 && lowWater < highWater_) ? lowWater : highWater_ - highWater_ / 10;
+    if(retryAfterSec < 0) { retryAfterSec = 0; }
+    // 没有正文、总是关闭连接，客户端据Retry-After退避
+    busy_ = "HTTP/1.1 503 Service Unavailable\r\n"
+            "Retry-After: " + to_string(retryAfterSec) + "\r\n"
+            "Content-Length: 0\r\n"
+            "Connection: close\r\n\r\n";
+}
+
+bool Admission::TryEnter(size_t queueDepth) {
+    if(maxQueue_ > 0 && queueDepth >= maxQueue_) { return false; }
+    if(maxInFlight_ > 0) {
+        // 先加后判断，并发投递时也不会超过上限
+        if(inFlight_.fetch_add(1, memory_order_relaxed) >= maxInFlight_) {
+            inFlight_.fetch_sub(1, memory_order_relaxed);
+            return false;
+        }
+    }
+    return true;
+}
+
+void Admission::Shed(int fd) {
+    char drain[4096];
+    // 最多读掉16KB，再多的请求数据说明客户端还在发送，RST也无法避免
+    for(int i = 0; i < 4 && recv(fd, drain, sizeof(drain), MSG_DONTWAIT) == (ssize_t)sizeof(drain); i++) {}
+    send(fd, busy_.data(), busy_.size(), MSG_DONTWAIT | MSG_NOSIGNAL);
+    shed_.fetch_add(1, memory_order_relaxed);
+}
@@ -0,0 +1,94 @@
+#ifndef ADMISSION_H
+#define ADMISSION_H
+
+#include <atomic>
+#include <string>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @class Admission
+ * @brief 过载保护：连接数水位线和请求准入控制。
+ *
+ * 两层保护：
+ *  - 连接层：连接数达到高水位时各Reactor把监听套接字移出epoll，不再accept，
+ *    新连接留在内核的全连接队列里（满了由内核拒绝）；降到低水位以下再重新加入。
+ *  - 请求层（主Reactor + 线程池模型）：读事件投递给线程池之前检查任务队列深度和在途请求数，
+ *    超过限制时直接回复预先格式化好的503（带Retry-After）并关闭连接，不进入队列，
+ *    排队时间因此有上界，而不是在过载时无限增长。
+ * 限制为0表示不启用对应的检查；没有Init时不做任何限制。
+ */
+class Admission {
+public:
+    static Admission* Instance();
+
+    /**
+     * @brief 初始化
+     * @param maxQueue 线程池任务队列深度上限
+     * @param maxInFlight 在途请求数（已投递、还没处理完的读任务）上限
+     * @param highWater 连接数高水位，达到时暂停accept
+     * @param lowWater 连接数低水位，降到它以下时恢复accept；不小于highWater时取highWater的90%
+     * @param retryAfterSec 503响应中Retry-After的秒数
+     */
+    void Init(size_t maxQueue, int maxInFlight, int highWater, int lowWater, int retryAfterSec);
+
+    /**
+     * @brief 请求准入：队列深度和在途请求数都没有超限时计入在途请求
+     * @param queueDepth 线程池当前的任务队列深度
+     * @return 准入时返回true，之后必须调用Leave()；否则调用者应Shed()该连接
+     */
+    bool TryEnter(size_t queueDepth);
+
+    /**
+     * @brief 一个准入的请求处理完毕
+     */
+    void Leave() {
+        if(maxInFlight_ > 0) { inFlight_.fetch_sub(1, std::memory_order_relaxed); }
+    }
+
+    /**
+     * @brief 连接数是否达到高水位（应暂停accept）
+     */
+    bool OverHighWater(int conns) const { return highWater_ > 0 && conns >= highWater_; }
+
+    /**
+     * @brief 连接数是否降到低水位以下（可以恢复accept）
+     */
+    bool BelowLowWater(int conns) const { return conns < lowWater_; }
+
+    /**
+     * @brief 拒绝一个连接：读掉已到达的请求数据（避免close时发RST冲掉响应），发送503
+     *
+     * 只做非阻塞的收发，不关闭fd，由调用者按自己的方式关闭连接。
+     *
+     * @param fd 客户端套接字
+     */
+    void Shed(int fd);
+
+    /**
+     * @brief 预先格式化好的503响应
+     */
+    const std::string& BusyResponse() const { return busy_; }
+
+    int InFlight() const { return inFlight_.load(std::memory_order_relaxed); }
+    uint64_t ShedCount() const { return shed_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief 暂停accept时事件循环的最长等待时间（毫秒），用于及时检查低水位
+     */
+    static const int PAUSE_POLL_MS = 10;
+
+private:
+    Admission();
+
+    size_t maxQueue_;
+    int maxInFlight_;
+    int highWater_;
+    int lowWater_;
+    std::string busy_;              // 503响应，Init时生成一次
+
+    alignas(64) std::atomic<int> inFlight_;
+    alignas(64) std::atomic<uint64_t> shed_;
+};
+
+#endif // ADMISSION_H
@@ -0,0 +1,153 @@
+#include "config.h"
+
+#include <fstream>
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace std;
+
+namespace {
+
+struct IntKey {
+    const char* key;
+    int ServerConfig::*field;
+    int min;
+};
+
+struct BoolKey {
+    const char* key;
+    bool ServerConfig::*field;
+};
+
+struct StringKey {
+    const char* key;
+    string ServerConfig::*field;
+};
+
+const IntKey INT_KEYS[] = {
+    {"port", &ServerConfig::port, 1},
+    {"trig_mode", &ServerConfig::trigMode, 0},
+    {"timeout_ms", &ServerConfig::timeoutMS, 0},
+    {"sql_port", &ServerConfig::sqlPort, 1},
+    {"sql_pool_size", &ServerConfig::connPoolNum, 1},
+    {"thread_num", &ServerConfig::threadNum, 1},
+    {"log_level", &ServerConfig::logLevel, 0},
+    {"log_queue_size", &ServerConfig::logQueSize, 0},
+    {"backlog", &ServerConfig::backlog, 1},
+    {"file_cache_mb", &ServerConfig::fileCacheMB, 0},
+    {"keep_alive_max", &ServerConfig::keepAliveMax, 0},
+    {"keep_alive_timeout_ms", &ServerConfig::keepAliveTimeoutMS, 0},
+    {"max_queue", &ServerConfig::maxQueue, 0},
+    {"max_in_flight", &ServerConfig::maxInFlight, 0},
+    {"conn_high_water", &ServerConfig::connHighWater, 0},
+    {"conn_low_water", &ServerConfig::connLowWater, 0},
+    {"retry_after_sec", &ServerConfig::retryAfterSec, 0},
+    {"slow_request_ms", &ServerConfig::slowRequestMS, 0},
+    {"drain_timeout_ms", &ServerConfig::drainTimeoutMS, 0},
+    {"max_body_kb", &ServerConfig::maxBodyKB, 0},
+    {"housekeeping_cpu", &ServerConfig::housekeepingCpu, -1},
+};
+
+const BoolKey BOOL_KEYS[] = {
+    {"open_log", &ServerConfig::openLog},
+    {"multi_reactor", &ServerConfig::multiReactor},
+    {"reuse_port", &ServerConfig::reusePort},
+    {"work_stealing", &ServerConfig::workStealing},
+    {"sendfile", &ServerConfig::useSendfile},
+    {"time_wheel", &ServerConfig::timeWheel},
+    {"access_log", &ServerConfig::accessLog},
+    {"io_uring", &ServerConfig::ioUring},
+    {"metrics", &ServerConfig::metrics},
+    {"cpu_affinity", &ServerConfig::cpuAffinity},
+};
+
+const StringKey STRING_KEYS[] = {
+    {"sql_user", &ServerConfig::sqlUser},
+    {"sql_password", &ServerConfig::sqlPwd},
+    {"db_name", &ServerConfig::dbName},
+};
+
+string Trim(const string& s) {
+    size_t begin = s.find_first_not_of(" \t\r");
+    if(begin == string::npos) { return ""; }
+    size_t end = s.find_last_not_of(" \t\r");
+    return s.substr(begin, end - begin + 1);
+}
+
+bool ParseBool(const string& value, bool* out) {
+    if(value == "true" || value == "on" || value == "1") { *out = true; return true; }
+    if(value == "false" || value == "off" || value == "0") { *out = false; return true; }
+    return false;
+}
+
+} // namespace
+
+bool ServerConfig::Load(const string& path, string* err) {
+    ifstream in(path);
+    if(!in) {
+        *err = path + ": " + strerror(errno);
+        return false;
+    }
+    string line;
+    for(int lineNo = 1; getline(in, line); lineNo++) {
+        size_t comment = line.find('#');
+        if(comment != string::npos) { line.resize(comment); }
+        line = Trim(line);
+        if(line.empty()) { continue; }
+        size_t eq = line.find('=');
+        string key = Trim(line.substr(0, eq));
+        string value = eq == string::npos ? "" : Trim(line.substr(eq + 1));
+        string where = path + ":" + to_string(lineNo) + ": ";
+        if(eq == string::npos || key.empty()) {
+            *err = where + "expected 'key = value'";
+            return false;
+        }
+        bool found = false;
+        for(const IntKey& item : INT_KEYS) {
+            if(key != item.key) { continue; }
+            char* end = nullptr;
+            errno = 0;
+            long n = strtol(value.c_str(), &end, 10);
+            if(value.empty() || *end != '\0' || errno == ERANGE || n < item.min || n > INT32_MAX) {
+                *err = where + "invalid value '" + value + "' for " + key;
+                return false;
+            }
+            this->*item.field = static_cast<int>(n);
+            found = true;
+        }
+        for(const BoolKey& item : BOOL_KEYS) {
+            if(key != item.key) { continue; }
+            if(!ParseBool(value, &(this->*item.field))) {
+                *err = where + "invalid value '" + value + "' for " + key;
+                return false;
+            }
+            found = true;
+        }
+        for(const StringKey& item : STRING_KEYS) {
+            if(key != item.key) { continue; }
+            this->*item.field = value;
+            found = true;
+        }
+        if(!found) {
+            *err = where + "unknown key '" + key + "'";
+            return false;
+        }
+    }
+    return true;
+}
+
+vector<string> ServerConfig::Diff(const ServerConfig& other) const {
+    vector<string> keys;
+    for(const IntKey& item : INT_KEYS) {
+        if(this->*item.field != other.*item.field) { keys.push_back(item.key); }
+    }
+    for(const BoolKey& item : BOOL_KEYS) {
+        if(this->*item.field != other.*item.field) { keys.push_back(item.key); }
+    }
+    for(const StringKey& item : STRING_KEYS) {
+        if(this->*item.field != other.*item.field) { keys.push_back(item.key); }
+    }
+    return keys;
+}
@@ -0,0 +1,70 @@
+/**
+ * @file config.h
+ * @brief 定义了服务器配置 ServerConfig 和配置文件的读取。
+ */
+
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <string>
+#include <vector>
+
+/**
+ * @struct ServerConfig
+ * @brief WebServer构造参数的集合，默认值与原先main.cpp中写死的参数相同。
+ *
+ * 配置文件每行一项"key = value"，'#'之后为注释，key与成员名对应（小写、下划线分隔），
+ * bool取值true/false/on/off/1/0。未出现的key保持默认值，未知的key和非法的值视为错误，避免拼写错误被悄悄忽略。
+ * 仓库根目录下的server.conf列出了所有的key。
+ */
+struct ServerConfig {
+    int port = 1316;                // 监听端口
+    int trigMode = 3;               // 触发模式（0~3，3为监听和连接都用ET）
+    int timeoutMS = 60000;          // 连接超时（毫秒），0表示不启用
+    int sqlPort = 3306;
+    std::string sqlUser = "root";
+    std::string sqlPwd = "123456";
+    std::string dbName = "webserver";
+    int connPoolNum = 12;           // 数据库连接池大小
+    int threadNum = 8;              // 线程池线程数（多Reactor模式下为从Reactor数量）
+    bool openLog = true;
+    int logLevel = 0;
+    int logQueSize = 1024;
+    bool multiReactor = false;
+    bool reusePort = false;
+    int backlog = 1024;
+    bool workStealing = false;
+    bool useSendfile = false;
+    int fileCacheMB = 64;
+    bool timeWheel = false;
+    int keepAliveMax = 100;
+    int keepAliveTimeoutMS = 0;
+    bool accessLog = true;
+    bool ioUring = false;
+    int maxQueue = 0;
+    int maxInFlight = 0;
+    int connHighWater = 0;
+    int connLowWater = 0;
+    int retryAfterSec = 1;
+    bool metrics = false;
+    int slowRequestMS = 0;
+    int drainTimeoutMS = 30000;     // 收到SIGTERM后等待在途请求完成的时限（毫秒）
+    int maxBodyKB = 1024;           // 请求体上限（KB），超过时回复413，0表示不限制
+    bool cpuAffinity = false;       // 是否把工作线程绑到各自的核上
+    int housekeepingCpu = -1;       // 日志等后台线程使用的核，-1表示最后一个可用的核
+
+    /**
+     * @brief 读取配置文件，覆盖文件中出现的项
+     * @param path 文件路径
+     * @param err 失败时保存错误信息（含行号）
+     * @return 成功返回true；失败时本对象可能已被部分修改
+     */
+    bool Load(const std::string& path, std::string* err);
+
+    /**
+     * @brief 与另一份配置相比取值不同的key
+     */
+    std::vector<std::string> Diff(const ServerConfig& other) const;
+};
+
+#endif // CONFIG_H
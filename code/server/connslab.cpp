@@ -0,0 +1,38 @@
+#include "connslab.h"
+
+ConnSlab::ConnSlab(int maxFd)
+    : maxFd_(maxFd), chunkCount_((maxFd + CHUNK_SIZE - 1) >> CHUNK_SHIFT),
+      chunks_(new std::atomic<HttpConn*>[chunkCount_]) {
+    assert(maxFd > 0);
+    for(int i = 0; i < chunkCount_; i++) {
+        chunks_[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+ConnSlab::~ConnSlab() {
+    for(int i = 0; i < chunkCount_; i++) {
+        delete[] chunks_[i].load(std::memory_order_relaxed);
+    }
+}
+
+HttpConn* ConnSlab::Get(int fd) {
+    assert(fd >= 0 && fd < maxFd_);
+    HttpConn* conn = Find(fd);
+    if(conn) { return conn; }
+    // 双重检查，只有第一个线程真正分配
+    std::lock_guard<std::mutex> locker(mtx_);
+    std::atomic<HttpConn*>& slot = chunks_[fd >> CHUNK_SHIFT];
+    HttpConn* chunk = slot.load(std::memory_order_relaxed);
+    if(!chunk) {
+        chunk = new HttpConn[CHUNK_SIZE];
+        slot.store(chunk, std::memory_order_release);
+    }
+    return &chunk[fd & (CHUNK_SIZE - 1)];
+}
+
+void ConnSlab::Reserve(int count) {
+    if(count > maxFd_) { count = maxFd_; }
+    for(int fd = 0; fd < count; fd += CHUNK_SIZE) {
+        Get(fd);
+    }
+}
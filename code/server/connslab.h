@@ -0,0 +1,82 @@
+#ifndef CONN_SLAB_H
+#define CONN_SLAB_H
+
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <assert.h>
+
+#include "../http/httpconn.h"
+
+/**
+ * @class ConnSlab
+ * @brief 以fd为下标的连接表。
+ *
+ * 表按CHUNK_SIZE个连接分块，块指针数组按maxFd一次性预留，块在第一次使用时整体分配且不再释放，
+ * 因此连接对象的地址在整个生命周期内不变，同一块内的连接在内存中连续。
+ * 查找只是两次数组下标运算，没有哈希和链表遍历；只有分配新块时才加锁，可在多个线程中同时使用
+ * （各线程只访问自己负责的fd）。连接被复用时HttpConn的代数会变化，用于识别过期的定时器和任务。
+ */
+class ConnSlab {
+public:
+    /**
+     * @brief 构造函数
+     * @param maxFd 支持的最大fd（不含）
+     */
+    explicit ConnSlab(int maxFd);
+
+    /**
+     * @brief 析构函数，释放所有块（会关闭仍然打开的连接）。
+     */
+    ~ConnSlab();
+
+    /**
+     * @brief 获取fd对应的连接对象，所在块还没有分配时分配该块
+     * @param fd 文件描述符，必须小于Capacity()
+     * @return 地址稳定的连接对象
+     */
+    HttpConn* Get(int fd);
+
+    /**
+     * @brief 查找fd对应的连接对象，不分配
+     * @return 所在块还没有分配时返回nullptr
+     */
+    HttpConn* Find(int fd) const {
+        if(fd < 0 || fd >= maxFd_) { return nullptr; }
+        HttpConn* chunk = chunks_[fd >> CHUNK_SHIFT].load(std::memory_order_acquire);
+        return chunk ? &chunk[fd & (CHUNK_SIZE - 1)] : nullptr;
+    }
+
+    /**
+     * @brief 预先分配前count个fd所在的块，让最初的连接不需要在请求路径上分配内存
+     */
+    void Reserve(int count);
+
+    /**
+     * @brief 支持的最大fd（不含）
+     */
+    int Capacity() const { return maxFd_; }
+
+    /**
+     * @brief 遍历所有已分配的连接对象
+     */
+    template<typename Func>
+    void ForEach(Func func) {
+        for(int i = 0; i < chunkCount_; i++) {
+            HttpConn* chunk = chunks_[i].load(std::memory_order_acquire);
+            if(!chunk) { continue; }
+            for(int j = 0; j < CHUNK_SIZE; j++) { func(&chunk[j]); }
+        }
+    }
+
+private:
+    static const int CHUNK_SHIFT = 8;
+    static const int CHUNK_SIZE = 1 << CHUNK_SHIFT;    // 每块256个连接
+
+    const int maxFd_;
+    const int chunkCount_;
+    std::unique_ptr<std::atomic<HttpConn*>[]> chunks_;  // 块指针数组
+    std::mutex mtx_;                                    // 只在分配新块时使用
+};
+
+#endif //CONN_SLAB_H
@@ -1,11 +1,21 @@
 #include "epoller.h"
 
+// glibc 2.35起才提供epoll_pwait2的封装
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 35))
+#define EPOLLER_HAS_PWAIT2 1
+#else
+#define EPOLLER_HAS_PWAIT2 0
+#endif
+
+std::atomic<bool> Epoller::hasPwait2_(EPOLLER_HAS_PWAIT2 != 0);
+
 /**
  * @brief Epoller类的构造函数
  * 
- * @param maxEvent 最大事件数量
+ * @param maxEvent 事件数组的最大大小
  */
-Epoller::Epoller(int maxEvent):epollFd_(epoll_create(512)), events_(maxEvent){
+Epoller::Epoller(int maxEvent):epollFd_(epoll_create(512)), maxEvents_(maxEvent > 0 ? maxEvent : 1),
+                                events_(maxEvent < INIT_EVENTS ? maxEvents_ : INIT_EVENTS){
     // 断言确保epoll文件描述符创建成功且事件数组大小大于0
     assert(epollFd_ >= 0 && events_.size() > 0);
 }
@@ -76,7 +86,50 @@ bool Epoller::DelFd(int fd) {
  */
 int Epoller::Wait(int timeoutMs) {
     // 使用epoll_wait函数等待事件发生
-    return epoll_wait(epollFd_, &events_[0], static_cast<int>(events_.size()), timeoutMs);
+    int eventCnt = epoll_wait(epollFd_, &events_[0], static_cast<int>(events_.size()), timeoutMs);
+    Grow_(eventCnt);
+    return eventCnt;
+}
+
+/**
+ * @brief 等待事件发生，超时以微秒为单位
+ * 
+ * @param timeoutUs 超时时间（微秒）
+ * @return int 发生的事件数量
+ */
+int Epoller::WaitUs(int64_t timeoutUs) {
+    int eventCnt;
+#if EPOLLER_HAS_PWAIT2
+    if(hasPwait2_.load(std::memory_order_relaxed)) {
+        struct timespec ts;
+        ts.tv_sec = timeoutUs / 1000000;
+        ts.tv_nsec = (timeoutUs % 1000000) * 1000;
+        eventCnt = epoll_pwait2(epollFd_, &events_[0], static_cast<int>(events_.size()),
+                                timeoutUs < 0 ? nullptr : &ts, nullptr);
+        if(eventCnt >= 0 || errno != ENOSYS) {
+            Grow_(eventCnt);
+            return eventCnt;
+        }
+        hasPwait2_.store(false, std::memory_order_relaxed);
+    }
+#endif
+    // 向上取整，避免不足1毫秒的超时变成0而空转
+    int timeoutMs = timeoutUs < 0 ? -1 : static_cast<int>((timeoutUs + 999) / 1000);
+    eventCnt = epoll_wait(epollFd_, &events_[0], static_cast<int>(events_.size()), timeoutMs);
+    Grow_(eventCnt);
+    return eventCnt;
+}
+
+/**
+ * @brief 这次等待取满了事件数组时把数组加倍
+ * 
+ * @param eventCnt 这次等待返回的事件数量
+ */
+void Epoller::Grow_(int eventCnt) {
+    // 加倍后已取回的事件仍在原位置，本轮循环照常读取
+    if(eventCnt > 0 && static_cast<size_t>(eventCnt) == events_.size() && events_.size() < maxEvents_) {
+        events_.resize(events_.size() * 2 < maxEvents_ ? events_.size() * 2 : maxEvents_);
+    }
 }
 
 /**
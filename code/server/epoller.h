@@ -5,19 +5,27 @@
 #include <unistd.h> // close()
 #include <assert.h> // close()
 #include <vector>
+#include <atomic>
 #include <errno.h>
+#include <stdint.h>
+#include <time.h>  // timespec
 
 /**
  * @brief Epoller类，用于管理epoll实例
+ *
+ * 事件数组从INIT_EVENTS个开始，某次等待取满整个数组时加倍，直到maxEvent；空闲的事件循环只占很小的数组，
+ * 高负载时一次系统调用取回更多事件。WaitUs在内核支持时使用epoll_pwait2，超时精确到微秒。
  */
 class Epoller {
 public:
+    static const int INIT_EVENTS = 64;  // 事件数组的初始大小
+
     /**
      * @brief 构造函数，初始化epoll实例
      * 
-     * @param maxEvent 最大事件数量，默认为1024
+     * @param maxEvent 事件数组最多增长到的大小，默认为4096
      */
-    explicit Epoller(int maxEvent = 1024);
+    explicit Epoller(int maxEvent = 4096);
 
     /**
      * @brief 析构函数，关闭epoll实例
@@ -61,6 +69,21 @@ public:
      */
     int Wait(int timeoutMs = -1);
 
+    /**
+     * @brief 等待事件发生，超时以微秒为单位
+     *
+     * 内核不支持epoll_pwait2（Linux 5.11之前）时退回epoll_wait，超时向上取整到毫秒。
+     *
+     * @param timeoutUs 超时时间（微秒），小于0表示无限等待
+     * @return int 发生的事件数量
+     */
+    int WaitUs(int64_t timeoutUs);
+
+    /**
+     * @brief 当前事件数组的大小
+     */
+    size_t EventCapacity() const { return events_.size(); }
+
     /**
      * @brief 获取事件的文件描述符
      * 
@@ -78,8 +101,15 @@ public:
     uint32_t GetEvents(size_t i) const;
         
 private:
+    /**
+     * @brief 这次等待取满了事件数组时把数组加倍
+     */
+    void Grow_(int eventCnt);
+
     int epollFd_; // epoll实例的文件描述符
+    size_t maxEvents_; // 事件数组的最大大小
     std::vector<struct epoll_event> events_; // 存储事件的数组    
+    static std::atomic<bool> hasPwait2_; // 内核是否支持epoll_pwait2，第一次返回ENOSYS后置为false
 };
 
 #endif //EPOLLER_H
\ No newline at end of file
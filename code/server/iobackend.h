@@ -0,0 +1,72 @@
+#ifndef IO_BACKEND_H
+#define IO_BACKEND_H
+
+#include <stdint.h>
+#include <netinet/in.h>
+
+#include "../http/httpconn.h"
+#include "../pool/cpuaffinity.h"
+
+/**
+ * @class IoBackend
+ * @brief 多Reactor模式下从Reactor的I/O后端接口。
+ *
+ * 每个后端在自己的线程中运行一个事件循环，负责它名下连接的accept、读写、超时和关闭，
+ * WebServer只通过这几个接口启动、停止和分发连接。默认的SubReactor基于Epoller + readv/sendmsg，
+ * UringReactor基于io_uring（内核不支持时WebServer回退到SubReactor）。
+ */
+class IoBackend : public ConnOwner {
+public:
+    virtual ~IoBackend() = default;
+
+    /**
+     * @brief 启动事件循环线程。
+     */
+    virtual void Start() = 0;
+
+    /**
+     * @brief 停止事件循环并等待线程退出。
+     */
+    virtual void Stop() = 0;
+
+    /**
+     * @brief 将一个已accept的连接交给该后端，可在任意线程调用。
+     * @param fd 客户端套接字文件描述符（已设置为非阻塞）。
+     * @param addr 客户端的地址信息。
+     */
+    virtual void AddConn(int fd, const sockaddr_in& addr) = 0;
+
+    /**
+     * @brief 让该后端自己监听一个（SO_REUSEPORT）套接字，需在Start()之前调用。
+     * @param listenFd 非阻塞的监听套接字，所有权交给本后端。
+     * @param listenEvent 监听套接字上的事件属性（ET/LT），不使用epoll的后端可以忽略。
+     * @param maxFd 允许的最大连接数，超过时直接拒绝新连接。
+     */
+    virtual void SetListenFd(int listenFd, uint32_t listenEvent, int maxFd) = 0;
+
+    /**
+     * @brief 修改连接超时和长连接空闲超时（配置重载），可在任意线程调用，由本后端的线程应用。
+     *        超时只能在启用的前提下修改，调用者保证两个值都大于0。
+     */
+    virtual void SetTimeouts(int timeoutMS, int keepAliveTimeoutMS) = 0;
+
+    /**
+     * @brief 停止accept并关闭自己的监听套接字（监听已交给新进程），可在任意线程调用；已有的连接照常处理。
+     */
+    virtual void StopAccept() = 0;
+
+    /**
+     * @brief 排空（服务器准备退出）：关闭空闲的长连接，之后本后端的连接一旦空闲也直接关闭。
+     *        可在任意线程调用，重复调用会再检查一遍空闲连接；调用前应设置HttpConn::draining。
+     */
+    virtual void Drain() = 0;
+
+    /**
+     * @brief 指定事件循环线程绑定的CPU，需在Start()之前调用；有自己的监听套接字时同时设置SO_INCOMING_CPU，
+     *        让内核把网卡队列中断落在该CPU上的连接交给本后端。
+     * @param cpu CPU编号，小于0表示不绑核。
+     */
+    virtual void SetCpu(int cpu) = 0;
+};
+
+#endif //IO_BACKEND_H
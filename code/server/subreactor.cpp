@@ -0,0 +1,503 @@
+#include "subreactor.h"
+
+using namespace std;
+
+/**
+ * @brief SubReactor类的构造函数
+ *
+ * @param id Reactor编号
+ * @param users 共享的连接表
+ * @param timeoutMS 连接超时时间（毫秒）
+ * @param connEvent 连接事件属性
+ * @param timeWheel 是否使用时间轮定时器
+ * @param keepAliveTimeoutMS 长连接空闲超时（毫秒）
+ */
+SubReactor::SubReactor(int id, ConnSlab* users, int timeoutMS, uint32_t connEvent,
+                       bool timeWheel, int keepAliveTimeoutMS):
+            id_(id), cpu_(-1), timeoutMS_(timeoutMS),
+            keepAliveTimeoutMS_(keepAliveTimeoutMS > 0 ? keepAliveTimeoutMS : timeoutMS),
+            connEvent_(connEvent),
+            rearm_((connEvent & EPOLLONESHOT) || !(connEvent & EPOLLET)), isClose_(false),
+            wakeupFd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+            listenFd_(-1), listenEvent_(0), maxFd_(0), acceptPaused_(false),
+            timer_(timeWheel ? static_cast<Timer*>(new TimeWheel()) : new HeapTimer()),
+            epoller_(new Epoller()), users_(users),
+            newTimeoutMS_(0), newKeepAliveTimeoutMS_(0), stopAccept_(false),
+            drain_(false), draining_(false) {
+    assert(users_ && wakeupFd_ >= 0);
+    // eventfd使用水平触发，保证积压的唤醒不会丢失
+    epoller_->AddFd(wakeupFd_, EPOLLIN);
+}
+
+/**
+ * @brief SubReactor类的析构函数
+ */
+SubReactor::~SubReactor() {
+    Stop();
+    close(wakeupFd_);
+    if(listenFd_ >= 0) { close(listenFd_); }
+    // 关闭尚未被接管的连接
+    for(auto& item : pending_) {
+        close(item.first);
+    }
+}
+
+/**
+ * @brief 启动事件循环线程
+ */
+void SubReactor::Start() {
+    assert(!thread_.joinable());
+    thread_ = thread(&SubReactor::Loop_, this);
+}
+
+/**
+ * @brief 停止事件循环并等待线程退出
+ */
+void SubReactor::Stop() {
+    isClose_ = true;
+    Wakeup_();
+    if(thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+/**
+ * @brief 将已accept的连接交给本Reactor
+ *
+ * 由主Reactor线程调用，只在锁内把连接放入待接管队列，真正的初始化在本Reactor线程中完成。
+ *
+ * @param fd 客户端套接字
+ * @param addr 客户端地址
+ */
+void SubReactor::AddConn(int fd, const sockaddr_in& addr) {
+    {
+        lock_guard<mutex> locker(mtx_);
+        pending_.emplace_back(fd, addr);
+    }
+    Wakeup_();
+}
+
+/**
+ * @brief 异步验证完成
+ *
+ * 由数据库线程调用，和AddConn一样只在锁内入队，真正的处理在本Reactor线程中完成。
+ *
+ * @param conn 客户端连接
+ * @param gen 投递时连接的代数
+ * @param ok 验证结果
+ */
+void SubReactor::ResumeConn(HttpConn* conn, uint32_t gen, bool ok) {
+    {
+        lock_guard<mutex> locker(mtx_);
+        resumed_.push_back(Resumed{conn, gen, ok});
+    }
+    Wakeup_();
+}
+
+/**
+ * @brief 修改超时，由本线程在唤醒时应用（之后续期的连接使用新的超时）
+ *
+ * @param timeoutMS 连接超时（毫秒）
+ * @param keepAliveTimeoutMS 长连接空闲超时（毫秒）
+ */
+void SubReactor::SetTimeouts(int timeoutMS, int keepAliveTimeoutMS) {
+    assert(timeoutMS > 0 && keepAliveTimeoutMS > 0);
+    {
+        lock_guard<mutex> locker(mtx_);
+        newTimeoutMS_ = timeoutMS;
+        newKeepAliveTimeoutMS_ = keepAliveTimeoutMS;
+    }
+    Wakeup_();
+}
+
+/**
+ * @brief 停止accept，由本线程在唤醒时关闭监听套接字
+ */
+void SubReactor::StopAccept() {
+    {
+        lock_guard<mutex> locker(mtx_);
+        stopAccept_ = true;
+    }
+    Wakeup_();
+}
+
+/**
+ * @brief 排空，由本线程在唤醒时关闭空闲连接
+ */
+void SubReactor::Drain() {
+    {
+        lock_guard<mutex> locker(mtx_);
+        drain_ = true;
+    }
+    Wakeup_();
+}
+
+/**
+ * @brief 设置本Reactor独占的监听套接字
+ *
+ * @param listenFd 监听套接字
+ * @param listenEvent 监听事件属性
+ * @param maxFd 最大连接数
+ */
+void SubReactor::SetListenFd(int listenFd, uint32_t listenEvent, int maxFd) {
+    assert(listenFd >= 0 && listenFd_ < 0 && !thread_.joinable());
+    listenFd_ = listenFd;
+    listenEvent_ = listenEvent;
+    maxFd_ = maxFd;
+    epoller_->AddFd(listenFd_, listenEvent_ | EPOLLIN);
+}
+
+/**
+ * @brief 向eventfd写入数据以唤醒epoll_wait
+ */
+void SubReactor::Wakeup_() {
+    uint64_t one = 1;
+    ssize_t n = ::write(wakeupFd_, &one, sizeof(one));
+    if(n != sizeof(one) && errno != EAGAIN) {
+        LOG_ERROR("SubReactor[%d] wakeup error!", id_);
+    }
+}
+
+/**
+ * @brief 处理唤醒事件，接管所有待处理的新连接
+ */
+void SubReactor::HandleWakeup_() {
+    uint64_t cnt = 0;
+    // 读空eventfd计数器
+    while(::read(wakeupFd_, &cnt, sizeof(cnt)) > 0) {}
+
+    // 交换出待接管队列，尽量缩短持锁时间
+    vector<pair<int, sockaddr_in>> conns;
+    vector<Resumed> resumed;
+    int timeoutMS, keepAliveTimeoutMS;
+    bool stopAccept, drain;
+    {
+        lock_guard<mutex> locker(mtx_);
+        conns.swap(pending_);
+        resumed.swap(resumed_);
+        timeoutMS = newTimeoutMS_;
+        keepAliveTimeoutMS = newKeepAliveTimeoutMS_;
+        stopAccept = stopAccept_;
+        drain = drain_;
+        newTimeoutMS_ = newKeepAliveTimeoutMS_ = 0;
+        stopAccept_ = drain_ = false;
+    }
+    if(timeoutMS > 0) {
+        timeoutMS_ = timeoutMS;
+        keepAliveTimeoutMS_ = keepAliveTimeoutMS;
+    }
+    if(stopAccept && listenFd_ >= 0) {
+        // 监听套接字已交给新进程，关闭自己的引用；全连接队列里的连接由新进程accept
+        if(!acceptPaused_) { epoller_->DelFd(listenFd_); }
+        close(listenFd_);
+        listenFd_ = -1;
+        acceptPaused_ = false;
+        LOG_INFO("SubReactor[%d] stop accept", id_);
+    }
+    for(auto& item : conns) {
+        AddClient_(item.first, item.second);
+    }
+    for(auto& item : resumed) {
+        // 等待期间连接已关闭或fd已被复用
+        if(item.conn->Generation() != item.gen) { continue; }
+        item.conn->OnVerifyDone(item.ok);
+        if(!rearm_) {
+            // ModFd会重新检查就绪状态，等待期间到达的数据会再产生一次EPOLLIN
+            epoller_->ModFd(item.conn->GetFd(), EPOLLIN | EPOLLOUT | connEvent_);
+        }
+        OnProcess_(item.conn);
+    }
+    if(drain) {
+        draining_ = true;
+        CloseIdle_();
+    }
+}
+
+/**
+ * @brief 事件循环
+ */
+void SubReactor::Loop_() {
+    int64_t timeUs = -1;
+    // 绑核后本线程分配的缓冲区都落在该核所在的NUMA节点上
+    if(CpuAffinity::Pin(cpu_) && listenFd_ >= 0) {
+        CpuAffinity::SetIncomingCpu(listenFd_, cpu_);
+    }
+    LOG_INFO("SubReactor[%d] start, cpu %d", id_, cpu_);
+    while(!isClose_) {
+        // 如果设置了超时时间，则先清理超时连接并获取下一次的超时等待时间
+        if(timeoutMS_ > 0) {
+            timeUs = timer_->GetNextTickUs();
+        }
+        // 暂停accept时连接可能在其他Reactor中关闭，定期醒来检查是否降到低水位
+        if(acceptPaused_) {
+            if(Admission::Instance()->BelowLowWater(HttpConn::userCount)) {
+                ResumeAccept_();
+            } else if(timeUs < 0 || timeUs > Admission::PAUSE_POLL_MS * 1000) {
+                timeUs = Admission::PAUSE_POLL_MS * 1000;
+            }
+        }
+        int eventCnt = epoller_->WaitUs(timeUs);
+        for(int i = 0; i < eventCnt; i++) {
+            int fd = epoller_->GetEventFd(i);
+            uint32_t events = epoller_->GetEvents(i);
+            if(fd == wakeupFd_) {
+                HandleWakeup_();
+            }
+            else if(fd == listenFd_) {
+                DealListen_();
+            }
+            else {
+                OnConnEvent_(fd, events);
+            }
+        }
+    }
+    LOG_INFO("SubReactor[%d] quit", id_);
+}
+
+/**
+ * @brief 处理连接上的事件
+ *
+ * @param fd 客户端套接字
+ * @param events 发生的事件
+ */
+void SubReactor::OnConnEvent_(int fd, uint32_t events) {
+    HttpConn* client = users_->Find(fd);
+    assert(client);
+    if(events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+        CloseConn_(client);
+    }
+    else if(!rearm_ && client->IsVerifyPending()) {
+        // 等待验证期间不读写，验证完成后重新注册一次，补上这期间错过的边沿
+    }
+    else if(events & EPOLLIN) {
+        // 不重新注册时EPOLLIN和EPOLLOUT可能一起到达，读完后的处理会接着把待发送的数据写出
+        ExtentTime_(client, timeoutMS_);
+        client->TraceEvent();
+        OnRead_(client);
+    }
+    else if(events & EPOLLOUT) {
+        // 边沿触发下套接字重新可写时也会通知，没有待发送的数据就忽略
+        if(!rearm_ && client->ToWriteBytes() == 0) { return; }
+        // 响应大多在这次写完，之后长连接进入空闲，按空闲超时续期
+        ExtentTime_(client, client->IsKeepAlive() ? keepAliveTimeoutMS_ : timeoutMS_);
+        OnWrite_(client);
+    } else {
+        LOG_ERROR("SubReactor[%d] unexpected event", id_);
+    }
+}
+
+/**
+ * @brief 处理本Reactor监听套接字上的事件
+ *
+ * ET模式下循环accept直到没有新连接为止。
+ */
+void SubReactor::DealListen_() {
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    do {
+        int fd = accept4(listenFd_, (struct sockaddr *)&addr, &len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if(fd <= 0) { return; }
+        else if(HttpConn::userCount >= maxFd_ || fd >= users_->Capacity()) {
+            SendError_(fd, Admission::Instance()->BusyResponse().c_str());
+            LOG_WARN("Clients is full!");
+            return;
+        }
+        AddClient_(fd, addr);
+        // 连接数达到高水位，剩下的连接留在全连接队列里（SO_REUSEPORT下内核仍会往这个队列分配）
+        if(Admission::Instance()->OverHighWater(HttpConn::userCount)) {
+            PauseAccept_();
+            return;
+        }
+    } while(listenEvent_ & EPOLLET);
+}
+
+/**
+ * @brief 暂停accept
+ */
+void SubReactor::PauseAccept_() {
+    if(acceptPaused_) { return; }
+    epoller_->DelFd(listenFd_);
+    acceptPaused_ = true;
+    LOG_WARN("SubReactor[%d] clients reach high watermark (%d), pause accept", id_, (int)HttpConn::userCount);
+}
+
+/**
+ * @brief 恢复accept
+ */
+void SubReactor::ResumeAccept_() {
+    if(!acceptPaused_) { return; }
+    epoller_->AddFd(listenFd_, listenEvent_ | EPOLLIN);
+    acceptPaused_ = false;
+    LOG_INFO("SubReactor[%d] clients below low watermark (%d), resume accept", id_, (int)HttpConn::userCount);
+}
+
+/**
+ * @brief 向客户端发送错误信息并关闭连接
+ *
+ * @param fd 客户端套接字
+ * @param info 错误信息
+ */
+void SubReactor::SendError_(int fd, const char* info) {
+    assert(fd > 0);
+    ssize_t ret = send(fd, info, strlen(info), 0);
+    if(ret < 0) {
+        LOG_WARN("send error to client[%d] error!", fd);
+    }
+    close(fd);
+}
+
+/**
+ * @brief 添加新客户端连接
+ *
+ * @param fd 客户端套接字
+ * @param addr 客户端地址
+ */
+void SubReactor::AddClient_(int fd, const sockaddr_in& addr) {
+    assert(fd > 0);
+    HttpConn* client = users_->Get(fd);
+    client->init(fd, addr, this);
+    if(timeoutMS_ > 0) {
+        timer_->add(fd, timeoutMS_, std::bind(&SubReactor::OnTimeout_, this, client, client->Generation()));
+    }
+    // 不重新注册时一次性注册读写事件
+    epoller_->AddFd(fd, EPOLLIN | connEvent_ | (rearm_ ? 0 : EPOLLOUT));
+    LOG_INFO("Client[%d] in SubReactor[%d]!", fd, id_);
+}
+
+/**
+ * @brief 关闭客户端连接
+ *
+ * @param client 客户端连接对象
+ */
+void SubReactor::CloseConn_(HttpConn* client) {
+    assert(client);
+    LOG_INFO("Client[%d] quit!", client->GetFd());
+    // 连接只在本线程中关闭，可以直接取消定时器，避免fd复用后被旧定时器误关
+    if(timeoutMS_ > 0) { timer_->cancel(client->GetFd()); }
+    epoller_->DelFd(client->GetFd());
+    client->Close();
+}
+
+/**
+ * @brief 排空时关闭空闲连接
+ *
+ * 遍历共享的连接表，只处理所属者是自己的连接（其他Reactor的连接关闭时所属者被清空，读到自己说明仍归本线程）。
+ * 处理到一半的请求和没发完的响应不受影响，它们的响应带Connection: close，发完后关闭。
+ */
+void SubReactor::CloseIdle_() {
+    int closed = 0;
+    for(int fd = 0; fd < users_->Capacity(); fd++) {
+        HttpConn* client = users_->Find(fd);
+        if(client && client->Owner() == this && client->IsIdle()) {
+            CloseConn_(client);
+            closed++;
+        }
+    }
+    if(closed > 0) { LOG_INFO("SubReactor[%d] drain: closed %d idle connections", id_, closed); }
+}
+
+/**
+ * @brief 超时回调
+ *
+ * @param client 客户端连接对象
+ * @param gen 添加定时器时连接的代数
+ */
+void SubReactor::OnTimeout_(HttpConn* client, uint32_t gen) {
+    if(client->Generation() != gen) { return; }
+    Metrics::Add(METRIC_TIMER_EXPIRED);
+    CloseConn_(client);
+}
+
+/**
+ * @brief 延长客户端连接的超时时间
+ *
+ * @param client 客户端连接对象
+ * @param timeoutMS 超时时间（毫秒）
+ */
+void SubReactor::ExtentTime_(HttpConn* client, int timeoutMS) {
+    assert(client);
+    if(timeoutMS_ > 0) { timer_->adjust(client->GetFd(), timeoutMS); }
+}
+
+/**
+ * @brief 处理读事件，读完直接在本线程处理请求
+ *
+ * @param client 客户端连接对象
+ */
+void SubReactor::OnRead_(HttpConn* client) {
+    assert(client);
+    int readErrno = 0;
+    ssize_t ret = client->read(&readErrno);
+    if(ret <= 0 && readErrno != EAGAIN) {
+        CloseConn_(client);
+        return;
+    }
+    OnProcess_(client);
+}
+
+/**
+ * @brief 处理请求数据，根据结果将fd置为EPOLLOUT或EPOLLIN
+ *
+ * @param client 客户端连接对象
+ */
+void SubReactor::OnProcess_(HttpConn* client) {
+    bool hasResponse = client->process();
+    // 等待异步验证时不注册事件，验证完成后由ResumeConn继续
+    if(client->IsVerifyPending()) {
+        return;
+    }
+    // 不重新注册时直接写，写到EAGAIN再等待EPOLLOUT；没有响应时等待下一次EPOLLIN
+    if(!rearm_) {
+        if(hasResponse) { OnWrite_(client); }
+        else if(draining_ && client->IsIdle()) { CloseConn_(client); }
+        return;
+    }
+    if(hasResponse) {
+        epoller_->ModFd(client->GetFd(), connEvent_ | EPOLLOUT);
+    } else if(draining_ && client->IsIdle()) {
+        CloseConn_(client);
+    } else {
+        epoller_->ModFd(client->GetFd(), connEvent_ | EPOLLIN);
+    }
+}
+
+/**
+ * @brief 处理写事件
+ *
+ * @param client 客户端连接对象
+ */
+void SubReactor::OnWrite_(HttpConn* client) {
+    assert(client);
+    while(true) {
+        int writeErrno = 0;
+        ssize_t ret = client->write(&writeErrno);
+        if(client->ToWriteBytes() == 0) {
+            /* 传输完成 */
+            if(client->IsKeepAlive()) {
+                if(rearm_) {
+                    // 继续处理读缓冲区中剩余的流水线请求，没有则重新监听读事件
+                    OnProcess_(client);
+                    return;
+                }
+                // 不重新注册时响应多在读事件中直接写完，在这里按空闲超时续期；
+                // 然后循环处理剩余的流水线请求，不递归，没有新响应（或等待验证）时结束
+                ExtentTime_(client, keepAliveTimeoutMS_);
+                if(client->process() && !client->IsVerifyPending()) {
+                    continue;
+                }
+                if(draining_ && client->IsIdle()) { CloseConn_(client); }
+                return;
+            }
+        }
+        // LT模式下一次只发送一部分（ret > 0），或者缓冲区满了（EAGAIN）
+        else if(ret > 0 || writeErrno == EAGAIN) {
+            /* 继续传输，不重新注册时已经监听着EPOLLOUT */
+            if(rearm_) {
+                epoller_->ModFd(client->GetFd(), connEvent_ | EPOLLOUT);
+            }
+            return;
+        }
+        CloseConn_(client);
+        return;
+    }
+}
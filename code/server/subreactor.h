@@ -0,0 +1,227 @@
+#ifndef SUB_REACTOR_H
+#define SUB_REACTOR_H
+
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <unistd.h>       // close()
+#include <assert.h>
+#include <errno.h>
+#include <string.h>       // strlen()
+#include <sys/eventfd.h>  // eventfd()
+#include <sys/socket.h>   // accept4()
+#include <netinet/in.h>
+
+#include "epoller.h"
+#include "../timer/heaptimer.h"
+#include "../timer/timewheel.h"
+#include "../log/log.h"
+#include "../http/httpconn.h"
+#include "connslab.h"
+#include "iobackend.h"
+#include "admission.h"
+
+/**
+ * @class SubReactor
+ * @brief 从Reactor（one loop per thread），基于epoll的默认I/O后端。
+ *
+ * 每个SubReactor在自己的线程中运行一个事件循环，独占一个Epoller和一个定时器；连接对象存放在
+ * 所有Reactor共享的ConnSlab中，每个fd同一时刻只属于一个Reactor，访问不需要加锁。
+ * 主Reactor accept到新连接后通过AddConn()交给某个SubReactor，此后该连接的读、处理、写和关闭
+ * 都在同一个线程内完成，不再经过线程池，也就没有跨线程的任务队列锁和唤醒。
+ *
+ * 连接只由本线程处理，EPOLLONESHOT没有意义：边沿触发（connEvent不带EPOLLONESHOT）时连接在加入时
+ * 一次性注册EPOLLIN|EPOLLOUT，处理完请求直接写，写到EAGAIN才等待EPOLLOUT，每个请求不再需要epoll_ctl重新注册。
+ */
+class SubReactor : public IoBackend {
+public:
+    /**
+     * @brief 构造函数，创建epoll实例、定时器和用于跨线程唤醒的eventfd。
+     * @param id 该Reactor的编号，仅用于日志。
+     * @param users 共享的连接表，生命周期必须长于本Reactor。
+     * @param timeoutMS 连接超时时间（毫秒），小于等于0表示不启用超时。
+     * @param connEvent 连接上需要监听的事件属性（ET/ONESHOT/RDHUP），ET且不带ONESHOT时不再重新注册事件。
+     * @param timeWheel 是否使用时间轮定时器（否则使用HeapTimer）。
+     * @param keepAliveTimeoutMS 长连接空闲超时（毫秒）。
+     */
+    SubReactor(int id, ConnSlab* users, int timeoutMS, uint32_t connEvent,
+               bool timeWheel = false, int keepAliveTimeoutMS = 0);
+
+    /**
+     * @brief 析构函数，停止事件循环并关闭尚未接管的连接。
+     */
+    ~SubReactor();
+
+    /**
+     * @brief 启动事件循环线程。
+     */
+    void Start() override;
+
+    /**
+     * @brief 停止事件循环并等待线程退出。
+     */
+    void Stop() override;
+
+    /**
+     * @brief 将一个已accept的连接交给该Reactor，可在任意线程调用。
+     * @param fd 客户端套接字文件描述符（已设置为非阻塞）。
+     * @param addr 客户端的地址信息。
+     */
+    void AddConn(int fd, const sockaddr_in& addr) override;
+
+    /**
+     * @brief 让该Reactor自己监听一个（SO_REUSEPORT）套接字，需在Start()之前调用。
+     *        之后新连接由本线程直接accept，不再经过主Reactor。
+     * @param listenFd 非阻塞的监听套接字，所有权交给本Reactor。
+     * @param listenEvent 监听套接字上的事件属性（ET/LT）。
+     * @param maxFd 允许的最大连接数，超过时直接拒绝新连接。
+     */
+    void SetListenFd(int listenFd, uint32_t listenEvent, int maxFd) override;
+
+    /**
+     * @brief 异步验证完成（数据库线程调用），唤醒本Reactor在自己的线程中继续处理该连接。
+     */
+    void ResumeConn(HttpConn* conn, uint32_t gen, bool ok) override;
+
+    /**
+     * @brief 修改超时，在下次唤醒时由本线程应用。
+     */
+    void SetTimeouts(int timeoutMS, int keepAliveTimeoutMS) override;
+
+    /**
+     * @brief 停止accept并关闭监听套接字，在下次唤醒时由本线程执行。
+     */
+    void StopAccept() override;
+
+    /**
+     * @brief 排空，在下次唤醒时由本线程关闭空闲的长连接。
+     */
+    void Drain() override;
+
+    /**
+     * @brief 指定事件循环线程绑定的CPU，在线程启动时生效。
+     */
+    void SetCpu(int cpu) override { cpu_ = cpu; }
+
+private:
+    /**
+     * @brief 事件循环，运行在该Reactor自己的线程中。
+     */
+    void Loop_();
+
+    /**
+     * @brief 处理eventfd唤醒，把待接管的连接加入本Reactor，继续处理验证完成的连接。
+     */
+    void HandleWakeup_();
+
+    /**
+     * @brief 唤醒事件循环。
+     */
+    void Wakeup_();
+
+    /**
+     * @brief 处理本Reactor监听套接字上的事件，accept新的客户端连接。
+     */
+    void DealListen_();
+
+    /**
+     * @brief 连接数达到高水位时把监听套接字移出epoll，暂停accept。
+     */
+    void PauseAccept_();
+
+    /**
+     * @brief 暂停期间连接数降到低水位以下时重新监听，恢复accept。
+     */
+    void ResumeAccept_();
+
+    /**
+     * @brief 向客户端发送错误信息并关闭连接。
+     */
+    void SendError_(int fd, const char* info);
+
+    /**
+     * @brief 将新客户端添加到本Reactor的连接表、定时器和epoll中。
+     */
+    void AddClient_(int fd, const sockaddr_in& addr);
+
+    /**
+     * @brief 关闭客户端连接。
+     */
+    void CloseConn_(HttpConn* client);
+
+    /**
+     * @brief 排空时关闭本Reactor所有空闲的长连接。
+     */
+    void CloseIdle_();
+
+    /**
+     * @brief 超时回调：连接仍是添加定时器时的那一个才关闭。
+     */
+    void OnTimeout_(HttpConn* client, uint32_t gen);
+
+    /**
+     * @brief 延长客户端连接的超时时间。
+     */
+    void ExtentTime_(HttpConn* client, int timeoutMS);
+
+    /**
+     * @brief 读取客户端数据并处理请求。
+     */
+    void OnRead_(HttpConn* client);
+
+    /**
+     * @brief 向客户端发送响应。
+     */
+    void OnWrite_(HttpConn* client);
+
+    /**
+     * @brief 处理请求并根据结果重新注册读/写事件（不重新注册时直接写）。
+     */
+    void OnProcess_(HttpConn* client);
+
+    /**
+     * @brief 处理连接上的事件。
+     */
+    void OnConnEvent_(int fd, uint32_t events);
+
+    int id_;                    // Reactor编号
+    int cpu_;                   // 事件循环线程绑定的CPU，-1表示不绑核
+    int timeoutMS_;             // 连接超时时间（毫秒）
+    int keepAliveTimeoutMS_;    // 长连接空闲超时时间（毫秒）
+    uint32_t connEvent_;        // 连接事件
+    bool rearm_;                // 每次读写后是否需要用ModFd重新注册（ONESHOT或LT模式）
+    std::atomic<bool> isClose_; // 事件循环是否退出
+    int wakeupFd_;              // 跨线程唤醒用的eventfd
+    int listenFd_;              // 本Reactor自己的监听套接字，-1表示由主Reactor分发连接
+    uint32_t listenEvent_;      // 监听事件
+    int maxFd_;                 // 允许的最大连接数
+    bool acceptPaused_;         // 是否因连接数达到高水位暂停了accept
+
+    std::unique_ptr<Timer> timer_;              // 本线程独占的定时器
+    std::unique_ptr<Epoller> epoller_;          // 本线程独占的epoll实例
+    ConnSlab* users_;                           // 共享的连接表（不拥有）
+
+    /**
+     * @brief 验证完成、等待本线程继续处理的连接
+     */
+    struct Resumed {
+        HttpConn* conn;
+        uint32_t gen;
+        bool ok;
+    };
+
+    std::mutex mtx_;                                    // 保护pending_和resumed_
+    std::vector<std::pair<int, sockaddr_in>> pending_;  // 等待本线程接管的新连接
+    std::vector<Resumed> resumed_;                      // 等待本线程继续处理的连接
+    // 其他线程的控制请求（配置重载、交接监听套接字、排空），在mtx_内设置，唤醒时由本线程应用
+    int newTimeoutMS_;                                  // 大于0时更新超时
+    int newKeepAliveTimeoutMS_;
+    bool stopAccept_;
+    bool drain_;                                        // 请求本线程检查并关闭空闲连接
+    bool draining_;                                     // 本线程：已进入排空，连接空闲时直接关闭
+    std::thread thread_;                                // 事件循环线程
+};
+
+#endif //SUB_REACTOR_H
@@ -0,0 +1,203 @@
+#include "uring.h"
+
+#if WEBSERVER_HAS_URING
+
+#include <string.h>
+#include <stdio.h>     // sscanf
+#include <sys/utsname.h>
+
+IoUring::IoUring() : ringFd_(-1), features_(0),
+                     sqRing_(MAP_FAILED), sqRingSize_(0), sqHead_(nullptr), sqTail_(nullptr),
+                     sqArray_(nullptr), sqMask_(0), sqEntries_(0), sqeTail_(0),
+                     sqes_(static_cast<struct io_uring_sqe*>(MAP_FAILED)), sqesSize_(0),
+                     cqRing_(MAP_FAILED), cqRingSize_(0), cqHead_(nullptr), cqTail_(nullptr),
+                     cqMask_(0), cqes_(nullptr),
+                     bufRing_(static_cast<struct io_uring_buf_ring*>(MAP_FAILED)), bufRingSize_(0),
+                     bufBase_(static_cast<char*>(MAP_FAILED)), bufBytes_(0), bufSize_(0), bufMask_(0),
+                     bufTail_(0), groupId_(0) {}
+
+IoUring::~IoUring() {
+    // 先关闭环（内核取消所有未完成的操作），再释放它们可能还在使用的缓冲区
+    if(ringFd_ >= 0) { close(ringFd_); }
+    if(sqes_ != MAP_FAILED) { munmap(sqes_, sqesSize_); }
+    if(cqRing_ != MAP_FAILED && cqRing_ != sqRing_) { munmap(cqRing_, cqRingSize_); }
+    if(sqRing_ != MAP_FAILED) { munmap(sqRing_, sqRingSize_); }
+    if(bufRing_ != MAP_FAILED) { munmap(bufRing_, bufRingSize_); }
+    if(bufBase_ != MAP_FAILED) { munmap(bufBase_, bufBytes_); }
+}
+
+bool IoUring::Supported() {
+    static const bool supported = [] {
+        // 多次recv要求Linux 6.0，无法通过IORING_REGISTER_PROBE探测，只能看版本
+        struct utsname name;
+        int major = 0, minor = 0;
+        if(uname(&name) != 0 || sscanf(name.release, "%d.%d", &major, &minor) != 2 || major < 6) {
+            return false;
+        }
+        IoUring ring;
+        return ring.Init(4, 8) && ring.SetupBuffers(0, 2, 64);
+    }();
+    return supported;
+}
+
+bool IoUring::Init(unsigned entries, unsigned cqEntries) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_SUBMIT_ALL | IORING_SETUP_COOP_TASKRUN;
+    params.cq_entries = cqEntries;
+    ringFd_ = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    if(ringFd_ < 0 && errno == EINVAL) {
+        // 较早的内核不认识后两个标志
+        memset(&params, 0, sizeof(params));
+        params.flags = IORING_SETUP_CQSIZE;
+        params.cq_entries = cqEntries;
+        ringFd_ = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    }
+    if(ringFd_ < 0) {
+        return false;
+    }
+    features_ = params.features;
+    // 不丢CQE、单次mmap和带超时的enter都是必需的
+    unsigned required = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG;
+    if((features_ & required) != required) {
+        errno = ENOSYS;
+        return false;
+    }
+
+    // SQ和CQ共用一次映射
+    sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if(cqRingSize_ > sqRingSize_) { sqRingSize_ = cqRingSize_; }
+    cqRingSize_ = sqRingSize_;
+    sqRing_ = mmap(nullptr, sqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                   ringFd_, IORING_OFF_SQ_RING);
+    if(sqRing_ == MAP_FAILED) {
+        return false;
+    }
+    cqRing_ = sqRing_;
+    sqesSize_ = params.sq_entries * sizeof(struct io_uring_sqe);
+    void* sqes = mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      ringFd_, IORING_OFF_SQES);
+    if(sqes == MAP_FAILED) {
+        return false;
+    }
+    sqes_ = static_cast<struct io_uring_sqe*>(sqes);
+
+    char* sq = static_cast<char*>(sqRing_);
+    sqHead_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sqTail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sqArray_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    sqMask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sqEntries_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_entries);
+    sqeTail_ = *sqTail_;
+    // SQE下标与SQ数组一一对应，之后不再修改数组
+    for(unsigned i = 0; i < sqEntries_; i++) {
+        sqArray_[i] = i;
+    }
+    char* cq = static_cast<char*>(cqRing_);
+    cqHead_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cqTail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cqMask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes);
+    return true;
+}
+
+bool IoUring::SetupBuffers(uint16_t groupId, unsigned count, unsigned size) {
+    if(ringFd_ < 0 || count == 0 || (count & (count - 1)) != 0 || count > 32768) {
+        errno = EINVAL;
+        return false;
+    }
+    bufRingSize_ = count * sizeof(struct io_uring_buf);
+    void* ring = mmap(nullptr, bufRingSize_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(ring == MAP_FAILED) {
+        return false;
+    }
+    bufRing_ = static_cast<struct io_uring_buf_ring*>(ring);
+    bufBytes_ = static_cast<size_t>(count) * size;
+    void* base = mmap(nullptr, bufBytes_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(base == MAP_FAILED) {
+        return false;
+    }
+    bufBase_ = static_cast<char*>(base);
+
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = reinterpret_cast<uint64_t>(bufRing_);
+    reg.ring_entries = count;
+    reg.bgid = groupId;
+    if(syscall(__NR_io_uring_register, ringFd_, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        return false;
+    }
+    groupId_ = groupId;
+    bufSize_ = size;
+    bufMask_ = count - 1;
+    bufTail_ = 0;
+    for(unsigned i = 0; i < count; i++) {
+        RecycleBuffer(static_cast<uint16_t>(i));
+    }
+    return true;
+}
+
+void IoUring::RecycleBuffer(uint16_t bid) {
+    // C++中头文件里__DECLARE_FLEX_ARRAY的空结构体占1字节，bufs会偏移8字节，按数组直接计算位置
+    struct io_uring_buf* buf = reinterpret_cast<struct io_uring_buf*>(bufRing_) + (bufTail_ & bufMask_);
+    buf->addr = reinterpret_cast<uint64_t>(Buffer(bid));
+    buf->len = bufSize_;
+    buf->bid = bid;
+    bufTail_++;
+    // 内核按tail读取，先写好缓冲区描述再发布
+    __atomic_store_n(&bufRing_->tail, bufTail_, __ATOMIC_RELEASE);
+}
+
+struct io_uring_sqe* IoUring::GetSqe() {
+    unsigned head = __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+    if(sqeTail_ - head >= sqEntries_) {
+        // SQ满了，先提交这一批
+        if(Submit() < 0) {
+            return nullptr;
+        }
+        head = __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+        if(sqeTail_ - head >= sqEntries_) {
+            return nullptr;
+        }
+    }
+    struct io_uring_sqe* sqe = &sqes_[sqeTail_ & sqMask_];
+    sqeTail_++;
+    memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+int IoUring::SubmitAndWait(int64_t timeoutUs) {
+    // 内核按head消费，上次因CQ溢出（EBUSY）没有提交的SQE这次一并提交
+    unsigned toSubmit = sqeTail_ - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+    // SQE的内容对内核可见后再发布tail
+    __atomic_store_n(sqTail_, sqeTail_, __ATOMIC_RELEASE);
+    unsigned flags = 0;
+    unsigned minComplete = 0;
+    struct io_uring_getevents_arg arg;
+    struct __kernel_timespec ts;
+    memset(&arg, 0, sizeof(arg));
+    if(timeoutUs != 0) {
+        flags = IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+        minComplete = 1;
+        if(timeoutUs > 0) {
+            ts.tv_sec = timeoutUs / 1000000;
+            ts.tv_nsec = (timeoutUs % 1000000) * 1000;
+            arg.ts = reinterpret_cast<uint64_t>(&ts);
+        }
+    } else if(toSubmit == 0) {
+        return 0;
+    }
+    int ret = static_cast<int>(syscall(__NR_io_uring_enter, ringFd_, toSubmit, minComplete, flags,
+                                       flags ? &arg : nullptr, flags ? sizeof(arg) : 0));
+    if(ret < 0) {
+        // 等待超时或被信号打断时SQE已经提交
+        if(errno == ETIME || errno == EINTR) {
+            return 0;
+        }
+        return -errno;
+    }
+    return ret;
+}
+
+#endif // WEBSERVER_HAS_URING
@@ -0,0 +1,157 @@
+#ifndef URING_H
+#define URING_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <errno.h>
+#include <unistd.h>       // close()
+#include <sys/mman.h>     // mmap, munmap
+#include <sys/syscall.h>
+#include <sys/uio.h>      // iovec
+#include <linux/io_uring.h>
+
+// 完整的io_uring后端需要多次accept、多次recv和provided buffer ring（Linux 6.0的头文件）
+#if defined(IORING_RECV_MULTISHOT) && defined(IORING_ACCEPT_MULTISHOT) && defined(__NR_io_uring_setup)
+#define WEBSERVER_HAS_URING 1
+#else
+#define WEBSERVER_HAS_URING 0
+#endif
+
+#if WEBSERVER_HAS_URING
+
+/**
+ * @class IoUring
+ * @brief 不依赖liburing的最小io_uring封装，只能在一个线程中使用。
+ *
+ * 负责创建环、映射SQ/CQ/SQE，按需取SQE并在每轮事件循环用一次io_uring_enter批量提交和等待；
+ * 另外管理一个provided buffer ring（IORING_REGISTER_PBUF_RING），多次recv由内核从中挑选缓冲区，
+ * 用户读走数据后调用RecycleBuffer()归还。不支持时（内核或头文件太旧）Init()返回false，由调用者回退到epoll。
+ */
+class IoUring {
+public:
+    IoUring();
+    ~IoUring();
+
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    /**
+     * @brief 进程运行的内核是否支持本封装用到的全部特性（多次accept/recv、buffer ring、带超时的enter）
+     *        第一次调用时创建一个临时的环探测，结果缓存
+     */
+    static bool Supported();
+
+    /**
+     * @brief 创建环
+     * @param entries SQ大小（向上取整为2的幂）
+     * @param cqEntries CQ大小，多次操作会持续产生CQE，通常取SQ的若干倍
+     * @return 失败时返回false，errno为失败原因
+     */
+    bool Init(unsigned entries, unsigned cqEntries);
+
+    /**
+     * @brief 注册provided buffer ring并放入全部缓冲区
+     * @param groupId 缓冲区组号（SQE的buf_group）
+     * @param count 缓冲区个数（2的幂，不超过32768）
+     * @param size 每个缓冲区的字节数
+     */
+    bool SetupBuffers(uint16_t groupId, unsigned count, unsigned size);
+
+    /**
+     * @brief 取一个空闲的SQE（已清零），SQ满时先把已有的SQE提交给内核
+     * @return SQ满且提交失败时返回nullptr
+     */
+    struct io_uring_sqe* GetSqe();
+
+    /**
+     * @brief 提交所有排队的SQE并等待至少一个CQE
+     * @param timeoutUs 等待超时（微秒），小于0表示无限等待，0表示只提交不等待
+     * @return 提交的SQE数，超时或被信号打断时返回0，出错时返回-errno
+     */
+    int SubmitAndWait(int64_t timeoutUs);
+
+    /**
+     * @brief 只提交，不等待
+     */
+    int Submit() { return SubmitAndWait(0); }
+
+    /**
+     * @brief 依次处理已完成的CQE，处理函数中可以继续取SQE
+     * @param func 对每个CQE调用func(const io_uring_cqe&)
+     * @return 处理的CQE数
+     */
+    template<typename F>
+    unsigned ForEachCqe(F&& func) {
+        unsigned count = 0;
+        unsigned head = *cqHead_;
+        while(head != __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE)) {
+            // 先拷贝出来再推进head，处理函数内产生的新CQE下一轮继续处理
+            struct io_uring_cqe cqe = cqes_[head & cqMask_];
+            head++;
+            __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+            func(cqe);
+            count++;
+        }
+        return count;
+    }
+
+    /**
+     * @brief provided buffer的地址
+     */
+    char* Buffer(uint16_t bid) const { return bufBase_ + static_cast<size_t>(bid) * bufSize_; }
+
+    /**
+     * @brief 把读完的缓冲区放回buffer ring
+     */
+    void RecycleBuffer(uint16_t bid);
+
+    unsigned BufferSize() const { return bufSize_; }
+
+private:
+    int ringFd_;
+    unsigned features_;
+
+    // SQ
+    void* sqRing_;
+    size_t sqRingSize_;
+    unsigned* sqHead_;
+    unsigned* sqTail_;
+    unsigned* sqArray_;
+    unsigned sqMask_;
+    unsigned sqEntries_;
+    unsigned sqeTail_;      // 本地已填写的SQE位置，提交时发布到sqTail_
+    struct io_uring_sqe* sqes_;
+    size_t sqesSize_;
+
+    // CQ
+    void* cqRing_;
+    size_t cqRingSize_;
+    unsigned* cqHead_;
+    unsigned* cqTail_;
+    unsigned cqMask_;
+    struct io_uring_cqe* cqes_;
+
+    // provided buffer ring
+    struct io_uring_buf_ring* bufRing_;
+    size_t bufRingSize_;
+    char* bufBase_;
+    size_t bufBytes_;
+    unsigned bufSize_;
+    unsigned bufMask_;
+    uint16_t bufTail_;
+    uint16_t groupId_;
+};
+
+#else
+
+/**
+ * @brief 头文件不支持时的占位，Supported()总是返回false
+ */
+class IoUring {
+public:
+    static bool Supported() { return false; }
+};
+
+#endif // WEBSERVER_HAS_URING
+
+#endif //URING_H
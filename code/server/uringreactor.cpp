@@ -0,0 +1,663 @@
+#include "uringreactor.h"
+
+using namespace std;
+
+#if WEBSERVER_HAS_URING
+
+IoBackend* NewUringReactor(int id, ConnSlab* users, int timeoutMS, bool timeWheel, int keepAliveTimeoutMS) {
+    if(!IoUring::Supported()) {
+        return nullptr;
+    }
+    unique_ptr<UringReactor> reactor(new UringReactor(id, users, timeoutMS, timeWheel, keepAliveTimeoutMS));
+    if(!reactor->Init()) {
+        LOG_ERROR("UringReactor[%d] init error: %d", id, errno);
+        return nullptr;
+    }
+    return reactor.release();
+}
+
+/**
+ * @brief UringReactor类的构造函数
+ *
+ * @param id Reactor编号
+ * @param users 共享的连接表
+ * @param timeoutMS 连接超时时间（毫秒）
+ * @param timeWheel 是否使用时间轮定时器
+ * @param keepAliveTimeoutMS 长连接空闲超时（毫秒）
+ */
+UringReactor::UringReactor(int id, ConnSlab* users, int timeoutMS, bool timeWheel, int keepAliveTimeoutMS):
+            id_(id), cpu_(-1), timeoutMS_(timeoutMS),
+            keepAliveTimeoutMS_(keepAliveTimeoutMS > 0 ? keepAliveTimeoutMS : timeoutMS),
+            isClose_(false), wakeupFd_(eventfd(0, EFD_CLOEXEC)), wakeupBuf_(0),
+            listenFd_(-1), maxFd_(0), acceptArmed_(false), acceptPaused_(false), acceptStopped_(false),
+            timer_(timeWheel ? static_cast<Timer*>(new TimeWheel()) : new HeapTimer()),
+            users_(users), newTimeoutMS_(0), newKeepAliveTimeoutMS_(0), stopAccept_(false),
+            drain_(false), draining_(false) {
+    // eventfd保持阻塞模式：io_uring对O_NONBLOCK的文件会直接返回EAGAIN，而不是等待可读
+    assert(users_ && wakeupFd_ >= 0);
+}
+
+/**
+ * @brief UringReactor类的析构函数
+ */
+UringReactor::~UringReactor() {
+    Stop();
+    close(wakeupFd_);
+    if(listenFd_ >= 0) { close(listenFd_); }
+    // 关闭尚未被接管的连接
+    for(auto& item : pending_) {
+        close(item.first);
+    }
+}
+
+/**
+ * @brief 创建环并注册provided buffer ring
+ */
+bool UringReactor::Init() {
+    return ring_.Init(RING_ENTRIES, CQ_ENTRIES) && ring_.SetupBuffers(BUF_GROUP, BUF_COUNT, BUF_SIZE);
+}
+
+/**
+ * @brief 启动事件循环线程
+ */
+void UringReactor::Start() {
+    assert(!thread_.joinable());
+    thread_ = thread(&UringReactor::Loop_, this);
+}
+
+/**
+ * @brief 停止事件循环并等待线程退出
+ */
+void UringReactor::Stop() {
+    isClose_ = true;
+    Wakeup_();
+    if(thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+/**
+ * @brief 将已accept的连接交给本Reactor，在锁内入队，由本线程接管
+ *
+ * @param fd 客户端套接字
+ * @param addr 客户端地址
+ */
+void UringReactor::AddConn(int fd, const sockaddr_in& addr) {
+    {
+        lock_guard<mutex> locker(mtx_);
+        pending_.emplace_back(fd, addr);
+    }
+    Wakeup_();
+}
+
+/**
+ * @brief 异步验证完成，在锁内入队，由本线程继续处理
+ *
+ * @param conn 客户端连接
+ * @param gen 投递时连接的代数
+ * @param ok 验证结果
+ */
+void UringReactor::ResumeConn(HttpConn* conn, uint32_t gen, bool ok) {
+    {
+        lock_guard<mutex> locker(mtx_);
+        resumed_.push_back(Resumed{conn, gen, ok});
+    }
+    Wakeup_();
+}
+
+/**
+ * @brief 修改超时，由本线程在唤醒时应用（之后续期的连接使用新的超时）
+ *
+ * @param timeoutMS 连接超时（毫秒）
+ * @param keepAliveTimeoutMS 长连接空闲超时（毫秒）
+ */
+void UringReactor::SetTimeouts(int timeoutMS, int keepAliveTimeoutMS) {
+    assert(timeoutMS > 0 && keepAliveTimeoutMS > 0);
+    {
+        lock_guard<mutex> locker(mtx_);
+        newTimeoutMS_ = timeoutMS;
+        newKeepAliveTimeoutMS_ = keepAliveTimeoutMS;
+    }
+    Wakeup_();
+}
+
+/**
+ * @brief 停止accept，由本线程在唤醒时关闭监听套接字
+ */
+void UringReactor::StopAccept() {
+    {
+        lock_guard<mutex> locker(mtx_);
+        stopAccept_ = true;
+    }
+    Wakeup_();
+}
+
+/**
+ * @brief 排空，由本线程在唤醒时关闭空闲连接
+ */
+void UringReactor::Drain() {
+    {
+        lock_guard<mutex> locker(mtx_);
+        drain_ = true;
+    }
+    Wakeup_();
+}
+
+/**
+ * @brief 设置本Reactor独占的监听套接字，多次accept在事件循环开始时提交
+ *
+ * @param listenFd 监听套接字
+ * @param listenEvent 监听事件属性（不使用）
+ * @param maxFd 最大连接数
+ */
+void UringReactor::SetListenFd(int listenFd, uint32_t listenEvent, int maxFd) {
+    assert(listenFd >= 0 && listenFd_ < 0 && !thread_.joinable());
+    (void)listenEvent;
+    listenFd_ = listenFd;
+    maxFd_ = maxFd;
+}
+
+/**
+ * @brief 向eventfd写入数据，完成在途的IORING_OP_READ
+ */
+void UringReactor::Wakeup_() {
+    uint64_t one = 1;
+    ssize_t n = ::write(wakeupFd_, &one, sizeof(one));
+    if(n != sizeof(one)) {
+        LOG_ERROR("UringReactor[%d] wakeup error!", id_);
+    }
+}
+
+/**
+ * @brief 事件循环
+ *
+ * 上一轮处理CQE时产生的SQE（新的recv、send、cancel）和这次的等待在同一次io_uring_enter中完成。
+ */
+void UringReactor::Loop_() {
+    int64_t timeUs = -1;
+    if(CpuAffinity::Pin(cpu_) && listenFd_ >= 0) {
+        CpuAffinity::SetIncomingCpu(listenFd_, cpu_);
+    }
+    LOG_INFO("UringReactor[%d] start, cpu %d", id_, cpu_);
+    ArmWakeup_();
+    if(listenFd_ >= 0) { ArmAccept_(); }
+    while(!isClose_) {
+        // 清理超时连接并获取下一次的超时等待时间
+        if(timeoutMS_ > 0) {
+            timeUs = timer_->GetNextTickUs();
+        }
+        // 暂停accept时连接可能在其他Reactor中关闭，定期醒来检查是否降到低水位
+        if(acceptPaused_ && !acceptStopped_) {
+            if(Admission::Instance()->BelowLowWater(HttpConn::userCount)) {
+                acceptPaused_ = false;
+                // 取消还没有完成时由最后一个accept CQE重新提交
+                if(!acceptArmed_) { ArmAccept_(); }
+                LOG_INFO("UringReactor[%d] clients below low watermark (%d), resume accept",
+                         id_, (int)HttpConn::userCount);
+            } else if(timeUs < 0 || timeUs > Admission::PAUSE_POLL_MS * 1000) {
+                timeUs = Admission::PAUSE_POLL_MS * 1000;
+            }
+        }
+        int ret = ring_.SubmitAndWait(timeUs);
+        // EBUSY：CQ溢出，先处理完成事件，没提交的SQE下一轮再提交
+        if(ret < 0 && ret != -EBUSY && ret != -EAGAIN) {
+            LOG_ERROR("UringReactor[%d] io_uring_enter error: %d", id_, -ret);
+        }
+        ring_.ForEachCqe([this](const struct io_uring_cqe& cqe) { OnCqe_(cqe); });
+    }
+    LOG_INFO("UringReactor[%d] quit", id_);
+}
+
+/**
+ * @brief 按user_data中的操作码分发一个完成事件
+ */
+void UringReactor::OnCqe_(const struct io_uring_cqe& cqe) {
+    int op = static_cast<int>(cqe.user_data >> 56);
+    int fd = static_cast<int>(cqe.user_data & 0xffffffff);
+    uint32_t gen = static_cast<uint32_t>(cqe.user_data >> 32) & GEN_MASK;
+    switch(op) {
+    case OP_WAKEUP:
+        HandleWakeup_();
+        if(!isClose_) { ArmWakeup_(); }
+        break;
+    case OP_ACCEPT:
+        OnAccept_(cqe);
+        break;
+    case OP_RECV:
+        OnRecv_(fd, gen, cqe);
+        break;
+    case OP_SEND:
+        OnSend_(fd, gen, cqe.res);
+        break;
+    case OP_CANCEL:
+        // 要取消的操作已经完成时返回ENOENT，不需要处理
+        break;
+    default:
+        LOG_ERROR("UringReactor[%d] unexpected cqe", id_);
+        break;
+    }
+}
+
+/**
+ * @brief 取一个SQE并填好user_data
+ */
+struct io_uring_sqe* UringReactor::Sqe_(int op, int fd, uint32_t gen) {
+    struct io_uring_sqe* sqe = ring_.GetSqe();
+    if(!sqe) {
+        LOG_ERROR("UringReactor[%d] submission queue error!", id_);
+        return nullptr;
+    }
+    sqe->user_data = Pack_(op, fd, gen);
+    return sqe;
+}
+
+/**
+ * @brief 提交读取eventfd的操作，每次唤醒后重新提交
+ */
+void UringReactor::ArmWakeup_() {
+    struct io_uring_sqe* sqe = Sqe_(OP_WAKEUP, wakeupFd_, 0);
+    if(!sqe) { return; }
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = wakeupFd_;
+    sqe->addr = reinterpret_cast<uint64_t>(&wakeupBuf_);
+    sqe->len = sizeof(wakeupBuf_);
+}
+
+/**
+ * @brief 在监听套接字上提交多次accept
+ */
+void UringReactor::ArmAccept_() {
+    struct io_uring_sqe* sqe = Sqe_(OP_ACCEPT, listenFd_, 0);
+    if(!sqe) { return; }
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = listenFd_;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+    acceptArmed_ = true;
+}
+
+/**
+ * @brief 取消多次accept，之后新连接留在全连接队列里，直到降到低水位重新提交
+ */
+void UringReactor::PauseAccept_() {
+    if(acceptPaused_) { return; }
+    struct io_uring_sqe* sqe = Sqe_(OP_CANCEL, listenFd_, 0);
+    if(!sqe) { return; }
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->addr = Pack_(OP_ACCEPT, listenFd_, 0);
+    acceptPaused_ = true;
+    LOG_WARN("UringReactor[%d] clients reach high watermark (%d), pause accept", id_, (int)HttpConn::userCount);
+}
+
+/**
+ * @brief 关闭已停止accept的监听套接字
+ */
+void UringReactor::CloseListen_() {
+    if(listenFd_ < 0) { return; }
+    close(listenFd_);
+    listenFd_ = -1;
+}
+
+/**
+ * @brief 在连接上提交多次recv，数据写入内核挑选的provided buffer
+ */
+bool UringReactor::ArmRecv_(HttpConn* client) {
+    int fd = client->GetFd();
+    struct io_uring_sqe* sqe = Sqe_(OP_RECV, fd, client->Generation());
+    if(!sqe) { return false; }
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = fd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = BUF_GROUP;
+    states_[fd]->recvArmed = true;
+    return true;
+}
+
+/**
+ * @brief 处理accept完成事件
+ *
+ * 多次accept每个新连接产生一个CQE，没有IORING_CQE_F_MORE时说明已经终止，需要重新提交。
+ */
+void UringReactor::OnAccept_(const struct io_uring_cqe& cqe) {
+    if(!(cqe.flags & IORING_CQE_F_MORE)) {
+        acceptArmed_ = false;
+        if(!isClose_ && !acceptPaused_) { ArmAccept_(); }
+        if(acceptStopped_) { CloseListen_(); }
+    }
+    int fd = cqe.res;
+    if(fd < 0) {
+        // 暂停accept时的取消不是错误
+        if(fd != -ECANCELED) { LOG_WARN("UringReactor[%d] accept error: %d", id_, -fd); }
+        return;
+    }
+    if(HttpConn::userCount >= maxFd_ || fd >= users_->Capacity()) {
+        SendError_(fd, Admission::Instance()->BusyResponse().c_str());
+        LOG_WARN("Clients is full!");
+        return;
+    }
+    struct sockaddr_in addr = {};
+    socklen_t len = sizeof(addr);
+    getpeername(fd, (struct sockaddr *)&addr, &len);
+    AddClient_(fd, addr);
+    // 连接数达到高水位，取消之前已经完成的accept照常接管
+    if(Admission::Instance()->OverHighWater(HttpConn::userCount)) {
+        PauseAccept_();
+    }
+}
+
+/**
+ * @brief 处理recv完成事件
+ *
+ * 数据从provided buffer拷贝到读缓冲区后立即归还缓冲区。发送在途或等待验证时只追加数据，
+ * 发送完成（或验证完成）后再处理。
+ *
+ * @param fd 客户端套接字
+ * @param gen 提交时连接的代数
+ * @param cqe 完成事件
+ */
+void UringReactor::OnRecv_(int fd, uint32_t gen, const struct io_uring_cqe& cqe) {
+    HttpConn* client = users_->Find(fd);
+    ConnState* st = State_(fd);
+    // 已关闭（或fd已被新连接复用）的连接上被取消的recv仍可能带着缓冲区
+    bool current = client && st && Match_(client, gen) && !st->closing;
+    if(cqe.flags & IORING_CQE_F_BUFFER) {
+        uint16_t bid = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+        if(current && cqe.res > 0) {
+            client->TraceEvent();
+            client->AppendInput(ring_.Buffer(bid), cqe.res);
+        }
+        ring_.RecycleBuffer(bid);
+    }
+    if(!current) { return; }
+    if(!(cqe.flags & IORING_CQE_F_MORE)) {
+        st->recvArmed = false;
+    }
+    if(cqe.res == -ENOBUFS) {
+        // 缓冲区暂时用完，多次recv已终止，刚才归还了缓冲区，重新提交即可
+        if(!ArmRecv_(client)) { CloseConn_(client); }
+        return;
+    }
+    if(cqe.res <= 0) {
+        CloseConn_(client);
+        return;
+    }
+    if(!st->recvArmed && !ArmRecv_(client)) {
+        CloseConn_(client);
+        return;
+    }
+    ExtentTime_(client, timeoutMS_);
+    if(!st->sending && !client->IsVerifyPending()) {
+        Process_(client);
+    }
+}
+
+/**
+ * @brief 处理SENDMSG完成事件
+ *
+ * @param fd 客户端套接字
+ * @param gen 提交时连接的代数
+ * @param res 发送的字节数或-errno
+ */
+void UringReactor::OnSend_(int fd, uint32_t gen, int res) {
+    HttpConn* client = users_->Find(fd);
+    ConnState* st = State_(fd);
+    if(!client || !st || !Match_(client, gen)) { return; }
+    st->sending = false;
+    if(st->closing) {
+        // 内核不再引用写缓冲区，可以真正关闭了
+        st->closing = false;
+        client->Close();
+        return;
+    }
+    if(res == -EAGAIN || res == -EINTR) {
+        Send_(client);
+        return;
+    }
+    if(res <= 0) {
+        CloseConn_(client);
+        return;
+    }
+    client->Consume(res);
+    if(client->ToWriteBytes() > 0) {
+        // 发送了一部分，接着发送剩下的
+        Send_(client);
+        return;
+    }
+    if(!client->IsKeepAlive()) {
+        CloseConn_(client);
+        return;
+    }
+    // 响应发完后长连接进入空闲，按空闲超时续期，再处理发送期间收到的流水线请求
+    ExtentTime_(client, keepAliveTimeoutMS_);
+    Process_(client);
+}
+
+/**
+ * @brief 用一个SENDMSG聚合发送写队列头部的响应头和文件内容
+ *
+ * @param client 客户端连接对象
+ */
+void UringReactor::Send_(HttpConn* client) {
+    int fd = client->GetFd();
+    ConnState* st = states_[fd].get();
+    bool more = false;
+    int cnt = client->GatherIov(st->iov, HttpConn::MAX_IOV, &more);
+    // io_uring模式下文件总是mmap，写队列中没有sendfile段
+    assert(cnt > 0 && !more);
+    struct io_uring_sqe* sqe = Sqe_(OP_SEND, fd, client->Generation());
+    if(!sqe) {
+        CloseConn_(client);
+        return;
+    }
+    memset(&st->msg, 0, sizeof(st->msg));
+    st->msg.msg_iov = st->iov;
+    st->msg.msg_iovlen = cnt;
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(&st->msg);
+    sqe->len = 1;
+    sqe->msg_flags = MSG_NOSIGNAL;
+    st->sending = true;
+}
+
+/**
+ * @brief 处理读缓冲区中的请求，有响应时发送
+ *
+ * @param client 客户端连接对象
+ */
+void UringReactor::Process_(HttpConn* client) {
+    // 等待异步验证时不发送，验证完成后由ResumeConn继续
+    if(client->process() && !client->IsVerifyPending()) {
+        Send_(client);
+    } else if(draining_ && client->IsIdle()) {
+        CloseConn_(client);
+    }
+}
+
+/**
+ * @brief 处理唤醒事件，接管新连接，继续处理验证完成的连接
+ */
+void UringReactor::HandleWakeup_() {
+    vector<pair<int, sockaddr_in>> conns;
+    vector<Resumed> resumed;
+    int timeoutMS, keepAliveTimeoutMS;
+    bool stopAccept, drain;
+    {
+        lock_guard<mutex> locker(mtx_);
+        conns.swap(pending_);
+        resumed.swap(resumed_);
+        timeoutMS = newTimeoutMS_;
+        keepAliveTimeoutMS = newKeepAliveTimeoutMS_;
+        stopAccept = stopAccept_;
+        drain = drain_;
+        newTimeoutMS_ = newKeepAliveTimeoutMS_ = 0;
+        stopAccept_ = drain_ = false;
+    }
+    if(timeoutMS > 0) {
+        timeoutMS_ = timeoutMS;
+        keepAliveTimeoutMS_ = keepAliveTimeoutMS;
+    }
+    if(stopAccept && listenFd_ >= 0 && !acceptStopped_) {
+        // 监听套接字已交给新进程：取消多次accept，最后一个accept CQE到达后关闭自己的引用
+        acceptStopped_ = true;
+        if(acceptArmed_ && !acceptPaused_) {
+            struct io_uring_sqe* sqe = Sqe_(OP_CANCEL, listenFd_, 0);
+            if(sqe) {
+                sqe->opcode = IORING_OP_ASYNC_CANCEL;
+                sqe->addr = Pack_(OP_ACCEPT, listenFd_, 0);
+            }
+        }
+        acceptPaused_ = true;
+        if(!acceptArmed_) { CloseListen_(); }
+        LOG_INFO("UringReactor[%d] stop accept", id_);
+    }
+    for(auto& item : conns) {
+        AddClient_(item.first, item.second);
+    }
+    for(auto& item : resumed) {
+        // 等待期间连接已关闭或fd已被复用
+        if(item.conn->Generation() != item.gen) { continue; }
+        ConnState* st = State_(item.conn->GetFd());
+        if(!st || st->closing) { continue; }
+        item.conn->OnVerifyDone(item.ok);
+        // 投递验证时写队列为空，不会有发送在途
+        assert(!st->sending);
+        Process_(item.conn);
+    }
+    if(drain) {
+        draining_ = true;
+        CloseIdle_();
+    }
+}
+
+/**
+ * @brief 向客户端发送错误信息并关闭连接
+ *
+ * @param fd 客户端套接字
+ * @param info 错误信息
+ */
+void UringReactor::SendError_(int fd, const char* info) {
+    assert(fd > 0);
+    ssize_t ret = send(fd, info, strlen(info), MSG_NOSIGNAL);
+    if(ret < 0) {
+        LOG_WARN("send error to client[%d] error!", fd);
+    }
+    close(fd);
+}
+
+/**
+ * @brief 添加新客户端连接并提交多次recv
+ *
+ * @param fd 客户端套接字
+ * @param addr 客户端地址
+ */
+void UringReactor::AddClient_(int fd, const sockaddr_in& addr) {
+    assert(fd > 0);
+    HttpConn* client = users_->Get(fd);
+    client->init(fd, addr, this);
+    if(static_cast<size_t>(fd) >= states_.size()) {
+        states_.resize(fd + 1);
+    }
+    if(!states_[fd]) {
+        states_[fd].reset(new ConnState());
+    }
+    ConnState* st = states_[fd].get();
+    st->recvArmed = false;
+    st->sending = false;
+    st->closing = false;
+    if(timeoutMS_ > 0) {
+        timer_->add(fd, timeoutMS_, std::bind(&UringReactor::OnTimeout_, this, client, client->Generation()));
+    }
+    if(!ArmRecv_(client)) {
+        CloseConn_(client);
+        return;
+    }
+    LOG_INFO("Client[%d] in UringReactor[%d]!", fd, id_);
+}
+
+/**
+ * @brief 关闭客户端连接
+ *
+ * 按user_data取消在途的recv（fd关闭后内核仍持有套接字，直到操作结束）；有发送在途时同样取消，
+ * 等SENDMSG的完成事件到达、内核不再引用写缓冲区后再关闭。
+ *
+ * @param client 客户端连接对象
+ */
+void UringReactor::CloseConn_(HttpConn* client) {
+    assert(client);
+    int fd = client->GetFd();
+    ConnState* st = State_(fd);
+    if(st && st->closing) { return; }
+    LOG_INFO("Client[%d] quit!", fd);
+    if(timeoutMS_ > 0) { timer_->cancel(fd); }
+    uint32_t gen = client->Generation();
+    if(st && st->recvArmed) {
+        struct io_uring_sqe* sqe = Sqe_(OP_CANCEL, fd, gen);
+        if(sqe) {
+            sqe->opcode = IORING_OP_ASYNC_CANCEL;
+            sqe->addr = Pack_(OP_RECV, fd, gen);
+        }
+        st->recvArmed = false;
+    }
+    if(st && st->sending) {
+        struct io_uring_sqe* sqe = Sqe_(OP_CANCEL, fd, gen);
+        if(sqe) {
+            sqe->opcode = IORING_OP_ASYNC_CANCEL;
+            sqe->addr = Pack_(OP_SEND, fd, gen);
+        }
+        st->closing = true;
+        return;
+    }
+    client->Close();
+}
+
+/**
+ * @brief 排空时关闭空闲连接
+ *
+ * 只处理所属者是自己、没有发送在途也没有在关闭的连接，处理到一半的请求发完响应（带Connection: close）后关闭。
+ */
+void UringReactor::CloseIdle_() {
+    int closed = 0;
+    for(size_t fd = 0; fd < states_.size(); fd++) {
+        ConnState* st = states_[fd].get();
+        HttpConn* client = users_->Find(static_cast<int>(fd));
+        if(!st || !client || st->sending || st->closing) { continue; }
+        if(client->Owner() == this && client->IsIdle()) {
+            CloseConn_(client);
+            closed++;
+        }
+    }
+    if(closed > 0) { LOG_INFO("UringReactor[%d] drain: closed %d idle connections", id_, closed); }
+}
+
+/**
+ * @brief 超时回调
+ *
+ * @param client 客户端连接对象
+ * @param gen 添加定时器时连接的代数
+ */
+void UringReactor::OnTimeout_(HttpConn* client, uint32_t gen) {
+    if(client->Generation() != gen) { return; }
+    Metrics::Add(METRIC_TIMER_EXPIRED);
+    CloseConn_(client);
+}
+
+/**
+ * @brief 延长客户端连接的超时时间
+ *
+ * @param client 客户端连接对象
+ * @param timeoutMS 超时时间（毫秒）
+ */
+void UringReactor::ExtentTime_(HttpConn* client, int timeoutMS) {
+    assert(client);
+    if(timeoutMS_ > 0) { timer_->adjust(client->GetFd(), timeoutMS); }
+}
+
+#else
+
+IoBackend* NewUringReactor(int, ConnSlab*, int, bool, int) {
+    return nullptr;
+}
+
+#endif // WEBSERVER_HAS_URING
@@ -0,0 +1,235 @@
+#ifndef URING_REACTOR_H
+#define URING_REACTOR_H
+
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <unistd.h>       // close()
+#include <assert.h>
+#include <errno.h>
+#include <string.h>       // strlen()
+#include <sys/eventfd.h>  // eventfd()
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+#include "iobackend.h"
+#include "uring.h"
+#include "connslab.h"
+#include "admission.h"
+#include "../timer/heaptimer.h"
+#include "../timer/timewheel.h"
+#include "../log/log.h"
+#include "../http/httpconn.h"
+
+/**
+ * @brief 创建基于io_uring的从Reactor。
+ * @param id 该Reactor的编号，仅用于日志。
+ * @param users 共享的连接表，生命周期必须长于本Reactor。
+ * @param timeoutMS 连接超时时间（毫秒），小于等于0表示不启用超时。
+ * @param timeWheel 是否使用时间轮定时器（否则使用HeapTimer）。
+ * @param keepAliveTimeoutMS 长连接空闲超时（毫秒）。
+ * @return 编译环境或内核不支持io_uring时返回nullptr，调用者回退到SubReactor。
+ */
+IoBackend* NewUringReactor(int id, ConnSlab* users, int timeoutMS,
+                           bool timeWheel = false, int keepAliveTimeoutMS = 0);
+
+#if WEBSERVER_HAS_URING
+
+/**
+ * @class UringReactor
+ * @brief 基于io_uring的从Reactor，与SubReactor一样one loop per thread，可以互相替换。
+ *
+ * 监听套接字上挂一个多次accept，每个连接挂一个带IOSQE_BUFFER_SELECT的多次recv：内核从本Reactor的
+ * provided buffer ring中挑选缓冲区，数据追加到读缓冲区后立即归还，空闲连接不占接收缓冲区，
+ * 不需要每次读都重新提交。响应用一个SENDMSG把写队列头部的响应头和mmap的文件内容聚合发出（MSG_NOSIGNAL），
+ * 每个连接同一时刻最多一个发送在途：写缓冲区在发送完成之前不能扩容搬移，所以发送期间收到的流水线请求
+ * 只追加到读缓冲区，发送完成后再处理。一轮循环中产生的所有SQE在下一次io_uring_enter时一起提交，
+ * 这次enter同时等待完成事件，超时取定时器的下一次到期时间。
+ */
+class UringReactor : public IoBackend {
+public:
+    /**
+     * @brief 构造函数，创建定时器和用于跨线程唤醒的eventfd，环在Init()中创建。
+     * @param id 该Reactor的编号，仅用于日志。
+     * @param users 共享的连接表，生命周期必须长于本Reactor。
+     * @param timeoutMS 连接超时时间（毫秒），小于等于0表示不启用超时。
+     * @param timeWheel 是否使用时间轮定时器（否则使用HeapTimer）。
+     * @param keepAliveTimeoutMS 长连接空闲超时（毫秒）。
+     */
+    UringReactor(int id, ConnSlab* users, int timeoutMS, bool timeWheel = false, int keepAliveTimeoutMS = 0);
+
+    /**
+     * @brief 析构函数，停止事件循环并关闭尚未接管的连接。
+     */
+    ~UringReactor();
+
+    /**
+     * @brief 创建环并注册provided buffer ring。
+     * @return 失败时返回false，此时不能使用本Reactor。
+     */
+    bool Init();
+
+    void Start() override;
+    void Stop() override;
+    void AddConn(int fd, const sockaddr_in& addr) override;
+    void SetListenFd(int listenFd, uint32_t listenEvent, int maxFd) override;
+
+    /**
+     * @brief 异步验证完成（数据库线程调用），唤醒本Reactor在自己的线程中继续处理该连接。
+     */
+    void ResumeConn(HttpConn* conn, uint32_t gen, bool ok) override;
+
+    /**
+     * @brief 修改超时，在下次唤醒时由本线程应用。
+     */
+    void SetTimeouts(int timeoutMS, int keepAliveTimeoutMS) override;
+
+    /**
+     * @brief 停止accept并关闭监听套接字，在下次唤醒时由本线程执行。
+     */
+    void StopAccept() override;
+
+    /**
+     * @brief 排空，在下次唤醒时由本线程关闭空闲的长连接。
+     */
+    void Drain() override;
+
+    /**
+     * @brief 指定事件循环线程绑定的CPU，在线程启动时生效。
+     */
+    void SetCpu(int cpu) override { cpu_ = cpu; }
+
+private:
+    // user_data的高8位是操作码，中间24位是连接代数，低32位是fd
+    enum Op { OP_WAKEUP = 1, OP_ACCEPT, OP_RECV, OP_SEND, OP_CANCEL };
+    static const uint32_t GEN_MASK = 0xffffff;
+
+    static const unsigned RING_ENTRIES = 256;   // SQ大小
+    static const unsigned CQ_ENTRIES = 4096;    // CQ大小，多次recv和accept会持续产生CQE
+    static const uint16_t BUF_GROUP = 0;        // provided buffer组号
+    static const unsigned BUF_COUNT = 256;      // provided buffer个数
+    static const unsigned BUF_SIZE = 4096;      // 每个provided buffer的字节数
+
+    /**
+     * @brief 每个fd上在途的操作，按fd下标保存，地址稳定（msg被内核引用到SENDMSG完成）
+     */
+    struct ConnState {
+        bool recvArmed = false;     // 多次recv是否仍在内核中
+        bool sending = false;       // 是否有SENDMSG在途
+        bool closing = false;       // 已决定关闭，等在途的发送完成后再关闭连接
+        struct iovec iov[HttpConn::MAX_IOV];
+        struct msghdr msg;
+    };
+
+    static uint64_t Pack_(int op, int fd, uint32_t gen) {
+        return (static_cast<uint64_t>(op) << 56) | (static_cast<uint64_t>(gen & GEN_MASK) << 32) |
+               static_cast<uint32_t>(fd);
+    }
+
+    void Loop_();
+    void OnCqe_(const struct io_uring_cqe& cqe);
+    void OnAccept_(const struct io_uring_cqe& cqe);
+    void OnRecv_(int fd, uint32_t gen, const struct io_uring_cqe& cqe);
+    void OnSend_(int fd, uint32_t gen, int res);
+
+    /**
+     * @brief 取一个SQE并填好user_data，SQ提交失败时返回nullptr
+     */
+    struct io_uring_sqe* Sqe_(int op, int fd, uint32_t gen);
+
+    void ArmWakeup_();
+    void ArmAccept_();
+    bool ArmRecv_(HttpConn* client);
+
+    /**
+     * @brief 连接数达到高水位时取消多次accept，暂停accept
+     */
+    void PauseAccept_();
+
+    /**
+     * @brief 停止accept后，在多次accept终止时关闭监听套接字。
+     */
+    void CloseListen_();
+
+    /**
+     * @brief 用一个SENDMSG发送写队列头部的数据
+     */
+    void Send_(HttpConn* client);
+
+    /**
+     * @brief 处理读缓冲区中的请求，有响应时发送
+     */
+    void Process_(HttpConn* client);
+
+    void Wakeup_();
+    void HandleWakeup_();
+    void SendError_(int fd, const char* info);
+    void AddClient_(int fd, const sockaddr_in& addr);
+
+    /**
+     * @brief 关闭客户端连接：取消在途的recv，有发送在途时等它完成再关闭
+     */
+    void CloseConn_(HttpConn* client);
+
+    /**
+     * @brief 排空时关闭本Reactor所有空闲的长连接（没有发送在途的）。
+     */
+    void CloseIdle_();
+    void OnTimeout_(HttpConn* client, uint32_t gen);
+    void ExtentTime_(HttpConn* client, int timeoutMS);
+
+    /**
+     * @brief 连接仍是提交操作时的那一个
+     */
+    static bool Match_(const HttpConn* client, uint32_t gen) {
+        return (client->Generation() & GEN_MASK) == (gen & GEN_MASK);
+    }
+
+    ConnState* State_(int fd) {
+        return fd >= 0 && static_cast<size_t>(fd) < states_.size() ? states_[fd].get() : nullptr;
+    }
+
+    int id_;                    // Reactor编号
+    int cpu_;                   // 事件循环线程绑定的CPU，-1表示不绑核
+    int timeoutMS_;             // 连接超时时间（毫秒）
+    int keepAliveTimeoutMS_;    // 长连接空闲超时时间（毫秒）
+    std::atomic<bool> isClose_; // 事件循环是否退出
+    int wakeupFd_;              // 跨线程唤醒用的eventfd（阻塞模式，由IORING_OP_READ读取）
+    uint64_t wakeupBuf_;        // eventfd读到的计数
+    int listenFd_;              // 本Reactor自己的监听套接字，-1表示由主Reactor分发连接
+    int maxFd_;                 // 允许的最大连接数
+    bool acceptArmed_;          // 多次accept是否在途（取消后直到最后一个CQE到达之前仍为true）
+    bool acceptPaused_;         // 是否因连接数达到高水位暂停了accept
+    bool acceptStopped_;        // 监听套接字已交给新进程，不再accept
+
+    IoUring ring_;                                  // 本线程独占的环
+    std::unique_ptr<Timer> timer_;                  // 本线程独占的定时器
+    ConnSlab* users_;                               // 共享的连接表（不拥有）
+    std::vector<std::unique_ptr<ConnState>> states_; // 以fd为下标的在途操作
+
+    /**
+     * @brief 验证完成、等待本线程继续处理的连接
+     */
+    struct Resumed {
+        HttpConn* conn;
+        uint32_t gen;
+        bool ok;
+    };
+
+    std::mutex mtx_;                                    // 保护pending_和resumed_
+    std::vector<std::pair<int, sockaddr_in>> pending_;  // 等待本线程接管的新连接
+    std::vector<Resumed> resumed_;                      // 等待本线程继续处理的连接
+    // 其他线程的控制请求（配置重载、交接监听套接字、排空），在mtx_内设置，唤醒时由本线程应用
+    int newTimeoutMS_;                                  // 大于0时更新超时
+    int newKeepAliveTimeoutMS_;
+    bool stopAccept_;
+    bool drain_;                                        // 请求本线程检查并关闭空闲连接
+    bool draining_;                                     // 本线程：已进入排空，连接空闲时直接关闭
+    std::thread thread_;                                // 事件循环线程
+};
+
+#endif // WEBSERVER_HAS_URING
+
+#endif //URING_REACTOR_H
@@ -1,7 +1,39 @@
 #include "webserver.h"
 
+#include <algorithm>
+#include <dirent.h>
+#include <limits.h>
+#include <fstream>
+#include <iterator>
+
 using namespace std;
 
+extern char** environ;
+
+namespace {
+
+// 平滑升级时旧进程通过环境变量把监听套接字和自己的pid交给新进程
+const char LISTEN_FDS_ENV[] = "WEBSERVER_LISTEN_FDS";
+const char UPGRADE_PARENT_ENV[] = "WEBSERVER_UPGRADE_PARENT";
+// 排空时检查连接是否处理完、关闭新出现的空闲连接的间隔（毫秒）
+const int DRAIN_POLL_MS = 100;
+
+int64_t NowMs() {
+    return chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void HandledSignals(sigset_t* mask) {
+    sigemptyset(mask);
+    sigaddset(mask, SIGHUP);
+    sigaddset(mask, SIGUSR2);
+    sigaddset(mask, SIGWINCH);
+    sigaddset(mask, SIGCHLD);
+    sigaddset(mask, SIGTERM);
+    sigaddset(mask, SIGINT);
+}
+
+} // namespace
+
 /**
  * @brief WebServer类的构造函数
  * 
@@ -17,15 +49,60 @@ using namespace std;
  * @param openLog 是否开启日志
  * @param logLevel 日志级别
  * @param logQueSize 日志队列大小
+ * @param multiReactor 是否使用多Reactor模式，为true时threadNum表示从Reactor数量
+ * @param reusePort 是否开启SO_REUSEPORT，多Reactor模式下每个从Reactor各自监听
+ * @param backlog listen的全连接队列长度
+ * @param workStealing 是否使用工作窃取线程池
+ * @param useSendfile 是否用sendfile发送静态文件
+ * @param fileCacheMB 静态文件缓存容量（MB）
+ * @param timeWheel 是否使用时间轮定时器
+ * @param keepAliveMax 每个长连接最多处理的请求数
+ * @param keepAliveTimeoutMS 长连接空闲超时（毫秒）
+ * @param accessLog 是否记录访问日志
+ * @param ioUring 从Reactor是否使用io_uring后端
+ * @param maxQueue 线程池任务队列深度上限
+ * @param maxInFlight 在途请求数上限
+ * @param connHighWater 连接数高水位
+ * @param connLowWater 连接数低水位
+ * @param retryAfterSec 503响应中Retry-After的秒数
+ * @param metrics 是否开启指标
+ * @param slowRequestMS 慢请求阈值（毫秒）
+ * @param drainTimeoutMS 收到SIGTERM后等待在途请求完成的时限（毫秒）
+ * @param maxBodyKB 请求体上限（KB）
+ * @param cpuAffinity 是否绑核
+ * @param housekeepingCpu 后台线程使用的核
  */
 WebServer::WebServer(
             int port, int trigMode, int timeoutMS,
             int sqlPort, const char* sqlUser, const  char* sqlPwd,
             const char* dbName, int connPoolNum, int threadNum,
-            bool openLog, int logLevel, int logQueSize):
-            port_(port), timeoutMS_(timeoutMS), isClose_(false),
-            timer_(new HeapTimer()), threadpool_(new ThreadPool(threadNum)), epoller_(new Epoller())
+            bool openLog, int logLevel, int logQueSize,
+            bool multiReactor, bool reusePort, int backlog,
+            bool workStealing, bool useSendfile, int fileCacheMB,
+            bool timeWheel, int keepAliveMax, int keepAliveTimeoutMS,
+            bool accessLog, bool ioUring,
+            int maxQueue, int maxInFlight, int connHighWater, int connLowWater,
+            int retryAfterSec, bool metrics, int slowRequestMS, int drainTimeoutMS,
+            int maxBodyKB, bool cpuAffinity, int housekeepingCpu):
+            port_(port), timeoutMS_(timeoutMS),
+            keepAliveTimeoutMS_(keepAliveTimeoutMS > 0 ? keepAliveTimeoutMS : timeoutMS),
+            isClose_(false), multiReactor_(multiReactor),
+            reusePort_(reusePort), backlog_(backlog), listenFd_(-1), acceptPaused_(false),
+            users_(new ConnSlab(MAX_FD)),
+            timer_(timeWheel ? static_cast<Timer*>(new TimeWheel()) : new HeapTimer()),
+            epoller_(new Epoller()), nextReactor_(0), mainCpu_(-1),
+            signalFd_(-1), upgradePid_(0), upgradeParent_(0),
+            draining_(false), drainTimeoutMS_(drainTimeoutMS > 0 ? drainTimeoutMS : 0),
+            drainDeadlineMs_(0), nextSweepMs_(0)
     {
+    // 信号由主Reactor通过signalfd处理，必须在日志、线程池等创建线程之前屏蔽
+    InitSignals_();
+    // 绑核的线程（包括日志写线程）在启动时读取分配结果，必须在创建它们之前初始化
+    CpuAffinity::Instance()->Init(cpuAffinity, housekeepingCpu);
+    // io_uring后端只用于多Reactor模式，编译环境或内核不支持时回退到epoll
+    bool uring = ioUring && multiReactor && IoUring::Supported();
+    // io_uring后端用SENDMSG发送mmap的文件，不使用sendfile
+    if(uring) { useSendfile = false; }
     // 是否打开日志标志
     if(openLog) {
         // 初始化日志系统
@@ -46,6 +123,26 @@ WebServer::WebServer(
             LOG_INFO("srcDir: %s", HttpConn::srcDir);
             // 打印数据库连接池数量和线程池线程数量
             LOG_INFO("SqlConnPool num: %d, ThreadPool num: %d", connPoolNum, threadNum);
+            // 打印文件发送方式
+            LOG_INFO("File send: %s, FileCache: %dMB", useSendfile ? "sendfile" : "mmap + writev", fileCacheMB);
+            // 打印线程模型
+            LOG_INFO("Reactor Mode: %s", multiReactor_ ? (uring ? "one loop per thread (io_uring)" : "one loop per thread") :
+                            (workStealing ? "reactor + work-stealing pool" : "reactor + threadpool"));
+            if(ioUring && !uring) {
+                LOG_WARN("io_uring backend %s, fall back to epoll",
+                         multiReactor ? "not supported" : "requires multi-reactor mode");
+            }
+            // 打印定时器和长连接限制
+            LOG_INFO("Timer: %s, keep-alive max: %d, idle timeout: %dms",
+                            timeWheel ? "time wheel" : "heap", keepAliveMax, keepAliveTimeoutMS_);
+            // 打印过载保护的限制
+            LOG_INFO("Admission: max queue: %d, max in-flight: %d, conn watermark: %d/%d, Retry-After: %ds",
+                            maxQueue, maxInFlight, connHighWater, connLowWater, retryAfterSec);
+            LOG_INFO("Metrics: %s", metrics ? Metrics::PATH : "off");
+            LOG_INFO("Slow request threshold: %dms", slowRequestMS > 0 ? slowRequestMS : 0);
+            LOG_INFO("Drain timeout: %dms", drainTimeoutMS_);
+            LOG_INFO("Max request body: %dKB", maxBodyKB);
+            LOG_INFO("CPU affinity: %s", CpuAffinity::Instance()->Describe().c_str());
         }
     }
 
@@ -58,23 +155,167 @@ WebServer::WebServer(
     HttpConn::userCount = 0;
     // 设置资源目录
     HttpConn::srcDir = srcDir_;
+    // 设置文件发送方式
+    HttpConn::useSendfile = useSendfile;
+    // 设置长连接限制（没有定时器时不通告空闲超时）
+    HttpConn::keepAliveMax = keepAliveMax;
+    HttpConn::keepAliveTimeoutMS = timeoutMS_ > 0 ? keepAliveTimeoutMS_ : 0;
+    // 设置请求体上限
+    assert(maxBodyKB >= 0);
+    HttpRequest::maxBodySize = static_cast<size_t>(maxBodyKB) << 10;
+    // 初始化静态文件缓存，sendfile模式下不需要内存映射
+    assert(fileCacheMB >= 0);
+    FileCache::Instance()->Init(static_cast<size_t>(fileCacheMB) << 20, !useSendfile);
+    // 每个请求一条的二进制访问日志，由独立的写线程落盘，写线程放在housekeeping核上
+    if(accessLog) {
+        AccessLog::Instance()->Init("./log", ".access", 64 * 1024 * 1024, 8192,
+                                    CpuAffinity::Instance()->HousekeepingCpu());
+    }
+
+    // 过载保护：队列深度/在途请求数超限时回复503，连接数达到高水位时暂停accept
+    Admission::Instance()->Init(maxQueue > 0 ? maxQueue : 0, maxInFlight, connHighWater, connLowWater, retryAfterSec);
 
+    // 预先分配前面一部分连接对象，最初的连接不需要在请求路径上分配内存
+    users_->Reserve(RESERVE_CONN);
     // 初始化数据库连接池
     SqlConnPool::Instance()->Init("localhost", sqlPort, sqlUser, sqlPwd, dbName, connPoolNum);
+    // 登录/注册先查用户缓存，未命中才访问数据库
+    UserCache::Instance()->Init(USER_CACHE_SIZE, USER_CACHE_TTL_MS);
+    // 登录/注册在专门的数据库线程执行，每个线程同时最多占用一个连接
+    SqlExecutor::Instance()->Init(SqlConnPool::Instance(), connPoolNum);
     // 初始化事件模式
     InitEventMode_(trigMode);
+    // 多Reactor模式下主Reactor只accept和处理信号，放在housekeeping核上；
+    // 单Reactor模式下主Reactor负责所有连接的事件，和工作线程一样占一个核（在Start()中绑定，之后创建的线程不会继承）
+    CpuAffinity* affinity = CpuAffinity::Instance();
+    mainCpu_ = multiReactor_ ? affinity->HousekeepingCpu() : affinity->ClaimWorkerCpu();
+    // 多Reactor模式下每个线程自带事件循环，否则创建线程池
+    if(multiReactor_) {
+        assert(threadNum > 0);
+        // 连接只由所属的从Reactor处理，边沿触发时去掉EPOLLONESHOT，省去每次读写后的epoll_ctl
+        uint32_t reactorEvent = (connEvent_ & EPOLLET) ? (connEvent_ & ~EPOLLONESHOT) : connEvent_;
+        for(int i = 0; i < threadNum; i++) {
+            IoBackend* reactor = uring ? NewUringReactor(i, users_.get(), timeoutMS_, timeWheel,
+                                                         keepAliveTimeoutMS_) : nullptr;
+            if(!reactor) {
+                reactor = new SubReactor(i, users_.get(), timeoutMS_, reactorEvent, timeWheel, keepAliveTimeoutMS_);
+            }
+            // 工作核比从Reactor少时同一个核上有多个从Reactor，新连接交给第一个
+            int cpu = affinity->ClaimWorkerCpu();
+            reactor->SetCpu(cpu);
+            if(cpu >= 0) {
+                if(cpu >= static_cast<int>(cpuReactor_.size())) { cpuReactor_.resize(cpu + 1, -1); }
+                if(cpuReactor_[cpu] < 0) { cpuReactor_[cpu] = i; }
+            }
+            reactors_.emplace_back(reactor);
+        }
+    } else if(workStealing) {
+        stealpool_.reset(new WorkStealingPool<ConnTask>(threadNum,
+                            [this](ConnTask& task) { OnTask_(task); }));
+    } else {
+        threadpool_.reset(new ThreadPool(threadNum));
+    }
+    if(!multiReactor_) {
+        idle_.reset(new std::atomic<bool>[MAX_FD]());
+    }
+    HttpConn::draining = false;
+    // 请求阶段计时，在工作线程处理请求之前校准时钟
+    Trace::Instance()->Init(slowRequestMS);
+    // 开启指标时注册导出时读取的瞬时值
+    Metrics::Instance()->SetEnabled(metrics);
+    if(metrics) { RegisterGauges_(); }
     // 初始化套接字
     if(!InitSocket_()) { isClose_ = true;}
 }
 
+/**
+ * @brief 按配置构造WebServer
+ *
+ * @param config 服务器配置
+ * @param configFile 配置文件路径，SIGHUP时重新读取
+ */
+WebServer::WebServer(const ServerConfig& config, const string& configFile):
+            WebServer(config.port, config.trigMode, config.timeoutMS,
+                      config.sqlPort, config.sqlUser.c_str(), config.sqlPwd.c_str(),
+                      config.dbName.c_str(), config.connPoolNum, config.threadNum,
+                      config.openLog, config.logLevel, config.logQueSize,
+                      config.multiReactor, config.reusePort, config.backlog,
+                      config.workStealing, config.useSendfile, config.fileCacheMB,
+                      config.timeWheel, config.keepAliveMax, config.keepAliveTimeoutMS,
+                      config.accessLog, config.ioUring,
+                      config.maxQueue, config.maxInFlight, config.connHighWater, config.connLowWater,
+                      config.retryAfterSec, config.metrics, config.slowRequestMS,
+                      config.drainTimeoutMS, config.maxBodyKB,
+                      config.cpuAffinity, config.housekeepingCpu) {
+    config_ = config;
+    configFile_ = configFile;
+    if(!configFile_.empty()) { LOG_INFO("Config: %s (SIGHUP to reload)", configFile_.c_str()); }
+}
+
+/**
+ * @brief 注册导出时读取的瞬时值
+ *
+ * 回调在处理/metrics请求的线程中调用，只读原子变量或在各自模块的锁内读取。
+ */
+void WebServer::RegisterGauges_() {
+    Metrics* metrics = Metrics::Instance();
+    metrics->AddGauge("webserver_connections", "Open client connections.",
+                      [] { return static_cast<double>(HttpConn::userCount.load()); });
+    metrics->AddGauge("webserver_threadpool_queue_depth", "Tasks waiting in the worker pool.", [this] {
+        if(stealpool_) { return static_cast<double>(stealpool_->QueueSize()); }
+        return threadpool_ ? static_cast<double>(threadpool_->QueueSize()) : 0.0;
+    });
+    metrics->AddGauge("webserver_inflight_requests", "Admitted requests not yet processed.",
+                      [] { return static_cast<double>(Admission::Instance()->InFlight()); });
+    metrics->AddGauge("webserver_shed_total", "Requests and connections rejected with 503.",
+                      [] { return static_cast<double>(Admission::Instance()->ShedCount()); }, true);
+    metrics->AddGauge("webserver_sql_free_connections", "Idle connections in SqlConnPool.",
+                      [] { return static_cast<double>(SqlConnPool::Instance()->GetFreeConnCount()); });
+    metrics->AddGauge("webserver_user_cache_hits_total", "UserCache lookups served from memory.",
+                      [] { return static_cast<double>(UserCache::Instance()->Hits()); }, true);
+    metrics->AddGauge("webserver_user_cache_misses_total", "UserCache lookups that went to the DB.",
+                      [] { return static_cast<double>(UserCache::Instance()->Misses()); }, true);
+    if(Trace::Instance()->IsEnabled()) {
+        metrics->AddGauge("webserver_slow_requests_total", "Requests slower than the slow request threshold.",
+                          [] { return static_cast<double>(Trace::Instance()->SlowCount()); }, true);
+    }
+}
+
 /**
  * @brief WebServer类的析构函数
  */
 WebServer::~WebServer() {
-    close(listenFd_);
+    // 回调引用着本对象，先注销
+    Metrics::Instance()->ClearGauges();
+    if(listenFd_ >= 0) { close(listenFd_); }
+    if(signalFd_ >= 0) { close(signalFd_); }
     isClose_ = true;
+    // 先停掉数据库线程，之后不会再有ResumeConn回调
+    SqlExecutor::Instance()->Stop();
+    LOG_INFO("UserCache hits: %llu, misses: %llu", (unsigned long long)UserCache::Instance()->Hits(),
+             (unsigned long long)UserCache::Instance()->Misses());
+    LOG_INFO("Admission shed: %llu", (unsigned long long)Admission::Instance()->ShedCount());
+    // 先停掉从Reactor，保证没有线程还在使用连接
+    for(auto& reactor : reactors_) {
+        reactor->Stop();
+    }
+    // 线程池执行完队列中剩下的任务后join工作线程，需在连接表、epoll和数据库连接池释放之前完成
+    threadpool_.reset();
+    stealpool_.reset();
+    if(HttpConn::userCount > 0) {
+        LOG_WARN("Close %d connections on exit", (int)HttpConn::userCount);
+    }
+    if(AccessLog::Instance()->IsOpen()) {
+        LOG_INFO("AccessLog written: %llu, dropped: %llu",
+                 (unsigned long long)AccessLog::Instance()->Written(),
+                 (unsigned long long)AccessLog::Instance()->Dropped());
+        AccessLog::Instance()->Close();
+    }
     free(srcDir_);
     SqlConnPool::Instance()->ClosePool();
+    // 所有线程都已退出，写完日志队列中剩下的内容再返回，进程退出时不丢日志
+    LOG_INFO("========== Server stop ==========");
+    Log::Instance()->Close();
 }
 
 /**
@@ -120,18 +361,57 @@ void WebServer::InitEventMode_(int trigMode) {
  * @brief 启动服务器
  */
 void WebServer::Start() {
-    // 初始化epoll_wait的超时时间为-1，表示无事件时将阻塞
-    int timeMS = -1;  
+    // 初始化等待超时为-1，表示无事件时将阻塞
+    int64_t timeUs = -1;  
     // 如果服务器未关闭，则打印服务器启动信息
     if(!isClose_) { LOG_INFO("========== Server start =========="); }
+    CpuAffinity::Pin(mainCpu_);
+    // 多Reactor模式下启动所有从Reactor，主线程只负责accept
+    for(auto& reactor : reactors_) {
+        reactor->Start();
+    }
+    // 平滑升级启动的新进程已经可以服务，通知旧进程交出监听
+    if(!isClose_ && upgradeParent_ > 0 && upgradeParent_ == getppid()) {
+        LOG_INFO("Upgraded from pid %d, notify it to hand over", (int)upgradeParent_);
+        kill(upgradeParent_, SIGWINCH);
+    }
     // 进入服务器主循环，直到服务器关闭
     while(!isClose_) {
         // 如果设置了超时时间，则获取下一次的超时等待时间
         if(timeoutMS_ > 0) {
-            timeMS = timer_->GetNextTick();     
+            timeUs = timer_->GetNextTickUs();     
+        }
+        // 暂停accept时连接在其他线程中关闭，定期醒来检查是否降到低水位
+        if(acceptPaused_) {
+            if(Admission::Instance()->BelowLowWater(HttpConn::userCount)) {
+                ResumeAccept_();
+            } else if(timeUs < 0 || timeUs > Admission::PAUSE_POLL_MS * 1000) {
+                timeUs = Admission::PAUSE_POLL_MS * 1000;
+            }
+        }
+        // 排空：连接全部关闭或超过时限后退出，期间定期关闭新出现的空闲连接
+        if(draining_) {
+            int64_t now = NowMs();
+            if(HttpConn::userCount == 0) {
+                LOG_INFO("All connections closed, exit");
+                isClose_ = true;
+                break;
+            }
+            if(now >= drainDeadlineMs_) {
+                LOG_WARN("Drain timeout (%dms), %d connections still open, exit",
+                         drainTimeoutMS_, (int)HttpConn::userCount);
+                isClose_ = true;
+                break;
+            }
+            if(now >= nextSweepMs_) {
+                CloseIdle_();
+                nextSweepMs_ = now + DRAIN_POLL_MS;
+            }
+            int64_t waitUs = min<int64_t>(DRAIN_POLL_MS, drainDeadlineMs_ - now) * 1000;
+            if(timeUs < 0 || timeUs > waitUs) { timeUs = waitUs; }
         }
-        // 调用epoller的Wait函数等待事件发生，返回发生的事件数量
-        int eventCnt = epoller_->Wait(timeMS);
+        // 调用epoller的WaitUs函数等待事件发生（超时精确到微秒），返回发生的事件数量
+        int eventCnt = epoller_->WaitUs(timeUs);
         // 遍历所有发生的事件
         for(int i = 0; i < eventCnt; i++) {
             // 获取事件的文件描述符
@@ -142,20 +422,24 @@ void WebServer::Start() {
             if(fd == listenFd_) {
                 DealListen_();
             }
+            // 信号：重载配置、平滑升级
+            else if(fd == signalFd_) {
+                OnSignal_();
+            }
             // 如果事件是客户端关闭连接、挂起或错误，则关闭客户端连接
             else if(events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
-                assert(users_.count(fd) > 0);
-                CloseConn_(&users_[fd]);
+                assert(users_->Find(fd));
+                CloseConn_(users_->Find(fd));
             }
             // 如果事件是可读事件，则处理读事件
             else if(events & EPOLLIN) {
-                assert(users_.count(fd) > 0);
-                DealRead_(&users_[fd]);
+                assert(users_->Find(fd));
+                DealRead_(users_->Find(fd));
             }
             // 如果事件是可写事件，则处理写事件
             else if(events & EPOLLOUT) {
-                assert(users_.count(fd) > 0);
-                DealWrite_(&users_[fd]);
+                assert(users_->Find(fd));
+                DealWrite_(users_->Find(fd));
             } else {
                 // 如果事件类型未知，则打印错误信息
                 LOG_ERROR("Unexpected event");
@@ -195,6 +479,7 @@ void WebServer::CloseConn_(HttpConn* client) {
     LOG_INFO("Client[%d] quit!", client->GetFd());
     // 从epoll实例中删除客户端的文件描述符
     epoller_->DelFd(client->GetFd());
+    if(idle_) { idle_[client->GetFd()].store(false, std::memory_order_relaxed); }
     // 关闭客户端连接
     client->Close();
 }
@@ -209,17 +494,18 @@ void WebServer::AddClient_(int fd, sockaddr_in addr) {
     // 确保文件描述符有效
     assert(fd > 0);
     // 初始化客户端连接对象
-    users_[fd].init(fd, addr);
+    HttpConn* client = users_->Get(fd);
+    client->init(fd, addr, this);
     // 如果设置了超时时间，则将客户端连接添加到定时器中
     if(timeoutMS_ > 0) {
-        timer_->add(fd, timeoutMS_, std::bind(&WebServer::CloseConn_, this, &users_[fd]));
+        timer_->add(fd, timeoutMS_, std::bind(&WebServer::OnTimeout_, this, client, client->Generation()));
     }
-    // 将客户端连接添加到epoll实例中，监听读事件和连接事件
+    // 将客户端连接添加到epoll实例中，监听读事件和连接事件（fd已由accept4设为非阻塞）
     epoller_->AddFd(fd, EPOLLIN | connEvent_);
-    // 设置客户端套接字为非阻塞模式
-    SetFdNonblock(fd);
+    // 等待第一个请求，排空时可以直接关闭
+    idle_[fd].store(true, std::memory_order_relaxed);
     // 记录客户端连接成功的日志信息
-    LOG_INFO("Client[%d] in!", users_[fd].GetFd());
+    LOG_INFO("Client[%d] in!", client->GetFd());
 }
 
 // 处理监听套接字，主要逻辑是accept新的套接字，并加入timer和epoller中
@@ -236,25 +522,55 @@ void WebServer::DealListen_() {
     socklen_t len = sizeof(addr);
     // 使用do-while循环，确保至少执行一次循环体
     do {
-        // 调用accept函数接受新的客户端连接，返回一个新的套接字描述符
-        int fd = accept(listenFd_, (struct sockaddr *)&addr, &len);
+        // 调用accept4接受新的客户端连接，直接得到非阻塞的套接字，省去一次fcntl
+        int fd = accept4(listenFd_, (struct sockaddr *)&addr, &len, SOCK_NONBLOCK | SOCK_CLOEXEC);
         // 如果返回的套接字描述符小于等于0，表示接受连接失败，直接返回
         if(fd <= 0) { return;}
         // 如果当前的用户数量已经达到了最大限制
-        else if(HttpConn::userCount >= MAX_FD) {
-            // 向客户端发送错误信息，表示服务器繁忙
-            SendError_(fd, "Server busy!");
+        else if(HttpConn::userCount >= MAX_FD || fd >= MAX_FD) {
+            // 向客户端发送预先格式化好的503，表示服务器繁忙
+            SendError_(fd, Admission::Instance()->BusyResponse().c_str());
             // 记录警告日志，提示客户端连接已满
             LOG_WARN("Clients is full!");
             // 返回，不再处理新的连接
             return;
         }
-        // 调用AddClient_函数，将新的客户端连接添加到服务器中
-        AddClient_(fd, addr);
+        // 多Reactor模式下轮询分发给从Reactor，此后该连接只在那个线程中处理
+        if(multiReactor_) {
+            reactors_[PickReactor_(fd)]->AddConn(fd, addr);
+        } else {
+            // 调用AddClient_函数，将新的客户端连接添加到服务器中
+            AddClient_(fd, addr);
+        }
+        // 连接数达到高水位，剩下的连接留在全连接队列里
+        if(Admission::Instance()->OverHighWater(HttpConn::userCount)) {
+            PauseAccept_();
+            return;
+        }
     // 如果事件模式为ET（边缘触发），则继续循环，直到没有新的连接为止
     } while(listenEvent_ & EPOLLET);
 }
 
+/**
+ * @brief 暂停accept
+ */
+void WebServer::PauseAccept_() {
+    if(acceptPaused_) { return; }
+    epoller_->DelFd(listenFd_);
+    acceptPaused_ = true;
+    LOG_WARN("Clients reach high watermark (%d), pause accept", (int)HttpConn::userCount);
+}
+
+/**
+ * @brief 恢复accept，全连接队列里积压的连接会让监听套接字立即就绪
+ */
+void WebServer::ResumeAccept_() {
+    if(!acceptPaused_) { return; }
+    epoller_->AddFd(listenFd_, listenEvent_ | EPOLLIN);
+    acceptPaused_ = false;
+    LOG_INFO("Clients below low watermark (%d), resume accept", (int)HttpConn::userCount);
+}
+
 // 处理读事件，主要逻辑是将OnRead加入线程池的任务队列中
 /**
  * @brief 处理读事件
@@ -264,10 +580,21 @@ void WebServer::DealListen_() {
 void WebServer::DealRead_(HttpConn* client) {
     // 确保客户端连接对象有效
     assert(client);
+    // 准入控制：任务队列太深或在途请求太多时不再排队，直接回复503并关闭连接
+    size_t queueDepth = stealpool_ ? stealpool_->QueueSize() : threadpool_->QueueSize();
+    if(!Admission::Instance()->TryEnter(queueDepth)) {
+        LOG_DEBUG("Shed client[%d], queue: %d", client->GetFd(), (int)queueDepth);
+        Admission::Instance()->Shed(client->GetFd());
+        CloseConn_(client);
+        return;
+    }
+    // 连接交给工作线程，排空时主线程不再关闭它
+    idle_[client->GetFd()].store(false, std::memory_order_relaxed);
     // 延长客户端连接的超时时间
-    ExtentTime_(client);
+    ExtentTime_(client, timeoutMS_);
     // 将读事件处理函数添加到线程池的任务队列中
-    threadpool_->AddTask(std::bind(&WebServer::OnRead_, this, client)); // 这是一个右值，bind将参数和函数绑定
+    PostTask_(ConnTask{client, ConnTask::READ, client->Generation(), 0,
+                       Trace::Instance()->IsEnabled() ? Trace::Now() : 0});
 }
 
 // 处理写事件，主要逻辑是将OnWrite加入线程池的任务队列中
@@ -279,22 +606,89 @@ void WebServer::DealRead_(HttpConn* client) {
 void WebServer::DealWrite_(HttpConn* client) {
     // 确保客户端连接对象有效
     assert(client);
-    // 延长客户端连接的超时时间
-    ExtentTime_(client);
+    // 延长客户端连接的超时时间：响应大多在这次写完，之后长连接进入空闲，按空闲超时续期
+    ExtentTime_(client, client->IsKeepAlive() ? keepAliveTimeoutMS_ : timeoutMS_);
     // 将写事件处理函数添加到线程池的任务队列中
-    threadpool_->AddTask(std::bind(&WebServer::OnWrite_, this, client));
+    PostTask_(ConnTask{client, ConnTask::WRITE, client->Generation(), 0});
+}
+
+/**
+ * @brief 投递任务到线程池
+ * 
+ * @param task 连接指针 + 操作码 + 代数
+ */
+void WebServer::PostTask_(const ConnTask& task) {
+    if(stealpool_) {
+        stealpool_->AddTask(task);
+        return;
+    }
+    threadpool_->AddTask(std::bind(&WebServer::OnTask_, this, task)); // 这是一个右值，bind将参数和函数绑定
+}
+
+/**
+ * @brief 异步验证完成
+ * 
+ * 在数据库线程中调用。等待验证期间连接没有注册任何事件，交给线程池后只有一个线程处理它。
+ * 
+ * @param conn 客户端连接对象
+ * @param gen 投递时连接的代数
+ * @param ok 验证结果
+ */
+void WebServer::ResumeConn(HttpConn* conn, uint32_t gen, bool ok) {
+    PostTask_(ConnTask{conn, ConnTask::RESUME, gen, ok ? 1 : 0});
+}
+
+/**
+ * @brief 执行线程池中的任务
+ * 
+ * @param task 连接指针 + 操作码 + 代数
+ */
+void WebServer::OnTask_(ConnTask& task) {
+    // 任务排队期间连接已被关闭（超时、对端断开），或者fd已被新连接复用
+    if(task.conn->Generation() != task.gen) {
+        LOG_DEBUG("Drop stale task, client[%d]", task.conn->GetFd());
+        if(task.op == ConnTask::READ) { Admission::Instance()->Leave(); }
+        return;
+    }
+    TRACE_PROBE2(task__start, task.conn->GetFd(), task.op);
+    if(task.op == ConnTask::READ) {
+        // 线程池中的排队时间从派发算起
+        task.conn->TraceEvent(task.dispatchTs);
+        OnRead_(task.conn);
+        // DealRead_准入的请求处理完毕
+        Admission::Instance()->Leave();
+    } else if(task.op == ConnTask::WRITE) {
+        OnWrite_(task.conn);
+    } else {
+        task.conn->OnVerifyDone(task.arg != 0);
+        OnProcess(task.conn);
+    }
+}
+
+/**
+ * @brief 超时回调
+ * 
+ * @param client 客户端连接对象
+ * @param gen 添加定时器时连接的代数
+ */
+void WebServer::OnTimeout_(HttpConn* client, uint32_t gen) {
+    // 连接已经关闭过或fd已被复用，旧定时器不再关闭它
+    if(client->Generation() != gen) { return; }
+    Metrics::Add(METRIC_TIMER_EXPIRED);
+    CloseConn_(client);
 }
 
 /**
  * @brief 延长客户端连接的超时时间
  * 
  * @param client 客户端连接对象
+ * @param timeoutMS 超时时间（毫秒）
  */
-void WebServer::ExtentTime_(HttpConn* client) {
+void WebServer::ExtentTime_(HttpConn* client, int timeoutMS) {
     // 确保客户端连接对象有效
     assert(client);
     // 如果设置了超时时间，则调整客户端连接的超时时间
-    if(timeoutMS_ > 0) { timer_->adjust(client->GetFd(), timeoutMS_); }
+    if(timeoutMS_ > 0) { timer_->adjust(client->GetFd(), timeoutMS); }
 }
 
 /**
@@ -323,12 +717,27 @@ void WebServer::OnRead_(HttpConn* client) {
 /* 处理读（请求）数据的函数 */
 void WebServer::OnProcess(HttpConn* client) {
     // 首先调用process()进行逻辑处理
-    if(client->process()) { // 根据返回的信息重新将fd置为EPOLLOUT（写）或EPOLLIN（读）
+    bool hasResponse = client->process();
+    // 等待异步验证时不注册事件，验证完成后由ResumeConn继续
+    if(client->IsVerifyPending()) {
+        return;
+    }
+    int fd = client->GetFd();
+    if(hasResponse) { // 根据返回的信息重新将fd置为EPOLLOUT（写）或EPOLLIN（读）
     //读完事件就跟内核说可以写了
-        epoller_->ModFd(client->GetFd(), connEvent_ | EPOLLOUT);    // 响应成功，修改监听事件为写,等待OnWrite_()发送
+        epoller_->ModFd(fd, connEvent_ | EPOLLOUT);    // 响应成功，修改监听事件为写,等待OnWrite_()发送
     } else {
+        // 长连接空闲：排空时直接关闭；否则交还主线程，在重新注册之前标记，排空时主线程可以关闭它。
+        // 标记之后主线程随时可能关闭连接，不能再访问client，fd要提前取出
+        if(client->IsIdle()) {
+            if(HttpConn::draining) {
+                CloseConn_(client);
+                return;
+            }
+            idle_[fd].store(true, std::memory_order_release);
+        }
     //写完事件就跟内核说可以读了
-        epoller_->ModFd(client->GetFd(), connEvent_ | EPOLLIN);
+        epoller_->ModFd(fd, connEvent_ | EPOLLIN);
     }
 }
 
@@ -350,18 +759,16 @@ void WebServer::OnWrite_(HttpConn* client) {
     if(client->ToWriteBytes() == 0) {
         /* 传输完成 */
         if(client->IsKeepAlive()) {
-            // 重新将文件描述符设置为监听读事件
-            epoller_->ModFd(client->GetFd(), connEvent_ | EPOLLIN);
+            // 继续处理读缓冲区中剩余的流水线请求，没有则重新监听读事件
+            OnProcess(client);
             return;
         }
     }
-    // 如果写入操作返回值小于0
-    else if(ret < 0) {
-        if(writeErrno == EAGAIN) {  // 缓冲区满了 
-            /* 继续传输 */
-            epoller_->ModFd(client->GetFd(), connEvent_ | EPOLLOUT);
-            return;
-        }
+    // LT模式下一次只发送一部分（ret > 0），或者缓冲区满了（EAGAIN）
+    else if(ret > 0 || writeErrno == EAGAIN) {
+        /* 继续传输 */
+        epoller_->ModFd(client->GetFd(), connEvent_ | EPOLLOUT);
+        return;
     }
     // 关闭客户端连接
     CloseConn_(client);
@@ -371,10 +778,431 @@ void WebServer::OnWrite_(HttpConn* client) {
 /**
  * @brief 初始化服务器套接字
  * 
+ * 普通模式下创建一个监听套接字并加入主Reactor的epoller；
+ * 多Reactor + SO_REUSEPORT模式下为每个从Reactor各创建一个监听套接字，由内核在它们之间做连接负载均衡，
+ * 主Reactor不再参与accept。
+ * 
  * @return true 初始化成功
  * @return false 初始化失败
  */
 bool WebServer::InitSocket_() {
+    // 平滑升级启动时优先使用旧进程交过来的监听套接字
+    vector<int> inherited = InheritListenFds_();
+    // 每个从Reactor绑定自己的SO_REUSEPORT监听套接字
+    if(multiReactor_ && reusePort_) {
+        for(auto& reactor : reactors_) {
+            int fd = TakeListenFd_(inherited);
+            if(fd < 0) { return false; }
+            reactor->SetListenFd(fd, listenEvent_, MAX_FD);
+        }
+        listenFd_ = -1;
+        LOG_INFO("Server port:%d, SO_REUSEPORT listeners:%d, backlog:%d",
+                    port_, static_cast<int>(reactors_.size()), backlog_);
+        // 新配置用不完的监听套接字
+        for(int fd : inherited) { DrainListenFd_(fd); }
+        return true;
+    }
+
+    listenFd_ = TakeListenFd_(inherited);
+    if(listenFd_ < 0) { return false; }
+    for(int fd : inherited) { DrainListenFd_(fd); }
+    int ret = epoller_->AddFd(listenFd_,  listenEvent_ | EPOLLIN);  // 将监听套接字加入epoller
+    if(ret == 0) {
+        // 记录错误日志
+        LOG_ERROR("Add listen error!");
+        // 关闭套接字
+        close(listenFd_);
+        // 返回失败
+        return false;
+    }
+    // 记录服务器启动信息
+    LOG_INFO("Server port:%d, backlog:%d%s", port_, backlog_, reusePort_ ? ", SO_REUSEPORT" : "");
+    // 返回成功
+    return true;
+}
+
+/**
+ * @brief 取出从旧进程继承的监听套接字
+ *
+ * 环境变量WEBSERVER_LISTEN_FDS是逗号分隔的fd列表，只接受处于监听状态的IPv4套接字。
+ * 读取后清除环境变量，以后再升级时由本进程重新设置。
+ *
+ * @return 继承的监听套接字，已重新设置FD_CLOEXEC
+ */
+vector<int> WebServer::InheritListenFds_() {
+    vector<int> fds;
+    const char* parent = getenv(UPGRADE_PARENT_ENV);
+    if(parent) { upgradeParent_ = static_cast<pid_t>(atoi(parent)); }
+    const char* list = getenv(LISTEN_FDS_ENV);
+    for(const char* p = list; p && *p; ) {
+        char* end = nullptr;
+        long fd = strtol(p, &end, 10);
+        if(end == p) { break; }
+        int accepting = 0;
+        socklen_t optLen = sizeof(accepting);
+        struct sockaddr_in addr;
+        socklen_t addrLen = sizeof(addr);
+        if(fd > STDERR_FILENO && fd < INT_MAX
+           && getsockopt(fd, SOL_SOCKET, SO_ACCEPTCONN, &accepting, &optLen) == 0 && accepting
+           && getsockname(fd, (struct sockaddr *)&addr, &addrLen) == 0 && addr.sin_family == AF_INET) {
+            fcntl(fd, F_SETFD, FD_CLOEXEC);
+            fds.push_back(static_cast<int>(fd));
+        } else {
+            LOG_WARN("Ignore inherited fd %ld: not a listening socket", fd);
+        }
+        p = (*end == ',') ? end + 1 : end;
+    }
+    unsetenv(LISTEN_FDS_ENV);
+    unsetenv(UPGRADE_PARENT_ENV);
+    if(!fds.empty()) { LOG_INFO("Inherited %d listen fds from pid %d", (int)fds.size(), (int)upgradeParent_); }
+    return fds;
+}
+
+/**
+ * @brief 取一个监听本端口的继承套接字，没有时新建
+ *
+ * @param inherited 继承的监听套接字，取走的会被移除
+ * @return int 成功返回监听套接字，失败返回-1
+ */
+int WebServer::TakeListenFd_(vector<int>& inherited) {
+    int fd = -1;
+    for(auto it = inherited.begin(); it != inherited.end(); ++it) {
+        struct sockaddr_in addr;
+        socklen_t len = sizeof(addr);
+        if(getsockname(*it, (struct sockaddr *)&addr, &len) == 0 && ntohs(addr.sin_port) == port_) {
+            fd = *it;
+            inherited.erase(it);
+            break;
+        }
+    }
+    if(fd < 0) { fd = CreateListenFd_(); }
+    if(fd >= 0) { listenFds_.push_back(fd); }
+    return fd;
+}
+
+/**
+ * @brief 接走多余的继承监听套接字中已完成握手的连接，然后关闭它
+ *
+ * 新配置的监听套接字比旧进程少（或换了端口）时，直接关闭会重置全连接队列里的连接。
+ * 旧进程交出监听之前仍可能有新连接排进这个队列，它们由旧进程accept。
+ *
+ * @param fd 多余的监听套接字
+ */
+void WebServer::DrainListenFd_(int fd) {
+    int count = 0;
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    int connFd;
+    while((connFd = accept4(fd, (struct sockaddr *)&addr, &len, SOCK_NONBLOCK | SOCK_CLOEXEC)) > 0) {
+        if(HttpConn::userCount >= MAX_FD || connFd >= MAX_FD) {
+            SendError_(connFd, Admission::Instance()->BusyResponse().c_str());
+        } else if(multiReactor_) {
+            reactors_[PickReactor_(connFd)]->AddConn(connFd, addr);
+        } else {
+            AddClient_(connFd, addr);
+        }
+        count++;
+        len = sizeof(addr);
+    }
+    close(fd);
+    LOG_INFO("Close surplus inherited listen fd %d, drained %d connections", fd, count);
+}
+
+/**
+ * @brief 屏蔽由signalfd处理的信号并创建signalfd
+ */
+void WebServer::InitSignals_() {
+    sigset_t mask;
+    HandledSignals(&mask);
+    pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+    signalFd_ = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if(signalFd_ < 0) { return; }
+    epoller_->AddFd(signalFd_, EPOLLIN);
+}
+
+/**
+ * @brief 处理signalfd上的信号
+ */
+void WebServer::OnSignal_() {
+    struct signalfd_siginfo info;
+    while(read(signalFd_, &info, sizeof(info)) == sizeof(info)) {
+        switch(info.ssi_signo) {
+        case SIGHUP:
+            Reload_();
+            break;
+        case SIGUSR2:
+            Upgrade_();
+            break;
+        case SIGWINCH:
+            // 只接受升级出的新进程的通知（终端窗口变化也会发SIGWINCH）
+            if(upgradePid_ > 0 && static_cast<pid_t>(info.ssi_pid) == upgradePid_ && !draining_) {
+                LOG_INFO("Listen sockets handed over to pid %d", (int)upgradePid_);
+                Drain_();
+            }
+            break;
+        case SIGTERM:
+        case SIGINT:
+            if(draining_) {
+                // 再收到一次就不再等待
+                LOG_WARN("Signal %d during drain, exit now", (int)info.ssi_signo);
+                isClose_ = true;
+            } else {
+                LOG_INFO("Signal %d, shutting down", (int)info.ssi_signo);
+                Drain_();
+            }
+            break;
+        case SIGCHLD: {
+            int status = 0;
+            pid_t pid;
+            while((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+                if(pid != upgradePid_) { continue; }
+                upgradePid_ = 0;
+                if(!draining_) {
+                    LOG_ERROR("Upgrade process %d exited before taking over (status %d), keep serving",
+                              (int)pid, status);
+                }
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+}
+
+/**
+ * @brief 重新读取配置文件并应用可以在运行中修改的项
+ *
+ * 配置文件读取失败时保持原配置。新配置与当前配置逐项比较：日志等级、超时、长连接限制、
+ * 文件缓存预算、线程池线程数和数据库连接池大小立即生效；端口、线程模型等需要重建监听或线程的项
+ * 只记录警告，用SIGUSR2平滑升级后生效。
+ */
+void WebServer::Reload_() {
+    if(configFile_.empty()) {
+        LOG_WARN("SIGHUP ignored: server was not started from a config file");
+        return;
+    }
+    ServerConfig next;
+    string err;
+    if(!next.Load(configFile_, &err)) {
+        LOG_ERROR("Reload config failed, keep the current one: %s", err.c_str());
+        return;
+    }
+    string applied, pending;
+    for(const string& key : config_.Diff(next)) {
+        bool live = true;
+        if(key == "log_level") {
+            Log::Instance()->SetLevel(next.logLevel);
+            config_.logLevel = next.logLevel;
+        } else if(key == "keep_alive_max") {
+            HttpConn::keepAliveMax = next.keepAliveMax;
+            config_.keepAliveMax = next.keepAliveMax;
+        } else if(key == "file_cache_mb") {
+            FileCache::Instance()->SetBudget(static_cast<size_t>(next.fileCacheMB) << 20);
+            config_.fileCacheMB = next.fileCacheMB;
+        } else if(key == "max_body_kb") {
+            HttpRequest::maxBodySize = static_cast<size_t>(next.maxBodyKB) << 10;
+            config_.maxBodyKB = next.maxBodyKB;
+        } else if(key == "drain_timeout_ms") {
+            drainTimeoutMS_ = next.drainTimeoutMS;
+            config_.drainTimeoutMS = next.drainTimeoutMS;
+        } else if(key == "sql_pool_size") {
+            // 数据库线程数跟着连接数调整，任何时候都不超过连接数：增加时先建连接，减少时先减线程
+            if(next.connPoolNum > config_.connPoolNum) {
+                SqlConnPool::Instance()->Resize(next.connPoolNum);
+                SqlExecutor::Instance()->Resize(next.connPoolNum);
+            } else {
+                SqlExecutor::Instance()->Resize(next.connPoolNum);
+                SqlConnPool::Instance()->Resize(next.connPoolNum);
+            }
+            config_.connPoolNum = next.connPoolNum;
+        } else if(key == "thread_num" && threadpool_) {
+            // 多Reactor模式下是从Reactor数量，工作窃取线程池的队列按线程划分，都不能在运行中修改
+            threadpool_->Resize(next.threadNum);
+            config_.threadNum = next.threadNum;
+        } else if((key == "timeout_ms" || key == "keep_alive_timeout_ms") && timeoutMS_ > 0 && next.timeoutMS > 0) {
+            // 只调整超时时长，开关定时器需要重启
+            timeoutMS_ = next.timeoutMS;
+            keepAliveTimeoutMS_ = next.keepAliveTimeoutMS > 0 ? next.keepAliveTimeoutMS : next.timeoutMS;
+            HttpConn::keepAliveTimeoutMS = keepAliveTimeoutMS_;
+            for(auto& reactor : reactors_) {
+                reactor->SetTimeouts(timeoutMS_, keepAliveTimeoutMS_);
+            }
+            config_.timeoutMS = next.timeoutMS;
+            config_.keepAliveTimeoutMS = next.keepAliveTimeoutMS;
+        } else {
+            live = false;
+        }
+        string& list = live ? applied : pending;
+        list += (list.empty() ? "" : ", ") + key;
+    }
+    LOG_INFO("Reload %s, applied: %s", configFile_.c_str(), applied.empty() ? "none" : applied.c_str());
+    if(!pending.empty()) {
+        LOG_WARN("Config changes need a binary upgrade (SIGUSR2) to take effect: %s", pending.c_str());
+    }
+}
+
+/**
+ * @brief 平滑升级：启动磁盘上的新程序并把监听套接字交给它
+ *
+ * 新进程以相同的参数和工作目录启动，从环境变量中取得监听套接字，初始化完成后发SIGWINCH通知本进程。
+ * 在此之前两个进程都在accept同一组监听套接字，不会丢失连接；新进程启动失败时本进程照常服务。
+ */
+void WebServer::Upgrade_() {
+    if(upgradePid_ > 0 || draining_) {
+        LOG_WARN("SIGUSR2 ignored: %s", draining_ ? "shutting down" : "upgrade already in progress");
+        return;
+    }
+    if(listenFds_.empty()) {
+        LOG_WARN("SIGUSR2 ignored: no listen socket to hand over");
+        return;
+    }
+    // 程序文件被替换后/proc/self/exe指向已删除的旧文件，去掉后缀即新程序的路径
+    char exe[PATH_MAX];
+    ssize_t n = readlink("/proc/self/exe", exe, sizeof(exe) - 1);
+    if(n <= 0) {
+        LOG_ERROR("Upgrade failed: readlink /proc/self/exe: %s", strerror(errno));
+        return;
+    }
+    string path(exe, n);
+    const string deleted = " (deleted)";
+    if(path.size() > deleted.size() && path.compare(path.size() - deleted.size(), deleted.size(), deleted) == 0) {
+        path.resize(path.size() - deleted.size());
+    }
+    // 命令行参数原样传给新进程
+    ifstream cmdline("/proc/self/cmdline");
+    string rawArgs((istreambuf_iterator<char>(cmdline)), istreambuf_iterator<char>());
+    vector<string> args;
+    for(size_t pos = 0; pos < rawArgs.size(); ) {
+        size_t end = rawArgs.find('\0', pos);
+        if(end == string::npos) { end = rawArgs.size(); }
+        args.push_back(rawArgs.substr(pos, end - pos));
+        pos = end + 1;
+    }
+    if(args.empty()) { args.push_back(path); }
+    string fdList;
+    for(int fd : listenFds_) { fdList += (fdList.empty() ? "" : ",") + to_string(fd); }
+    vector<string> envs;
+    for(char** env = environ; env && *env; env++) {
+        if(strncmp(*env, LISTEN_FDS_ENV, sizeof(LISTEN_FDS_ENV) - 1) == 0
+           || strncmp(*env, UPGRADE_PARENT_ENV, sizeof(UPGRADE_PARENT_ENV) - 1) == 0) { continue; }
+        envs.push_back(*env);
+    }
+    envs.push_back(string(LISTEN_FDS_ENV) + "=" + fdList);
+    envs.push_back(string(UPGRADE_PARENT_ENV) + "=" + to_string(getpid()));
+    vector<char*> argv, envp;
+    for(string& arg : args) { argv.push_back(&arg[0]); }
+    argv.push_back(nullptr);
+    for(string& env : envs) { envp.push_back(&env[0]); }
+    envp.push_back(nullptr);
+    // 除监听套接字外的fd都不能泄漏给新进程（数据库连接、日志文件等未必设置了FD_CLOEXEC）
+    vector<int> otherFds;
+    DIR* dir = opendir("/proc/self/fd");
+    if(dir) {
+        struct dirent* entry;
+        while((entry = readdir(dir)) != nullptr) {
+            int fd = atoi(entry->d_name);
+            if(fd <= STDERR_FILENO || fd == dirfd(dir)) { continue; }
+            if(find(listenFds_.begin(), listenFds_.end(), fd) == listenFds_.end()) { otherFds.push_back(fd); }
+        }
+        closedir(dir);
+    }
+
+    pid_t pid = fork();
+    if(pid < 0) {
+        LOG_ERROR("Upgrade failed: fork: %s", strerror(errno));
+        return;
+    }
+    if(pid == 0) {
+        // 子进程中只调用异步信号安全的函数
+        sigset_t mask;
+        sigemptyset(&mask);
+        sigprocmask(SIG_SETMASK, &mask, nullptr);
+        // exec会保留主Reactor绑定的核，新进程需要看到全部可用的CPU
+        CpuAffinity::Instance()->Unpin();
+        for(int fd : otherFds) { fcntl(fd, F_SETFD, FD_CLOEXEC); }
+        for(int fd : listenFds_) { fcntl(fd, F_SETFD, 0); }
+        execve(path.c_str(), argv.data(), envp.data());
+        _exit(127);
+    }
+    upgradePid_ = pid;
+    LOG_INFO("Upgrade: started %s as pid %d, listen fds: %s", path.c_str(), (int)pid, fdList.c_str());
+}
+
+/**
+ * @brief 开始排空
+ *
+ * 关闭监听套接字（平滑升级时新进程持有的副本不受影响），全连接队列里还没accept的连接由新进程处理，
+ * 没有新进程时被内核重置。正在处理的请求照常完成，响应带Connection: close，发完后关闭连接；
+ * 空闲的长连接立即关闭。Start()在连接全部关闭或超过drainTimeoutMS_后返回，析构函数再join所有线程。
+ */
+void WebServer::Drain_() {
+    if(draining_) { return; }
+    if(listenFd_ >= 0) {
+        if(!acceptPaused_) { epoller_->DelFd(listenFd_); }
+        close(listenFd_);
+        listenFd_ = -1;
+        acceptPaused_ = false;
+    }
+    for(auto& reactor : reactors_) {
+        reactor->StopAccept();
+    }
+    listenFds_.clear();
+    draining_ = true;
+    HttpConn::draining = true;
+    int64_t now = NowMs();
+    drainDeadlineMs_ = now + drainTimeoutMS_;
+    nextSweepMs_ = now + DRAIN_POLL_MS;
+    LOG_INFO("Stop accepting, draining %d connections (timeout %dms)", (int)HttpConn::userCount, drainTimeoutMS_);
+    CloseIdle_();
+}
+
+/**
+ * @brief 排空时关闭空闲的长连接
+ */
+void WebServer::CloseIdle_() {
+    for(auto& reactor : reactors_) {
+        reactor->Drain();
+    }
+    if(!idle_) { return; }
+    int closed = 0;
+    for(int fd = 0; fd < MAX_FD; fd++) {
+        // 先不加屏障地检查，绝大多数fd上没有空闲连接
+        if(!idle_[fd].load(std::memory_order_relaxed) || !idle_[fd].exchange(false, std::memory_order_acquire)) {
+            continue;
+        }
+        HttpConn* client = users_->Find(fd);
+        if(client && client->GetFd() == fd) {
+            CloseConn_(client);
+            closed++;
+        }
+    }
+    if(closed > 0) { LOG_INFO("Drain: closed %d idle connections", closed); }
+}
+
+/**
+ * @brief 选择接收新连接的从Reactor：绑核时优先选连接的网卡中断所在核上的，否则轮询。
+ * 
+ * @param fd 新连接的套接字
+ * @return size_t 从Reactor的下标
+ */
+size_t WebServer::PickReactor_(int fd) {
+    // 连接交给网卡中断所在核上的从Reactor，收包、处理和发送都在同一个核（同一个NUMA节点）上
+    if(!cpuReactor_.empty()) {
+        int cpu = CpuAffinity::IncomingCpu(fd);
+        if(cpu >= 0 && cpu < static_cast<int>(cpuReactor_.size()) && cpuReactor_[cpu] >= 0) {
+            return static_cast<size_t>(cpuReactor_[cpu]);
+        }
+    }
+    return nextReactor_++ % reactors_.size();
+}
+
+/**
+ * @brief 创建、绑定并监听一个非阻塞的监听套接字
+ * 
+ * @return int 成功返回监听套接字，失败返回-1
+ */
+int WebServer::CreateListenFd_() {
     // 定义一个变量用于存储函数返回值
     int ret;
     // 定义一个sockaddr_in结构体，用于存储服务器地址信息
@@ -386,86 +1214,63 @@ bool WebServer::InitSocket_() {
     // 设置端口号
     addr.sin_port = htons(port_);
 
-    // 创建套接字，使用IPv4协议，流式套接字，默认协议
-    listenFd_ = socket(AF_INET, SOCK_STREAM, 0);
+    // 创建非阻塞套接字，使用IPv4协议，流式套接字，默认协议
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
     // 如果创建套接字失败
-    if(listenFd_ < 0) {
+    if(fd < 0) {
         // 记录错误日志
         LOG_ERROR("Create socket error!", port_);
         // 返回失败
-        return false;
+        return -1;
     }
 
     // 设置套接字选项，允许地址重用
     int optval = 1;
     /* 端口复用 */
     /* 只有最后一个套接字会正常接收数据。 */
-    ret = setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, (const void*)&optval, sizeof(int));
+    ret = setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, (const void*)&optval, sizeof(int));
     // 如果设置选项失败
     if(ret == -1) {
         // 记录错误日志
         LOG_ERROR("set socket setsockopt error !");
         // 关闭套接字
-        close(listenFd_);
+        close(fd);
         // 返回失败
-        return false;
+        return -1;
+    }
+
+    /* 多个套接字（或多个进程）绑定同一端口，由内核分发新连接 */
+    if(reusePort_) {
+        ret = setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, (const void*)&optval, sizeof(int));
+        if(ret == -1) {
+            LOG_ERROR("set socket SO_REUSEPORT error !");
+            close(fd);
+            return -1;
+        }
     }
 
     // 绑定套接字到指定的地址和端口
-    ret = bind(listenFd_, (struct sockaddr *)&addr, sizeof(addr));
+    ret = bind(fd, (struct sockaddr *)&addr, sizeof(addr));
     // 如果绑定失败
     if(ret < 0) {
         // 记录错误日志
         LOG_ERROR("Bind Port:%d error!", port_);
         // 关闭套接字
-        close(listenFd_);
+        close(fd);
         // 返回失败
-        return false;
+        return -1;
     }
 
-    // 开始监听套接字，设置最大连接数为8
-    ret = listen(listenFd_, 8);
+    // 开始监听套接字，全连接队列长度由backlog_指定（内核会截断到somaxconn）
+    ret = listen(fd, backlog_);
     // 如果监听失败
     if(ret < 0) {
         // 记录错误日志
         LOG_ERROR("Listen port:%d error!", port_);
         // 关闭套接字
-        close(listenFd_);
+        close(fd);
         // 返回失败
-        return false;
+        return -1;
     }
-    ret = epoller_->AddFd(listenFd_,  listenEvent_ | EPOLLIN);  // 将监听套接字加入epoller
-    if(ret == 0) {
-        // 记录错误日志
-        LOG_ERROR("Add listen error!");
-        // 关闭套接字
-        close(listenFd_);
-        // 返回失败
-        return false;
-    }
-    // 设置监听套接字为非阻塞模式
-    SetFdNonblock(listenFd_);
-    // 记录服务器启动信息
-    LOG_INFO("Server port:%d", port_);
-    // 返回成功
-    return true;
-}
-
-// 设置非阻塞
-/**
- * @brief 设置文件描述符为非阻塞模式
- * 
- * @param fd 需要设置的文件描述符
- * @return int 返回值，成功返回0，失败返回-1
- */
-int WebServer::SetFdNonblock(int fd) {
-    // 确保文件描述符有效
-    assert(fd > 0);
-    // 使用fcntl函数将文件描述符设置为非阻塞模式
-    // F_SETFL用于设置文件状态标志
-    // F_GETFD用于获取文件描述符标志
-    // O_NONBLOCK用于设置非阻塞模式
-    return fcntl(fd, F_SETFL, fcntl(fd, F_GETFD, 0) | O_NONBLOCK);
+    return fd;
 }
-
-
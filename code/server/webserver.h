@@ -1,7 +1,8 @@
 #ifndef WEBSERVER_H
 #define WEBSERVER_H
 
-#include <unordered_map>
+#include <vector>
+#include <string>
 #include <fcntl.h>       // fcntl()
 #include <unistd.h>      // close()
 #include <assert.h>
@@ -9,21 +10,44 @@
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
+#include <signal.h>
+#include <sys/signalfd.h>
+#include <sys/wait.h>
 
 #include "epoller.h"
+#include "subreactor.h"
+#include "uringreactor.h"
+#include "connslab.h"
+#include "admission.h"
+#include "config.h"
 #include "../timer/heaptimer.h"
+#include "../timer/timewheel.h"
 
 #include "../log/log.h"
 #include "../pool/sqlconnpool.h"
+#include "../pool/sqlexecutor.h"
 #include "../pool/threadpool.h"
+#include "../pool/stealpool.h"
 
 #include "../http/httpconn.h"
 
+/**
+ * @brief 投递给WorkStealingPool的固定大小任务句柄，不需要为每个事件分配std::function。
+ */
+struct ConnTask {
+    enum Op { READ, WRITE, RESUME };
+    HttpConn* conn;     // 客户端连接
+    int op;             // 操作码
+    uint32_t gen;       // 投递时连接的代数，执行时不一致说明连接已关闭或被复用
+    int arg;            // RESUME：异步验证的结果
+    uint64_t dispatchTs; // READ：派发的时间（Trace::Now），只在开启阶段计时时记录
+};
+
 /**
  * @class WebServer
  * @brief 一个简单的Web服务器类，用于处理HTTP请求和响应。
  */
-class WebServer {
+class WebServer : public ConnOwner {
 public:
     /**
      * @brief 构造函数，初始化Web服务器的各种参数。
@@ -39,12 +63,57 @@ public:
      * @param openLog 是否开启日志记录。
      * @param logLevel 日志记录级别。
      * @param logQueSize 日志队列的大小。
+     * @param multiReactor 是否使用多Reactor模式（one loop per thread）。
+     *        为false时沿用主Reactor + 线程池模型，threadNum为线程池线程数；
+     *        为true时不创建线程池，threadNum为从Reactor的数量。
+     * @param reusePort 是否开启SO_REUSEPORT。多Reactor模式下每个从Reactor各绑定一个监听套接字，
+     *        由内核做连接负载均衡；单Reactor模式下可以让多个进程共享同一端口。
+     * @param backlog listen()的全连接队列长度。
+     * @param workStealing 主Reactor + 线程池模型下是否使用WorkStealingPool代替ThreadPool。
+     * @param useSendfile 静态文件是否用sendfile零拷贝发送（否则mmap + writev）。
+     * @param fileCacheMB 静态文件缓存的容量（MB），为0时不缓存。
+     * @param timeWheel 连接超时是否使用时间轮（否则使用小根堆HeapTimer）。
+     * @param keepAliveMax 每个长连接最多处理的请求数，小于等于0表示不限制。
+     * @param keepAliveTimeoutMS 长连接空闲超时（毫秒），小于等于0表示与timeoutMS相同。
+     * @param accessLog 是否记录二进制访问日志（./log/日期.access，用tools/accesslog_dump查看）。
+     * @param ioUring 多Reactor模式下从Reactor是否使用io_uring后端（多次accept/recv、provided buffer、批量提交），
+     *        此时静态文件总是mmap后随响应头一起用SENDMSG发送，忽略useSendfile；内核不支持时回退到epoll。
+     * @param maxQueue 线程池任务队列深度上限，超过时新请求直接回复503，0表示不限制（多Reactor模式下不使用）。
+     * @param maxInFlight 在途请求数上限，超过时新请求直接回复503，0表示不限制（多Reactor模式下不使用）。
+     * @param connHighWater 连接数高水位，达到时暂停accept，0表示不暂停。
+     * @param connLowWater 连接数低水位，降到它以下时恢复accept，0表示取高水位的90%。
+     * @param retryAfterSec 过载时503响应中Retry-After的秒数。
+     * @param metrics 是否开启指标：记录每个请求的耗时，并在/metrics路径以Prometheus文本格式导出。
+     * @param slowRequestMS 慢请求阈值（毫秒）：大于0时记录每个请求各阶段的时间，
+     *        从派发到发送完超过阈值的请求把各阶段耗时写进日志，0表示关闭。
+     * @param drainTimeoutMS 收到SIGTERM后等待在途请求完成的时限（毫秒）。
+     * @param maxBodyKB 请求体上限（KB），Content-Length或chunked累计长度超过时立即回复413并关闭连接，0表示不限制。
+     * @param cpuAffinity 是否绑核：从Reactor、线程池线程（单Reactor模式下还有主Reactor）各占一个核，
+     *        按NUMA节点交错分配；SO_REUSEPORT监听套接字设置SO_INCOMING_CPU，主Reactor把新连接交给
+     *        网卡中断所在核上的从Reactor。
+     * @param housekeepingCpu 日志写线程、数据库线程（多Reactor模式下还有主Reactor）使用的核，
+     *        小于0时取最后一个可用的核。
      */
     WebServer(
         int port, int trigMode, int timeoutMS, 
         int sqlPort, const char* sqlUser, const  char* sqlPwd, 
         const char* dbName, int connPoolNum, int threadNum,
-        bool openLog, int logLevel, int logQueSize);
+        bool openLog, int logLevel, int logQueSize,
+        bool multiReactor = false, bool reusePort = false, int backlog = 1024,
+        bool workStealing = false, bool useSendfile = false, int fileCacheMB = 64,
+        bool timeWheel = false, int keepAliveMax = 100, int keepAliveTimeoutMS = 0,
+        bool accessLog = false, bool ioUring = false,
+        int maxQueue = 0, int maxInFlight = 0, int connHighWater = 0, int connLowWater = 0,
+        int retryAfterSec = 1, bool metrics = false, int slowRequestMS = 0,
+        int drainTimeoutMS = 30000, int maxBodyKB = 1024,
+        bool cpuAffinity = false, int housekeepingCpu = -1);
+
+    /**
+     * @brief 按配置构造，参数含义同上。
+     * @param config 服务器配置。
+     * @param configFile config读取自的配置文件，收到SIGHUP时重新读取；为空时SIGHUP不重载任何配置。
+     */
+    explicit WebServer(const ServerConfig& config, const std::string& configFile = "");
 
     /**
      * @brief 析构函数，清理Web服务器的资源。
@@ -56,6 +125,11 @@ public:
      */
     void Start();
 
+    /**
+     * @brief 异步验证完成（数据库线程调用），把连接交给线程池继续处理。
+     */
+    void ResumeConn(HttpConn* conn, uint32_t gen, bool ok) override;
+
 private:
     /**
      * @brief 初始化服务器套接字。
@@ -63,6 +137,19 @@ private:
      */
     bool InitSocket_(); 
 
+    /**
+     * @brief 创建、绑定并监听一个非阻塞的监听套接字。
+     * @return 成功返回监听套接字，失败返回-1。
+     */
+    int CreateListenFd_();
+
+    /**
+     * @brief 选择接收新连接的从Reactor：绑核时优先选连接的网卡中断所在核上的，否则轮询。
+     * @param fd 新连接的套接字。
+     * @return 从Reactor的下标。
+     */
+    size_t PickReactor_(int fd);
+
     /**
      * @brief 根据给定的触发模式初始化事件模式。
      * @param trigMode 事件触发模式（例如，ET或LT）。
@@ -81,6 +168,16 @@ private:
      */
     void DealListen_();
 
+    /**
+     * @brief 连接数达到高水位时把监听套接字移出epoll，暂停accept。
+     */
+    void PauseAccept_();
+
+    /**
+     * @brief 暂停期间连接数降到低水位以下时重新监听，恢复accept。
+     */
+    void ResumeAccept_();
+
     /**
      * @brief 处理客户端的写事件。
      * @param client 指向HttpConn对象的指针，表示客户端连接。
@@ -93,6 +190,25 @@ private:
      */
     void DealRead_(HttpConn* client);
 
+    /**
+     * @brief 把任务投递给WorkStealingPool或ThreadPool。
+     * @param task 连接指针 + 操作码 + 代数。
+     */
+    void PostTask_(const ConnTask& task);
+
+    /**
+     * @brief 执行线程池投递过来的任务，连接代数已变化的过期任务直接丢弃。
+     * @param task 连接指针 + 操作码 + 代数。
+     */
+    void OnTask_(ConnTask& task);
+
+    /**
+     * @brief 超时回调：连接仍是添加定时器时的那一个才关闭。
+     * @param client 指向HttpConn对象的指针，表示客户端连接。
+     * @param gen 添加定时器时连接的代数。
+     */
+    void OnTimeout_(HttpConn* client, uint32_t gen);
+
     /**
      * @brief 向客户端发送错误信息。
      * @param fd 客户端套接字文件描述符。
@@ -103,8 +219,9 @@ private:
     /**
      * @brief 延长客户端连接的超时时间。
      * @param client 指向HttpConn对象的指针，表示客户端连接。
+     * @param timeoutMS 从现在起的超时时间（毫秒）。
      */
-    void ExtentTime_(HttpConn* client);
+    void ExtentTime_(HttpConn* client, int timeoutMS);
 
     /**
      * @brief 关闭客户端连接。
@@ -136,26 +253,111 @@ private:
     static const int MAX_FD = 65536;
 
     /**
-     * @brief 设置文件描述符为非阻塞模式。
-     * @param fd 文件描述符。
-     * @return 设置成功返回0，否则返回-1。
+     * @brief 启动时预先分配的连接对象数量。
      */
-    static int SetFdNonblock(int fd);
+    static const int RESERVE_CONN = 1024;
+
+    /**
+     * @brief 用户缓存的容量和记录有效期（毫秒）。
+     */
+    static const int USER_CACHE_SIZE = 10000;
+    static const int USER_CACHE_TTL_MS = 60000;
+
+    /**
+     * @brief 注册导出时读取的瞬时值（连接数、队列深度、空闲数据库连接数等）。
+     */
+    void RegisterGauges_();
+
+    /**
+     * @brief 屏蔽由signalfd处理的信号并创建signalfd，加入主Reactor的epoll，信号在事件循环中同步处理。
+     *        需在创建任何线程之前调用，之后创建的线程都继承这个屏蔽字。
+     */
+    void InitSignals_();
+
+    /**
+     * @brief 处理signalfd上的信号：SIGHUP重载配置，SIGUSR2平滑升级，SIGWINCH交接监听，SIGCHLD回收新进程。
+     */
+    void OnSignal_();
+
+    /**
+     * @brief 重新读取配置文件，应用可以在运行中修改的项：日志等级、超时、长连接限制、文件缓存预算、
+     *        线程池线程数和数据库连接池大小；其余改动只记录警告，在平滑升级后生效。
+     */
+    void Reload_();
+
+    /**
+     * @brief 平滑升级：fork并exec磁盘上的新程序，监听套接字通过环境变量WEBSERVER_LISTEN_FDS交给它。
+     *        新进程启动后发SIGWINCH通知本进程交接，启动失败时本进程照常服务。
+     */
+    void Upgrade_();
+
+    /**
+     * @brief 开始排空（SIGTERM/SIGINT，或监听已交给新进程）：停止accept并关闭监听套接字，之后的响应都带
+     *        Connection: close，关闭空闲的长连接；连接全部关闭或超过排空时限后Start()返回。
+     */
+    void Drain_();
+
+    /**
+     * @brief 排空时关闭空闲的长连接：主Reactor模式下关闭停在epoll中等待下一个请求的连接，
+     *        多Reactor模式下让各从Reactor在自己的线程中关闭。
+     */
+    void CloseIdle_();
+
+    /**
+     * @brief 取出从旧进程继承的监听套接字（只保留监听本端口的），并记下需要通知的旧进程。
+     */
+    std::vector<int> InheritListenFds_();
+
+    /**
+     * @brief 优先使用继承的监听套接字，没有时新建一个。
+     * @param inherited 继承的监听套接字，用掉的从头部移除。
+     */
+    int TakeListenFd_(std::vector<int>& inherited);
+
+    /**
+     * @brief 接走多余的继承监听套接字全连接队列中的连接，然后关闭它（新配置的监听套接字比旧进程少时）。
+     */
+    void DrainListenFd_(int fd);
 
     int port_;                 // 服务器监听的端口号
     bool openLinger_;          // 是否开启linger选项
     int timeoutMS_;            // 连接超时时间（毫秒）
+    int keepAliveTimeoutMS_;   // 长连接空闲超时时间（毫秒）
     bool isClose_;             // 服务器是否关闭
+    bool multiReactor_;        // 是否使用多Reactor模式
+    bool reusePort_;           // 是否开启SO_REUSEPORT
+    int backlog_;              // listen的全连接队列长度
     int listenFd_;             // 监听套接字文件描述符
+    bool acceptPaused_;        // 是否因连接数达到高水位暂停了accept
     char* srcDir_;             // 服务器资源目录
 
     uint32_t listenEvent_;     // 监听事件
     uint32_t connEvent_;       // 连接事件
    
-    std::unique_ptr<HeapTimer> timer_;     // 定时器，用于管理连接超时
+    std::unique_ptr<ConnSlab> users_;      // 以fd为下标的连接表，与从Reactor共享；最先构造、最后析构
+    std::unique_ptr<Timer> timer_;         // 定时器（HeapTimer或TimeWheel），用于管理连接超时
     std::unique_ptr<ThreadPool> threadpool_; // 线程池，用于处理客户端请求
+    std::unique_ptr<WorkStealingPool<ConnTask>> stealpool_; // 工作窃取线程池，与threadpool_二选一
     std::unique_ptr<Epoller> epoller_;       // epoll实例，用于I/O多路复用
-    std::unordered_map<int, HttpConn> users_; // 存储所有客户端连接的映射表
+
+    std::vector<std::unique_ptr<IoBackend>> reactors_;  // 多Reactor模式下的从Reactor（epoll或io_uring后端）
+    size_t nextReactor_;                                // 下一个接收新连接的从Reactor（轮询）
+    std::vector<int> cpuReactor_;                       // 绑核时CPU -> 绑在该核上的从Reactor，-1表示没有
+    int mainCpu_;                                       // 主Reactor线程绑定的CPU，-1表示不绑核
+
+    ServerConfig config_;          // 当前生效的配置，重载时与配置文件比较
+    std::string configFile_;       // 配置文件路径，为空时不支持重载
+    int signalFd_;                 // 接收SIGHUP/SIGUSR2/SIGWINCH/SIGCHLD的signalfd
+    std::vector<int> listenFds_;   // 本进程所有的监听套接字（主Reactor或从Reactor的），升级时交给新进程
+    pid_t upgradePid_;             // 升级中的新进程，0表示没有
+    pid_t upgradeParent_;          // 本进程是升级启动的新进程时，需要通知交接的旧进程
+    bool draining_;                // 正在排空，连接处理完或超时后退出
+    int drainTimeoutMS_;           // 排空时限（毫秒）
+    int64_t drainDeadlineMs_;      // 排空截止时间（steady_clock毫秒）
+    int64_t nextSweepMs_;          // 排空时下一次检查空闲连接的时间
+    // 主Reactor模式下每个fd一个：连接停在epoll中等待下一个请求、没有交给工作线程时为true，
+    // 排空时主线程用exchange取得这样的连接并关闭，不会与工作线程同时处理同一个连接
+    std::unique_ptr<std::atomic<bool>[]> idle_;
 };
 
 #endif //WEBSERVER_H
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "heaptimer.h"
 
+using namespace std;
+
 void HeapTimer::SwapNode_(size_t i, size_t j) {
     // 确保索引 i 和 j 在堆的有效范围内
     assert(i >= 0 && i < heap_.size());
@@ -14,18 +16,16 @@ void HeapTimer::SwapNode_(size_t i, size_t j) {
 void HeapTimer::siftup_(size_t i) {
     // 确保索引 i 在堆的有效范围内
     assert(i >= 0 && i < heap_.size());
-    // 计算父节点的索引
-    size_t parent = (i-1) / 2;
-    // 当父节点存在时
-    while(parent >= 0) {
+    // 当父节点存在时（i为0时已经是堆顶，size_t下(i-1)/2会回绕）
+    while(i > 0) {
+        // 计算父节点的索引
+        size_t parent = (i-1) / 2;
         // 如果父节点的过期时间大于当前节点的过期时间
         if(heap_[parent] > heap_[i]) {
             // 交换当前节点和父节点
             SwapNode_(i, parent);
             // 更新当前节点的索引为父节点的索引
             i = parent;
-            // 重新计算父节点的索引
-            parent = (i-1)/2;
         } else {
             // 如果父节点的过期时间不大于当前节点的过期时间，说明已经满足堆的性质，跳出循环
             break;
@@ -92,12 +92,26 @@ void HeapTimer::del_(size_t index) {
 
 // 调整指定id的结点
 void HeapTimer::adjust(int id, int newExpires) {
-    // 确保堆不为空且 id 存在于 ref_ 映射表中
-    assert(!heap_.empty() && ref_.count(id));
+    // id 不存在（连接已关闭并取消了定时器）时忽略
+    auto it = ref_.find(id);
+    if(it == ref_.end()) {
+        return;
+    }
+    size_t i = it->second;
     // 更新指定 id 的节点的过期时间
-    heap_[ref_[id]].expires = Clock::now() + MS(newExpires);
-    // 调整节点的位置，使其满足堆的性质
-    siftdown_(ref_[id], heap_.size());
+    heap_[i].expires = Clock::now() + MS(newExpires);
+    // 调整节点的位置，使其满足堆的性质（超时时间可能变长也可能变短）
+    if(!siftdown_(i, heap_.size())) {
+        siftup_(i);
+    }
+}
+
+// 删除指定id，不触发回调函数
+void HeapTimer::cancel(int id) {
+    auto it = ref_.find(id);
+    if(it != ref_.end()) {
+        del_(it->second);
+    }
 }
 
 void HeapTimer::add(int id, int timeOut, const TimeoutCallBack& cb) {
@@ -138,10 +152,10 @@ void HeapTimer::doWork(int id) {
     size_t i = ref_[id];
     // 获取 id 对应的节点
     auto node = heap_[i];
+    // 先从堆中删除该节点，回调中可能再次操作定时器
+    del_(i);
     // 执行节点的回调函数
     node.cb();
-    // 从堆中删除该节点
-    del_(i);
 }
 
 void HeapTimer::tick() {
@@ -159,10 +173,10 @@ void HeapTimer::tick() {
             // 如果差值大于0，说明节点还未过期，跳出循环
             break; 
         }
+        // 先从堆中删除该节点，回调中可能再次操作定时器
+        pop();
         // 执行节点的回调函数
         node.cb();
-        // 从堆中删除该节点
-        pop();
     }
 }
 
@@ -194,4 +208,15 @@ int HeapTimer::GetNextTick() {
     }
     // 返回结果
     return res;
+}
+
+int64_t HeapTimer::GetNextTickUs() {
+    tick();
+    if(heap_.empty()) {
+        return -1;
+    }
+    // 按毫秒截断时，不足1毫秒的等待会变成0，事件循环空转到定时器到期
+    int64_t res = std::chrono::duration_cast<std::chrono::microseconds>(
+                    heap_.front().expires - Clock::now()).count();
+    return res > 0 ? res : 0;
 }
\ No newline at end of file
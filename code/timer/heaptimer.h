@@ -10,15 +10,7 @@
 #include <assert.h> 
 #include <chrono>
 #include "../log/log.h"
-
-// 定义一个函数对象类型，用于表示超时回调函数
-typedef std::function<void()> TimeoutCallBack;
-// 定义一个高精度时钟类型
-typedef std::chrono::high_resolution_clock Clock;
-// 定义一个毫秒时间单位类型
-typedef std::chrono::milliseconds MS;
-// 定义一个时间戳类型
-typedef Clock::time_point TimeStamp;
+#include "timer.h"
 
 // 定义一个结构体，表示定时器节点
 struct TimerNode {
@@ -38,7 +30,7 @@ struct TimerNode {
 };
 
 // 定义一个类，表示基于堆的定时器
-class HeapTimer {
+class HeapTimer : public Timer {
 public:
     // 默认构造函数，初始化堆的容量为64
     HeapTimer() { heap_.reserve(64); }
@@ -46,19 +38,25 @@ public:
     ~HeapTimer() { clear(); }
 
     // 调整指定id的定时器的过期时间
-    void adjust(int id, int newExpires);
+    void adjust(int id, int newExpires) override;
     // 添加一个新的定时器
-    void add(int id, int timeOut, const TimeoutCallBack& cb);
+    void add(int id, int timeOut, const TimeoutCallBack& cb) override;
+    // 删除指定id的定时器，不执行回调
+    void cancel(int id) override;
     // 执行指定id的定时器的回调函数，并从堆中删除该定时器
-    void doWork(int id);
+    void doWork(int id) override;
     // 清空所有定时器
-    void clear();
+    void clear() override;
     // 检查并执行所有已过期的定时器的回调函数，并从堆中删除这些定时器
-    void tick();
+    void tick() override;
     // 删除堆顶的定时器（即最早过期的定时器）
     void pop();
     // 获取下一个定时器的过期时间与当前时间的差值
-    int GetNextTick();
+    int GetNextTick() override;
+    // 同GetNextTick，以微秒为单位，不截断到毫秒
+    int64_t GetNextTickUs() override;
+    // 当前定时器个数
+    size_t size() const override { return heap_.size(); }
 
 private:
     // 删除指定索引位置的定时器节点
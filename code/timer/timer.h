@@ -0,0 +1,84 @@
+#ifndef TIMER_H
+#define TIMER_H
+
+#include <functional>
+#include <chrono>
+#include <stddef.h>
+#include <stdint.h>
+
+// 定义一个函数对象类型，用于表示超时回调函数
+typedef std::function<void()> TimeoutCallBack;
+// 定义一个高精度时钟类型
+typedef std::chrono::high_resolution_clock Clock;
+// 定义一个毫秒时间单位类型
+typedef std::chrono::milliseconds MS;
+// 定义一个时间戳类型
+typedef Clock::time_point TimeStamp;
+
+/**
+ * @brief 连接定时器接口，由HeapTimer（小根堆）和TimeWheel（时间轮）实现。
+ *
+ * 定时器以id（连接的fd）为键，只在所属事件循环线程中使用，不是线程安全的。
+ * 回调执行前对应的定时器已被移除，回调中可以安全地对同一id调用cancel/add。
+ */
+class Timer {
+public:
+    virtual ~Timer() = default;
+
+    /**
+     * @brief 添加定时器，id已存在时更新超时时间和回调
+     * @param id 定时器id
+     * @param timeOut 超时时间（毫秒）
+     * @param cb 超时回调
+     */
+    virtual void add(int id, int timeOut, const TimeoutCallBack& cb) = 0;
+
+    /**
+     * @brief 重新设置id的超时时间，id不存在时忽略
+     * @param id 定时器id
+     * @param newExpires 从现在起的超时时间（毫秒）
+     */
+    virtual void adjust(int id, int newExpires) = 0;
+
+    /**
+     * @brief 删除id的定时器且不执行回调，id不存在时忽略
+     */
+    virtual void cancel(int id) = 0;
+
+    /**
+     * @brief 删除id的定时器并立即执行回调
+     */
+    virtual void doWork(int id) = 0;
+
+    /**
+     * @brief 清空所有定时器
+     */
+    virtual void clear() = 0;
+
+    /**
+     * @brief 执行所有已超时的定时器
+     */
+    virtual void tick() = 0;
+
+    /**
+     * @brief 执行已超时的定时器，并返回距离下一次超时的毫秒数（没有定时器时返回-1）
+     */
+    virtual int GetNextTick() = 0;
+
+    /**
+     * @brief 与GetNextTick相同，但以微秒为单位（没有定时器时返回-1），配合Epoller::WaitUs使用
+     *
+     * 默认由GetNextTick换算，精度仍是毫秒；HeapTimer按实际到期时间计算。
+     */
+    virtual int64_t GetNextTickUs() {
+        int ms = GetNextTick();
+        return ms < 0 ? -1 : static_cast<int64_t>(ms) * 1000;
+    }
+
+    /**
+     * @brief 当前定时器个数
+     */
+    virtual size_t size() const = 0;
+};
+
+#endif //TIMER_H
@@ -0,0 +1,164 @@
+#include "timewheel.h"
+
+TimeWheel::TimeWheel(int tickMS, size_t slotCount)
+    : tickMS_(tickMS), mask_(slotCount - 1), slots_(slotCount, NIL),
+      cursor_(NowMS_() / tickMS), count_(0) {
+    // 槽位数量必须是2的幂，取模用位与代替
+    assert(tickMS > 0 && slotCount > 0 && (slotCount & (slotCount - 1)) == 0);
+    nodes_.reserve(64);
+}
+
+int64_t TimeWheel::NowMS_() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void TimeWheel::Link_(int id) {
+    Node& node = nodes_[id];
+    // 向上取整到格子，保证不会提前触发；已经过去的时间挂到当前格子
+    int64_t t = (node.expires + tickMS_ - 1) / tickMS_;
+    if(t < cursor_) { t = cursor_; }
+    size_t slot = t & mask_;
+    node.tick = t;
+    node.slot = static_cast<int>(slot);
+    // 头插法插入槽位链表
+    node.prev = NIL;
+    node.next = slots_[slot];
+    if(node.next != NIL) { nodes_[node.next].prev = id; }
+    slots_[slot] = id;
+}
+
+void TimeWheel::Unlink_(int id) {
+    Node& node = nodes_[id];
+    assert(node.slot >= 0);
+    if(node.prev != NIL) { nodes_[node.prev].next = node.next; }
+    else { slots_[node.slot] = node.next; }
+    if(node.next != NIL) { nodes_[node.next].prev = node.prev; }
+    node.prev = node.next = NIL;
+    node.slot = UNLINKED;
+}
+
+void TimeWheel::add(int id, int timeOut, const TimeoutCallBack& cb) {
+    // 确保 id 大于等于 0
+    assert(id >= 0);
+    if(static_cast<size_t>(id) >= nodes_.size()) {
+        nodes_.resize(id + 1, Node{NIL, NIL, UNLINKED, 0, 0, nullptr});
+    }
+    Node& node = nodes_[id];
+    if(node.slot == UNLINKED) {
+        count_++;
+    } else if(node.slot >= 0) {
+        Unlink_(id);
+    }
+    node.expires = NowMS_() + timeOut;
+    node.cb = cb;
+    // 正在等待重新挂入的节点由ProcessSlot_统一挂入
+    if(node.slot != REQUEUE) {
+        Link_(id);
+    }
+}
+
+void TimeWheel::adjust(int id, int newExpires) {
+    // id 不存在或已取消时忽略
+    if(id < 0 || static_cast<size_t>(id) >= nodes_.size() || nodes_[id].slot == UNLINKED) {
+        return;
+    }
+    Node& node = nodes_[id];
+    node.expires = NowMS_() + newExpires;
+    // 超时变长时只改到期时间，扫到旧槽位时再重新挂入；变短时需要立刻移到更早的槽位
+    if(node.slot >= 0 && (node.expires + tickMS_ - 1) / tickMS_ < node.tick) {
+        Unlink_(id);
+        Link_(id);
+    }
+}
+
+void TimeWheel::cancel(int id) {
+    if(id < 0 || static_cast<size_t>(id) >= nodes_.size() || nodes_[id].slot == UNLINKED) {
+        return;
+    }
+    Node& node = nodes_[id];
+    if(node.slot >= 0) {
+        Unlink_(id);
+    }
+    // REQUEUE的节点标记为UNLINKED后，ProcessSlot_不会再挂入
+    node.slot = UNLINKED;
+    node.cb = nullptr;
+    count_--;
+}
+
+void TimeWheel::doWork(int id) {
+    if(id < 0 || static_cast<size_t>(id) >= nodes_.size() || nodes_[id].slot == UNLINKED) {
+        return;
+    }
+    // 先移除定时器再执行回调
+    TimeoutCallBack cb;
+    cb.swap(nodes_[id].cb);
+    cancel(id);
+    if(cb) { cb(); }
+}
+
+void TimeWheel::clear() {
+    for(auto& head : slots_) { head = NIL; }
+    nodes_.clear();
+    requeue_.clear();
+    count_ = 0;
+}
+
+void TimeWheel::ProcessSlot_(size_t slot, int64_t now) {
+    int id;
+    while((id = slots_[slot]) != NIL) {
+        Unlink_(id);
+        if(nodes_[id].expires <= now) {
+            // 先移除再执行回调，回调中可能对任意id调用add/cancel（nodes_可能扩容，不能持有引用）
+            TimeoutCallBack cb;
+            cb.swap(nodes_[id].cb);
+            count_--;
+            if(cb) { cb(); }
+        } else {
+            // 续期过或者超过一圈的定时器，处理完本槽位后再挂入，避免挂回本槽位造成死循环
+            nodes_[id].slot = REQUEUE;
+            requeue_.push_back(id);
+        }
+    }
+    for(int rid : requeue_) {
+        if(nodes_[rid].slot == REQUEUE) {
+            Link_(rid);
+        }
+    }
+    requeue_.clear();
+}
+
+void TimeWheel::tick() {
+    int64_t now = NowMS_();
+    int64_t nowTick = now / tickMS_;
+    if(count_ == 0) {
+        cursor_ = nowTick + 1;
+        return;
+    }
+    // 长时间没有调用时最多扫一圈：每个节点都会被检查一次，该触发的触发，其余按当前时间重新挂入
+    size_t steps = 0;
+    while(cursor_ <= nowTick && count_ > 0 && steps <= mask_) {
+        ProcessSlot_(cursor_ & mask_, now);
+        cursor_++;
+        steps++;
+    }
+    if(cursor_ <= nowTick) {
+        cursor_ = nowTick + 1;
+    }
+}
+
+int TimeWheel::GetNextTick() {
+    tick();
+    if(count_ == 0) {
+        return -1;
+    }
+    // 找到下一个非空槽位，最多一圈
+    int64_t t = cursor_;
+    for(size_t i = 0; i <= mask_; i++, t++) {
+        if(slots_[t & mask_] != NIL) {
+            break;
+        }
+    }
+    int64_t res = t * tickMS_ - NowMS_();
+    return res > 0 ? static_cast<int>(res) : 0;
+}
@@ -0,0 +1,79 @@
+#ifndef TIME_WHEEL_H
+#define TIME_WHEEL_H
+
+#include <vector>
+#include <chrono>
+#include <stdint.h>
+#include <assert.h>
+#include "timer.h"
+
+/**
+ * @brief 哈希时间轮定时器。
+ *
+ * 时间被划分为tickMS毫秒的格子，slotCount个槽位首尾相连，定时器按到期的格子编号挂到对应槽位的
+ * 侵入式双向链表上。节点按id（连接fd）直接存放在数组中，不需要哈希表查找，add/adjust/cancel都是O(1)：
+ *  - 延长超时（keep-alive连接每个事件都会续期，是最常见的操作）只修改到期时间，不移动节点，
+ *    等指针扫到该槽位时发现还没到期再挂到新的槽位（惰性重排）；
+ *  - 超过一圈的定时器同样在每圈经过时重新挂入，无需多层时间轮。
+ * 到期精度为一个格子，适合连接空闲超时这类对精度要求不高的场景。
+ */
+class TimeWheel : public Timer {
+public:
+    /**
+     * @brief 构造函数
+     * @param tickMS 每个格子的时间跨度（毫秒）
+     * @param slotCount 槽位数量，必须是2的幂
+     */
+    explicit TimeWheel(int tickMS = 100, size_t slotCount = 512);
+    ~TimeWheel() { clear(); }
+
+    void add(int id, int timeOut, const TimeoutCallBack& cb) override;
+    void adjust(int id, int newExpires) override;
+    void cancel(int id) override;
+    void doWork(int id) override;
+    void clear() override;
+    void tick() override;
+    int GetNextTick() override;
+    size_t size() const override { return count_; }
+
+private:
+    static const int NIL = -1;          // 空链表/无后继
+    static const int UNLINKED = -1;     // 节点不在任何槽位中（未启用）
+    static const int REQUEUE = -2;      // 节点正等待重新挂入槽位
+
+    struct Node {
+        int prev;               // 同一槽位中的前一个节点
+        int next;               // 同一槽位中的后一个节点
+        int slot;               // 所在槽位，UNLINKED/REQUEUE表示不在链表中
+        int64_t tick;           // 所在槽位对应的格子编号
+        int64_t expires;        // 到期时间（毫秒）
+        TimeoutCallBack cb;     // 超时回调
+    };
+
+    static int64_t NowMS_();
+
+    /**
+     * @brief 把节点按到期时间挂到对应槽位
+     */
+    void Link_(int id);
+
+    /**
+     * @brief 把节点从所在槽位摘下
+     */
+    void Unlink_(int id);
+
+    /**
+     * @brief 处理一个槽位：执行已到期的定时器，未到期的重新挂入
+     */
+    void ProcessSlot_(size_t slot, int64_t now);
+
+    const int tickMS_;              // 格子的时间跨度
+    const size_t mask_;             // 槽位下标掩码
+    std::vector<int> slots_;        // 每个槽位链表的头节点
+    std::vector<Node> nodes_;       // 以id为下标的节点
+    std::vector<int> requeue_;      // 处理槽位时暂存未到期的节点
+    int64_t cursor_;                // 下一个要处理的格子编号
+    size_t count_;                  // 启用中的定时器个数
+};
+
+#endif //TIME_WHEEL_H
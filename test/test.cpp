@@ -1,7 +1,35 @@
 // 包含日志模块的头文件
 #include "../code/log/log.h"
+#include "../code/log/logring.h"
+#include "../code/log/accesslog.h"
+#include "../code/log/metrics.h"
+#include "../code/log/trace.h"
 // 包含线程池模块的头文件
 #include "../code/pool/threadpool.h"
+// 包含工作窃取线程池模块的头文件
+#include "../code/pool/stealpool.h"
+#include "../code/pool/sqlexecutor.h"
+#include "../code/pool/usercache.h"
+#include "../code/pool/cpuaffinity.h"
+// 包含缓冲区模块的头文件
+#include "../code/buffer/buffer.h"
+#include "../code/buffer/bufferpool.h"
+// 包含时间轮定时器模块的头文件
+#include "../code/timer/timewheel.h"
+#include "../code/server/connslab.h"
+#include "../code/server/epoller.h"
+#include "../code/server/uring.h"
+#include "../code/server/admission.h"
+#include "../code/server/config.h"
+#include "../code/timer/heaptimer.h"
+#include "../code/http/httprequest.h"
+#include "../code/http/httpresponse.h"
+#include "../code/http/httpconn.h"
+#include <fcntl.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <algorithm>
+#include <string>
 // 包含特性测试宏的头文件
 #include <features.h>
 
@@ -55,6 +83,125 @@ void TestLog() {
     }
 }
 
+/**
+ * @brief 测试日志无锁环形队列
+ *
+ * 多个生产者线程并发写入，单个消费者检查每一行都恰好收到一次、且每个生产者的顺序不变；
+ * 同时检查队列满和单行过长时TryPush返回false。
+ */
+void TestLogRing() {
+    LogRing full(4);
+    assert(full.Capacity() == 4);
+    for(int i = 0; i < 4; i++) {
+        assert(full.TryPush("x", 1));
+    }
+    assert(!full.TryPush("x", 1));
+    std::string big(LogRing::SLOT_DATA_SIZE + 1, 'a');
+    assert(!full.TryPush(big.data(), big.size()));
+    assert(full.Consume([](const char*, size_t) {}, 100) == 4);
+    assert(full.Empty());
+
+    const int PRODUCERS = 4, LINES = 20000;
+    LogRing ring(256);
+    std::vector<std::thread> producers;
+    for(int id = 0; id < PRODUCERS; id++) {
+        producers.emplace_back([&ring, id]() {
+            char line[32];
+            for(int i = 0; i < LINES; i++) {
+                int n = snprintf(line, sizeof(line), "%d %d\n", id, i);
+                while(!ring.TryPush(line, n)) { std::this_thread::yield(); }
+            }
+        });
+    }
+    std::vector<int> next(PRODUCERS, 0);
+    int total = 0;
+    while(total < PRODUCERS * LINES) {
+        total += ring.Consume([&next](const char* data, size_t len) {
+            std::string line(data, len);
+            int id = -1, i = -1;
+            sscanf(line.c_str(), "%d %d", &id, &i);
+            assert(id >= 0 && id < (int)next.size() && i == next[id]);
+            next[id]++;
+        }, 64);
+    }
+    for(auto& t : producers) { t.join(); }
+    assert(ring.Empty());
+    for(int id = 0; id < PRODUCERS; id++) { assert(next[id] == LINES); }
+    printf("TestLogRing: %d lines consumed\n", total);
+}
+
+/**
+ * @brief 测试二进制访问日志
+ *
+ * 单个文件只能放10条记录，写入25条后应切换出3个文件（10、10、5条），文件头和记录都能原样读回。
+ */
+void TestAccessLog() {
+    const size_t PER_FILE = 10;
+    const int TOTAL = 25;
+    system("rm -rf ./testaccess");
+    AccessLog::Instance()->Init("./testaccess", ".access",
+                                AccessLog::FILE_HEADER_SIZE + PER_FILE * sizeof(AccessRecord), 64);
+    for(int i = 0; i < TOTAL; i++) {
+        AccessRecord record;
+        memset(&record, 0, sizeof(record));
+        record.timeUs = AccessLog::NowUs();
+        record.latencyUs = i;
+        record.bytes = 1000 + i;
+        record.clientIp = htonl(INADDR_LOOPBACK);
+        record.clientPort = htons(1316);
+        record.status = 200;
+        memcpy(record.method, "GET", 3);
+        record.pathLen = snprintf(record.path, sizeof(record.path), "/%d.html", i);
+        while(!AccessLog::Instance()->Append(record)) { std::this_thread::yield(); }
+    }
+    AccessLog::Instance()->Close();
+    assert(AccessLog::Instance()->Written() == (uint64_t)TOTAL);
+
+    time_t now = time(nullptr);
+    struct tm t;
+    localtime_r(&now, &t);
+    int next = 0;
+    for(int index = 0; index < 3; index++) {
+        char name[256];
+        if(index == 0) {
+            snprintf(name, sizeof(name), "./testaccess/%04d_%02d_%02d.access", t.tm_year + 1900, t.tm_mon + 1, t.tm_mday);
+        } else {
+            snprintf(name, sizeof(name), "./testaccess/%04d_%02d_%02d-%d.access", t.tm_year + 1900, t.tm_mon + 1, t.tm_mday, index);
+        }
+        FILE* fp = fopen(name, "rb");
+        assert(fp);
+        uint32_t header[4];
+        assert(fread(header, 1, sizeof(header), fp) == sizeof(header));
+        assert(header[0] == AccessLog::FILE_MAGIC && header[2] == sizeof(AccessRecord));
+        AccessRecord record;
+        while(fread(&record, 1, sizeof(record), fp) == sizeof(record)) {
+            assert(record.latencyUs == (uint32_t)next && record.bytes == (uint32_t)(1000 + next));
+            char line[512];
+            AccessLog::Format(record, line, sizeof(line), false);
+            char expect[128];
+            snprintf(expect, sizeof(expect), "127.0.0.1:1316 \"GET /%d.html\" 200 %d %dus", next, 1000 + next, next);
+            assert(strstr(line, expect));
+            next++;
+        }
+        fclose(fp);
+        assert(next == std::min((index + 1) * (int)PER_FILE, TOTAL));
+    }
+    // JSON格式转义引号、反斜杠和控制字符，路径占满时也不截断
+    AccessRecord record;
+    memset(&record, 0, sizeof(record));
+    memcpy(record.method, "G\tT", 3);
+    record.pathLen = snprintf(record.path, sizeof(record.path), "/a\"b\\c\x01\x1f\x7f");
+    char line[AccessLog::MAX_LINE];
+    AccessLog::Format(record, line, sizeof(line), true);
+    assert(strstr(line, "\"method\":\"G\\u0009T\""));
+    assert(strstr(line, "\"path\":\"/a\\\"b\\\\c\\u0001\\u001f\x7f\""));
+    memset(record.path, '\n', sizeof(record.path));
+    record.pathLen = sizeof(record.path);
+    int n = AccessLog::Format(record, line, sizeof(line), true);
+    assert(n > 0 && line[n - 1] == '}' && (size_t)n < sizeof(line) - 1);
+    printf("TestAccessLog: %d records in 3 files\n", next);
+}
+
 /**
  * @brief 线程日志任务
  * 
@@ -90,6 +237,1294 @@ void TestThreadPool() {
     getchar();
 }
 
+/**
+ * @brief 测试预压缩文件的选择
+ *
+ * 检查Accept-Encoding的解析（q=0和"*"），以及FileCache加载的.gz兄弟文件只发给接受gzip的客户端。
+ */
+void TestPrecompressed() {
+    const char* cases[][2] = {
+        {"gzip, deflate, br", "3"}, {"gzip;q=0.5", "1"}, {"br;q=0, gzip", "1"},
+        {"gzip;q=0", "0"}, {"gzip;q=0, *", "2"}, {"identity", "0"}, {"", "0"},
+    };
+    for(auto& c : cases) {
+        std::string raw = std::string("GET /a.css HTTP/1.1\r\n") +
+                          (c[0][0] ? std::string("Accept-Encoding: ") + c[0] + "\r\n" : "") + "\r\n";
+        Buffer buff(0);
+        buff.Append(raw);
+        HttpRequest request;
+        assert(request.parse(buff) && request.IsFinished());
+        assert(request.AcceptEncoding() == atoi(c[1]));
+    }
+
+    system("rm -rf ./testgzip && mkdir -p ./testgzip");
+    std::string plain(4096, 'a');
+    FILE* fp = fopen("./testgzip/a.css", "w");
+    fwrite(plain.data(), 1, plain.size(), fp);
+    fclose(fp);
+    fp = fopen("./testgzip/a.css.gz", "w");
+    fwrite("compressed", 1, 10, fp);
+    fclose(fp);
+
+    FileCache::Instance()->Init(1 << 20, true);
+    std::string srcDir = "./testgzip";
+    int fileLens[2] = {0, 0};
+    for(int gzip = 0; gzip < 2; gzip++) {
+        std::string path = "/a.css";
+        HttpResponse response;
+        Buffer buff(0);
+        response.Init(srcDir, path, false, 200);
+        response.SetAcceptEncoding(gzip ? HttpRequest::ENCODING_GZIP : HttpRequest::ENCODING_BR);
+        response.MakeResponse(buff);
+        std::string header = buff.RetrieveAllToStr();
+        assert(response.Code() == 200);
+        assert(header.find("Vary: Accept-Encoding\r\n") != std::string::npos);
+        assert((header.find("Content-Encoding: gzip\r\n") != std::string::npos) == (gzip == 1));
+        fileLens[gzip] = (int)response.FileLen();
+    }
+    assert(fileLens[0] == (int)plain.size() && fileLens[1] == 10);
+    FileCache::Instance()->Clear();
+    printf("TestPrecompressed: %d / %d bytes\n", fileLens[1], fileLens[0]);
+}
+
+/**
+ * @brief 测试工作窃取线程池功能
+ * 
+ * 该函数向工作窃取线程池投递固定大小的任务句柄，并检查每个任务都恰好执行了一次。
+ */
+// 按给定的请求头生成一次/a.txt的响应，返回响应头
+static std::string ConditionalResponse(HttpResponse& response, const std::string& headers) {
+    std::string raw = "GET /a.txt HTTP/1.1\r\n" + headers + "\r\n";
+    Buffer in(0);
+    in.Append(raw);
+    HttpRequest request;
+    assert(request.parse(in) && request.IsFinished());
+    std::string srcDir = "./testrange", path = "/a.txt";
+    Buffer out(0);
+    response.Init(srcDir, path, false, 200);
+    response.SetConditional(request);
+    response.MakeResponse(out);
+    return out.RetrieveAllToStr();
+}
+
+void TestConditionalRange() {
+    system("rm -rf ./testrange && mkdir -p ./testrange");
+    std::string content;
+    for(int i = 0; i < 1000; i++) { content += (char)('a' + i % 26); }
+    FILE* fp = fopen("./testrange/a.txt", "w");
+    fwrite(content.data(), 1, content.size(), fp);
+    fclose(fp);
+    FileCache::Instance()->Init(1 << 20, true);
+
+    HttpResponse response;
+    std::string header = ConditionalResponse(response, "");
+    assert(response.Code() == 200 && response.FileLen() == content.size());
+    assert(header.find("Accept-Ranges: bytes\r\n") != std::string::npos);
+    size_t pos = header.find("ETag: ");
+    assert(pos != std::string::npos);
+    std::string etag = header.substr(pos + 6, header.find("\r\n", pos) - pos - 6);
+    pos = header.find("Last-Modified: ");
+    assert(pos != std::string::npos);
+    std::string lastModified = header.substr(pos + 15, header.find("\r\n", pos) - pos - 15);
+
+    // 条件请求：匹配时304且没有响应体
+    ConditionalResponse(response, "If-None-Match: \"x\", W/" + etag + "\r\n");
+    assert(response.Code() == 304 && response.FileLen() == 0);
+    header = ConditionalResponse(response, "If-Modified-Since: " + lastModified + "\r\n");
+    assert(response.Code() == 304 && header.find("Content-length") == std::string::npos);
+    ConditionalResponse(response, "If-None-Match: \"x\"\r\nIf-Modified-Since: " + lastModified + "\r\n");
+    assert(response.Code() == 200);
+    ConditionalResponse(response, "If-Modified-Since: Sat, 01 Jan 2000 00:00:00 GMT\r\n");
+    assert(response.Code() == 200);
+
+    // Range请求：{Range, 状态码, 起始偏移, 长度}
+    struct { const char* range; int code; size_t offset, len; } cases[] = {
+        {"bytes=0-99", 206, 0, 100}, {"bytes=990-", 206, 990, 10}, {"bytes=-10", 206, 990, 10},
+        {"bytes=-5000", 206, 0, 1000}, {"bytes=900-5000", 206, 900, 100}, {"bytes=1000-", 416, 0, 0},
+        {"bytes=-0", 416, 0, 0}, {"bytes=0-1,5-6", 200, 0, 1000}, {"bytes=9-1", 200, 0, 1000},
+        {"items=0-1", 200, 0, 1000},
+    };
+    for(auto& c : cases) {
+        header = ConditionalResponse(response, std::string("Range: ") + c.range + "\r\n");
+        assert(response.Code() == c.code && response.FileLen() == c.len);
+        if(c.code == 206) {
+            assert(response.FileOffset() == (off_t)c.offset);
+            assert(memcmp(response.File(), content.data() + c.offset, c.len) == 0);
+            char expect[128];
+            snprintf(expect, sizeof(expect), "Content-Range: bytes %zu-%zu/1000\r\nContent-length: %zu\r\n",
+                     c.offset, c.offset + c.len - 1, c.len);
+            assert(header.find(expect) != std::string::npos);
+        } else if(c.code == 416) {
+            assert(header.find("Content-Range: bytes */1000\r\n") != std::string::npos);
+        }
+    }
+    // If-Range不匹配时忽略Range
+    ConditionalResponse(response, "Range: bytes=0-9\r\nIf-Range: " + etag + "\r\n");
+    assert(response.Code() == 206 && response.FileLen() == 10);
+    ConditionalResponse(response, "Range: bytes=0-9\r\nIf-Range: \"stale\"\r\n");
+    assert(response.Code() == 200 && response.FileLen() == content.size());
+    response.UnmapFile();
+    FileCache::Instance()->Clear();
+    printf("TestConditionalRange: %s %s\n", etag.c_str(), lastModified.c_str());
+}
+
+void TestWorkStealingPool() {
+    // 任务句柄：计数器下标 + 增量
+    struct CountTask {
+        int idx;
+        int delta;
+    };
+    const int N = 100000;
+    std::vector<std::atomic<int>> counts(4);
+    for(auto& c : counts) { c = 0; }
+    {
+        // 创建一个包含4个线程、每个队列容量为64的工作窃取线程池，队列很小以便覆盖满队列时调用者执行的路径
+        WorkStealingPool<CountTask> pool(4, [&counts](CountTask& t) {
+            counts[t.idx] += t.delta;
+        }, 64);
+        for(int i = 0; i < N; i++) {
+            pool.AddTask(CountTask{i % 4, 1});
+        }
+    }   // 析构时处理完剩余任务并join工作线程
+    int total = 0;
+    for(auto& c : counts) { total += c; }
+    assert(total == N);
+    printf("TestWorkStealingPool: %d tasks done\n", total);
+}
+
+/**
+ * @brief 测试缓冲区的分隔符扫描
+ * 
+ * 用随机的 "\r\n" 和分隔符字符构造数据，在所有起止位置上与 std::search / std::find_first_of 的结果对比，
+ * 覆盖向量实现中跨越向量边界和尾部标量处理的情况。
+ */
+void TestSqlExecutor() {
+    // 连接池没有初始化时任务拿到nullptr，只验证调度：任务都在数据库线程执行且全部完成
+    SqlExecutor* executor = SqlExecutor::Instance();
+    executor->Init(SqlConnPool::Instance(), 2);
+    const int TASKS = 1000;
+    std::atomic<int> done(0), nullConn(0), onMain(0);
+    std::thread::id mainId = std::this_thread::get_id();
+    for(int i = 0; i < TASKS; i++) {
+        assert(executor->AddTask([&](MYSQL* sql) {
+            if(!sql) { nullConn++; }
+            if(std::this_thread::get_id() == mainId) { onMain++; }
+            done++;
+        }));
+    }
+    while(done < TASKS) { usleep(1000); }
+
+    // 调整线程数后同时执行的任务数不超过新的线程数
+    std::atomic<int> running(0), peak(0), resized(0);
+    auto probe = [&](MYSQL*) {
+        int now = ++running;
+        int prev = peak.load();
+        while(now > prev && !peak.compare_exchange_weak(prev, now)) {}
+        usleep(2000);
+        running--;
+        resized++;
+    };
+    executor->Resize(4);
+    assert(executor->ThreadCount() == 4);
+    for(int i = 0; i < 40; i++) { assert(executor->AddTask(probe)); }
+    while(resized < 40) { usleep(1000); }
+    assert(peak <= 4 && peak > 1);
+    executor->Resize(1);
+    assert(executor->ThreadCount() == 1);
+    peak = 0;
+    for(int i = 0; i < 20; i++) { assert(executor->AddTask(probe)); }
+    while(resized < 60) { usleep(1000); }
+    assert(peak == 1);
+    executor->Resize(3);
+    assert(executor->ThreadCount() == 3);
+
+    executor->Stop();
+    assert(!executor->IsRunning() && !executor->AddTask([](MYSQL*) {}));
+    assert(nullConn == TASKS && onMain == 0);
+    printf("TestSqlExecutor: %d tasks done, resize peak ok\n", done.load());
+}
+
+void TestUserCache() {
+    UserCache* cache = UserCache::Instance();
+    // 容量8、2个分片（每个分片4条），有效期200ms
+    cache->Init(8, 200, 2);
+    std::string pwd;
+    assert(!cache->Get("nobody", &pwd));
+    for(int i = 0; i < 100; i++) {
+        cache->Put("user" + std::to_string(i), "pwd" + std::to_string(i));
+    }
+    // 每个分片只保留最近写入的记录
+    assert(cache->Size() == 8);
+    assert(cache->Get("user99", &pwd) && pwd == "pwd99");
+    assert(!cache->Get("user0", &pwd));
+    cache->Put("user99", "new");
+    assert(cache->Get("user99", &pwd) && pwd == "new" && cache->Size() == 8);
+    cache->Erase("user99");
+    assert(!cache->Get("user99", &pwd) && cache->Size() == 7);
+    // 过期后未命中并被删除
+    cache->Put("ttl", "x");
+    usleep(250 * 1000);
+    assert(!cache->Get("ttl", &pwd));
+    assert(cache->Hits() == 2 && cache->Misses() == 4);
+    // 同一个请求未命中后再次尝试（等待前面的响应发完后重新进入）不再查找缓存
+    std::string login = "POST /login HTTP/1.1\r\nContent-Type: application/x-www-form-urlencoded\r\n"
+                        "Content-Length: 21\r\n\r\nusername=u&password=p";
+    Buffer buff(0);
+    buff.Append(login);
+    HttpRequest request;
+    assert(request.parse(buff) && request.IsFinished() && request.NeedsUserVerify());
+    assert(!request.VerifyFromCache() && !request.VerifyFromCache() && cache->Misses() == 5);
+    request.SetVerifyResult(false);
+    printf("TestUserCache: hits %llu, misses %llu\n",
+           (unsigned long long)cache->Hits(), (unsigned long long)cache->Misses());
+    cache->Clear();
+}
+
+void TestBufferScan() {
+    const char CRLF[] = "\r\n", CRLFCRLF[] = "\r\n\r\n", SET[] = "=+%&";
+    const char ALPHABET[] = "ab\r\n=+%&";
+    srand(1);
+    int checks = 0;
+    for(int round = 0; round < 50; round++) {
+        std::string data(100 + rand() % 100, 'x');
+        for(auto& ch : data) {
+            if(rand() % 3 == 0) { ch = ALPHABET[rand() % (sizeof(ALPHABET) - 1)]; }
+        }
+        const char* base = data.data();
+        for(size_t b = 0; b < data.size(); b++) {
+            for(size_t e = b; e <= data.size(); e += 7) {
+                const char* begin = base + b;
+                const char* end = base + e;
+                assert(Buffer::FindCRLF(begin, end) == std::search(begin, end, CRLF, CRLF + 2));
+                assert(Buffer::FindCRLFCRLF(begin, end) == std::search(begin, end, CRLFCRLF, CRLFCRLF + 4));
+                assert(Buffer::FindAnyOf(begin, end, SET, 4) == std::find_first_of(begin, end, SET, SET + 4));
+                checks++;
+            }
+        }
+    }
+    printf("TestBufferScan: %d checks passed\n", checks);
+}
+
+/**
+ * @brief 测试时间轮定时器
+ * 
+ * 使用很小的轮（8个槽位 x 10ms），让多数定时器跨越不止一圈；
+ * 检查取消的定时器不会触发、延长和缩短超时都按新的时间触发、回调中取消自己是安全的。
+ */
+void TestBufferPool() {
+    // 分级取整，归还后同一线程再次分配命中缓存
+    size_t cap = 0;
+    char* block = BufferPool::Alloc(1500, &cap);
+    assert(cap == 2048 && BufferPool::BlockSize(1500) == 2048);
+    size_t cached = BufferPool::ThreadCachedBytes();
+    BufferPool::Free(block, cap);
+    assert(BufferPool::ThreadCachedBytes() == cached + 2048);
+    size_t cap2 = 0;
+    assert(BufferPool::Alloc(2000, &cap2) == block && cap2 == 2048);
+    BufferPool::Free(block, cap2);
+    char* huge = BufferPool::Alloc(3 << 20, &cap);
+    assert(cap == (3u << 20));
+    BufferPool::Free(huge, cap);
+
+    // 空缓冲区不占内存，扩容保留数据，Shrink归还
+    Buffer buff(0);
+    assert(buff.Capacity() == 0 && buff.ReadableBytes() == 0);
+    std::string data;
+    for(int i = 0; i < 5000; i++) { data.push_back('a' + i % 26); }
+    buff.Append(data);
+    assert(buff.Capacity() == 8192 && buff.RetrieveAllToStr() == data);
+    buff.Shrink();
+    assert(buff.Capacity() == 0);
+    buff.Append("abc", 3);
+    buff.Shrink();
+    assert(buff.Capacity() == 1024 && buff.ReadableBytes() == 3);
+
+    // ReadFd：小数据拷贝进合适的块，大数据直接接管第二段
+    int fds[2];
+    assert(pipe(fds) == 0);
+    int err = 0;
+    Buffer small(0);
+    assert(write(fds[1], data.data(), 100) == 100);
+    assert(small.ReadFd(fds[0], &err) == 100 && small.Capacity() == 1024);
+    std::string big = data + data + data + data + data + data + data;   // 35000字节
+    assert(write(fds[1], big.data(), big.size()) == (ssize_t)big.size());
+    Buffer empty(0);
+    assert(empty.ReadFd(fds[0], &err) == (ssize_t)big.size());
+    assert(empty.Capacity() == Buffer::EXTRA_READ_SIZE && empty.RetrieveAllToStr() == big);
+    assert(write(fds[1], big.data(), big.size()) == (ssize_t)big.size());
+    assert(small.ReadFd(fds[0], &err) == (ssize_t)big.size());
+    assert(small.ReadableBytes() == 100 + big.size());
+    assert(std::string(small.Peek() + 100, big.size()) == big);
+    close(fds[0]);
+    close(fds[1]);
+
+    // 原子下标版本行为一致
+    AtomicBuffer atomicBuff(0);
+    atomicBuff.Append(big);
+    atomicBuff.Retrieve(100);
+    assert(atomicBuff.ReadableBytes() == big.size() - 100 && atomicBuff.RetrieveAllToStr() == big.substr(100));
+
+    // 整数追加与to_string结果一致
+    Buffer number(0);
+    const uint64_t values[] = {0, 7, 10, 99, 100, 3067, 65535, 1000000, 39667571, UINT64_MAX};
+    for(uint64_t value : values) {
+        number.AppendUInt(value);
+        number.AppendLiteral(",");
+        assert(number.RetrieveAllToStr() == std::to_string(value) + ",");
+    }
+    printf("TestBufferPool: %d bytes cached\n", (int)BufferPool::ThreadCachedBytes());
+}
+
+void TestTimeWheel() {
+    TimeWheel wheel(10, 8);
+    std::vector<int> fired(100, 0);
+    std::vector<int64_t> firedAt(100, 0);
+    auto now = []() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
+    };
+    int64_t start = now();
+    for(int i = 0; i < 100; i++) {
+        wheel.add(i, i * 5, [&, i]() {
+            fired[i]++;
+            firedAt[i] = now() - start;
+            wheel.cancel(i);
+        });
+    }
+    // 奇数id全部取消
+    for(int i = 1; i < 100; i += 2) { wheel.cancel(i); }
+    // 延长id 2，缩短id 98
+    wheel.adjust(2, 300);
+    wheel.adjust(98, 20);
+    assert(wheel.size() == 50);
+    while(wheel.size() > 0 && now() - start < 3000) {
+        int next = wheel.GetNextTick();
+        if(next > 0) { usleep(next * 1000); }
+    }
+    assert(wheel.size() == 0);
+    for(int i = 0; i < 100; i++) {
+        assert(fired[i] == (i % 2 == 0 ? 1 : 0));
+    }
+    // 不会提前触发
+    for(int i = 4; i < 98; i += 2) { assert(firedAt[i] >= i * 5); }
+    assert(firedAt[2] >= 300);
+    assert(firedAt[98] >= 20 && firedAt[98] < 490);
+    printf("TestTimeWheel: %d timers fired\n", (int)std::count(fired.begin(), fired.end(), 1));
+}
+
+void TestEpoller() {
+    // 300个同时就绪的eventfd：事件数组从INIT_EVENTS开始，取满时加倍
+    Epoller epoller(256);
+    assert(epoller.EventCapacity() == (size_t)Epoller::INIT_EVENTS);
+    std::vector<int> fds;
+    for(int i = 0; i < 300; i++) {
+        int fd = eventfd(1, EFD_NONBLOCK);
+        assert(fd >= 0 && epoller.AddFd(fd, EPOLLIN));
+        fds.push_back(fd);
+    }
+    int lastCnt = 0;
+    for(int i = 0; i < 4; i++) {
+        lastCnt = epoller.WaitUs(0);
+    }
+    assert(lastCnt == 256 && epoller.EventCapacity() == 256);
+    for(int fd : fds) { close(fd); }
+
+    // 亚毫秒超时不会被截断成0（否则立即返回），也不会被放大很多
+    Epoller idle;
+    auto begin = std::chrono::steady_clock::now();
+    for(int i = 0; i < 10; i++) {
+        assert(idle.WaitUs(300) == 0);
+    }
+    int64_t elapsedUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                            std::chrono::steady_clock::now() - begin).count();
+    assert(elapsedUs >= 3000);
+
+    // HeapTimer的微秒超时
+    HeapTimer timer;
+    assert(timer.GetNextTickUs() == -1);
+    timer.add(1, 5, []{});
+    int64_t nextUs = timer.GetNextTickUs();
+    assert(nextUs > 0 && nextUs <= 5000);
+    printf("TestEpoller: %d events, 10 x 300us waits in %dus\n", lastCnt, (int)elapsedUs);
+}
+
+void TestIoUring() {
+    if(!IoUring::Supported()) {
+        printf("TestIoUring: io_uring not supported, skipped\n");
+        return;
+    }
+#if WEBSERVER_HAS_URING
+    IoUring ring;
+    assert(ring.Init(8, 64) && ring.SetupBuffers(1, 4, 16));
+    int sv[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv) == 0);
+
+    // 多次recv：一次提交，每段数据一个CQE，数据在内核挑选的provided buffer中
+    io_uring_sqe* sqe = ring.GetSqe();
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = sv[0];
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = 1;
+    sqe->user_data = 1;
+    assert(ring.Submit() == 1);
+    std::string received;
+    int cqes = 0;
+    for(int round = 0; round < 3; round++) {
+        std::string msg = "hello-" + std::to_string(round) + "-0123456789";  // 超过一个缓冲区，分成两个CQE
+        assert(write(sv[1], msg.data(), msg.size()) == (ssize_t)msg.size());
+        size_t expect = received.size() + msg.size();
+        while(received.size() < expect) {
+            assert(ring.SubmitAndWait(1000000) >= 0);
+            ring.ForEachCqe([&](const io_uring_cqe& cqe) {
+                assert(cqe.user_data == 1 && cqe.res > 0 && (cqe.flags & IORING_CQE_F_BUFFER));
+                assert(cqe.flags & IORING_CQE_F_MORE);
+                uint16_t bid = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+                assert(cqe.res <= (int)ring.BufferSize());
+                received.append(ring.Buffer(bid), cqe.res);
+                ring.RecycleBuffer(bid);
+                cqes++;
+            });
+        }
+    }
+    assert(received == "hello-0-0123456789hello-1-0123456789hello-2-0123456789");
+
+    // SENDMSG聚合两段数据，和一个NOP在同一次io_uring_enter中批量提交
+    char head[] = "HTTP/1.1 200 OK\r\n\r\n";
+    char body[] = "body";
+    struct iovec iov[2] = {{head, sizeof(head) - 1}, {body, sizeof(body) - 1}};
+    struct msghdr msg = {};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = 2;
+    sqe = ring.GetSqe();
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = sv[0];
+    sqe->addr = reinterpret_cast<uint64_t>(&msg);
+    sqe->len = 1;
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = 2;
+    sqe = ring.GetSqe();
+    sqe->opcode = IORING_OP_NOP;
+    sqe->user_data = 3;
+    int sent = -1;
+    bool nop = false;
+    assert(ring.SubmitAndWait(1000000) == 2);
+    while(sent < 0 || !nop) {
+        ring.ForEachCqe([&](const io_uring_cqe& cqe) {
+            if(cqe.user_data == 2) { sent = cqe.res; }
+            if(cqe.user_data == 3) { nop = cqe.res == 0; }
+        });
+        if(sent < 0 || !nop) { assert(ring.SubmitAndWait(1000000) >= 0); }
+    }
+    assert(sent == (int)(sizeof(head) - 1 + sizeof(body) - 1));
+    char buf[64] = {0};
+    assert(read(sv[1], buf, sizeof(buf)) == sent && std::string(buf) == "HTTP/1.1 200 OK\r\n\r\nbody");
+
+    // 对端关闭：多次recv以res == 0结束
+    close(sv[1]);
+    bool eof = false;
+    while(!eof) {
+        assert(ring.SubmitAndWait(1000000) >= 0);
+        ring.ForEachCqe([&](const io_uring_cqe& cqe) {
+            if(cqe.user_data == 1 && cqe.res == 0) { eof = !(cqe.flags & IORING_CQE_F_MORE); }
+        });
+    }
+    close(sv[0]);
+
+    // 等待超时返回0
+    auto begin = std::chrono::steady_clock::now();
+    assert(ring.SubmitAndWait(2000) == 0);
+    int64_t elapsedUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                            std::chrono::steady_clock::now() - begin).count();
+    assert(elapsedUs >= 2000);
+    printf("TestIoUring: %d recv cqes, sendmsg %d bytes, 2ms wait in %dus\n", cqes, sent, (int)elapsedUs);
+#endif
+}
+
+void TestConnSlab() {
+    ConnSlab slab(1000);
+    assert(slab.Capacity() == 1000);
+    assert(slab.Find(-1) == nullptr && slab.Find(1000) == nullptr);
+    // 没有分配的块查不到，Get之后地址稳定，同一块内相邻
+    assert(slab.Find(700) == nullptr);
+    HttpConn* conn = slab.Get(700);
+    assert(conn && slab.Find(700) == conn && slab.Get(700) == conn);
+    assert(slab.Find(701) == conn + 1);
+    slab.Reserve(300);
+    assert(slab.Find(0) && slab.Find(299) && slab.Find(511) && slab.Find(768) == nullptr);
+
+    // 每次init/Close代数都会变化，旧代数可以识别出连接已被复用
+    sockaddr_in addr = {};
+    int fd = open("/dev/null", O_RDONLY);
+    assert(fd >= 0 && fd < slab.Capacity());
+    HttpConn* client = slab.Get(fd);
+    client->init(fd, addr);
+    uint32_t gen = client->Generation();
+    client->Close();
+    assert(client->Generation() != gen);
+    uint32_t closedGen = client->Generation();
+    client->Close();
+    assert(client->Generation() == closedGen);
+    fd = open("/dev/null", O_RDONLY);
+    assert(slab.Get(fd) == client);
+    client->init(fd, addr);
+    assert(client->Generation() != gen && client->Generation() != closedGen);
+    client->Close();
+
+    int count = 0;
+    slab.ForEach([&count](HttpConn*) { count++; });
+    assert(count == 3 * 256);
+    printf("TestConnSlab: %d slots allocated\n", count);
+}
+
+/**
+ * @brief 测试过载保护
+ *
+ * 检查在途请求数和队列深度的准入、连接数水位线，以及拒绝时发出的503。
+ */
+void TestAdmission() {
+    Admission* admission = Admission::Instance();
+    admission->Init(4, 2, 10, 0, 3);
+    assert(admission->TryEnter(0) && admission->TryEnter(1));
+    assert(!admission->TryEnter(0) && admission->InFlight() == 2);
+    admission->Leave();
+    assert(!admission->TryEnter(4) && admission->InFlight() == 1);
+    assert(admission->TryEnter(3));
+    admission->Leave();
+    admission->Leave();
+    assert(admission->InFlight() == 0);
+
+    // 低水位默认取高水位的90%
+    assert(admission->OverHighWater(10) && !admission->OverHighWater(9));
+    assert(!admission->BelowLowWater(9) && admission->BelowLowWater(8));
+    admission->Init(0, 0, 10, 5, 3);
+    assert(!admission->BelowLowWater(5) && admission->BelowLowWater(4));
+
+    // 拒绝时先读掉请求，再发出完整的503
+    int sv[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv) == 0);
+    const char req[] = "GET /index.html HTTP/1.1\r\nHost: a\r\n\r\n";
+    assert(write(sv[1], req, sizeof(req) - 1) == (ssize_t)sizeof(req) - 1);
+    uint64_t shed = admission->ShedCount();
+    admission->Shed(sv[0]);
+    char buf[256] = {0};
+    assert(read(sv[1], buf, sizeof(buf) - 1) == (ssize_t)admission->BusyResponse().size());
+    assert(strstr(buf, "HTTP/1.1 503 ") == buf && strstr(buf, "Retry-After: 3\r\n"));
+    assert(read(sv[0], buf, sizeof(buf)) < 0 && errno == EAGAIN);
+    assert(admission->ShedCount() == shed + 1);
+    close(sv[0]);
+    close(sv[1]);
+
+    // 不限制时总是准入
+    admission->Init(0, 0, 0, 0, 1);
+    for(int i = 0; i < 100; i++) { assert(admission->TryEnter(1000000)); }
+    assert(!admission->OverHighWater(1000000));
+    printf("TestAdmission: %llu shed\n", (unsigned long long)admission->ShedCount());
+}
+
+/**
+ * @brief 测试指标
+ *
+ * 检查HDR分桶的边界、多个线程各写自己的计数块后的合计，以及通过HttpConn请求/metrics得到的导出文本。
+ */
+void TestMetrics() {
+    // 子桶首尾相接，相对误差不超过1/SUB_BUCKETS
+    for(uint64_t us = 0; us < (1ULL << 20); us += 1 + us / 64) {
+        int index = Metrics::BucketIndex(us);
+        assert(us < Metrics::BucketUpperUs(index));
+        assert(index == 0 || us >= Metrics::BucketUpperUs(index - 1));
+        assert(Metrics::BucketUpperUs(index) - us <= us / Metrics::SUB_BUCKETS + 1);
+    }
+    assert(Metrics::BucketIndex(~0ULL) == Metrics::BUCKETS - 1);
+
+    Metrics* metrics = Metrics::Instance();
+    uint64_t before = metrics->Total(METRIC_DB_CALLS);
+    std::vector<std::thread> threads;
+    for(int t = 0; t < 4; t++) {
+        threads.emplace_back([] {
+            for(int i = 0; i < 100000; i++) { Metrics::Add(METRIC_DB_CALLS); }
+            // 1ms ~ 1000ms均匀分布
+            for(int i = 1; i <= 1000; i++) { Metrics::ObserveLatency(i * 1000); }
+        });
+    }
+    for(auto& t : threads) { t.join(); }
+    assert(metrics->Total(METRIC_DB_CALLS) - before == 400000);
+    uint64_t p50 = metrics->LatencyQuantileUs(0.5), p99 = metrics->LatencyQuantileUs(0.99);
+    assert(p50 >= 500000 && p50 <= 500000 * 9 / 8);
+    assert(p99 >= 990000 && p99 <= 990000 * 9 / 8);
+
+    // 通过HttpConn请求/metrics，注册的瞬时值在导出时读取
+    metrics->SetEnabled(true);
+    metrics->AddGauge("test_gauge", "Test gauge.", [] { return 42.0; });
+    HttpConn::srcDir = "./";
+    HttpConn::isET = true;
+    int sv[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv) == 0);
+    HttpConn conn;
+    sockaddr_in addr = {};
+    conn.init(sv[0], addr);
+    const char req[] = "GET /metrics HTTP/1.1\r\nHost: a\r\nConnection: keep-alive\r\n\r\n";
+    assert(write(sv[1], req, sizeof(req) - 1) == (ssize_t)sizeof(req) - 1);
+    int err = 0;
+    assert(conn.read(&err) > 0 || err == EAGAIN);
+    assert(conn.process());
+    assert(conn.write(&err) > 0 && conn.ToWriteBytes() == 0);
+    std::string text;
+    char buf[4096];
+    ssize_t n;
+    while((n = read(sv[1], buf, sizeof(buf))) > 0) { text.append(buf, n); }
+    assert(text.find("HTTP/1.1 200 OK\r\n") == 0);
+    assert(text.find("Content-type: text/plain; version=0.0.4\r\n") != std::string::npos);
+    assert(text.find("\ntest_gauge 42\n") != std::string::npos);
+    assert(text.find("# TYPE webserver_request_duration_seconds histogram\n") != std::string::npos);
+    assert(text.find("webserver_request_duration_seconds_bucket{le=\"+Inf\"} 4000\n") != std::string::npos);
+    assert(text.find("webserver_db_calls_total ") != std::string::npos);
+    // 响应发完后记录了这次请求的耗时和状态码
+    std::string again = metrics->Render();
+    assert(again.find("webserver_request_duration_seconds_count 4001\n") != std::string::npos);
+    assert(again.find("webserver_responses_total{code=\"200\"} ") != std::string::npos);
+    conn.Close();
+    close(sv[1]);
+    metrics->ClearGauges();
+    metrics->SetEnabled(false);
+    printf("TestMetrics: %d bytes exported, p50 %lluus p99 %lluus\n", (int)text.size(),
+           (unsigned long long)p50, (unsigned long long)p99);
+}
+
+void TestTrace() {
+    Trace* trace = Trace::Instance();
+    trace->Init(1);
+    assert(trace->IsEnabled());
+    // 校准后的时间戳换算成纳秒与实际经过的时间一致
+    uint64_t start = Trace::Now();
+    usleep(2000);
+    uint64_t ns = trace->ElapsedNs(start, Trace::Now());
+    assert(ns >= 2000000 && ns < 200000000);
+    assert(trace->ElapsedNs(0, start) == 0);
+
+    // 两个流水线请求在派发后排队3ms才开始处理，都超过1ms的阈值
+    HttpConn::srcDir = "./";
+    HttpConn::isET = true;
+    int sv[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv) == 0);
+    HttpConn conn;
+    sockaddr_in addr = {};
+    conn.init(sv[0], addr);
+    const char req[] = "GET /nope HTTP/1.1\r\nHost: a\r\nConnection: keep-alive\r\n\r\n"
+                       "GET /nope HTTP/1.1\r\nHost: a\r\nConnection: keep-alive\r\n\r\n";
+    assert(write(sv[1], req, sizeof(req) - 1) == (ssize_t)sizeof(req) - 1);
+    uint64_t before = trace->SlowCount();
+    uint64_t dispatch = Trace::Now();
+    usleep(3000);
+    conn.TraceEvent(dispatch);
+    int err = 0;
+    assert(conn.read(&err) > 0 || err == EAGAIN);
+    assert(conn.process());
+    assert(conn.write(&err) > 0 && conn.ToWriteBytes() == 0);
+    assert(trace->SlowCount() - before == 2);
+
+    // 没有排队的请求不算慢请求
+    assert(write(sv[1], req, sizeof(req) - 1) == (ssize_t)sizeof(req) - 1);
+    conn.TraceEvent();
+    assert(conn.read(&err) > 0 || err == EAGAIN);
+    assert(conn.process());
+    assert(conn.write(&err) > 0 && conn.ToWriteBytes() == 0);
+    uint64_t slow = trace->SlowCount() - before;
+    conn.Close();
+    close(sv[1]);
+    trace->Init(0);
+    printf("TestTrace: %llu slow, %s clock\n", (unsigned long long)slow, Trace::UsesTsc() ? "tsc" : "monotonic");
+}
+
+/**
+ * @brief 测试配置文件和运行中可调整的参数
+ *
+ * 检查配置文件的解析（注释、bool取值、未出现的key保持默认）、错误定位到行号、Diff，
+ * 以及重载时用到的ThreadPool::Resize和FileCache::SetBudget。
+ */
+void TestConfig() {
+    const char* path = "./test_server.conf";
+    FILE* fp = fopen(path, "w");
+    assert(fp);
+    fputs("# comment\n\nport = 8080   # trailing comment\nthread_num=4\nmulti_reactor = on\n"
+          "sql_user = web user\nfile_cache_mb = 0\n", fp);
+    fclose(fp);
+    ServerConfig config;
+    std::string err;
+    assert(config.Load(path, &err));
+    assert(config.port == 8080 && config.threadNum == 4 && config.multiReactor);
+    assert(config.sqlUser == "web user" && config.fileCacheMB == 0);
+    assert(config.trigMode == 3 && config.timeoutMS == 60000);
+    std::vector<std::string> diff = ServerConfig().Diff(config);
+    assert(diff.size() == 5);
+    assert(std::find(diff.begin(), diff.end(), "multi_reactor") != diff.end());
+    assert(config.Diff(config).empty());
+
+    const char* bad[] = {"prot = 1\n", "thread_num = 0\n", "port = 80x\n", "metrics = yes\n", "port\n"};
+    for(const char* line : bad) {
+        fp = fopen(path, "w");
+        fputs("# ok\n", fp);
+        fputs(line, fp);
+        fclose(fp);
+        ServerConfig c;
+        err.clear();
+        assert(!c.Load(path, &err));
+        assert(err.find(":2: ") != std::string::npos);
+    }
+    remove(path);
+    assert(!config.Load(path, &err));
+
+    // 线程池调小时空闲线程退出，调大后任务照常执行
+    ThreadPool pool(4);
+    pool.Resize(1);
+    assert(pool.ThreadCount() == 1);
+    pool.Resize(3);
+    assert(pool.ThreadCount() == 3);
+    std::atomic<int> done(0);
+    for(int i = 0; i < 100; i++) { pool.AddTask([&done] { done++; }); }
+    while(done < 100) { usleep(1000); }
+
+    // 缓存预算调小时立即淘汰
+    FileCache::Instance()->Init(1 << 20, true);
+    int cacheErr = 0;
+    assert(FileCache::Instance()->Get("./test.cpp", &cacheErr));
+    assert(FileCache::Instance()->UsedBytes() > 0);
+    FileCache::Instance()->SetBudget(0);
+    assert(FileCache::Instance()->UsedBytes() == 0);
+    FileCache::Instance()->Clear();
+    printf("TestConfig: %d keys changed\n", (int)diff.size());
+}
+
+/**
+ * @brief 测试排空退出用到的部分
+ *
+ * 排空时长连接上的响应带Connection: close、IsIdle()只在没有未处理数据和待发送响应时为true，
+ * ThreadPool析构时执行完队列中的任务并join工作线程，Log::Close()写完队列中的日志。
+ */
+void TestDrain() {
+    HttpConn::srcDir = "./";
+    HttpConn::isET = true;
+    HttpConn::keepAliveMax = 0;
+    int sv[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv) == 0);
+    HttpConn conn;
+    sockaddr_in addr = {};
+    conn.init(sv[0], addr);
+    assert(conn.IsIdle());
+    const char req[] = "GET /nope HTTP/1.1\r\nHost: a\r\nConnection: keep-alive\r\n\r\n";
+    // 不完整的请求留在读缓冲区，连接不空闲
+    assert(write(sv[1], req, 10) == 10);
+    int err = 0;
+    assert(conn.read(&err) > 0 || err == EAGAIN);
+    assert(!conn.process() && !conn.IsIdle());
+    assert(write(sv[1], req + 10, sizeof(req) - 11) == (ssize_t)sizeof(req) - 11);
+    assert(conn.read(&err) > 0 || err == EAGAIN);
+    assert(conn.process() && conn.IsKeepAlive() && !conn.IsIdle());
+    assert(conn.write(&err) > 0 && conn.IsIdle());
+    // 排空开始后的响应不再保持连接
+    HttpConn::draining = true;
+    assert(write(sv[1], req, sizeof(req) - 1) == (ssize_t)sizeof(req) - 1);
+    assert(conn.read(&err) > 0 || err == EAGAIN);
+    assert(conn.process() && !conn.IsKeepAlive());
+    assert(conn.write(&err) > 0 && conn.IsIdle());
+    char resp[4096];
+    ssize_t len = read(sv[1], resp, sizeof(resp) - 1);
+    assert(len > 0);
+    resp[len] = '\0';
+    assert(strstr(resp, "Connection: close") != nullptr);
+    HttpConn::draining = false;
+    assert(conn.Owner() == nullptr);
+    conn.Close();
+    close(sv[1]);
+
+    // 析构时队列中的任务都执行完
+    std::atomic<int> done(0);
+    {
+        ThreadPool pool(2);
+        pool.Resize(1);
+        pool.Resize(2);
+        for(int i = 0; i < 200; i++) {
+            pool.AddTask([&done] { usleep(50); done++; });
+        }
+    }
+    assert(done == 200);
+
+    // 关闭日志时队列中的日志都写进文件
+    Log::Instance()->init(0, "./testdrain", ".log", 64);
+    for(int i = 0; i < 1000; i++) { LOG_INFO("drain %d", i); }
+    Log::Instance()->Close();
+    assert(!Log::Instance()->IsOpen());
+    time_t now = time(nullptr);
+    struct tm t;
+    localtime_r(&now, &t);
+    char path[64];
+    snprintf(path, sizeof(path), "./testdrain/%04d_%02d_%02d.log", t.tm_year + 1900, t.tm_mon + 1, t.tm_mday);
+    FILE* fp = fopen(path, "r");
+    assert(fp);
+    // 队列满时直接同步写入，先后顺序可能和队列里的交错，只检查每一条都在
+    char line[256];
+    int lines = 0;
+    std::vector<bool> seen(1000, false);
+    while(fgets(line, sizeof(line), fp)) {
+        lines++;
+        const char* p = strstr(line, "drain ");
+        if(p) { seen[atoi(p + 6)] = true; }
+    }
+    fclose(fp);
+    assert(lines >= 1000 && std::count(seen.begin(), seen.end(), true) == 1000);
+    // 恢复之前的日志设置
+    Log::Instance()->init(3, "./testlog2", ".log", 5000);
+    printf("TestDrain: %d tasks done, %d log lines flushed\n", done.load(), lines);
+}
+
+static std::string ReadAll(int fd) {
+    std::string out;
+    char buf[4096];
+    ssize_t len;
+    while((len = read(fd, buf, sizeof(buf))) > 0) { out.append(buf, len); }
+    return out;
+}
+
+static int CountResponses(const std::string& out) {
+    int count = 0;
+    for(size_t pos = out.find("HTTP/1.1 "); pos != std::string::npos; pos = out.find("HTTP/1.1 ", pos + 1)) {
+        count++;
+    }
+    return count;
+}
+
+void TestPipeline() {
+    system("rm -rf ./testpipe && mkdir -p ./testpipe");
+    FILE* fp = fopen("./testpipe/a.txt", "w");
+    fputs("AAAA", fp);
+    fclose(fp);
+    fp = fopen("./testpipe/b.txt", "w");
+    fputs("BBBB", fp);
+    fclose(fp);
+    FileCache::Instance()->Init(1 << 20, true);
+    HttpConn::srcDir = "./testpipe";
+    HttpConn::isET = true;
+    HttpConn::keepAliveMax = 0;
+    int sv[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv) == 0);
+    HttpConn conn;
+    sockaddr_in addr = {};
+    conn.init(sv[0], addr);
+    int err = 0;
+
+    // 两个完整的请求加第三个请求的前一半一次到达：一次process按顺序回复两个，半个请求留在读缓冲区
+    std::string a = "GET /a.txt HTTP/1.1\r\nHost: x\r\n\r\n";
+    std::string b = "GET /b.txt HTTP/1.1\r\nHost: x\r\n\r\n";
+    std::string data = a + b + a.substr(0, 10);
+    assert(write(sv[1], data.data(), data.size()) == (ssize_t)data.size());
+    assert(conn.read(&err) > 0 || err == EAGAIN);
+    assert(conn.process() && conn.IsKeepAlive());
+    assert(conn.write(&err) > 0 && !conn.IsIdle());
+    std::string out = ReadAll(sv[1]);
+    size_t posA = out.find("AAAA"), posB = out.find("BBBB");
+    assert(CountResponses(out) == 2 && posA != std::string::npos && posB != std::string::npos && posA < posB);
+    // 剩下的一半到达后第三个请求完成
+    assert(write(sv[1], a.data() + 10, a.size() - 10) == (ssize_t)a.size() - 10);
+    assert(conn.read(&err) > 0 || err == EAGAIN);
+    assert(conn.process());
+    assert(conn.write(&err) > 0 && conn.IsIdle());
+    out = ReadAll(sv[1]);
+    assert(CountResponses(out) == 1 && out.find("AAAA") != std::string::npos);
+
+    // Connection: close结束这一批，后面的请求不再处理
+    data = a + "GET /b.txt HTTP/1.1\r\nConnection: close\r\n\r\n" + a;
+    assert(write(sv[1], data.data(), data.size()) == (ssize_t)data.size());
+    assert(conn.read(&err) > 0 || err == EAGAIN);
+    assert(conn.process() && !conn.IsKeepAlive());
+    assert(conn.write(&err) > 0);
+    out = ReadAll(sv[1]);
+    assert(CountResponses(out) == 2 && out.find("Connection: close\r\n") != std::string::npos);
+    assert(out.rfind("AAAA") < out.find("BBBB"));
+    conn.Close();
+    close(sv[1]);
+
+    // 一次process最多处理MAX_PIPELINE个请求，写完后再处理剩下的
+    assert(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv) == 0);
+    conn.init(sv[0], addr);
+    const int total = 40;
+    data.clear();
+    for(int i = 0; i < total; i++) { data += a; }
+    assert(write(sv[1], data.data(), data.size()) == (ssize_t)data.size());
+    assert(conn.read(&err) > 0 || err == EAGAIN);
+    assert(conn.process());
+    assert(conn.write(&err) > 0 && !conn.IsIdle());
+    int first = CountResponses(ReadAll(sv[1]));
+    assert(first == 32);
+    assert(conn.process());
+    assert(conn.write(&err) > 0 && conn.IsIdle());
+    assert(CountResponses(ReadAll(sv[1])) == total - first);
+    conn.Close();
+    close(sv[1]);
+    printf("TestPipeline: %d + %d responses\n", first, total - first);
+}
+
+void TestSendfile() {
+    system("rm -rf ./testsendfile && mkdir -p ./testsendfile");
+    std::string big(200000, 'x');
+    for(size_t i = 0; i < big.size(); i++) { big[i] = 'a' + i % 26; }
+    FILE* fp = fopen("./testsendfile/big.txt", "w");
+    fwrite(big.data(), 1, big.size(), fp);
+    fclose(fp);
+    fp = fopen("./testsendfile/a.txt", "w");
+    fputs("AAAA", fp);
+    fclose(fp);
+    FileCache::Instance()->Init(1 << 20, false);
+    HttpConn::srcDir = "./testsendfile";
+    HttpConn::isET = true;
+    HttpConn::keepAliveMax = 0;
+    HttpConn::useSendfile = true;
+    int sv[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv) == 0);
+    int sndbuf = 4096;
+    setsockopt(sv[0], SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+    HttpConn conn;
+    sockaddr_in addr = {};
+    conn.init(sv[0], addr);
+    int err = 0;
+
+    // 大文件后面流水线一个小文件：发送缓冲区写满后从文件段中间继续，第二个响应紧跟在文件之后
+    std::string data = "GET /big.txt HTTP/1.1\r\n\r\nGET /a.txt HTTP/1.1\r\n\r\n";
+    assert(write(sv[1], data.data(), data.size()) == (ssize_t)data.size());
+    assert(conn.read(&err) > 0 || err == EAGAIN);
+    assert(conn.process());
+    std::string out;
+    int rounds = 0;
+    while(conn.ToWriteBytes() > 0) {
+        err = 0;
+        ssize_t len = conn.write(&err);
+        assert(len > 0 || err == EAGAIN);
+        out += ReadAll(sv[1]);
+        rounds++;
+    }
+    out += ReadAll(sv[1]);
+    assert(rounds > 1 && conn.IsIdle() && CountResponses(out) == 2);
+    size_t body = out.find("\r\n\r\n") + 4;
+    assert(out.compare(body, big.size(), big) == 0);
+    assert(out.compare(body + big.size(), 9, "HTTP/1.1 ") == 0);
+    assert(out.size() - out.rfind("AAAA") == 4);
+
+    // 响应排队后文件被截短，sendfile返回0时报告EIO，而不是残留的EAGAIN
+    data = "GET /big.txt HTTP/1.1\r\n\r\n";
+    assert(write(sv[1], data.data(), data.size()) == (ssize_t)data.size());
+    assert(conn.read(&err) > 0 || err == EAGAIN);
+    assert(conn.process());
+    assert(truncate("./testsendfile/big.txt", 1000) == 0);
+    ssize_t len;
+    do {
+        err = 0;
+        len = conn.write(&err);
+        ReadAll(sv[1]);
+    } while(len > 0 || err == EAGAIN);
+    assert(len == 0 && err == EIO && conn.ToWriteBytes() > 0);
+    conn.Close();
+    close(sv[1]);
+    HttpConn::useSendfile = false;
+    system("rm -rf ./testsendfile");
+    printf("TestSendfile: %d rounds\n", rounds);
+}
+
+static void WriteFile(const char* path, const std::string& content) {
+    FILE* fp = fopen(path, "w");
+    fwrite(content.data(), 1, content.size(), fp);
+    fclose(fp);
+}
+
+void TestFileCache() {
+    system("rm -rf ./testcache && mkdir -p ./testcache");
+    WriteFile("./testcache/1.txt", std::string(100, '1'));
+    WriteFile("./testcache/2.txt", std::string(100, '2'));
+    WriteFile("./testcache/3.txt", std::string(100, '3'));
+    WriteFile("./testcache/big.txt", std::string(300, 'b'));
+    FileCache* cache = FileCache::Instance();
+    cache->Init(250, true);
+    int err = 0;
+    size_t hits = cache->Hits(), misses = cache->Misses();
+
+    // 命中时各连接共享同一个条目
+    FileEntryPtr e1 = cache->Get("./testcache/1.txt", &err);
+    FileEntryPtr e2 = cache->Get("./testcache/2.txt", &err);
+    assert(e1 && e2 && cache->UsedBytes() == 200);
+    assert(cache->Get("./testcache/1.txt", &err) == e1);
+    assert(cache->Hits() == hits + 1 && cache->Misses() == misses + 2);
+
+    // 超出预算时淘汰最久未使用的2.txt，借出的条目在淘汰后仍然可用
+    FileEntryPtr e3 = cache->Get("./testcache/3.txt", &err);
+    assert(e3 && cache->UsedBytes() == 200);
+    assert(cache->Get("./testcache/1.txt", &err) == e1 && cache->Get("./testcache/3.txt", &err) == e3);
+    assert(std::string(e2->data, e2->st.st_size) == std::string(100, '2'));
+    struct stat st;
+    assert(fstat(e2->fd, &st) == 0 && st.st_size == 100);
+    FileEntryPtr e2b = cache->Get("./testcache/2.txt", &err);
+    assert(e2b && e2b != e2 && cache->UsedBytes() == 200);
+
+    // 超过预算的单个文件不进入缓存
+    FileEntryPtr big = cache->Get("./testcache/big.txt", &err);
+    assert(big && big->st.st_size == 300 && cache->Get("./testcache/big.txt", &err) != big);
+    assert(cache->UsedBytes() == 200);
+
+    // 文件改变后，REVALIDATE_MS之内仍返回旧条目，之后重新加载
+    FileEntryPtr old = cache->Get("./testcache/2.txt", &err);
+    WriteFile("./testcache/2.txt", std::string(50, 'x'));
+    assert(cache->Get("./testcache/2.txt", &err) == old);
+    usleep(1100 * 1000);
+    FileEntryPtr fresh = cache->Get("./testcache/2.txt", &err);
+    assert(fresh && fresh != old && fresh->st.st_size == 50 && fresh->etag != old->etag);
+    assert(std::string(fresh->data, 50) == std::string(50, 'x'));
+    assert(cache->Get("./testcache/2.txt", &err) == fresh);
+    // 删除后返回ENOENT
+    unlink("./testcache/3.txt");
+    usleep(1100 * 1000);
+    err = 0;
+    assert(!cache->Get("./testcache/3.txt", &err) && err == ENOENT);
+
+    cache->Clear();
+    assert(cache->UsedBytes() == 0 && e1->data[0] == '1');
+    system("rm -rf ./testcache");
+    printf("TestFileCache: ok\n");
+}
+
+void TestHttpRequest() {
+    // 同一个请求整块、分几段、逐字节到达，中途读缓冲区扩容搬移，解析结果都相同
+    std::string pad(1500, 'p');
+    std::string req = "GET /login HTTP/1.1\r\nhost: example.com\r\nX-Pad: " + pad +
+                      "\r\nCONTENT-TYPE: text/plain\r\nContent-Length: 0\r\nConnection: Keep-Alive\r\n\r\n";
+    const size_t steps[] = {req.size(), 7, 1};
+    for(size_t step : steps) {
+        Buffer buff(0);
+        HttpRequest request;
+        size_t capacity = 0;
+        bool grown = false;
+        for(size_t off = 0; off < req.size(); off += step) {
+            size_t n = std::min(step, req.size() - off);
+            buff.Append(req.data() + off, n);
+            grown = grown || (capacity && buff.Capacity() != capacity);
+            capacity = buff.Capacity();
+            assert(request.parse(buff));
+            assert(request.IsFinished() == (off + n == req.size()));
+        }
+        assert(step == req.size() || grown);
+        assert(request.method() == "GET" && request.path() == "/login.html" && request.version() == "1.1");
+        assert(request.Host().ToString() == "example.com" && request.ContentType().ToString() == "text/plain");
+        assert(request.ContentLength() == 0 && request.IsKeepAlive());
+        assert(request.GetHeader("x-pad").ToString() == pad && request.GetHeader("CONNECTION").EqualsNoCase("keep-alive"));
+        assert(request.GetHeader("X-Missing").empty() && request.RequestLength() == req.size());
+    }
+
+    // 长连接：HTTP/1.1默认保持，HTTP/1.0需要显式keep-alive
+    const char* alive[][2] = {
+        {"GET / HTTP/1.1\r\n\r\n", "1"},
+        {"GET / HTTP/1.1\r\nConnection: close\r\n\r\n", "0"},
+        {"GET / HTTP/1.0\r\n\r\n", "0"},
+        {"GET / HTTP/1.0\r\nConnection: keep-alive\r\n\r\n", "1"},
+    };
+    for(auto& c : alive) {
+        Buffer buff(0);
+        HttpRequest request;
+        buff.Append(c[0], strlen(c[0]));
+        assert(request.parse(buff) && request.IsFinished() && request.path() == "/index.html");
+        assert(request.IsKeepAlive() == (atoi(c[1]) == 1));
+    }
+
+    // 格式错误的请求行和请求头返回400
+    const char* bad[] = {
+        "GET /index.html\r\n\r\n",
+        "GET  /index.html HTTP/1.1\r\n\r\n",
+        "GET /index.html FTP/1.1\r\n\r\n",
+        "GET /a b HTTP/1.1\r\n\r\n",
+        "GET / HTTP/1.1\r\nNoColon\r\n\r\n",
+        "GET / HTTP/1.1\r\n: empty-name\r\n\r\n",
+        "GET / HTTP/1.1\r\nContent-Length: 12a\r\n\r\n",
+    };
+    for(const char* c : bad) {
+        Buffer buff(0);
+        HttpRequest request;
+        buff.Append(c, strlen(c));
+        assert(!request.parse(buff) && request.ErrorCode() == 400);
+    }
+    // 一直收不到空行的超长请求头也是400
+    Buffer buff(0);
+    HttpRequest request;
+    std::string huge = "GET / HTTP/1.1\r\nX-Huge: " + std::string(70000, 'h');
+    buff.Append(huge);
+    assert(!request.parse(buff) && request.ErrorCode() == 400);
+
+    // 连接对格式错误的请求回复400并关闭
+    HttpConn::srcDir = "./";
+    HttpConn::isET = true;
+    int sv[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv) == 0);
+    HttpConn conn;
+    sockaddr_in addr = {};
+    conn.init(sv[0], addr);
+    assert(write(sv[1], bad[0], strlen(bad[0])) == (ssize_t)strlen(bad[0]));
+    int err = 0;
+    assert(conn.read(&err) > 0 || err == EAGAIN);
+    assert(conn.process() && !conn.IsKeepAlive());
+    assert(conn.write(&err) > 0);
+    char resp[4096];
+    ssize_t len = read(sv[1], resp, sizeof(resp) - 1);
+    assert(len > 0);
+    resp[len] = '\0';
+    assert(strstr(resp, "HTTP/1.1 400 Bad Request\r\n") == resp && strstr(resp, "Connection: close\r\n"));
+    conn.Close();
+    close(sv[1]);
+    printf("TestHttpRequest: ok\n");
+}
+
+void TestRequestBody() {
+    HttpRequest::maxBodySize = 1024;
+    // 按Content-Length分几次到达，请求体留在缓冲区里就地解码表单
+    std::string req = "POST /login HTTP/1.1\r\nContent-Type: application/x-www-form-urlencoded\r\n"
+                      "Content-Length: 33\r\n\r\nusername=a+b%41&password=%e4%B8x%";
+    Buffer buff(0);
+    HttpRequest request;
+    size_t head = req.find("\r\n\r\n") + 4;
+    buff.Append(req.data(), head + 5);
+    assert(request.parse(buff) && !request.IsFinished() && request.BodyPending() == 28);
+    buff.Append(req.data() + head + 5, req.size() - head - 5);
+    assert(request.parse(buff) && request.IsFinished() && request.BodyPending() == 0);
+    assert(request.RequestLength() == req.size() && request.ContentLength() == 33);
+    assert(request.GetPost("username") == "a bA" && request.GetPost("password") == "\xe4\xb8x%");
+    assert(request.NeedsUserVerify() && request.IsLoginRequest());
+    buff.RetrieveAll();
+
+    // chunked请求体逐字节到达，分块格式被去掉，后面流水线的请求不受影响
+    req = "POST /upload HTTP/1.1\r\nTransfer-Encoding: chunked\r\nContent-Length: 3\r\n\r\n"
+          "5\r\nhello\r\n7;ext=1\r\n, world\r\n0\r\nX-Trailer: 1\r\n\r\n";
+    std::string next = "GET / HTTP/1.1\r\n\r\n";
+    request.Init();
+    for(size_t i = 0; i < req.size(); i++) {
+        buff.Append(req.data() + i, 1);
+        assert(request.parse(buff) && request.IsFinished() == (i + 1 == req.size()));
+        assert(request.BodyPending() == 0);
+    }
+    buff.Append(next);
+    assert(request.parse(buff) && request.RequestLength() == req.size());
+    assert(request.Body().ToString() == "hello, world" && request.ContentLength() == 12);
+    // 同时带Content-Length时响应后关闭连接
+    assert(!request.IsKeepAlive());
+    buff.Retrieve(request.RequestLength());
+    request.Init();
+    assert(request.parse(buff) && request.IsFinished() && request.path() == "/index.html");
+    buff.RetrieveAll();
+
+    // 超过上限时不等请求体到达就返回413，格式错误返回400
+    const char* bad[][2] = {
+        {"POST / HTTP/1.1\r\nContent-Length: 1025\r\n\r\n", "413"},
+        {"POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n401\r\n", "413"},
+        {"POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n3ff\r\n", "0"},
+        {"POST / HTTP/1.1\r\nTransfer-Encoding: gzip\r\n\r\n", "400"},
+        {"POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\nzz\r\n", "400"},
+        {"POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n1\r\nab\r\n", "400"},
+        {"POST / HTTP/1.1\r\nContent-Length: 5\r\nContent-Length: 6\r\n\r\n", "400"},
+        {"POST / HTTP/1.1\r\nContent-Length: 5\r\nContent-Length: 5\r\n\r\n", "0"},
+    };
+    for(auto& c : bad) {
+        request.Init();
+        buff.Append(c[0], strlen(c[0]));
+        bool ok = request.parse(buff);
+        assert(ok == (atoi(c[1]) == 0) && (ok || request.ErrorCode() == atoi(c[1])));
+        buff.RetrieveAll();
+    }
+    HttpRequest::maxBodySize = 0;
+    request.Init();
+    buff.Append(bad[0][0], strlen(bad[0][0]));
+    assert(request.parse(buff) && !request.IsFinished() && request.BodyPending() == 0);
+    buff.RetrieveAll();
+
+    // 连接收到过大的请求体时回复413并关闭
+    HttpRequest::maxBodySize = 1024;
+    HttpConn::srcDir = "./";
+    HttpConn::isET = true;
+    int sv[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv) == 0);
+    HttpConn conn;
+    sockaddr_in addr = {};
+    conn.init(sv[0], addr);
+    assert(write(sv[1], bad[0][0], strlen(bad[0][0])) == (ssize_t)strlen(bad[0][0]));
+    int err = 0;
+    assert(conn.read(&err) > 0 || err == EAGAIN);
+    assert(conn.process() && !conn.IsKeepAlive());
+    assert(conn.write(&err) > 0);
+    char resp[4096];
+    ssize_t len = read(sv[1], resp, sizeof(resp) - 1);
+    assert(len > 0);
+    resp[len] = '\0';
+    assert(strstr(resp, "HTTP/1.1 413 Payload Too Large\r\n") == resp);
+    conn.Close();
+    close(sv[1]);
+    HttpRequest::maxBodySize = 0;
+    printf("TestRequestBody: ok\n");
+}
+
+static int AllowedCpus(int* only) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    assert(sched_getaffinity(0, sizeof(set), &set) == 0);
+    for(int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if(CPU_ISSET(cpu, &set)) { *only = cpu; }
+    }
+    return CPU_COUNT(&set);
+}
+
+void TestCpuAffinity() {
+    CpuAffinity* affinity = CpuAffinity::Instance();
+    affinity->Init(false, -1);
+    assert(!affinity->IsEnabled() && affinity->ClaimWorkerCpu() < 0 && affinity->HousekeepingCpu() < 0);
+    assert(affinity->Describe() == "off" && affinity->NodeCount() >= 1);
+    int last = -1;
+    int total = AllowedCpus(&last);
+
+    // 不可用的housekeeping核回退到最后一个可用的核
+    affinity->Init(true, CPU_SETSIZE + 1);
+    assert(affinity->IsEnabled() && affinity->HousekeepingCpu() == last);
+    std::vector<int> claimed;
+    for(int i = 0; i < total; i++) {
+        int cpu = affinity->ClaimWorkerCpu();
+        assert(cpu >= 0 && affinity->NodeOf(cpu) < affinity->NodeCount());
+        claimed.push_back(cpu);
+    }
+    // 不止一个核时housekeeping核不分给工作线程，其余的核各分一次后循环
+    std::sort(claimed.begin(), claimed.end());
+    assert(total == 1 || !std::binary_search(claimed.begin(), claimed.end(), last));
+    int distinct = std::unique(claimed.begin(), claimed.end()) - claimed.begin();
+    assert(distinct == (total == 1 ? 1 : total - 1));
+
+    // 线程池线程各绑一个核，Unpin恢复原来的亲和性
+    std::atomic<int> pinned(0);
+    {
+        ThreadPool pool(2);
+        for(int i = 0; i < 2; i++) {
+            pool.AddTask([&pinned] {
+                int cpu = -1;
+                if(AllowedCpus(&cpu) == 1 && sched_getcpu() == cpu) { pinned++; }
+            });
+        }
+    }
+    assert(pinned == 2);
+    std::thread([total] {
+        int cpu = -1;
+        assert(CpuAffinity::Instance()->PinWorker() >= 0 && AllowedCpus(&cpu) == 1);
+        CpuAffinity::Instance()->Unpin();
+        assert(AllowedCpus(&cpu) == total);
+    }).join();
+    affinity->Init(false, -1);
+    assert(!affinity->IsEnabled());
+
+    // 监听套接字的SO_INCOMING_CPU
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    assert(fd >= 0);
+    CpuAffinity::SetIncomingCpu(fd, last);
+    int incoming = CpuAffinity::IncomingCpu(fd);
+    close(fd);
+    printf("TestCpuAffinity: %d cpus, %d NUMA nodes, SO_INCOMING_CPU %d\n", total, affinity->NodeCount(), incoming);
+}
+
 /**
  * @brief 主函数
  * 
@@ -100,6 +1535,54 @@ void TestThreadPool() {
 int main() {
     // 调用TestLog函数进行日志功能测试
     TestLog();
+    // 调用TestLogRing函数进行日志无锁队列功能测试
+    TestLogRing();
+    // 调用TestAccessLog函数进行访问日志功能测试
+    TestAccessLog();
+    // 调用TestBufferScan函数进行缓冲区扫描功能测试
+    TestBufferScan();
+    // 调用TestBufferPool函数进行缓冲区内存池功能测试
+    TestBufferPool();
+    // 调用TestTimeWheel函数进行时间轮定时器功能测试
+    TestTimeWheel();
+    // 调用TestEpoller函数进行事件数组扩容和微秒超时功能测试
+    TestEpoller();
+    // 调用TestIoUring函数进行io_uring多次recv和批量提交功能测试
+    TestIoUring();
+    // 调用TestConnSlab函数进行连接表功能测试
+    TestConnSlab();
+    // 调用TestAdmission函数进行过载保护功能测试
+    TestAdmission();
+    // 调用TestMetrics函数进行指标功能测试
+    TestMetrics();
+    // 调用TestTrace函数进行请求阶段计时和慢请求采样功能测试
+    TestTrace();
+    // 调用TestConfig函数进行配置文件和运行中调整参数功能测试
+    TestConfig();
+    // 调用TestDrain函数进行排空退出功能测试
+    TestDrain();
+    // 调用TestPipeline函数进行流水线请求功能测试
+    TestPipeline();
+    // 调用TestSendfile函数进行sendfile发送文件功能测试
+    TestSendfile();
+    // 调用TestFileCache函数进行文件缓存淘汰和重新校验功能测试
+    TestFileCache();
+    // 调用TestHttpRequest函数进行请求增量解析功能测试
+    TestHttpRequest();
+    // 调用TestRequestBody函数进行请求体增量解析和大小限制功能测试
+    TestRequestBody();
+    // 调用TestCpuAffinity函数进行绑核功能测试
+    TestCpuAffinity();
+    // 调用TestUserCache函数进行用户缓存功能测试
+    TestUserCache();
+    // 调用TestSqlExecutor函数进行数据库线程功能测试
+    TestSqlExecutor();
+    // 调用TestPrecompressed函数进行预压缩文件功能测试
+    TestPrecompressed();
+    // 调用TestConditionalRange函数进行条件请求和Range请求功能测试
+    TestConditionalRange();
+    // 调用TestWorkStealingPool函数进行工作窃取线程池功能测试
+    TestWorkStealingPool();
     // 调用TestThreadPool函数进行线程池功能测试
     TestThreadPool();
     // 返回0，表示程序正常结束
@@ -0,0 +1,59 @@
+/*
+ * 二进制访问日志的离线解码工具：把AccessLog写出的.access文件转成文本或JSON（每条记录一行）。
+ *
+ * 在仓库根目录下运行：cd tools && make && ./accesslog_dump [--json] ../log/2024_01_01.access ...
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../code/log/accesslog.h"
+
+namespace {
+
+// 解码一个文件，返回记录条数，文件头不对时返回-1
+long DumpFile(const char* name, bool json) {
+    FILE* fp = fopen(name, "rb");
+    if(!fp) {
+        fprintf(stderr, "%s: cannot open\n", name);
+        return -1;
+    }
+    uint32_t header[4];
+    if(fread(header, 1, sizeof(header), fp) != sizeof(header) || header[0] != AccessLog::FILE_MAGIC
+       || header[1] != AccessLog::FILE_VERSION || header[2] != sizeof(AccessRecord)) {
+        fprintf(stderr, "%s: not an access log (version %u)\n", name, AccessLog::FILE_VERSION);
+        fclose(fp);
+        return -1;
+    }
+    long count = 0;
+    AccessRecord record;
+    char line[AccessLog::MAX_LINE];
+    while(fread(&record, 1, sizeof(record), fp) == sizeof(record)) {
+        int n = AccessLog::Format(record, line, sizeof(line), json);
+        line[n] = '\n';
+        fwrite(line, 1, n + 1, stdout);
+        count++;
+    }
+    fclose(fp);
+    return count;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    bool json = false;
+    int files = 0, failed = 0;
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "--json") == 0) {
+            json = true;
+            continue;
+        }
+        files++;
+        if(DumpFile(argv[i], json) < 0) { failed++; }
+    }
+    if(files == 0) {
+        fprintf(stderr, "usage: %s [--json] file.access ...\n", argv[0]);
+        return 2;
+    }
+    return failed ? 1 : 0;
+}
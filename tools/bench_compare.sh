@@ -0,0 +1,47 @@
+#!/bin/sh
+# 比较两次基准结果（bench/micro_bench、bench/loadgen输出的JSON行），按名字对齐，列出变化并标出退化。
+# 在仓库根目录下运行：sh tools/bench_compare.sh 旧结果.jsonl 新结果.jsonl [阈值百分比，默认5]
+# 单位为req/s、ops/s的越大越好，其余（ns/op、us等）越小越好；有退化超过阈值时退出码为1，可用于CI。
+if [ $# -lt 2 ]; then
+    echo "usage: $0 base.jsonl new.jsonl [threshold%]" >&2
+    exit 2
+fi
+THRESHOLD=${3:-5}
+
+awk -v threshold="$THRESHOLD" '
+function field(line, key,    s) {
+    if (!match(line, "\"" key "\":\"?[^,\"}]*")) return ""
+    s = substr(line, RSTART, RLENGTH)
+    sub("^\"" key "\":\"?", "", s)
+    return s
+}
+FNR == 1 { file++ }
+/^\{/ {
+    name = field($0, "name")
+    if (name == "") next
+    if (file == 1) {
+        base[name] = field($0, "value"); baseVersion = field($0, "version")
+    } else {
+        cur[name] = field($0, "value"); unit[name] = field($0, "unit"); order[++n] = name
+        curVersion = field($0, "version")
+    }
+}
+END {
+    printf "%-28s %14s %14s %9s  %s -> %s\n", "name", "base", "new", "delta", baseVersion, curVersion
+    bad = 0
+    for (i = 1; i <= n; i++) {
+        name = order[i]
+        if (!(name in base)) {
+            printf "%-28s %14s %14.3f %9s  %s\n", name, "-", cur[name], "new", unit[name]
+            continue
+        }
+        delta = base[name] == 0 ? 0 : (cur[name] - base[name]) * 100 / base[name]
+        higherBetter = (unit[name] == "req/s" || unit[name] == "ops/s")
+        worse = higherBetter ? -delta : delta
+        mark = ""
+        if (worse > threshold) { mark = "  REGRESSION"; bad = 1 }
+        else if (-worse > threshold) { mark = "  improved" }
+        printf "%-28s %14.3f %14.3f %+8.1f%%  %s%s\n", name, base[name], cur[name], delta, unit[name], mark
+    }
+    exit bad
+}' "$1" "$2"
@@ -0,0 +1,16 @@
+#!/bin/sh
+# 为静态资源生成预压缩版本（xxx.gz / xxx.br），服务器加载文件时会自动使用，请求路径上不做压缩。
+# 在仓库根目录下运行：sh tools/precompress.sh [资源目录，默认resources]
+# 没有安装brotli时只生成.gz；资源修改后需重新运行，比原文件旧的压缩文件会被服务器忽略。
+DIR=${1:-resources}
+HAS_BROTLI=0
+command -v brotli >/dev/null 2>&1 && HAS_BROTLI=1
+
+find "$DIR" -type f \( -name '*.html' -o -name '*.css' -o -name '*.js' -o -name '*.svg' \
+    -o -name '*.txt' -o -name '*.xml' -o -name '*.ttf' -o -name '*.otf' -o -name '*.eot' \) |
+while read -r f; do
+    gzip -9 -k -f -n "$f"
+    if [ $HAS_BROTLI -eq 1 ]; then
+        brotli -q 11 -k -f "$f"
+    fi
+done